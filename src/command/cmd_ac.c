@@ -49,6 +49,7 @@
 #include "command/cmd_ac.h"
 #include "command/cmd_funcs.h"
 #include "tools/parser.h"
+#include "tools/memstats.h"
 #include "plugins/plugins.h"
 #include "ui/ui.h"
 #include "ui/win_types.h"
@@ -153,6 +154,9 @@ static Autocomplete notify_typing_ac;
 static Autocomplete notify_mention_ac;
 static Autocomplete notify_trigger_ac;
 static Autocomplete prefs_ac;
+static Autocomplete stats_ac;
+static Autocomplete stats_trace_ac;
+static Autocomplete memory_ac;
 static Autocomplete sub_ac;
 static Autocomplete log_ac;
 static Autocomplete log_level_ac;
@@ -253,6 +257,7 @@ static Autocomplete plugins_ac;
 static Autocomplete plugins_load_ac;
 static Autocomplete plugins_unload_ac;
 static Autocomplete plugins_reload_ac;
+static Autocomplete plugins_stats_ac;
 static Autocomplete filepath_ac;
 static Autocomplete blocked_ac;
 static Autocomplete tray_ac;
@@ -297,6 +302,8 @@ static Autocomplete vcard_set_param_ac;
 static Autocomplete vcard_togglable_param_ac;
 static Autocomplete vcard_address_type_ac;
 
+static void _cmd_ac_memstats(MemStats* stats);
+
 static Autocomplete* all_acs[] = {
     &commands_ac,
     &who_room_ac,
@@ -310,6 +317,9 @@ static Autocomplete* all_acs[] = {
     &notify_mention_ac,
     &notify_trigger_ac,
     &prefs_ac,
+    &stats_ac,
+    &stats_trace_ac,
+    &memory_ac,
     &sub_ac,
     &log_ac,
     &log_level_ac,
@@ -405,6 +415,7 @@ static Autocomplete* all_acs[] = {
     &console_msg_ac,
     &autoping_ac,
     &plugins_ac,
+    &plugins_stats_ac,
     &filepath_ac,
     &blocked_ac,
     &tray_ac,
@@ -481,6 +492,16 @@ cmd_ac_init(void)
     autocomplete_add(help_commands_ac, "ui");
     autocomplete_add(help_commands_ac, "plugins");
 
+    autocomplete_add(stats_ac, "reset");
+    autocomplete_add(stats_ac, "dump");
+    autocomplete_add(stats_ac, "trace");
+
+    autocomplete_add(stats_trace_ac, "on");
+    autocomplete_add(stats_trace_ac, "off");
+
+    autocomplete_add(memory_ac, "all");
+    autocomplete_add(memory_ac, "log");
+
     autocomplete_add(prefs_ac, "ui");
     autocomplete_add(prefs_ac, "desktop");
     autocomplete_add(prefs_ac, "chat");
@@ -1052,6 +1073,10 @@ cmd_ac_init(void)
     autocomplete_add(plugins_ac, "unload");
     autocomplete_add(plugins_ac, "reload");
     autocomplete_add(plugins_ac, "python_version");
+    autocomplete_add(plugins_ac, "stats");
+
+    autocomplete_add(plugins_stats_ac, "reset");
+    autocomplete_add(plugins_stats_ac, "threshold");
 
     autocomplete_add(blocked_ac, "add");
     autocomplete_add(blocked_ac, "remove");
@@ -1155,6 +1180,7 @@ cmd_ac_init(void)
 
     autocomplete_add(url_ac, "open");
     autocomplete_add(url_ac, "save");
+    autocomplete_add(url_ac, "transfers");
 
     autocomplete_add(executable_ac, "avatar");
     autocomplete_add(executable_ac, "urlopen");
@@ -1343,6 +1369,8 @@ cmd_ac_init(void)
     autocomplete_add(vcard_address_type_ac, "domestic");
     autocomplete_add(vcard_address_type_ac, "international");
 
+    memstats_register("autocomplete.commands", _cmd_ac_memstats);
+
     if (ac_funcs != NULL)
         g_hash_table_destroy(ac_funcs);
     ac_funcs = g_hash_table_new(g_str_hash, g_str_equal);
@@ -1635,9 +1663,24 @@ cmd_ac_reset(ProfWin* window)
     plugins_reset_autocomplete();
 }
 
+static void
+_cmd_ac_memstats(MemStats* stats)
+{
+    gsize bytes = 0;
+    guint items = 0;
+    for (size_t n = 0; n < ARRAY_SIZE(all_acs); ++n) {
+        bytes += autocomplete_memory(*(all_acs[n]));
+        items += autocomplete_length(*(all_acs[n]));
+    }
+
+    memstats_add(stats, "autocomplete.commands", bytes, items);
+}
+
 void
 cmd_ac_uninit(void)
 {
+    memstats_unregister("autocomplete.commands");
+
     size_t n;
     for (n = ARRAY_SIZE(all_acs); n > 0; --n) {
         autocomplete_free(*(all_acs[n - 1]));
@@ -1851,6 +1894,9 @@ _cmd_ac_complete_params(ProfWin* window, const char* const input, gboolean previ
         Autocomplete completer;
     } ac_cmds[] = {
         { "/prefs", prefs_ac },
+        { "/stats trace", stats_trace_ac },
+        { "/stats", stats_ac },
+        { "/memory", memory_ac },
         { "/disco", disco_ac },
         { "/room", room_ac },
         { "/autoping", autoping_ac },
@@ -2675,6 +2721,11 @@ _plugins_autocomplete(ProfWin* window, const char* const input, gboolean previou
         return cmd_ac_complete_filepath(input, "/plugins update", previous);
     }
 
+    result = autocomplete_param_with_ac(input, "/plugins stats", plugins_stats_ac, TRUE, previous);
+    if (result) {
+        return result;
+    }
+
     if (strncmp(input, "/plugins load ", 14) == 0) {
         if (plugins_load_ac == NULL) {
             plugins_load_ac = autocomplete_new();
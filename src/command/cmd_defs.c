@@ -2154,7 +2154,8 @@ static const struct cmd_t command_defs[] = {
               { "load", cmd_plugins_load },
               { "unload", cmd_plugins_unload },
               { "reload", cmd_plugins_reload },
-              { "python_version", cmd_plugins_python_version })
+              { "python_version", cmd_plugins_python_version },
+              { "stats", cmd_plugins_stats })
       CMD_MAINFUNC(cmd_plugins)
       CMD_SYN(
               "/plugins",
@@ -2164,7 +2165,9 @@ static const struct cmd_t command_defs[] = {
               "/plugins unload [<plugin>]",
               "/plugins load [<plugin>]",
               "/plugins reload [<plugin>]",
-              "/plugins python_version")
+              "/plugins python_version",
+              "/plugins stats [reset]",
+              "/plugins stats threshold <ms>")
       CMD_DESC(
               "Manage plugins. Passing no arguments lists installed plugins and global plugins which are available for local installation. Global directory for Python plugins is " GLOBAL_PYTHON_PLUGINS_PATH " and for C Plugins is " GLOBAL_C_PLUGINS_PATH ".")
       CMD_ARGS(
@@ -2174,7 +2177,10 @@ static const struct cmd_t command_defs[] = {
               { "load [<plugin>]", "Load a plugin that already exists in the plugin directory, passing no argument loads all found plugins. It will be loaded upon next start too unless unloaded." },
               { "unload [<plugin>]", "Unload a loaded plugin, passing no argument will unload all plugins." },
               { "reload [<plugin>]", "Reload a plugin, passing no argument will reload all plugins." },
-              { "python_version", "Show the Python interpreter version." })
+              { "python_version", "Show the Python interpreter version." },
+              { "stats", "Show how many times each loaded plugin's hooks ran and how long they took." },
+              { "stats reset", "Clear the hook statistics." },
+              { "stats threshold <ms>", "Log hook calls taking at least this many milliseconds, 0 to disable. Default 100." })
       CMD_EXAMPLES(
               "/plugins install /home/steveharris/Downloads/metal.py",
               "/plugins install https://raw.githubusercontent.com/profanity-im/profanity-plugins/master/stable/sounds.py",
@@ -2183,7 +2189,8 @@ static const struct cmd_t command_defs[] = {
               "/plugins uninstall browser.py",
               "/plugins load browser.py",
               "/plugins unload say.py",
-              "/plugins reload wikipedia.py")
+              "/plugins reload wikipedia.py",
+              "/plugins stats threshold 50")
     },
 
     { CMD_PREAMBLE("/prefs",
@@ -2558,24 +2565,28 @@ static const struct cmd_t command_defs[] = {
     },
 
     { CMD_PREAMBLE("/url",
-                   parse_args, 2, 3, NULL)
+                   parse_args, 1, 3, NULL)
       CMD_SUBFUNCS(
               { "open", cmd_url_open },
-              { "save", cmd_url_save })
+              { "save", cmd_url_save },
+              { "transfers", cmd_url_transfers })
       CMD_TAGS(
               CMD_TAG_CHAT,
               CMD_TAG_GROUPCHAT)
       CMD_SYN(
               "/url open <url>",
-              "/url save <url> [<path>]")
+              "/url save <url> [<path>]",
+              "/url transfers <count>")
       CMD_DESC(
               "Open or save URLs. This works with OMEMO encrypted files as well.")
       CMD_ARGS(
               { "open", "Open URL with predefined executable." },
-              { "save", "Save URL to optional path. The location is displayed after successful download." })
+              { "save", "Save URL to optional path. The location is displayed after successful download." },
+              { "transfers <count>", "Number of file transfers running at the same time, further ones wait for a free slot. Default is 4." })
       CMD_EXAMPLES(
               "/url open https://profanity-im.github.io",
-              "/url save https://profanity-im.github.io/guide/latest/userguide.html /home/user/Download/")
+              "/url save https://profanity-im.github.io/guide/latest/userguide.html /home/user/Download/",
+              "/url transfers 2")
     },
 
     { CMD_PREAMBLE("/mam",
@@ -2741,6 +2752,52 @@ static const struct cmd_t command_defs[] = {
               "Redraw user interface. Can be used when some other program interrupted profanity or wrote to the same terminal and the interface looks \"broken\"." )
     },
 
+    { CMD_PREAMBLE("/stats",
+                   parse_args, 0, 2, NULL)
+      CMD_MAINFUNC(cmd_stats)
+      CMD_TAGS(
+              CMD_TAG_UI)
+      CMD_SYN(
+              "/stats",
+              "/stats reset",
+              "/stats dump [<seconds>]",
+              "/stats trace on|off")
+      CMD_DESC(
+              "Show internal timing statistics: how often stanza handlers, database writes, redraws, keyfile saves, "
+              "OMEMO and plugin hooks ran, and how long they took.")
+      CMD_ARGS(
+              { "reset", "Clear all statistics." },
+              { "dump", "Write the current statistics to the stats file in the data directory." },
+              { "dump <seconds>", "Write the statistics to the stats file every given seconds, 0 to stop." },
+              { "trace on|off", "Record main loop phases, stanza handlers, database writes, redraws and plugin hooks "
+                                "to a trace-<date>.json file in the data directory. Open it in chrome://tracing or ui.perfetto.dev." })
+      CMD_EXAMPLES(
+              "/stats",
+              "/stats dump 60",
+              "/stats trace on")
+    },
+
+    { CMD_PREAMBLE("/memory",
+                   parse_args, 0, 2, NULL)
+      CMD_MAINFUNC(cmd_memory)
+      CMD_TAGS(
+              CMD_TAG_UI)
+      CMD_SYN(
+              "/memory",
+              "/memory all",
+              "/memory log <seconds>")
+      CMD_DESC(
+              "Show the approximate memory held by windows, autocompleters, the roster, rooms, the capabilities cache, "
+              "OMEMO stores, pending requests and plugins, largest first. "
+              "Sizes count the data itself, not allocator overhead or memory held by libraries and plugin interpreters.")
+      CMD_ARGS(
+              { "all", "List every entry rather than only the largest." },
+              { "log <seconds>", "Write the total and the largest entries to the log every given seconds, 0 to stop." })
+      CMD_EXAMPLES(
+              "/memory",
+              "/memory log 3600")
+    },
+
     // NEXT-COMMAND (search helper)
 };
 
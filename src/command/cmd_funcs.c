@@ -75,11 +75,15 @@
 #include "event/client_events.h"
 #include "tools/http_upload.h"
 #include "tools/http_download.h"
+#include "tools/http_transfer.h"
 #include "tools/autocomplete.h"
 #include "tools/parser.h"
 #include "tools/plugin_download.h"
 #include "tools/bookmark_ignore.h"
 #include "tools/editor.h"
+#include "tools/memstats.h"
+#include "tools/metrics.h"
+#include "tools/trace.h"
 #include "plugins/plugins.h"
 #include "ui/inputwin.h"
 #include "ui/ui.h"
@@ -4842,46 +4846,6 @@ cmd_disco(ProfWin* window, const char* const command, gchar** args)
     return TRUE;
 }
 
-// TODO: Move this into its own tools such as HTTPUpload or AESGCMDownload.
-#ifdef HAVE_OMEMO
-char*
-_add_omemo_stream(int* fd, FILE** fh, char** err)
-{
-    // Create temporary file for writing ciphertext.
-    int tmpfd;
-    auto_char char* tmpname = NULL;
-    if ((tmpfd = g_file_open_tmp("profanity.XXXXXX", &tmpname, NULL)) == -1) {
-        *err = "Unable to create temporary file for encrypted transfer.";
-        return NULL;
-    }
-    FILE* tmpfh = fdopen(tmpfd, "w+b");
-
-    // The temporary ciphertext file should be removed after it has
-    // been closed.
-    remove(tmpname);
-
-    int crypt_res;
-    char* fragment;
-    fragment = omemo_encrypt_file(*fh, tmpfh, file_size(*fd), &crypt_res);
-    if (crypt_res != 0) {
-        fclose(tmpfh);
-        return NULL;
-    }
-
-    // Force flush as the upload will read from the same stream.
-    fflush(tmpfh);
-    rewind(tmpfh);
-
-    fclose(*fh); // Also closes descriptor.
-
-    // Switch original stream with temporary ciphertext stream.
-    *fd = tmpfd;
-    *fh = tmpfh;
-
-    return fragment;
-}
-#endif
-
 gboolean
 cmd_sendfile(ProfWin* window, const char* const command, gchar** args)
 {
@@ -4951,17 +4915,23 @@ cmd_sendfile(ProfWin* window, const char* const command, gchar** args)
     }
 
     FILE* fh = fdopen(fd, "rb");
+    off_t upload_size = file_size(fd);
+    struct omemo_file_stream_t* omemo_stream = NULL;
 
     if (omemo_enabled) {
 #ifdef HAVE_OMEMO
-        char* err = NULL;
+        // the file is encrypted by the upload worker while it is sent
+        gcry_error_t crypt_res;
         alt_scheme = OMEMO_AESGCM_URL_SCHEME;
-        alt_fragment = _add_omemo_stream(&fd, &fh, &err);
-        if (err != NULL) {
+        omemo_stream = omemo_encrypt_stream_new(fh, upload_size, &alt_fragment, &crypt_res);
+        if (omemo_stream == NULL) {
+            const char* err = "Unable to set up encryption for file transfer.";
             cons_show_error(err);
             win_println(window, THEME_ERROR, "-", err);
+            fclose(fh);
             goto out;
         }
+        upload_size = omemo_encrypt_stream_size(omemo_stream);
 #endif
     }
 
@@ -4970,7 +4940,8 @@ cmd_sendfile(ProfWin* window, const char* const command, gchar** args)
 
     upload->filename = strdup(filename);
     upload->filehandle = fh;
-    upload->filesize = file_size(fd);
+    upload->filesize = upload_size;
+    upload->omemo_stream = omemo_stream;
     upload->mime_type = file_mime_type(filename);
 
     if (alt_scheme != NULL) {
@@ -7190,6 +7161,83 @@ cmd_plugins_python_version(ProfWin* window, const char* const command, gchar** a
     return TRUE;
 }
 
+gboolean
+cmd_plugins_stats(ProfWin* window, const char* const command, gchar** args)
+{
+    if (g_strcmp0(args[1], "reset") == 0) {
+        plugins_reset_hook_stats();
+        cons_show("Plugin hook statistics reset.");
+        return TRUE;
+    }
+
+    if (g_strcmp0(args[1], "threshold") == 0) {
+        if (args[2] == NULL) {
+            cons_bad_cmd_usage(command);
+            return TRUE;
+        }
+        int ms = 0;
+        auto_char char* err_msg = NULL;
+        if (!strtoi_range(args[2], &ms, 0, INT_MAX, &err_msg)) {
+            cons_show(err_msg);
+            return TRUE;
+        }
+        prefs_set_plugins_slow_hook(ms);
+        plugins_set_slow_hook_threshold(ms);
+        if (ms == 0) {
+            cons_show("Slow plugin hook logging disabled.");
+        } else {
+            cons_show("Logging plugin hook calls taking at least %d ms.", ms);
+        }
+        return TRUE;
+    }
+
+    if (args[1] != NULL) {
+        cons_bad_cmd_usage(command);
+        return TRUE;
+    }
+
+    GList* plugins = plugins_loaded_list();
+    if (plugins == NULL) {
+        cons_show("No plugins loaded.");
+        return TRUE;
+    }
+
+    static const char* const bucket_names[PLUGINS_HOOK_BUCKETS] = { "<0.1ms", "<1ms", "<10ms", "<100ms", "<1s", ">=1s" };
+
+    cons_show("Plugin hook statistics (slow call threshold %d ms):", prefs_get_plugins_slow_hook());
+    for (GList* curr = plugins; curr; curr = g_list_next(curr)) {
+        const char* name = curr->data;
+        gboolean shown = FALSE;
+        for (int hook = 0; hook < PROF_HOOK_COUNT; hook++) {
+            const PluginHookStats* stats = plugins_get_hook_stats(name, hook);
+            if (!stats || stats->calls == 0) {
+                continue;
+            }
+            if (!shown) {
+                cons_show("  %s", name);
+                shown = TRUE;
+            }
+            GString* histogram = g_string_new(NULL);
+            for (int i = 0; i < PLUGINS_HOOK_BUCKETS; i++) {
+                if (stats->buckets[i] > 0) {
+                    g_string_append_printf(histogram, " %s:%" G_GUINT64_FORMAT, bucket_names[i], stats->buckets[i]);
+                }
+            }
+            cons_show("    %s: %" G_GUINT64_FORMAT " calls, total %.1f ms, avg %.2f ms, max %.1f ms,%s",
+                      plugins_hook_name(hook), stats->calls,
+                      stats->total_us / 1000.0, stats->total_us / 1000.0 / stats->calls, stats->max_us / 1000.0,
+                      histogram->str);
+            g_string_free(histogram, TRUE);
+        }
+        if (!shown) {
+            cons_show("  %s: no hook calls", name);
+        }
+    }
+    g_list_free(plugins);
+
+    return TRUE;
+}
+
 gboolean
 cmd_plugins(ProfWin* window, const char* const command, gchar** args)
 {
@@ -9446,8 +9494,7 @@ _url_aesgcm_method(ProfWin* window, const char* cmd_template, gchar* url, gchar*
     }
     download->window = window;
 
-    pthread_create(&(download->worker), NULL, &aesgcm_file_get, download);
-    aesgcm_download_add_download(download);
+    aesgcm_file_get(download);
 }
 #endif
 
@@ -9465,8 +9512,8 @@ _download_install_plugin(ProfWin* window, gchar* url, gchar* path)
     download->window = window;
     download->silent = TRUE;
 
-    pthread_create(&(download->worker), NULL, &plugin_download_install, download);
     plugin_download_add_download(download);
+    plugin_download_install(download);
     return TRUE;
 }
 
@@ -9484,8 +9531,8 @@ _url_http_method(ProfWin* window, const char* cmd_template, gchar* url, gchar* p
     download->window = window;
     download->silent = FALSE;
 
-    pthread_create(&(download->worker), NULL, &http_file_get, download);
     http_download_add_download(download);
+    http_file_get(download);
 }
 
 static void
@@ -9587,6 +9634,27 @@ cmd_url_save(ProfWin* window, const char* const command, gchar** args)
     return TRUE;
 }
 
+gboolean
+cmd_url_transfers(ProfWin* window, const char* const command, gchar** args)
+{
+    if (args[1] == NULL) {
+        cons_show("File transfers running at the same time: %d", prefs_get_http_transfers());
+        return TRUE;
+    }
+
+    int count = 0;
+    auto_char char* err_msg = NULL;
+    if (!strtoi_range(args[1], &count, 1, INT_MAX, &err_msg)) {
+        cons_show(err_msg);
+        return TRUE;
+    }
+    prefs_set_http_transfers(count);
+    http_transfer_set_max_active(count);
+    cons_show("Running up to %d file transfers at the same time.", count);
+
+    return TRUE;
+}
+
 gboolean
 _cmd_executable_template(const preference_t setting, const char* command, gchar** args)
 {
@@ -10792,3 +10860,135 @@ cmd_vcard_save(ProfWin* window, const char* const command, gchar** args)
     cons_show("User vCard uploaded");
     return TRUE;
 }
+
+gboolean
+cmd_stats(ProfWin* window, const char* const command, gchar** args)
+{
+    if (g_strcmp0(args[0], "reset") == 0) {
+        metrics_reset();
+        cons_show("Statistics reset.");
+        return TRUE;
+    }
+
+    if (g_strcmp0(args[0], "dump") == 0) {
+        if (args[1] == NULL) {
+            auto_gchar gchar* filename = files_get_data_path(FILE_STATS);
+            if (metrics_dump()) {
+                cons_show("Statistics written to %s", filename);
+            } else {
+                cons_show_error("Could not write statistics to %s", filename);
+            }
+            return TRUE;
+        }
+
+        int seconds = 0;
+        auto_char char* err_msg = NULL;
+        if (!strtoi_range(args[1], &seconds, 0, INT_MAX, &err_msg)) {
+            cons_show(err_msg);
+            return TRUE;
+        }
+        prefs_set_stats_dump(seconds);
+        metrics_set_dump_interval(seconds);
+        if (seconds == 0) {
+            cons_show("Periodic statistics dump disabled.");
+        } else {
+            cons_show("Writing statistics every %d seconds.", seconds);
+        }
+        return TRUE;
+    }
+
+    if (g_strcmp0(args[0], "trace") == 0) {
+        if (g_strcmp0(args[1], "on") == 0) {
+            if (trace_enabled()) {
+                cons_show("Already tracing to %s", trace_get_filename());
+                return TRUE;
+            }
+            GDateTime* now = g_date_time_new_now_local();
+            auto_gchar gchar* date = g_date_time_format(now, "%Y%m%d-%H%M%S");
+            g_date_time_unref(now);
+            auto_gchar gchar* name = g_strdup_printf("trace-%s.json", date);
+            auto_gchar gchar* filename = files_get_data_path(name);
+            if (trace_start(filename)) {
+                cons_show("Tracing to %s, use '/stats trace off' to stop.", filename);
+            } else {
+                cons_show_error("Could not start tracing to %s", filename);
+            }
+        } else if (g_strcmp0(args[1], "off") == 0) {
+            if (!trace_enabled()) {
+                cons_show("Not tracing.");
+                return TRUE;
+            }
+            auto_gchar gchar* filename = g_strdup(trace_get_filename());
+            trace_stop();
+            cons_show("Trace written to %s", filename);
+        } else {
+            cons_bad_cmd_usage(command);
+        }
+        return TRUE;
+    }
+
+    if (args[0] != NULL) {
+        cons_bad_cmd_usage(command);
+        return TRUE;
+    }
+
+    cons_show("%-16s %10s %8s %10s %10s %10s %10s", "", "count", "rate/s", "p50 ms", "p90 ms", "p99 ms", "max ms");
+    for (int i = 0; i < METRIC_COUNT; i++) {
+        MetricSnapshot snapshot;
+        metrics_get(i, &snapshot);
+        cons_show("%-16s %10" G_GUINT64_FORMAT " %8.1f %10.2f %10.2f %10.2f %10.2f", snapshot.name, snapshot.count,
+                  snapshot.rate, snapshot.p50_us / 1000.0, snapshot.p90_us / 1000.0, snapshot.p99_us / 1000.0,
+                  snapshot.max_us / 1000.0);
+    }
+
+    return TRUE;
+}
+
+gboolean
+cmd_memory(ProfWin* window, const char* const command, gchar** args)
+{
+    if (g_strcmp0(args[0], "log") == 0) {
+        int seconds = 0;
+        auto_char char* err_msg = NULL;
+        if (args[1] == NULL) {
+            cons_bad_cmd_usage(command);
+            return TRUE;
+        }
+        if (!strtoi_range(args[1], &seconds, 0, INT_MAX, &err_msg)) {
+            cons_show(err_msg);
+            return TRUE;
+        }
+        prefs_set_memory_log(seconds);
+        memstats_set_log_interval(seconds);
+        if (seconds == 0) {
+            cons_show("Periodic memory log disabled.");
+        } else {
+            cons_show("Logging memory use every %d seconds.", seconds);
+        }
+        return TRUE;
+    }
+
+    guint limit = 20;
+    if (g_strcmp0(args[0], "all") == 0) {
+        limit = G_MAXUINT;
+    } else if (args[0] != NULL) {
+        cons_bad_cmd_usage(command);
+        return TRUE;
+    }
+
+    MemStats* stats = memstats_collect();
+    auto_gchar gchar* total = g_format_size(stats->total);
+    cons_show("Approximate memory use: %s in %u entries", total, stats->entries->len);
+    cons_show("%-48s %10s %8s", "", "size", "items");
+    for (guint i = 0; i < stats->entries->len && i < limit; i++) {
+        MemStatsEntry* entry = g_ptr_array_index(stats->entries, i);
+        auto_gchar gchar* size = g_format_size(entry->bytes);
+        cons_show("%-48s %10s %8u", entry->name, size, entry->items);
+    }
+    if (stats->entries->len > limit) {
+        cons_show("%u smaller entries not shown, use /memory all to list them.", stats->entries->len - limit);
+    }
+    memstats_free(stats);
+
+    return TRUE;
+}
@@ -176,6 +176,7 @@ gboolean cmd_plugins_load(ProfWin* window, const char* const command, gchar** ar
 gboolean cmd_plugins_unload(ProfWin* window, const char* const command, gchar** args);
 gboolean cmd_plugins_reload(ProfWin* window, const char* const command, gchar** args);
 gboolean cmd_plugins_python_version(ProfWin* window, const char* const command, gchar** args);
+gboolean cmd_plugins_stats(ProfWin* window, const char* const command, gchar** args);
 
 gboolean cmd_blocked(ProfWin* window, const char* const command, gchar** args);
 
@@ -247,6 +248,7 @@ gboolean cmd_slashguard(ProfWin* window, const char* const command, gchar** args
 gboolean cmd_serversoftware(ProfWin* window, const char* const command, gchar** args);
 gboolean cmd_url_open(ProfWin* window, const char* const command, gchar** args);
 gboolean cmd_url_save(ProfWin* window, const char* const command, gchar** args);
+gboolean cmd_url_transfers(ProfWin* window, const char* const command, gchar** args);
 gboolean cmd_executable_avatar(ProfWin* window, const char* const command, gchar** args);
 gboolean cmd_executable_urlopen(ProfWin* window, const char* const command, gchar** args);
 gboolean cmd_executable_urlsave(ProfWin* window, const char* const command, gchar** args);
@@ -270,4 +272,7 @@ gboolean cmd_vcard_refresh(ProfWin* window, const char* const command, gchar** a
 gboolean cmd_vcard_set(ProfWin* window, const char* const command, gchar** args);
 gboolean cmd_vcard_save(ProfWin* window, const char* const command, gchar** args);
 
+gboolean cmd_stats(ProfWin* window, const char* const command, gchar** args);
+gboolean cmd_memory(ProfWin* window, const char* const command, gchar** args);
+
 #endif
@@ -37,6 +37,8 @@
 #include "config.h"
 
 #include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
 #include <sys/select.h>
 #include <assert.h>
 #include <stdlib.h>
@@ -45,6 +47,7 @@
 #include <string.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <unistd.h>
 
 #include <curl/curl.h>
 #include <curl/easy.h>
@@ -63,6 +66,7 @@
 #include "log.h"
 #include "common.h"
 #include "config/files.h"
+#include "tools/metrics.h"
 
 #ifdef HAVE_GIT_VERSION
 #include "gitversion.h"
@@ -74,6 +78,21 @@ struct curl_data_t
     size_t size;
 };
 
+typedef struct keyfile_write_t
+{
+    gchar* filename;
+    gchar* data;
+    gsize length;
+} KeyfileWrite;
+
+static GList* dirty_keyfiles;
+static GQueue* keyfile_writes;
+static gboolean keyfile_writer_running;
+static gboolean keyfile_writer_busy;
+static pthread_t keyfile_writer;
+static pthread_mutex_t keyfile_writer_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t keyfile_writer_cond = PTHREAD_COND_INITIALIZER;
+
 static size_t _data_callback(void* ptr, size_t size, size_t nmemb, void* data);
 static gchar* _get_file_or_linked(gchar* loc);
 
@@ -196,6 +215,7 @@ gboolean
 load_custom_keyfile(prof_keyfile_t* keyfile, gchar* filename)
 {
     keyfile->filename = filename;
+    keyfile->dirty_since = 0;
 
     if (g_file_test(keyfile->filename, G_FILE_TEST_EXISTS)) {
         g_chmod(keyfile->filename, S_IRUSR | S_IWUSR);
@@ -204,23 +224,224 @@ load_custom_keyfile(prof_keyfile_t* keyfile, gchar* filename)
     return _load_keyfile(keyfile);
 }
 
-gboolean
-save_keyfile(prof_keyfile_t* keyfile)
+/*
+ * Write the data to a temporary file next to the target and rename it over
+ * the target, so a crash never leaves a truncated keyfile behind.
+ */
+static gboolean
+_keyfile_write_file(const gchar* filename, const gchar* data, gsize length)
 {
-    GError* error = NULL;
-    if (!g_key_file_save_to_file(keyfile->keyfile, keyfile->filename, &error)) {
-        log_error("[Keyfile]: saving file %s failed! %s", keyfile->filename, error->message);
-        g_error_free(error);
+    auto_gchar gchar* tmpname = g_strdup_printf("%s.XXXXXX", filename);
+    gint fd = g_mkstemp_full(tmpname, O_WRONLY | O_CLOEXEC, S_IRUSR | S_IWUSR);
+    if (fd == -1) {
+        log_error("[Keyfile]: creating temporary file for %s failed! %s", filename, g_strerror(errno));
         return FALSE;
     }
-    g_chmod(keyfile->filename, S_IRUSR | S_IWUSR);
+
+    gsize written = 0;
+    while (written < length) {
+        ssize_t res = write(fd, data + written, length - written);
+        if (res < 0 && errno == EINTR) {
+            continue;
+        }
+        if (res < 0) {
+            log_error("[Keyfile]: writing file %s failed! %s", filename, g_strerror(errno));
+            close(fd);
+            g_unlink(tmpname);
+            return FALSE;
+        }
+        written += res;
+    }
+
+    if (fsync(fd) != 0 || close(fd) != 0) {
+        log_error("[Keyfile]: syncing file %s failed! %s", filename, g_strerror(errno));
+        g_unlink(tmpname);
+        return FALSE;
+    }
+
+    if (g_rename(tmpname, filename) != 0) {
+        log_error("[Keyfile]: saving file %s failed! %s", filename, g_strerror(errno));
+        g_unlink(tmpname);
+        return FALSE;
+    }
+
     return TRUE;
 }
 
+static gboolean
+_keyfile_write_atomic(const gchar* filename, const gchar* data, gsize length)
+{
+    gint64 start = metrics_start();
+    gboolean res = _keyfile_write_file(filename, data, length);
+    metrics_record(METRIC_KEYFILE_SAVE, start);
+
+    return res;
+}
+
+static void
+_keyfile_write_free(KeyfileWrite* job)
+{
+    if (job) {
+        g_free(job->filename);
+        g_free(job->data);
+        free(job);
+    }
+}
+
+static void*
+_keyfile_writer_run(void* userdata)
+{
+    pthread_mutex_lock(&keyfile_writer_lock);
+    while (TRUE) {
+        while (g_queue_is_empty(keyfile_writes)) {
+            pthread_cond_wait(&keyfile_writer_cond, &keyfile_writer_lock);
+        }
+        KeyfileWrite* job = g_queue_pop_head(keyfile_writes);
+        keyfile_writer_busy = TRUE;
+        pthread_mutex_unlock(&keyfile_writer_lock);
+
+        _keyfile_write_atomic(job->filename, job->data, job->length);
+        _keyfile_write_free(job);
+
+        pthread_mutex_lock(&keyfile_writer_lock);
+        keyfile_writer_busy = FALSE;
+        pthread_cond_broadcast(&keyfile_writer_cond);
+    }
+
+    return NULL;
+}
+
+// block until every queued job has hit the disk
+static void
+_keyfile_writer_wait(void)
+{
+    if (!keyfile_writer_running) {
+        return;
+    }
+
+    pthread_mutex_lock(&keyfile_writer_lock);
+    while (!g_queue_is_empty(keyfile_writes) || keyfile_writer_busy) {
+        pthread_cond_wait(&keyfile_writer_cond, &keyfile_writer_lock);
+    }
+    pthread_mutex_unlock(&keyfile_writer_lock);
+}
+
+// serialize on the calling thread, GKeyFile is not thread safe, and hand the data to the writer
+static void
+_keyfile_queue_write(prof_keyfile_t* keyfile)
+{
+    KeyfileWrite* job = malloc(sizeof(KeyfileWrite));
+    job->filename = g_strdup(keyfile->filename);
+    job->data = g_key_file_to_data(keyfile->keyfile, &job->length, NULL);
+
+    pthread_mutex_lock(&keyfile_writer_lock);
+    if (!keyfile_writer_running) {
+        keyfile_writes = g_queue_new();
+        if (pthread_create(&keyfile_writer, NULL, _keyfile_writer_run, NULL) != 0) {
+            pthread_mutex_unlock(&keyfile_writer_lock);
+            log_error("[Keyfile]: could not start writer thread, saving %s synchronously", keyfile->filename);
+            g_queue_free(keyfile_writes);
+            keyfile_writes = NULL;
+            _keyfile_write_atomic(job->filename, job->data, job->length);
+            _keyfile_write_free(job);
+            return;
+        }
+        pthread_detach(keyfile_writer);
+        keyfile_writer_running = TRUE;
+    }
+    g_queue_push_tail(keyfile_writes, job);
+    pthread_cond_broadcast(&keyfile_writer_cond);
+    pthread_mutex_unlock(&keyfile_writer_lock);
+}
+
+gboolean
+save_keyfile(prof_keyfile_t* keyfile)
+{
+    dirty_keyfiles = g_list_remove(dirty_keyfiles, keyfile);
+    keyfile->dirty_since = 0;
+
+    // older deferred writes of the same file must not land after this one
+    _keyfile_writer_wait();
+
+    gsize length = 0;
+    auto_gchar gchar* data = g_key_file_to_data(keyfile->keyfile, &length, NULL);
+    return _keyfile_write_atomic(keyfile->filename, data, length);
+}
+
+/**
+ * Mark the keyfile as modified. It is written by a background thread once it
+ * has been left alone for KEYFILE_SAVE_DEBOUNCE_MS, so a burst of mutations
+ * results in a single write. A keyfile that keeps changing is written after
+ * KEYFILE_SAVE_MAX_DELAY_MS at the latest.
+ *
+ * Every exit through exit() runs the shutdown routines, whose free_keyfile()
+ * writes what is still dirty. There is no fatal signal handler, writing a
+ * keyfile is not async-signal-safe, so a crash or a kill by signal loses the
+ * changes of the last KEYFILE_SAVE_MAX_DELAY_MS. Use save_keyfile() for data
+ * that must not be lost that way.
+ *
+ * @param keyfile The keyfile to persist.
+ */
+void
+save_keyfile_deferred(prof_keyfile_t* keyfile)
+{
+    save_keyfile_deferred_at(keyfile, g_get_monotonic_time());
+}
+
+void
+save_keyfile_deferred_at(prof_keyfile_t* keyfile, gint64 now)
+{
+    if (keyfile->dirty_since == 0) {
+        dirty_keyfiles = g_list_append(dirty_keyfiles, keyfile);
+        keyfile->dirty_since = now;
+    }
+    keyfile->changed_at = now;
+}
+
+/**
+ * Hand keyfiles that were left alone for the debounce window, or that stayed
+ * dirty for the maximum delay, to the writer thread.
+ *
+ * @param force Write all dirty keyfiles and wait until they are on disk.
+ */
+void
+flush_keyfiles(gboolean force)
+{
+    flush_keyfiles_at(force, g_get_monotonic_time());
+}
+
+void
+flush_keyfiles_at(gboolean force, gint64 now)
+{
+    GList* curr = dirty_keyfiles;
+    while (curr) {
+        GList* next = g_list_next(curr);
+        prof_keyfile_t* keyfile = curr->data;
+        if (force || (now - keyfile->changed_at) >= KEYFILE_SAVE_DEBOUNCE_MS * 1000
+            || (now - keyfile->dirty_since) >= KEYFILE_SAVE_MAX_DELAY_MS * 1000) {
+            dirty_keyfiles = g_list_delete_link(dirty_keyfiles, curr);
+            keyfile->dirty_since = 0;
+            _keyfile_queue_write(keyfile);
+        }
+        curr = next;
+    }
+
+    if (force) {
+        _keyfile_writer_wait();
+    }
+}
+
 void
 free_keyfile(prof_keyfile_t* keyfile)
 {
     log_debug("[Keyfile]: free %s", STR_MAYBE_NULL(keyfile->filename));
+    if (keyfile->dirty_since != 0 && keyfile->keyfile) {
+        save_keyfile(keyfile);
+    } else {
+        _keyfile_writer_wait();
+    }
+    dirty_keyfiles = g_list_remove(dirty_keyfiles, keyfile);
+    keyfile->dirty_since = 0;
     if (keyfile->keyfile)
         g_key_file_free(keyfile->keyfile);
     keyfile->keyfile = NULL;
@@ -506,39 +727,51 @@ is_notify_enabled(void)
     return notify_enabled;
 }
 
+static gboolean
+_is_whole_word(const char* const haystack, const char* const match, size_t match_len)
+{
+    gunichar before = 0;
+    gchar* haystack_before_ch = g_utf8_find_prev_char(haystack, match);
+    if (haystack_before_ch) {
+        before = g_utf8_get_char(haystack_before_ch);
+    }
+
+    gunichar after = 0;
+    const gchar* haystack_after_ch = match + match_len;
+    if (haystack_after_ch[0] != '\0') {
+        after = g_utf8_get_char(haystack_after_ch);
+    }
+
+    return !g_unichar_isalnum(before) && !g_unichar_isalnum(after);
+}
+
 GSList*
 prof_occurrences(const char* const needle, const char* const haystack, int offset, gboolean whole_word, GSList** result)
 {
-    if (needle == NULL || haystack == NULL) {
+    if (needle == NULL || haystack == NULL || needle[0] == '\0') {
         return *result;
     }
 
-    do {
-        gchar* haystack_curr = g_utf8_offset_to_pointer(haystack, offset);
-        if (g_str_has_prefix(haystack_curr, needle)) {
-            if (whole_word) {
-                gunichar before = 0;
-                gchar* haystack_before_ch = g_utf8_find_prev_char(haystack, haystack_curr);
-                if (haystack_before_ch) {
-                    before = g_utf8_get_char(haystack_before_ch);
-                }
-
-                gunichar after = 0;
-                gchar* haystack_after_ch = haystack_curr + strlen(needle);
-                if (haystack_after_ch[0] != '\0') {
-                    after = g_utf8_get_char(haystack_after_ch);
-                }
-
-                if (!g_unichar_isalnum(before) && !g_unichar_isalnum(after)) {
-                    *result = g_slist_append(*result, GINT_TO_POINTER(offset));
-                }
-            } else {
-                *result = g_slist_append(*result, GINT_TO_POINTER(offset));
-            }
+    // Single pass over the haystack: jump from match to match with strstr() and
+    // only count the characters in between to keep the offset up to date.
+    // UTF-8 is self-synchronising so a match always starts on a character.
+    size_t needle_len = strlen(needle);
+    GSList* found = NULL;
+    const gchar* curr = g_utf8_offset_to_pointer(haystack, offset);
+    const gchar* match;
+
+    while ((match = strstr(curr, needle)) != NULL) {
+        offset += g_utf8_strlen(curr, match - curr);
+        if (!whole_word || _is_whole_word(haystack, match, needle_len)) {
+            found = g_slist_prepend(found, GINT_TO_POINTER(offset));
         }
 
+        // overlapping occurrences are reported too, continue with the next character
+        curr = g_utf8_next_char(match);
         offset++;
-    } while (g_strcmp0(g_utf8_offset_to_pointer(haystack, offset), "\0") != 0);
+    }
+
+    *result = g_slist_concat(*result, g_slist_reverse(found));
 
     return *result;
 }
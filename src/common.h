@@ -118,10 +118,18 @@ void auto_close_FILE(FILE** fd);
 #define STR_MAYBE_NULL(p) (p)
 #endif
 
+// time a keyfile must stay unchanged before the write-behind thread persists it
+#define KEYFILE_SAVE_DEBOUNCE_MS 2000
+// time a keyfile that keeps changing may stay dirty before it is persisted anyway
+#define KEYFILE_SAVE_MAX_DELAY_MS 10000
+
 typedef struct prof_keyfile_t
 {
     gchar* filename;
     GKeyFile* keyfile;
+    // first change since the last write, 0 when clean
+    gint64 dirty_since;
+    gint64 changed_at;
 } prof_keyfile_t;
 
 gboolean
@@ -133,6 +141,14 @@ load_custom_keyfile(prof_keyfile_t* keyfile, gchar* filename);
 gboolean
 save_keyfile(prof_keyfile_t* keyfile);
 void
+save_keyfile_deferred(prof_keyfile_t* keyfile);
+void
+save_keyfile_deferred_at(prof_keyfile_t* keyfile, gint64 now);
+void
+flush_keyfiles(gboolean force);
+void
+flush_keyfiles_at(gboolean force, gint64 now);
+void
 free_keyfile(prof_keyfile_t* keyfile);
 
 /* Our own define of MB_CUR_MAX but this time at compile time */
@@ -957,5 +957,5 @@ accounts_get_login_status(const char* const account_name)
 static void
 _save_accounts(void)
 {
-    save_keyfile(&accounts_prof_keyfile);
+    save_keyfile_deferred(&accounts_prof_keyfile);
 }
@@ -47,6 +47,7 @@
 #define FILE_CAPSCACHE                "capscache"
 #define FILE_PROFANITY_IDENTIFIER     "profident"
 #define FILE_BOOKMARK_AUTOJOIN_IGNORE "bookmark_ignore"
+#define FILE_STATS                    "stats"
 
 #define DIR_THEMES    "themes"
 #define DIR_ICONS     "icons"
@@ -47,6 +47,7 @@
 #include "log.h"
 #include "preferences.h"
 #include "tools/autocomplete.h"
+#include "tools/trigger_matcher.h"
 #include "config/files.h"
 #include "config/conflists.h"
 
@@ -68,6 +69,8 @@
 #define PREF_GROUP_EXECUTABLES   "executables"
 
 #define INPBLOCK_DEFAULT 1000
+#define PLUGINS_SLOW_HOOK_DEFAULT 100
+#define HTTP_TRANSFERS_DEFAULT    4
 
 static prof_keyfile_t prefs_prof_keyfile;
 static GKeyFile* prefs;
@@ -75,6 +78,8 @@ gint log_maxsize = 0;
 
 static Autocomplete boolean_choice_ac;
 static Autocomplete room_trigger_ac;
+static gchar** room_triggers;
+static TriggerMatcher* room_trigger_matcher;
 
 static void _save_prefs(void);
 static const char* _get_group(preference_t pref);
@@ -82,6 +87,19 @@ static const char* _get_key(preference_t pref);
 static gboolean _get_default_boolean(preference_t pref);
 static char* _get_default_string(preference_t pref);
 
+/* Room triggers are matched against every incoming room message, compile
+ * them once whenever the list changes instead of on each message. */
+static void
+_compile_room_triggers(void)
+{
+    trigger_matcher_free(room_trigger_matcher);
+    g_strfreev(room_triggers);
+
+    gsize len = 0;
+    room_triggers = g_key_file_get_string_list(prefs, PREF_GROUP_NOTIFICATIONS, "room.trigger.list", &len, NULL);
+    room_trigger_matcher = len > 0 ? trigger_matcher_new(room_triggers, len) : NULL;
+}
+
 static void
 _prefs_load(void)
 {
@@ -255,6 +273,8 @@ _prefs_load(void)
     for (int i = 0; i < len; i++) {
         autocomplete_add(room_trigger_ac, triggers[i]);
     }
+
+    _compile_room_triggers();
 }
 
 /* Clean up after _prefs_load() */
@@ -263,6 +283,10 @@ _prefs_close(void)
 {
     autocomplete_free(boolean_choice_ac);
     autocomplete_free(room_trigger_ac);
+    trigger_matcher_free(room_trigger_matcher);
+    room_trigger_matcher = NULL;
+    g_strfreev(room_triggers);
+    room_triggers = NULL;
 }
 
 void
@@ -289,7 +313,7 @@ prefs_load(const char* config_file)
 void
 prefs_save(void)
 {
-    _save_prefs();
+    save_keyfile(&prefs_prof_keyfile);
 }
 
 void
@@ -339,21 +363,33 @@ prefs_do_chat_notify(gboolean current_win)
     }
 }
 
+TriggerMatcher*
+prefs_get_room_trigger_matcher(void)
+{
+    return room_trigger_matcher;
+}
+
 GList*
-prefs_message_get_triggers(const char* const message)
+prefs_room_triggers_from_matches(GArray* matches)
 {
-    GList* result = NULL;
+    if (!room_trigger_matcher || matches->len == 0) {
+        return NULL;
+    }
 
-    auto_gchar gchar* message_lower = g_utf8_strdown(message, -1);
-    gsize len = 0;
-    auto_gcharv gchar** triggers = g_key_file_get_string_list(prefs, PREF_GROUP_NOTIFICATIONS, "room.trigger.list", &len, NULL);
+    guint count = g_strv_length(room_triggers);
+    gboolean* found = g_new0(gboolean, count);
+    for (guint i = 0; i < matches->len; i++) {
+        found[g_array_index(matches, TriggerMatch, i).pattern] = TRUE;
+    }
 
-    for (int i = 0; i < len; i++) {
-        auto_gchar gchar* trigger_lower = g_utf8_strdown(triggers[i], -1);
-        if (g_strrstr(message_lower, trigger_lower)) {
-            result = g_list_append(result, strdup(triggers[i]));
+    // report in configured order
+    GList* result = NULL;
+    for (guint i = 0; i < count; i++) {
+        if (found[i]) {
+            result = g_list_append(result, strdup(room_triggers[i]));
         }
     }
+    g_free(found);
 
     return result;
 }
@@ -896,6 +932,62 @@ prefs_remove_plugin(const char* const name)
     _save_prefs();
 }
 
+gint
+prefs_get_stats_dump(void)
+{
+    return g_key_file_get_integer(prefs, PREF_GROUP_LOGGING, "stats.dump", NULL);
+}
+
+void
+prefs_set_stats_dump(gint value)
+{
+    g_key_file_set_integer(prefs, PREF_GROUP_LOGGING, "stats.dump", value);
+}
+
+gint
+prefs_get_memory_log(void)
+{
+    return g_key_file_get_integer(prefs, PREF_GROUP_LOGGING, "memory.log", NULL);
+}
+
+void
+prefs_set_memory_log(gint value)
+{
+    g_key_file_set_integer(prefs, PREF_GROUP_LOGGING, "memory.log", value);
+}
+
+gint
+prefs_get_plugins_slow_hook(void)
+{
+    if (!g_key_file_has_key(prefs, PREF_GROUP_PLUGINS, "slowhook", NULL)) {
+        return PLUGINS_SLOW_HOOK_DEFAULT;
+    }
+
+    return g_key_file_get_integer(prefs, PREF_GROUP_PLUGINS, "slowhook", NULL);
+}
+
+void
+prefs_set_plugins_slow_hook(gint value)
+{
+    g_key_file_set_integer(prefs, PREF_GROUP_PLUGINS, "slowhook", value);
+}
+
+gint
+prefs_get_http_transfers(void)
+{
+    if (!g_key_file_has_key(prefs, PREF_GROUP_CONNECTION, "http.transfers", NULL)) {
+        return HTTP_TRANSFERS_DEFAULT;
+    }
+
+    return g_key_file_get_integer(prefs, PREF_GROUP_CONNECTION, "http.transfers", NULL);
+}
+
+void
+prefs_set_http_transfers(gint value)
+{
+    g_key_file_set_integer(prefs, PREF_GROUP_CONNECTION, "http.transfers", value);
+}
+
 void
 prefs_set_occupants_size(gint value)
 {
@@ -1297,6 +1389,7 @@ prefs_add_room_notify_trigger(const char* const text)
 
     if (res) {
         autocomplete_add(room_trigger_ac, text);
+        _compile_room_triggers();
     }
 
     return res;
@@ -1310,6 +1403,7 @@ prefs_remove_room_notify_trigger(const char* const text)
 
     if (res) {
         autocomplete_remove(room_trigger_ac, text);
+        _compile_room_triggers();
     }
 
     return res;
@@ -1703,7 +1797,7 @@ prefs_free_aliases(GList* aliases)
 static void
 _save_prefs(void)
 {
-    save_keyfile(&prefs_prof_keyfile);
+    save_keyfile_deferred(&prefs_prof_keyfile);
 }
 
 // get the preference group for a specific preference
@@ -41,6 +41,8 @@
 
 #include <glib.h>
 
+#include "tools/trigger_matcher.h"
+
 #define PREFS_MIN_LOG_SIZE 64
 #define PREFS_MAX_LOG_SIZE (10 * 1024 * 1024)
 
@@ -250,6 +252,14 @@ void prefs_set_autoxa_time(gint value);
 gchar** prefs_get_plugins(void);
 void prefs_add_plugin(const char* const name);
 void prefs_remove_plugin(const char* const name);
+gint prefs_get_stats_dump(void);
+void prefs_set_stats_dump(gint value);
+gint prefs_get_memory_log(void);
+void prefs_set_memory_log(gint value);
+gint prefs_get_plugins_slow_hook(void);
+void prefs_set_plugins_slow_hook(gint value);
+gint prefs_get_http_transfers(void);
+void prefs_set_http_transfers(gint value);
 
 gchar* prefs_get_otr_char(void);
 gboolean prefs_set_otr_char(char* ch);
@@ -341,7 +351,8 @@ gboolean prefs_do_chat_notify(gboolean current_win);
 gboolean prefs_do_room_notify(gboolean current_win, const char* const roomjid, const char* const mynick,
                               const char* const theirnick, const char* const message, gboolean mention, gboolean trigger_found);
 gboolean prefs_do_room_notify_mention(const char* const roomjid, int unread, gboolean mention, gboolean trigger);
-GList* prefs_message_get_triggers(const char* const message);
+TriggerMatcher* prefs_get_room_trigger_matcher(void);
+GList* prefs_room_triggers_from_matches(GArray* matches);
 
 void prefs_set_room_notify(const char* const roomjid, gboolean value);
 void prefs_set_room_notify_mention(const char* const roomjid, gboolean value);
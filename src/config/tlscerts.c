@@ -374,5 +374,5 @@ tlscerts_free(TLSCertificate* cert)
 static void
 _save_tlscerts(void)
 {
-    save_keyfile(&tlscerts_prof_keyfile);
+    save_keyfile_deferred(&tlscerts_prof_keyfile);
 }
@@ -49,6 +49,7 @@
 #include "config/files.h"
 #include "database.h"
 #include "config/preferences.h"
+#include "tools/metrics.h"
 #include "ui/ui.h"
 #include "xmpp/xmpp.h"
 #include "xmpp/message.h"
@@ -56,6 +57,7 @@
 static sqlite3* g_chatlog_database;
 
 static void _add_to_db(ProfMessage* message, char* type, const Jid* const from_jid, const Jid* const to_jid);
+static void _write_to_db(ProfMessage* message, char* type, const Jid* const from_jid, const Jid* const to_jid);
 static char* _get_db_filename(ProfAccount* account);
 static prof_msg_type_t _get_message_type_type(const char* const type);
 static prof_enc_t _get_message_enc_type(const char* const encstr);
@@ -65,12 +67,6 @@ static gboolean _check_available_space_for_db_migration(char* path_to_db);
 
 static const int latest_version = 2;
 
-static char*
-_db_strdup(const char* str)
-{
-    return str ? strdup(str) : NULL;
-}
-
 #define auto_sqlite __attribute__((__cleanup__(auto_free_sqlite)))
 
 static void
@@ -244,10 +240,10 @@ _log_database_add_outgoing(char* type, const char* const id, const char* const b
 {
     ProfMessage* msg = message_init();
 
-    msg->id = _db_strdup(id);
+    msg->id = message_strdup(msg, id);
     msg->from_jid = jid_create(barejid);
-    msg->plain = _db_strdup(message);
-    msg->replace_id = _db_strdup(replace_id);
+    msg->plain = message_strdup(msg, message);
+    msg->replace_id = message_strdup(msg, replace_id);
     msg->timestamp = g_date_time_new_now_local(); // TODO: get from outside. best to have whole ProfMessage from outside
     msg->enc = enc;
 
@@ -307,7 +303,7 @@ log_database_get_limits_info(const gchar* const contact_barejid, gboolean is_las
         char* archive_id = (char*)sqlite3_column_text(stmt, 0);
         char* date = (char*)sqlite3_column_text(stmt, 1);
 
-        msg->stanzaid = _db_strdup(archive_id);
+        msg->stanzaid = message_strdup(msg, archive_id);
         msg->timestamp = g_date_time_new_from_iso8601(date, NULL);
     }
     sqlite3_finalize(stmt);
@@ -357,6 +353,8 @@ log_database_get_previous_chat(const gchar* const contact_barejid, const char* s
     }
 
     GSList* history = NULL;
+    // the whole page shares one arena, each message holds a reference
+    Arena* arena = arena_new(16 * 1024);
 
     while (sqlite3_step(stmt) == SQLITE_ROW) {
         char* message = (char*)sqlite3_column_text(stmt, 0);
@@ -369,20 +367,21 @@ log_database_get_previous_chat(const gchar* const contact_barejid, const char* s
         char* encryption = (char*)sqlite3_column_text(stmt, 7);
         char* id = (char*)sqlite3_column_text(stmt, 8);
 
-        ProfMessage* msg = message_init();
-        msg->id = id ? strdup(id) : NULL;
+        ProfMessage* msg = message_init_in(arena);
+        msg->id = message_strdup(msg, id);
         msg->from_jid = jid_create_from_bare_and_resource(from_jid, from_resource);
         msg->to_jid = jid_create_from_bare_and_resource(to_jid, to_resource);
-        msg->plain = strdup(message ?: "");
+        msg->plain = message_strdup(msg, message ?: "");
         msg->timestamp = g_date_time_new_from_iso8601(date, NULL);
         msg->type = _get_message_type_type(type);
         msg->enc = _get_message_enc_type(encryption);
 
-        history = g_slist_append(history, msg);
+        history = g_slist_prepend(history, msg);
     }
     sqlite3_finalize(stmt);
+    arena_unref(arena);
 
-    return history;
+    return g_slist_reverse(history);
 }
 
 static const char*
@@ -452,6 +451,14 @@ _get_message_enc_type(const char* const encstr)
 
 static void
 _add_to_db(ProfMessage* message, char* type, const Jid* const from_jid, const Jid* const to_jid)
+{
+    gint64 start = metrics_start();
+    _write_to_db(message, type, from_jid, to_jid);
+    metrics_record(METRIC_DB_ADD, start);
+}
+
+static void
+_write_to_db(ProfMessage* message, char* type, const Jid* const from_jid, const Jid* const to_jid)
 {
     auto_gchar gchar* pref_dblog = prefs_get_string(PREF_DBLOG);
     sqlite_int64 original_message_id = -1;
@@ -459,10 +466,7 @@ _add_to_db(ProfMessage* message, char* type, const Jid* const from_jid, const Ji
     if (g_strcmp0(pref_dblog, "off") == 0) {
         return;
     } else if (g_strcmp0(pref_dblog, "redact") == 0) {
-        if (message->plain) {
-            free(message->plain);
-        }
-        message->plain = strdup("[REDACTED]");
+        message_set_plain(message, message_strdup(message, "[REDACTED]"));
     }
 
     if (!g_chatlog_database) {
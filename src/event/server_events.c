@@ -349,14 +349,13 @@ sv_ev_room_message(ProfMessage* message)
     if (plugin_msg)
         message->plain = plugin_msg;
 
-    GSList* mentions = get_mentions(prefs_get_boolean(PREF_NOTIFY_MENTION_WHOLE_WORD), prefs_get_boolean(PREF_NOTIFY_MENTION_CASE_SENSITIVE), message->plain, mynick);
-    gboolean mention = g_slist_length(mentions) > 0;
-    GList* triggers = prefs_message_get_triggers(message->plain);
-
     _clean_incoming_message(message);
-    mucwin_incoming_msg(mucwin, message, mentions, triggers, TRUE);
 
-    g_slist_free(mentions);
+    MessageAnnotations* annotations = message_annotate(message->plain, mynick);
+    gboolean mention = annotations->mentions != NULL;
+    GList* triggers = annotations->triggers;
+
+    mucwin_incoming_msg(mucwin, message, annotations, TRUE);
 
     ProfWin* window = (ProfWin*)mucwin;
     int num = wins_get_num(window);
@@ -381,7 +380,7 @@ sv_ev_room_message(ProfMessage* message)
 
         cons_show_incoming_room_message(message->from_jid->resourcepart, mucwin->roomjid, num, mention, triggers, mucwin->unread, window);
 
-        mucwin->unread++;
+        wins_add_unread(window);
 
         if (mention) {
             mucwin->unread_mentions = TRUE;
@@ -404,9 +403,7 @@ sv_ev_room_message(ProfMessage* message)
         }
     }
 
-    if (triggers) {
-        g_list_free_full(triggers, free);
-    }
+    message_annotations_free(annotations);
 
     rosterwin_roster();
 
@@ -477,13 +474,13 @@ sv_ev_outgoing_carbon(ProfMessage* message)
                 return;
             }
             message->enc = PROF_MSG_ENC_NONE;
-            message->plain = strdup(message->body);
+            message->plain = message_strdup(message, message->body);
             chatwin_outgoing_carbon(chatwin, message);
         }
 #endif
     } else {
         message->enc = PROF_MSG_ENC_NONE;
-        message->plain = strdup(message->body);
+        message->plain = message_strdup(message, message->body);
         chatwin_outgoing_carbon(chatwin, message);
     }
 
@@ -521,7 +518,7 @@ _sv_ev_incoming_pgp(ProfChatWin* chatwin, gboolean new_win, ProfMessage* message
             return;
         }
         message->enc = PROF_MSG_ENC_NONE;
-        message->plain = strdup(message->body);
+        message->plain = message_strdup(message, message->body);
         _clean_incoming_message(message);
         chatwin_incoming_msg(chatwin, message, new_win);
         log_database_add_incoming(message);
@@ -540,7 +537,7 @@ _sv_ev_incoming_ox(ProfChatWin* chatwin, gboolean new_win, ProfMessage* message,
             log_error("Couldn't decrypt OX message and body was empty");
             return;
         }
-        message->plain = strdup(message->body);
+        message->plain = message_strdup(message, message->body);
     }
 
     //_clean_incoming_message(message);
@@ -602,7 +599,7 @@ _sv_ev_incoming_plain(ProfChatWin* chatwin, gboolean new_win, ProfMessage* messa
 {
     if (message->body) {
         message->enc = PROF_MSG_ENC_NONE;
-        message->plain = strdup(message->body);
+        message->plain = message_strdup(message, message->body);
         _clean_incoming_message(message);
         chatwin_incoming_msg(chatwin, message, new_win);
         log_database_add_incoming(message);
@@ -1312,8 +1309,7 @@ _cut(ProfMessage* message, const char* cut)
 {
     if (strstr(message->plain, cut)) {
         auto_gcharv gchar** split = g_strsplit(message->plain, cut, -1);
-        free(message->plain);
-        message->plain = g_strjoinv("", split);
+        message_set_plain(message, g_strjoinv("", split));
     }
 }
 
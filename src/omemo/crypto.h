@@ -41,6 +41,8 @@
 #define AES128_GCM_IV_LENGTH  12
 #define AES128_GCM_TAG_LENGTH 16
 
+#define AES256_GCM_TAG_LENGTH 16
+
 int omemo_crypto_init(void);
 /**
  * Callback for a secure random number generator.
@@ -184,8 +186,15 @@ int aes128gcm_decrypt(unsigned char* plaintext,
                       size_t ciphertext_len, const unsigned char* const iv, size_t iv_len,
                       const unsigned char* const key, const unsigned char* const tag);
 
-gcry_error_t aes256gcm_crypt_file(FILE* in, FILE* out, off_t file_size,
-                                  unsigned char key[], unsigned char nonce[], bool encrypt);
+/**
+ * Open an AES-256-GCM cipher handle for incremental encryption or decryption
+ * with gcry_cipher_encrypt()/gcry_cipher_decrypt(). All but the last chunk
+ * passed to it must be a multiple of the block size.
+ *
+ * @param hd the opened handle, to be closed with gcry_cipher_close()
+ * @return GPG_ERR_NO_ERROR on success
+ */
+gcry_error_t aes256gcm_stream_open(gcry_cipher_hd_t* hd, unsigned char key[], unsigned char nonce[]);
 
 char* aes256gcm_create_secure_fragment(unsigned char* key,
                                        unsigned char* nonce);
@@ -0,0 +1,282 @@
+/*
+ * file_stream.c
+ * vim: expandtab:ts=4:sts=4:sw=4
+ *
+ * This file is part of Profanity.
+ *
+ * Profanity is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Profanity is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Profanity.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link the code of portions of this program with the OpenSSL library under
+ * certain conditions as described in each individual source file, and
+ * distribute linked combinations including the two.
+ *
+ * You must obey the GNU General Public License in all respects for all of the
+ * code used other than OpenSSL. If you modify file(s) with this exception, you
+ * may extend this exception to your version of the file(s), but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version. If you delete this exception statement from all
+ * source files in the program, then also delete it here.
+ *
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <string.h>
+
+#include <glib.h>
+#include <gcrypt.h>
+
+#include "log.h"
+#include "omemo/crypto.h"
+#include "omemo/omemo.h"
+#include "omemo/file_stream.h"
+
+// a multiple of the AES block size, only the last chunk may be shorter
+#define OMEMO_AESGCM_BLOCK_LENGTH    16
+#define OMEMO_FILE_STREAM_CHUNK_SIZE 16384
+
+struct omemo_file_stream_t
+{
+    gcry_cipher_hd_t hd;
+    FILE* in;
+    off_t remaining;
+    off_t size;
+    unsigned char buffer[OMEMO_FILE_STREAM_CHUNK_SIZE + AES256_GCM_TAG_LENGTH];
+    size_t pos;
+    size_t len;
+    gboolean finished;
+};
+
+OmemoFileStream*
+omemo_encrypt_stream_new(FILE* in, off_t file_size, char** fragment, gcry_error_t* gcry_res)
+{
+    *fragment = NULL;
+
+    unsigned char* key = gcry_random_bytes_secure(
+        OMEMO_AESGCM_KEY_LENGTH,
+        GCRY_VERY_STRONG_RANDOM);
+
+    // Create nonce/IV with random bytes.
+    unsigned char nonce[OMEMO_AESGCM_NONCE_LENGTH];
+    gcry_create_nonce(nonce, OMEMO_AESGCM_NONCE_LENGTH);
+
+    OmemoFileStream* stream = g_new0(OmemoFileStream, 1);
+    *gcry_res = aes256gcm_stream_open(&stream->hd, key, nonce);
+    if (*gcry_res != GPG_ERR_NO_ERROR) {
+        gcry_free(key);
+        g_free(stream);
+        return NULL;
+    }
+
+    *fragment = aes256gcm_create_secure_fragment(key, nonce);
+    gcry_free(key);
+
+    stream->in = in;
+    stream->remaining = file_size;
+    stream->size = file_size + AES256_GCM_TAG_LENGTH;
+
+    return stream;
+}
+
+off_t
+omemo_encrypt_stream_size(OmemoFileStream* stream)
+{
+    return stream->size;
+}
+
+// encrypt the next chunk of the file, appending the tag after the last one
+static gcry_error_t
+_encrypt_stream_fill(OmemoFileStream* stream)
+{
+    size_t want = MIN(stream->remaining, OMEMO_FILE_STREAM_CHUNK_SIZE);
+    size_t got = want > 0 ? fread(stream->buffer, 1, want, stream->in) : 0;
+    if (got != want) {
+        return gcry_error_from_errno(ferror(stream->in) ? errno : EIO);
+    }
+    stream->remaining -= got;
+
+    gcry_error_t res;
+    if (stream->remaining == 0) {
+        gcry_cipher_final(stream->hd); // Signal last round of bytes.
+    }
+    res = gcry_cipher_encrypt(stream->hd, stream->buffer, got, NULL, 0);
+    if (res != GPG_ERR_NO_ERROR) {
+        return res;
+    }
+
+    stream->pos = 0;
+    stream->len = got;
+
+    if (stream->remaining == 0) {
+        res = gcry_cipher_gettag(stream->hd, stream->buffer + got, AES256_GCM_TAG_LENGTH);
+        stream->len += AES256_GCM_TAG_LENGTH;
+        stream->finished = TRUE;
+    }
+
+    return res;
+}
+
+ssize_t
+omemo_encrypt_stream_read(OmemoFileStream* stream, char* buffer, size_t size)
+{
+    if (stream->pos == stream->len) {
+        if (stream->finished) {
+            return 0;
+        }
+        gcry_error_t res = _encrypt_stream_fill(stream);
+        if (res != GPG_ERR_NO_ERROR) {
+            log_error("[OMEMO] file encryption failed: %s", gcry_strerror(res));
+            return -1;
+        }
+    }
+
+    size_t n = MIN(size, stream->len - stream->pos);
+    memcpy(buffer, stream->buffer + stream->pos, n);
+    stream->pos += n;
+
+    return n;
+}
+
+void
+omemo_file_stream_free(OmemoFileStream* stream)
+{
+    if (stream) {
+        gcry_cipher_close(stream->hd);
+        memset(stream->buffer, 0, sizeof(stream->buffer));
+        g_free(stream);
+    }
+}
+
+static void
+_bytes_from_hex(const char* hex, size_t hex_size,
+                unsigned char* bytes, size_t bytes_size)
+{
+    const unsigned char ht[] = {
+        0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, // 01234567
+        0x08, 0x09, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, // 89:;<=>?
+        0x00, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0x00, // @ABCDEFG
+    };
+    const size_t ht_size = sizeof(ht);
+
+    unsigned char b0;
+    unsigned char b1;
+
+    memset(bytes, 0, bytes_size);
+
+    for (int i = 0; (i < hex_size) && (i / 2 < bytes_size); i += 2) {
+        b0 = ((unsigned char)hex[i + 0] & 0x1f) ^ 0x10;
+        b1 = ((unsigned char)hex[i + 1] & 0x1f) ^ 0x10;
+
+        if (b0 <= ht_size && b1 <= ht_size) {
+            bytes[i / 2] = (unsigned char)(ht[b0] << 4) | ht[b1];
+        }
+    }
+}
+
+OmemoFileStream*
+omemo_decrypt_stream_new(const char* fragment, gcry_error_t* gcry_res)
+{
+    char nonce_hex[AESGCM_URL_NONCE_LEN];
+    char key_hex[AESGCM_URL_KEY_LEN];
+
+    const int nonce_pos = 0;
+    const int key_pos = AESGCM_URL_NONCE_LEN;
+
+    memcpy(nonce_hex, &(fragment[nonce_pos]), AESGCM_URL_NONCE_LEN);
+    memcpy(key_hex, &(fragment[key_pos]), AESGCM_URL_KEY_LEN);
+
+    unsigned char nonce[OMEMO_AESGCM_NONCE_LENGTH];
+    unsigned char* key = gcry_malloc_secure(OMEMO_AESGCM_KEY_LENGTH);
+
+    _bytes_from_hex(nonce_hex, AESGCM_URL_NONCE_LEN,
+                    nonce, OMEMO_AESGCM_NONCE_LENGTH);
+    _bytes_from_hex(key_hex, AESGCM_URL_KEY_LEN,
+                    key, OMEMO_AESGCM_KEY_LENGTH);
+
+    OmemoFileStream* stream = g_new0(OmemoFileStream, 1);
+    *gcry_res = aes256gcm_stream_open(&stream->hd, key, nonce);
+
+    gcry_free(key);
+
+    if (*gcry_res != GPG_ERR_NO_ERROR) {
+        g_free(stream);
+        return NULL;
+    }
+
+    return stream;
+}
+
+/*
+ * Ciphertext is buffered until more than the tag length is available, so the
+ * trailing tag is never decrypted as data. Everything before it is decrypted
+ * in whole blocks and written to out right away.
+ */
+gcry_error_t
+omemo_decrypt_stream_write(OmemoFileStream* stream, const char* data, size_t len, FILE* out)
+{
+    while (len > 0) {
+        size_t n = MIN(len, sizeof(stream->buffer) - stream->len);
+        memcpy(stream->buffer + stream->len, data, n);
+        stream->len += n;
+        data += n;
+        len -= n;
+
+        if (stream->len <= AES256_GCM_TAG_LENGTH) {
+            continue;
+        }
+
+        size_t ready = stream->len - AES256_GCM_TAG_LENGTH;
+        ready -= ready % OMEMO_AESGCM_BLOCK_LENGTH;
+        if (ready == 0) {
+            continue;
+        }
+
+        gcry_error_t res = gcry_cipher_decrypt(stream->hd, stream->buffer, ready, NULL, 0);
+        if (res != GPG_ERR_NO_ERROR) {
+            return res;
+        }
+        if (fwrite(stream->buffer, 1, ready, out) != ready) {
+            return gcry_error_from_errno(errno);
+        }
+
+        memmove(stream->buffer, stream->buffer + ready, stream->len - ready);
+        stream->len -= ready;
+    }
+
+    return GPG_ERR_NO_ERROR;
+}
+
+gcry_error_t
+omemo_decrypt_stream_finish(OmemoFileStream* stream, FILE* out)
+{
+    if (stream->len < AES256_GCM_TAG_LENGTH) {
+        return gcry_error(GPG_ERR_INV_LENGTH);
+    }
+
+    size_t rest = stream->len - AES256_GCM_TAG_LENGTH;
+
+    gcry_cipher_final(stream->hd); // Signal last round of bytes.
+    gcry_error_t res = gcry_cipher_decrypt(stream->hd, stream->buffer, rest, NULL, 0);
+    if (res != GPG_ERR_NO_ERROR) {
+        return res;
+    }
+    if (fwrite(stream->buffer, 1, rest, out) != rest) {
+        return gcry_error_from_errno(errno);
+    }
+
+    // Verify authentication tag stored at the end of the file.
+    return gcry_cipher_checktag(stream->hd, stream->buffer + rest, AES256_GCM_TAG_LENGTH);
+}
@@ -0,0 +1,76 @@
+/*
+ * file_stream.h
+ * vim: expandtab:ts=4:sts=4:sw=4
+ *
+ * This file is part of Profanity.
+ *
+ * Profanity is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Profanity is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Profanity.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link the code of portions of this program with the OpenSSL library under
+ * certain conditions as described in each individual source file, and
+ * distribute linked combinations including the two.
+ *
+ * You must obey the GNU General Public License in all respects for all of the
+ * code used other than OpenSSL. If you modify file(s) with this exception, you
+ * may extend this exception to your version of the file(s), but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version. If you delete this exception statement from all
+ * source files in the program, then also delete it here.
+ *
+ */
+
+#ifndef OMEMO_FILE_STREAM_H
+#define OMEMO_FILE_STREAM_H
+
+#include <stdio.h>
+#include <sys/types.h>
+#include <gcrypt.h>
+
+// length of the nonce and key in the hex encoded aesgcm URL fragment
+#define AESGCM_URL_NONCE_LEN (2 * OMEMO_AESGCM_NONCE_LENGTH)
+#define AESGCM_URL_KEY_LEN   (2 * OMEMO_AESGCM_KEY_LENGTH)
+
+typedef struct omemo_file_stream_t OmemoFileStream;
+
+/**
+ * Prepare streaming AES-256-GCM encryption of a file for OMEMO media sharing.
+ *
+ * @param in the plaintext file, read while the stream is consumed
+ * @param file_size number of plaintext bytes to read
+ * @param fragment the aesgcm URL fragment holding nonce and key, free with omemo_free()
+ * @param gcry_res the libgcrypt result
+ * @return the stream or NULL on error
+ */
+OmemoFileStream* omemo_encrypt_stream_new(FILE* in, off_t file_size, char** fragment, gcry_error_t* gcry_res);
+off_t omemo_encrypt_stream_size(OmemoFileStream* stream);
+ssize_t omemo_encrypt_stream_read(OmemoFileStream* stream, char* buffer, size_t size);
+
+/**
+ * Prepare streaming AES-256-GCM decryption of a file from an aesgcm URL.
+ *
+ * @param fragment the aesgcm URL fragment holding nonce and key
+ * @param gcry_res the libgcrypt result
+ * @return the stream or NULL on error
+ */
+OmemoFileStream* omemo_decrypt_stream_new(const char* fragment, gcry_error_t* gcry_res);
+gcry_error_t omemo_decrypt_stream_write(OmemoFileStream* stream, const char* data, size_t len, FILE* out);
+
+/**
+ * Decrypt the remaining data and verify the authentication tag. Everything
+ * written to out must be discarded if this fails.
+ */
+gcry_error_t omemo_decrypt_stream_finish(OmemoFileStream* stream, FILE* out);
+void omemo_file_stream_free(OmemoFileStream* stream);
+#endif
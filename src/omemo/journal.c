@@ -0,0 +1,212 @@
+/*
+ * journal.c
+ * vim: expandtab:ts=4:sts=4:sw=4
+ *
+ * This file is part of Profanity.
+ *
+ * Profanity is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Profanity is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Profanity.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link the code of portions of this program with the OpenSSL library under
+ * certain conditions as described in each individual source file, and
+ * distribute linked combinations including the two.
+ *
+ * You must obey the GNU General Public License in all respects for all of the
+ * code used other than OpenSSL. If you modify file(s) with this exception, you
+ * may extend this exception to your version of the file(s), but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version. If you delete this exception statement from all
+ * source files in the program, then also delete it here.
+ *
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include "log.h"
+#include "common.h"
+#include "omemo/journal.h"
+
+// records after which the keyfiles are rewritten and the journal emptied
+#define OMEMO_JOURNAL_COMPACT_RECORDS 2000
+
+#define OMEMO_JOURNAL_OP_SET    "S"
+#define OMEMO_JOURNAL_OP_REMOVE "R"
+#define OMEMO_JOURNAL_SESSIONS  "sessions"
+#define OMEMO_JOURNAL_IDENTITY  "identity"
+
+struct omemo_journal_t
+{
+    gchar* filename;
+    int fd;
+    guint records;
+};
+
+static gboolean _journal_append(OmemoJournal* journal, const char* const line, gsize len);
+
+OmemoJournal*
+omemo_journal_open(const char* const filename)
+{
+    int fd = open(filename, O_RDWR | O_APPEND | O_CREAT | O_CLOEXEC, S_IRUSR | S_IWUSR);
+    if (fd == -1) {
+        log_error("[OMEMO][JOURNAL] cannot open %s: %s", filename, g_strerror(errno));
+        return NULL;
+    }
+
+    OmemoJournal* journal = malloc(sizeof(OmemoJournal));
+    journal->filename = g_strdup(filename);
+    journal->fd = fd;
+    journal->records = 0;
+
+    return journal;
+}
+
+guint
+omemo_journal_replay(OmemoJournal* journal, GKeyFile* sessions, GKeyFile* identity)
+{
+    gsize length = 0;
+    auto_gchar gchar* contents = NULL;
+    GError* error = NULL;
+
+    if (!g_file_get_contents(journal->filename, &contents, &length, &error)) {
+        log_error("[OMEMO][JOURNAL] cannot read %s: %s", journal->filename, error->message);
+        g_error_free(error);
+        return 0;
+    }
+
+    guint applied = 0;
+    gchar* line = contents;
+    gchar* end = contents + length;
+    while (line < end) {
+        gchar* eol = memchr(line, '\n', end - line);
+        if (!eol) {
+            // torn write of the last record, it never completed, cut it off
+            // so the next record is not appended to it
+            log_warning("[OMEMO][JOURNAL] dropping incomplete record in %s", journal->filename);
+            if (ftruncate(journal->fd, line - contents) != 0) {
+                log_error("[OMEMO][JOURNAL] cannot truncate %s: %s", journal->filename, g_strerror(errno));
+            }
+            break;
+        }
+        *eol = '\0';
+
+        auto_gcharv gchar** fields = g_strsplit(line, "\t", 5);
+        guint n = g_strv_length(fields);
+        GKeyFile* target = NULL;
+        if (n >= 4) {
+            if (g_strcmp0(fields[1], OMEMO_JOURNAL_SESSIONS) == 0) {
+                target = sessions;
+            } else if (g_strcmp0(fields[1], OMEMO_JOURNAL_IDENTITY) == 0) {
+                target = identity;
+            }
+        }
+
+        if (target && n == 5 && g_strcmp0(fields[0], OMEMO_JOURNAL_OP_SET) == 0) {
+            g_key_file_set_string(target, fields[2], fields[3], fields[4]);
+            applied++;
+        } else if (target && n == 4 && g_strcmp0(fields[0], OMEMO_JOURNAL_OP_REMOVE) == 0) {
+            g_key_file_remove_key(target, fields[2], fields[3], NULL);
+            applied++;
+        } else {
+            log_warning("[OMEMO][JOURNAL] skipping malformed record in %s", journal->filename);
+        }
+
+        line = eol + 1;
+    }
+
+    journal->records = applied;
+    log_debug("[OMEMO][JOURNAL] replayed %u records from %s", applied, journal->filename);
+
+    return applied;
+}
+
+gboolean
+omemo_journal_set(OmemoJournal* journal, gboolean identity, const char* const group, const char* const key, const char* const value)
+{
+    auto_gchar gchar* line = g_strdup_printf("%s\t%s\t%s\t%s\t%s\n", OMEMO_JOURNAL_OP_SET,
+                                             identity ? OMEMO_JOURNAL_IDENTITY : OMEMO_JOURNAL_SESSIONS,
+                                             group, key, value);
+    return _journal_append(journal, line, strlen(line));
+}
+
+gboolean
+omemo_journal_remove(OmemoJournal* journal, gboolean identity, const char* const group, const char* const key)
+{
+    auto_gchar gchar* line = g_strdup_printf("%s\t%s\t%s\t%s\n", OMEMO_JOURNAL_OP_REMOVE,
+                                             identity ? OMEMO_JOURNAL_IDENTITY : OMEMO_JOURNAL_SESSIONS,
+                                             group, key);
+    return _journal_append(journal, line, strlen(line));
+}
+
+guint
+omemo_journal_records(OmemoJournal* journal)
+{
+    return journal->records;
+}
+
+gboolean
+omemo_journal_needs_compaction(OmemoJournal* journal)
+{
+    return journal->records >= OMEMO_JOURNAL_COMPACT_RECORDS;
+}
+
+void
+omemo_journal_truncate(OmemoJournal* journal)
+{
+    if (ftruncate(journal->fd, 0) != 0) {
+        log_error("[OMEMO][JOURNAL] cannot truncate %s: %s", journal->filename, g_strerror(errno));
+        return;
+    }
+    journal->records = 0;
+}
+
+void
+omemo_journal_close(OmemoJournal* journal)
+{
+    if (journal) {
+        close(journal->fd);
+        g_free(journal->filename);
+        free(journal);
+    }
+}
+
+// records are appended with O_APPEND, a crash can at most tear the last one
+static gboolean
+_journal_append(OmemoJournal* journal, const char* const line, gsize len)
+{
+    gsize written = 0;
+    while (written < len) {
+        ssize_t res = write(journal->fd, line + written, len - written);
+        if (res < 0 && errno == EINTR) {
+            continue;
+        }
+        if (res < 0) {
+            log_error("[OMEMO][JOURNAL] cannot append to %s: %s", journal->filename, g_strerror(errno));
+            return FALSE;
+        }
+        written += res;
+    }
+
+    journal->records++;
+    return TRUE;
+}
@@ -0,0 +1,90 @@
+/*
+ * journal.h
+ * vim: expandtab:ts=4:sts=4:sw=4
+ *
+ * This file is part of Profanity.
+ *
+ * Profanity is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Profanity is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Profanity.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link the code of portions of this program with the OpenSSL library under
+ * certain conditions as described in each individual source file, and
+ * distribute linked combinations including the two.
+ *
+ * You must obey the GNU General Public License in all respects for all of the
+ * code used other than OpenSSL. If you modify file(s) with this exception, you
+ * may extend this exception to your version of the file(s), but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version. If you delete this exception statement from all
+ * source files in the program, then also delete it here.
+ *
+ */
+
+#ifndef OMEMO_JOURNAL_H
+#define OMEMO_JOURNAL_H
+
+#include <glib.h>
+
+typedef struct omemo_journal_t OmemoJournal;
+
+/**
+ * Open the append-only journal of OMEMO store records, creating it if needed.
+ *
+ * The journal holds the changes made since the sessions and identity keyfiles
+ * were last written, one record per line.
+ *
+ * @param filename path of the journal file
+ * @return the journal or NULL if it could not be opened
+ */
+OmemoJournal* omemo_journal_open(const char* const filename);
+
+/**
+ * Apply all complete records of the journal to the given keyfiles.
+ *
+ * @return the number of records applied
+ */
+guint omemo_journal_replay(OmemoJournal* journal, GKeyFile* sessions, GKeyFile* identity);
+
+/**
+ * Append a record setting group/key in the sessions or identity keyfile.
+ *
+ * @return TRUE if the record was written
+ */
+gboolean omemo_journal_set(OmemoJournal* journal, gboolean identity, const char* const group, const char* const key, const char* const value);
+
+/**
+ * Append a record removing group/key from the sessions or identity keyfile.
+ *
+ * @return TRUE if the record was written
+ */
+gboolean omemo_journal_remove(OmemoJournal* journal, gboolean identity, const char* const group, const char* const key);
+
+/**
+ * @return the number of records currently in the journal
+ */
+guint omemo_journal_records(OmemoJournal* journal);
+
+/**
+ * @return TRUE once enough records piled up that the keyfiles should be rewritten
+ */
+gboolean omemo_journal_needs_compaction(OmemoJournal* journal);
+
+/**
+ * Drop all records. Only call once the keyfiles contain every change.
+ */
+void omemo_journal_truncate(OmemoJournal* journal);
+
+void omemo_journal_close(OmemoJournal* journal);
+
+#endif
@@ -51,8 +51,11 @@
 #include "config/account.h"
 #include "config/files.h"
 #include "config/preferences.h"
+#include "tools/memstats.h"
+#include "tools/metrics.h"
 #include "log.h"
 #include "omemo/crypto.h"
+#include "omemo/journal.h"
 #include "omemo/omemo.h"
 #include "omemo/store.h"
 #include "ui/ui.h"
@@ -63,9 +66,6 @@
 #include "xmpp/roster_list.h"
 #include "xmpp/xmpp.h"
 
-#define AESGCM_URL_NONCE_LEN (2 * OMEMO_AESGCM_NONCE_LENGTH)
-#define AESGCM_URL_KEY_LEN   (2 * OMEMO_AESGCM_KEY_LENGTH)
-
 static void _generate_pre_keys(int count);
 static void _generate_signed_pre_key(void);
 static gboolean _load_identity(void);
@@ -82,6 +82,13 @@ static unsigned char* _omemo_fingerprint_decode(const char* const fingerprint, s
 static char* _omemo_unformat_fingerprint(const char* const fingerprint_formatted);
 static void _cache_device_identity(const char* const jid, uint32_t device_id, ec_public_key* identity);
 static void _acquire_sender_devices_list(void);
+static void _store_record(gboolean identity, const char* const group, const char* const key, const char* const value);
+static void _compact_store(gboolean with_identity);
+static void _omemo_memstats(MemStats* stats);
+static char* _omemo_encrypt_message(ProfWin* win, const char* const message, gboolean request_receipt, gboolean muc, const char* const replace_id);
+static char* _omemo_decrypt_message(const char* const from_jid, uint32_t sid,
+                                    const unsigned char* const iv, size_t iv_len, GList* keys,
+                                    const unsigned char* const payload, size_t payload_len, gboolean muc, gboolean* trusted);
 
 typedef gboolean (*OmemoDeviceListHandler)(const char* const jid, GList* device_list);
 
@@ -103,6 +110,7 @@ typedef struct omemo_context
     prof_keyfile_t trust;
     prof_keyfile_t sessions;
     prof_keyfile_t knowndevices;
+    OmemoJournal* journal;
     GHashTable* known_devices;
     gboolean loaded;
 } omemo_context;
@@ -119,6 +127,7 @@ static struct omemo_static_data
 static void
 _omemo_close(void)
 {
+    memstats_unregister("omemo");
     if (omemo_static_data.fingerprint_ac) {
         g_hash_table_destroy(omemo_static_data.fingerprint_ac);
         omemo_static_data.fingerprint_ac = NULL;
@@ -143,6 +152,100 @@ omemo_init(void)
     pthread_mutex_init(&omemo_static_data.lock, &omemo_static_data.attr);
 
     omemo_static_data.fingerprint_ac = g_hash_table_new_full(g_str_hash, g_str_equal, free, (GDestroyNotify)autocomplete_free);
+
+    memstats_register("omemo", _omemo_memstats);
+}
+
+// device id -> signal_buffer
+static gsize
+_signal_buffers_memory(GHashTable* buffers)
+{
+    gsize bytes = memstats_hash_table(buffers);
+    GHashTableIter iter;
+    gpointer value;
+    g_hash_table_iter_init(&iter, buffers);
+    while (g_hash_table_iter_next(&iter, NULL, &value)) {
+        bytes += sizeof(size_t) + signal_buffer_len(value);
+    }
+
+    return bytes;
+}
+
+// barejid -> device id -> signal_buffer
+static gsize
+_signal_buffers_by_jid_memory(GHashTable* jids, guint* devices)
+{
+    gsize bytes = memstats_hash_table(jids);
+    GHashTableIter iter;
+    gpointer key;
+    gpointer value;
+    g_hash_table_iter_init(&iter, jids);
+    while (g_hash_table_iter_next(&iter, &key, &value)) {
+        bytes += memstats_str(key) + _signal_buffers_memory(value);
+        *devices += g_hash_table_size(value);
+    }
+
+    return bytes;
+}
+
+static void
+_omemo_memstats(MemStats* stats)
+{
+    pthread_mutex_lock(&omemo_static_data.lock);
+
+    GHashTableIter iter;
+    gpointer key;
+    gpointer value;
+
+    gsize bytes = memstats_hash_table(omemo_static_data.fingerprint_ac);
+    g_hash_table_iter_init(&iter, omemo_static_data.fingerprint_ac);
+    while (g_hash_table_iter_next(&iter, &key, &value)) {
+        bytes += memstats_str(key) + autocomplete_memory(value);
+    }
+    memstats_add(stats, "omemo.autocomplete", bytes, g_hash_table_size(omemo_static_data.fingerprint_ac));
+
+    if (!omemo_ctx.loaded) {
+        pthread_mutex_unlock(&omemo_static_data.lock);
+        return;
+    }
+
+    guint sessions = 0;
+    bytes = _signal_buffers_by_jid_memory(omemo_ctx.session_store, &sessions);
+    memstats_add(stats, "omemo.sessions", bytes, sessions);
+
+    bytes = _signal_buffers_memory(omemo_ctx.pre_key_store) + _signal_buffers_memory(omemo_ctx.signed_pre_key_store);
+    memstats_add(stats, "omemo.prekeys", bytes,
+                 g_hash_table_size(omemo_ctx.pre_key_store) + g_hash_table_size(omemo_ctx.signed_pre_key_store));
+
+    guint trusted = 0;
+    bytes = _signal_buffers_by_jid_memory(omemo_ctx.identity_key_store.trusted, &trusted);
+    memstats_add(stats, "omemo.trusted", bytes, trusted);
+
+    guint devices = 0;
+    bytes = memstats_hash_table(omemo_ctx.device_list) + memstats_hash_table(omemo_ctx.device_list_handler)
+            + memstats_hash_table(omemo_ctx.known_devices);
+    g_hash_table_iter_init(&iter, omemo_ctx.device_list);
+    while (g_hash_table_iter_next(&iter, &key, &value)) {
+        bytes += memstats_str(key) + memstats_list(value);
+    }
+    g_hash_table_iter_init(&iter, omemo_ctx.device_list_handler);
+    while (g_hash_table_iter_next(&iter, &key, NULL)) {
+        bytes += memstats_str(key);
+    }
+    g_hash_table_iter_init(&iter, omemo_ctx.known_devices);
+    while (g_hash_table_iter_next(&iter, &key, &value)) {
+        bytes += memstats_str(key) + memstats_hash_table(value);
+        GHashTableIter fingerprints;
+        gpointer fingerprint;
+        g_hash_table_iter_init(&fingerprints, value);
+        while (g_hash_table_iter_next(&fingerprints, &fingerprint, NULL)) {
+            bytes += memstats_str(fingerprint);
+            devices++;
+        }
+    }
+    memstats_add(stats, "omemo.devices", bytes, devices);
+
+    pthread_mutex_unlock(&omemo_static_data.lock);
 }
 
 void
@@ -238,16 +341,29 @@ omemo_on_connect(ProfAccount* account)
         return;
     }
 
-    if (load_custom_keyfile(&omemo_ctx.identity, g_strdup_printf("%s/%s", omemo_dir, "identity.txt"))) {
-        if (!_load_identity())
+    gboolean identity_loaded = load_custom_keyfile(&omemo_ctx.identity, g_strdup_printf("%s/%s", omemo_dir, "identity.txt"));
+    gboolean sessions_loaded = load_custom_keyfile(&omemo_ctx.sessions, g_strdup_printf("%s/%s", omemo_dir, "sessions.txt"));
+
+    // records written since the keyfiles were last rewritten
+    auto_gchar gchar* journal_path = g_strdup_printf("%s/%s", omemo_dir, "store.journal");
+    omemo_ctx.journal = omemo_journal_open(journal_path);
+    if (omemo_ctx.journal && omemo_journal_replay(omemo_ctx.journal, omemo_ctx.sessions.keyfile, omemo_ctx.identity.keyfile) > 0) {
+        _compact_store(identity_loaded);
+    }
+
+    if (identity_loaded) {
+        if (!_load_identity()) {
+            omemo_journal_close(omemo_ctx.journal);
+            omemo_ctx.journal = NULL;
             return;
+        }
     }
 
     if (load_custom_keyfile(&omemo_ctx.trust, g_strdup_printf("%s/%s", omemo_dir, "trust.txt"))) {
         _load_trust();
     }
 
-    if (load_custom_keyfile(&omemo_ctx.sessions, g_strdup_printf("%s/%s", omemo_dir, "sessions.txt"))) {
+    if (sessions_loaded) {
         _load_sessions();
     }
 
@@ -261,6 +377,15 @@ omemo_on_connect(ProfAccount* account)
 void
 omemo_on_disconnect(void)
 {
+    // the journal is opened on connect, with or without an identity
+    if (omemo_ctx.journal) {
+        if (omemo_journal_records(omemo_ctx.journal) > 0) {
+            _compact_store(omemo_ctx.loaded);
+        }
+        omemo_journal_close(omemo_ctx.journal);
+        omemo_ctx.journal = NULL;
+    }
+
     if (!omemo_ctx.loaded) {
         return;
     }
@@ -321,7 +446,8 @@ omemo_generate_crypto_materials(ProfAccount* account)
     /* Signed pre key */
     _generate_signed_pre_key();
 
-    omemo_identity_keyfile_save();
+    // freshly generated identity must be on disk before we publish it
+    save_keyfile(&omemo_ctx.identity);
 
     omemo_ctx.loaded = TRUE;
 
@@ -546,16 +672,22 @@ omemo_set_device_list(const char* const from, GList* device_list)
     }
 }
 
-GKeyFile*
-omemo_identity_keyfile(void)
+void
+omemo_identity_record_set(const char* const group, const char* const key, const char* const value)
+{
+    _store_record(TRUE, group, key, value);
+}
+
+void
+omemo_identity_record_remove(const char* const group, const char* const key)
 {
-    return omemo_ctx.identity.keyfile;
+    _store_record(TRUE, group, key, NULL);
 }
 
 void
 omemo_identity_keyfile_save(void)
 {
-    save_keyfile(&omemo_ctx.identity);
+    save_keyfile_deferred(&omemo_ctx.identity);
 }
 
 GKeyFile*
@@ -567,25 +699,25 @@ omemo_trust_keyfile(void)
 void
 omemo_trust_keyfile_save(void)
 {
-    save_keyfile(&omemo_ctx.trust);
+    save_keyfile_deferred(&omemo_ctx.trust);
 }
 
-GKeyFile*
-omemo_sessions_keyfile(void)
+void
+omemo_sessions_record_set(const char* const group, const char* const key, const char* const value)
 {
-    return omemo_ctx.sessions.keyfile;
+    _store_record(FALSE, group, key, value);
 }
 
 void
-omemo_sessions_keyfile_save(void)
+omemo_sessions_record_remove(const char* const group, const char* const key)
 {
-    save_keyfile(&omemo_ctx.sessions);
+    _store_record(FALSE, group, key, NULL);
 }
 
 void
 omemo_known_devices_keyfile_save(void)
 {
-    save_keyfile(&omemo_ctx.knowndevices);
+    save_keyfile_deferred(&omemo_ctx.knowndevices);
 }
 
 void
@@ -683,6 +815,16 @@ out:
 
 char*
 omemo_on_message_send(ProfWin* win, const char* const message, gboolean request_receipt, gboolean muc, const char* const replace_id)
+{
+    gint64 start = metrics_start();
+    char* id = _omemo_encrypt_message(win, message, request_receipt, muc, replace_id);
+    metrics_record(METRIC_OMEMO_ENCRYPT, start);
+
+    return id;
+}
+
+static char*
+_omemo_encrypt_message(ProfWin* win, const char* const message, gboolean request_receipt, gboolean muc, const char* const replace_id)
 {
     char* id = NULL;
     int res;
@@ -874,6 +1016,18 @@ char*
 omemo_on_message_recv(const char* const from_jid, uint32_t sid,
                       const unsigned char* const iv, size_t iv_len, GList* keys,
                       const unsigned char* const payload, size_t payload_len, gboolean muc, gboolean* trusted)
+{
+    gint64 start = metrics_start();
+    char* plaintext = _omemo_decrypt_message(from_jid, sid, iv, iv_len, keys, payload, payload_len, muc, trusted);
+    metrics_record(METRIC_OMEMO_DECRYPT, start);
+
+    return plaintext;
+}
+
+static char*
+_omemo_decrypt_message(const char* const from_jid, uint32_t sid,
+                       const unsigned char* const iv, size_t iv_len, GList* keys,
+                       const unsigned char* const payload, size_t payload_len, gboolean muc, gboolean* trusted)
 {
     unsigned char* plaintext = NULL;
     auto_jid Jid* sender = NULL;
@@ -1676,84 +1830,6 @@ omemo_free(void* a)
     gcry_free(a);
 }
 
-char*
-omemo_encrypt_file(FILE* in, FILE* out, off_t file_size, int* gcry_res)
-{
-    unsigned char* key = gcry_random_bytes_secure(
-        OMEMO_AESGCM_KEY_LENGTH,
-        GCRY_VERY_STRONG_RANDOM);
-
-    // Create nonce/IV with random bytes.
-    unsigned char nonce[OMEMO_AESGCM_NONCE_LENGTH];
-    gcry_create_nonce(nonce, OMEMO_AESGCM_NONCE_LENGTH);
-
-    char* fragment = aes256gcm_create_secure_fragment(key, nonce);
-    *gcry_res = aes256gcm_crypt_file(in, out, file_size, key, nonce, true);
-
-    if (*gcry_res != GPG_ERR_NO_ERROR) {
-        gcry_free(fragment);
-        fragment = NULL;
-    }
-
-    gcry_free(key);
-
-    return fragment;
-}
-
-void
-_bytes_from_hex(const char* hex, size_t hex_size,
-                unsigned char* bytes, size_t bytes_size)
-{
-    const unsigned char ht[] = {
-        0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, // 01234567
-        0x08, 0x09, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, // 89:;<=>?
-        0x00, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0x00, // @ABCDEFG
-    };
-    const size_t ht_size = sizeof(ht);
-
-    unsigned char b0;
-    unsigned char b1;
-
-    memset(bytes, 0, bytes_size);
-
-    for (int i = 0; (i < hex_size) && (i / 2 < bytes_size); i += 2) {
-        b0 = ((unsigned char)hex[i + 0] & 0x1f) ^ 0x10;
-        b1 = ((unsigned char)hex[i + 1] & 0x1f) ^ 0x10;
-
-        if (b0 <= ht_size && b1 <= ht_size) {
-            bytes[i / 2] = (unsigned char)(ht[b0] << 4) | ht[b1];
-        }
-    }
-}
-
-gcry_error_t
-omemo_decrypt_file(FILE* in, FILE* out, off_t file_size, const char* fragment)
-{
-    char nonce_hex[AESGCM_URL_NONCE_LEN];
-    char key_hex[AESGCM_URL_KEY_LEN];
-
-    const int nonce_pos = 0;
-    const int key_pos = AESGCM_URL_NONCE_LEN;
-
-    memcpy(nonce_hex, &(fragment[nonce_pos]), AESGCM_URL_NONCE_LEN);
-    memcpy(key_hex, &(fragment[key_pos]), AESGCM_URL_KEY_LEN);
-
-    unsigned char nonce[OMEMO_AESGCM_NONCE_LENGTH];
-    unsigned char* key = gcry_malloc_secure(OMEMO_AESGCM_KEY_LENGTH);
-
-    _bytes_from_hex(nonce_hex, AESGCM_URL_NONCE_LEN,
-                    nonce, OMEMO_AESGCM_NONCE_LENGTH);
-    _bytes_from_hex(key_hex, AESGCM_URL_KEY_LEN,
-                    key, OMEMO_AESGCM_KEY_LENGTH);
-
-    gcry_error_t crypt_res;
-    crypt_res = aes256gcm_crypt_file(in, out, file_size, key, nonce, false);
-
-    gcry_free(key);
-
-    return crypt_res;
-}
-
 int
 omemo_parse_aesgcm_url(const char* aesgcm_url,
                        char** https_url,
@@ -1815,3 +1891,53 @@ omemo_qrcode_str()
 
     return qrstr;
 }
+
+/*
+ * Keep the keyfile in memory up to date and persist only the changed record
+ * by appending it to the journal. The keyfiles themselves are rewritten when
+ * the journal gets compacted.
+ */
+static void
+_store_record(gboolean identity, const char* const group, const char* const key, const char* const value)
+{
+    prof_keyfile_t* keyfile = identity ? &omemo_ctx.identity : &omemo_ctx.sessions;
+
+    if (value) {
+        g_key_file_set_string(keyfile->keyfile, group, key, value);
+    } else {
+        g_key_file_remove_key(keyfile->keyfile, group, key, NULL);
+    }
+
+    gboolean journaled = FALSE;
+    if (omemo_ctx.journal) {
+        if (value) {
+            journaled = omemo_journal_set(omemo_ctx.journal, identity, group, key, value);
+        } else {
+            journaled = omemo_journal_remove(omemo_ctx.journal, identity, group, key);
+        }
+    }
+
+    if (!journaled) {
+        save_keyfile_deferred(keyfile);
+        return;
+    }
+
+    if (omemo_journal_needs_compaction(omemo_ctx.journal)) {
+        _compact_store(TRUE);
+    }
+}
+
+// Without an identity on disk the identity keyfile only holds replayed
+// records and writing it would leave an identity.txt that fails to load.
+static void
+_compact_store(gboolean with_identity)
+{
+    log_debug("[OMEMO] compacting store journal");
+
+    if (!save_keyfile(&omemo_ctx.sessions) || (with_identity && !save_keyfile(&omemo_ctx.identity))) {
+        log_error("[OMEMO] could not write store, keeping journal");
+        return;
+    }
+
+    omemo_journal_truncate(omemo_ctx.journal);
+}
@@ -37,6 +37,7 @@
 
 #include "ui/ui.h"
 #include "config/account.h"
+#include "omemo/file_stream.h"
 
 #define OMEMO_ERR_UNSUPPORTED_CRYPTO -10000
 #define OMEMO_ERR_GCRYPT             -20000
@@ -73,12 +74,13 @@ void omemo_signed_prekey(unsigned char** output, size_t* length);
 void omemo_signed_prekey_signature(unsigned char** output, size_t* length);
 void omemo_prekeys(GList** prekeys, GList** ids, GList** lengths);
 void omemo_set_device_list(const char* const jid, GList* device_list);
-GKeyFile* omemo_identity_keyfile(void);
+void omemo_identity_record_set(const char* const group, const char* const key, const char* const value);
+void omemo_identity_record_remove(const char* const group, const char* const key);
 void omemo_identity_keyfile_save(void);
 GKeyFile* omemo_trust_keyfile(void);
 void omemo_trust_keyfile_save(void);
-GKeyFile* omemo_sessions_keyfile(void);
-void omemo_sessions_keyfile_save(void);
+void omemo_sessions_record_set(const char* const group, const char* const key, const char* const value);
+void omemo_sessions_record_remove(const char* const group, const char* const key);
 char* omemo_format_fingerprint(const char* const fingerprint);
 char* omemo_own_fingerprint(gboolean formatted);
 void omemo_trust(const char* const jid, const char* const fingerprint);
@@ -98,8 +100,6 @@ gboolean omemo_loaded(void);
 char* omemo_on_message_send(ProfWin* win, const char* const message, gboolean request_receipt, gboolean muc, const char* const replace_id);
 char* omemo_on_message_recv(const char* const from, uint32_t sid, const unsigned char* const iv, size_t iv_len, GList* keys, const unsigned char* const payload, size_t payload_len, gboolean muc, gboolean* trusted);
 
-char* omemo_encrypt_file(FILE* in, FILE* out, off_t file_size, int* gcry_res);
-gcry_error_t omemo_decrypt_file(FILE* in, FILE* out, off_t file_size, const char* fragment);
 void omemo_free(void* a);
 int omemo_parse_aesgcm_url(const char* aesgcm_url, char** https_url, char** fragment);
 
@@ -150,7 +150,6 @@ api_register_timed(const char* const plugin_name, void* callback, int interval_s
     timed_function->callback_exec = callback_exec;
     timed_function->callback_destroy = callback_destroy;
     timed_function->interval_seconds = interval_seconds;
-    timed_function->timer = g_timer_new();
 
     callbacks_add_timed(plugin_name, timed_function);
 }
@@ -485,7 +484,7 @@ api_incoming_message(const char* const barejid, const char* const resource, cons
 {
     ProfMessage* message = message_init();
     message->from_jid = jid_create_from_bare_and_resource(barejid, resource);
-    message->plain = strdup(plain);
+    message->plain = message_strdup(message, plain);
 
     sv_ev_incoming_message(message);
 
@@ -40,6 +40,7 @@
 #include <glib.h>
 
 #include "tools/autocomplete.h"
+#include "tools/memstats.h"
 #include "command/cmd_ac.h"
 
 static GHashTable* plugin_to_acs;
@@ -214,3 +215,32 @@ autocompleters_destroy(void)
     plugin_to_acs = NULL;
     plugin_to_filepath_acs = NULL;
 }
+
+gsize
+autocompleters_memory(const char* const plugin_name)
+{
+    gsize bytes = 0;
+    GHashTableIter iter;
+    gpointer key;
+    gpointer value;
+
+    GHashTable* key_to_ac = g_hash_table_lookup(plugin_to_acs, plugin_name);
+    if (key_to_ac) {
+        bytes += memstats_hash_table(key_to_ac);
+        g_hash_table_iter_init(&iter, key_to_ac);
+        while (g_hash_table_iter_next(&iter, &key, &value)) {
+            bytes += memstats_str(key) + autocomplete_memory(value);
+        }
+    }
+
+    GHashTable* prefixes = g_hash_table_lookup(plugin_to_filepath_acs, plugin_name);
+    if (prefixes) {
+        bytes += memstats_hash_table(prefixes);
+        g_hash_table_iter_init(&iter, prefixes);
+        while (g_hash_table_iter_next(&iter, &key, NULL)) {
+            bytes += memstats_str(key);
+        }
+    }
+
+    return bytes;
+}
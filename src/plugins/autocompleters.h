@@ -46,5 +46,6 @@ void autocompleters_filepath_add(const char* const plugin_name, const char* pref
 char* autocompleters_complete(const char* const input, gboolean previous);
 void autocompleters_reset(void);
 void autocompleters_destroy(void);
+gsize autocompleters_memory(const char* const plugin_name);
 
 #endif
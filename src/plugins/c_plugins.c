@@ -78,7 +78,7 @@ c_plugin_create(const char* const filename)
         return NULL;
     }
 
-    plugin = malloc(sizeof(ProfPlugin));
+    plugin = calloc(1, sizeof(ProfPlugin));
     plugin->name = strdup(filename);
     plugin->lang = LANG_C;
     plugin->module = handle;
@@ -113,6 +113,10 @@ c_plugin_create(const char* const filename)
     plugin->on_chat_win_focus = c_on_chat_win_focus_hook;
     plugin->on_room_win_focus = c_on_room_win_focus_hook;
 
+    for (int i = 0; i < PROF_HOOK_COUNT; i++) {
+        plugin->hooks[i] = dlsym(handle, plugins_hook_name(i));
+    }
+
     g_string_free(path, TRUE);
 
     return plugin;
@@ -128,7 +132,7 @@ c_init_hook(ProfPlugin* plugin, const char* const version, const char* const sta
 
     assert(plugin && plugin->module);
 
-    if (NULL == (f = dlsym(plugin->module, "prof_init"))) {
+    if (NULL == (f = plugin->hooks[PROF_HOOK_INIT])) {
         log_warning("warning: %s does not have init function", plugin->name);
         return;
     }
@@ -156,7 +160,7 @@ c_on_start_hook(ProfPlugin* plugin)
     void (*func)(void);
     assert(plugin && plugin->module);
 
-    if (NULL == (f = dlsym(plugin->module, "prof_on_start")))
+    if (NULL == (f = plugin->hooks[PROF_HOOK_ON_START]))
         return;
 
     func = (void (*)(void))f;
@@ -170,7 +174,7 @@ c_on_shutdown_hook(ProfPlugin* plugin)
     void (*func)(void);
     assert(plugin && plugin->module);
 
-    if (NULL == (f = dlsym(plugin->module, "prof_on_shutdown")))
+    if (NULL == (f = plugin->hooks[PROF_HOOK_ON_SHUTDOWN]))
         return;
 
     func = (void (*)(void))f;
@@ -184,7 +188,7 @@ c_on_unload_hook(ProfPlugin* plugin)
     void (*func)(void);
     assert(plugin && plugin->module);
 
-    if (NULL == (f = dlsym(plugin->module, "prof_on_unload")))
+    if (NULL == (f = plugin->hooks[PROF_HOOK_ON_UNLOAD]))
         return;
 
     func = (void (*)(void))f;
@@ -198,7 +202,7 @@ c_on_connect_hook(ProfPlugin* plugin, const char* const account_name, const char
     void (*func)(const char* const __account_name, const char* const __fulljid);
     assert(plugin && plugin->module);
 
-    if (NULL == (f = dlsym(plugin->module, "prof_on_connect")))
+    if (NULL == (f = plugin->hooks[PROF_HOOK_ON_CONNECT]))
         return;
 
     func = (void (*)(const char* const, const char* const))f;
@@ -212,7 +216,7 @@ c_on_disconnect_hook(ProfPlugin* plugin, const char* const account_name, const c
     void (*func)(const char* const __account_name, const char* const __fulljid);
     assert(plugin && plugin->module);
 
-    if (NULL == (f = dlsym(plugin->module, "prof_on_disconnect")))
+    if (NULL == (f = plugin->hooks[PROF_HOOK_ON_DISCONNECT]))
         return;
 
     func = (void (*)(const char* const, const char* const))f;
@@ -226,7 +230,7 @@ c_pre_chat_message_display_hook(ProfPlugin* plugin, const char* const barejid, c
     char* (*func)(const char* const __barejid, const char* const __resource, const char* __message);
     assert(plugin && plugin->module);
 
-    if (NULL == (f = dlsym(plugin->module, "prof_pre_chat_message_display")))
+    if (NULL == (f = plugin->hooks[PROF_HOOK_PRE_CHAT_MESSAGE_DISPLAY]))
         return NULL;
 
     func = (char* (*)(const char* const, const char* const, const char*))f;
@@ -240,7 +244,7 @@ c_post_chat_message_display_hook(ProfPlugin* plugin, const char* const barejid,
     void (*func)(const char* const __barejid, const char* const __resource, const char* __message);
     assert(plugin && plugin->module);
 
-    if (NULL == (f = dlsym(plugin->module, "prof_post_chat_message_display")))
+    if (NULL == (f = plugin->hooks[PROF_HOOK_POST_CHAT_MESSAGE_DISPLAY]))
         return;
 
     func = (void (*)(const char* const, const char* const, const char*))f;
@@ -254,7 +258,7 @@ c_pre_chat_message_send_hook(ProfPlugin* plugin, const char* const barejid, cons
     char* (*func)(const char* const __barejid, const char* __message);
     assert(plugin && plugin->module);
 
-    if (NULL == (f = dlsym(plugin->module, "prof_pre_chat_message_send")))
+    if (NULL == (f = plugin->hooks[PROF_HOOK_PRE_CHAT_MESSAGE_SEND]))
         return NULL;
 
     func = (char* (*)(const char* const, const char*))f;
@@ -268,7 +272,7 @@ c_post_chat_message_send_hook(ProfPlugin* plugin, const char* const barejid, con
     void (*func)(const char* const __barejid, const char* __message);
     assert(plugin && plugin->module);
 
-    if (NULL == (f = dlsym(plugin->module, "prof_post_chat_message_send")))
+    if (NULL == (f = plugin->hooks[PROF_HOOK_POST_CHAT_MESSAGE_SEND]))
         return;
 
     func = (void (*)(const char* const, const char*))f;
@@ -282,7 +286,7 @@ c_pre_room_message_display_hook(ProfPlugin* plugin, const char* const barejid, c
     char* (*func)(const char* const __barejid, const char* const __nick, const char* __message);
     assert(plugin && plugin->module);
 
-    if (NULL == (f = dlsym(plugin->module, "prof_pre_room_message_display")))
+    if (NULL == (f = plugin->hooks[PROF_HOOK_PRE_ROOM_MESSAGE_DISPLAY]))
         return NULL;
 
     func = (char* (*)(const char* const, const char* const, const char*))f;
@@ -297,7 +301,7 @@ c_post_room_message_display_hook(ProfPlugin* plugin, const char* const barejid,
     void (*func)(const char* const __barejid, const char* const __nick, const char* __message);
     assert(plugin && plugin->module);
 
-    if (NULL == (f = dlsym(plugin->module, "prof_post_room_message_display")))
+    if (NULL == (f = plugin->hooks[PROF_HOOK_POST_ROOM_MESSAGE_DISPLAY]))
         return;
 
     func = (void (*)(const char* const, const char* const, const char*))f;
@@ -311,7 +315,7 @@ c_pre_room_message_send_hook(ProfPlugin* plugin, const char* const barejid, cons
     char* (*func)(const char* const __barejid, const char* __message);
     assert(plugin && plugin->module);
 
-    if (NULL == (f = dlsym(plugin->module, "prof_pre_room_message_send")))
+    if (NULL == (f = plugin->hooks[PROF_HOOK_PRE_ROOM_MESSAGE_SEND]))
         return NULL;
 
     func = (char* (*)(const char* const, const char*))f;
@@ -325,7 +329,7 @@ c_post_room_message_send_hook(ProfPlugin* plugin, const char* const barejid, con
     void (*func)(const char* const __barejid, const char* __message);
     assert(plugin && plugin->module);
 
-    if (NULL == (f = dlsym(plugin->module, "prof_post_room_message_send")))
+    if (NULL == (f = plugin->hooks[PROF_HOOK_POST_ROOM_MESSAGE_SEND]))
         return;
 
     func = (void (*)(const char* const, const char*))f;
@@ -341,7 +345,7 @@ c_on_room_history_message_hook(ProfPlugin* plugin, const char* const barejid, co
                  const char* const __timestamp);
     assert(plugin && plugin->module);
 
-    if (NULL == (f = dlsym(plugin->module, "prof_on_room_history_message")))
+    if (NULL == (f = plugin->hooks[PROF_HOOK_ON_ROOM_HISTORY_MESSAGE]))
         return;
 
     func = (void (*)(const char* const, const char* const, const char* const, const char* const))f;
@@ -355,7 +359,7 @@ c_pre_priv_message_display_hook(ProfPlugin* plugin, const char* const barejid, c
     char* (*func)(const char* const __barejid, const char* const __nick, const char* __message);
     assert(plugin && plugin->module);
 
-    if (NULL == (f = dlsym(plugin->module, "prof_pre_priv_message_display")))
+    if (NULL == (f = plugin->hooks[PROF_HOOK_PRE_PRIV_MESSAGE_DISPLAY]))
         return NULL;
 
     func = (char* (*)(const char* const, const char* const, const char*))f;
@@ -370,7 +374,7 @@ c_post_priv_message_display_hook(ProfPlugin* plugin, const char* const barejid,
     void (*func)(const char* const __barejid, const char* const __nick, const char* __message);
     assert(plugin && plugin->module);
 
-    if (NULL == (f = dlsym(plugin->module, "prof_post_priv_message_display")))
+    if (NULL == (f = plugin->hooks[PROF_HOOK_POST_PRIV_MESSAGE_DISPLAY]))
         return;
 
     func = (void (*)(const char* const, const char* const, const char*))f;
@@ -384,7 +388,7 @@ c_pre_priv_message_send_hook(ProfPlugin* plugin, const char* const barejid, cons
     char* (*func)(const char* const __barejid, const char* const __nick, const char* __message);
     assert(plugin && plugin->module);
 
-    if (NULL == (f = dlsym(plugin->module, "prof_pre_priv_message_send")))
+    if (NULL == (f = plugin->hooks[PROF_HOOK_PRE_PRIV_MESSAGE_SEND]))
         return NULL;
 
     func = (char* (*)(const char* const, const char* const, const char*))f;
@@ -398,7 +402,7 @@ c_post_priv_message_send_hook(ProfPlugin* plugin, const char* const barejid, con
     void (*func)(const char* const __barejid, const char* const __nick, const char* __message);
     assert(plugin && plugin->module);
 
-    if (NULL == (f = dlsym(plugin->module, "prof_post_priv_message_send")))
+    if (NULL == (f = plugin->hooks[PROF_HOOK_POST_PRIV_MESSAGE_SEND]))
         return;
 
     func = (void (*)(const char* const, const char* const, const char*))f;
@@ -412,7 +416,7 @@ c_on_message_stanza_send_hook(ProfPlugin* plugin, const char* const text)
     char* (*func)(const char* const __text);
     assert(plugin && plugin->module);
 
-    if (NULL == (f = dlsym(plugin->module, "prof_on_message_stanza_send")))
+    if (NULL == (f = plugin->hooks[PROF_HOOK_ON_MESSAGE_STANZA_SEND]))
         return NULL;
 
     func = (char* (*)(const char* const))f;
@@ -426,7 +430,7 @@ c_on_message_stanza_receive_hook(ProfPlugin* plugin, const char* const text)
     int (*func)(const char* const __text);
     assert(plugin && plugin->module);
 
-    if (NULL == (f = dlsym(plugin->module, "prof_on_message_stanza_receive")))
+    if (NULL == (f = plugin->hooks[PROF_HOOK_ON_MESSAGE_STANZA_RECEIVE]))
         return TRUE;
 
     func = (int (*)(const char* const))f;
@@ -440,7 +444,7 @@ c_on_presence_stanza_send_hook(ProfPlugin* plugin, const char* const text)
     char* (*func)(const char* const __text);
     assert(plugin && plugin->module);
 
-    if (NULL == (f = dlsym(plugin->module, "prof_on_presence_stanza_send")))
+    if (NULL == (f = plugin->hooks[PROF_HOOK_ON_PRESENCE_STANZA_SEND]))
         return NULL;
 
     func = (char* (*)(const char* const))f;
@@ -454,7 +458,7 @@ c_on_presence_stanza_receive_hook(ProfPlugin* plugin, const char* const text)
     int (*func)(const char* const __text);
     assert(plugin && plugin->module);
 
-    if (NULL == (f = dlsym(plugin->module, "prof_on_presence_stanza_receive")))
+    if (NULL == (f = plugin->hooks[PROF_HOOK_ON_PRESENCE_STANZA_RECEIVE]))
         return TRUE;
 
     func = (int (*)(const char* const))f;
@@ -468,7 +472,7 @@ c_on_iq_stanza_send_hook(ProfPlugin* plugin, const char* const text)
     char* (*func)(const char* const __text);
     assert(plugin && plugin->module);
 
-    if (NULL == (f = dlsym(plugin->module, "prof_on_iq_stanza_send")))
+    if (NULL == (f = plugin->hooks[PROF_HOOK_ON_IQ_STANZA_SEND]))
         return NULL;
 
     func = (char* (*)(const char* const))f;
@@ -482,7 +486,7 @@ c_on_iq_stanza_receive_hook(ProfPlugin* plugin, const char* const text)
     int (*func)(const char* const __text);
     assert(plugin && plugin->module);
 
-    if (NULL == (f = dlsym(plugin->module, "prof_on_iq_stanza_receive")))
+    if (NULL == (f = plugin->hooks[PROF_HOOK_ON_IQ_STANZA_RECEIVE]))
         return TRUE;
 
     func = (int (*)(const char* const))f;
@@ -497,7 +501,7 @@ c_on_contact_offline_hook(ProfPlugin* plugin, const char* const barejid, const c
     void (*func)(const char* const __barejid, const char* const __resource, const char* const __status);
     assert(plugin && plugin->module);
 
-    if (NULL == (f = dlsym(plugin->module, "prof_on_contact_offline")))
+    if (NULL == (f = plugin->hooks[PROF_HOOK_ON_CONTACT_OFFLINE]))
         return;
 
     func = (void (*)(const char* const, const char* const, const char* const))f;
@@ -513,7 +517,7 @@ c_on_contact_presence_hook(ProfPlugin* plugin, const char* const barejid, const
                  const char* const __status, const int __priority);
     assert(plugin && plugin->module);
 
-    if (NULL == (f = dlsym(plugin->module, "prof_on_contact_presence")))
+    if (NULL == (f = plugin->hooks[PROF_HOOK_ON_CONTACT_PRESENCE]))
         return;
 
     func = (void (*)(const char* const, const char* const, const char* const, const char* const, const int))f;
@@ -527,7 +531,7 @@ c_on_chat_win_focus_hook(ProfPlugin* plugin, const char* const barejid)
     void (*func)(const char* const __barejid);
     assert(plugin && plugin->module);
 
-    if (NULL == (f = dlsym(plugin->module, "prof_on_chat_win_focus")))
+    if (NULL == (f = plugin->hooks[PROF_HOOK_ON_CHAT_WIN_FOCUS]))
         return;
 
     func = (void (*)(const char* const))f;
@@ -541,7 +545,7 @@ c_on_room_win_focus_hook(ProfPlugin* plugin, const char* const barejid)
     void (*func)(const char* const __barejid);
     assert(plugin && plugin->module);
 
-    if (NULL == (f = dlsym(plugin->module, "prof_on_room_win_focus")))
+    if (NULL == (f = plugin->hooks[PROF_HOOK_ON_ROOM_WIN_FOCUS]))
         return;
 
     func = (void (*)(const char* const))f;
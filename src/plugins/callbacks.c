@@ -43,12 +43,15 @@
 #include "plugins/callbacks.h"
 #include "plugins/plugins.h"
 #include "tools/autocomplete.h"
+#include "tools/memstats.h"
 #include "tools/parser.h"
 #include "ui/ui.h"
 #include "ui/window_list.h"
 
 static GHashTable* p_commands = NULL;
 static GHashTable* p_timed_functions = NULL;
+// timed functions with an interval, ordered by next_run as a binary min-heap
+static GPtrArray* p_timed_heap = NULL;
 static GHashTable* p_window_callbacks = NULL;
 
 static void
@@ -116,6 +119,83 @@ _free_command_hash(GHashTable* command_hash)
     g_hash_table_destroy(command_hash);
 }
 
+#define TIMED_NOT_SCHEDULED G_MAXUINT
+
+static void
+_timed_heap_set(guint index, PluginTimedFunction* timed_function)
+{
+    g_ptr_array_index(p_timed_heap, index) = timed_function;
+    timed_function->heap_index = index;
+}
+
+static void
+_timed_heap_sift_up(guint index)
+{
+    PluginTimedFunction* timed_function = g_ptr_array_index(p_timed_heap, index);
+    while (index > 0) {
+        guint parent = (index - 1) / 2;
+        PluginTimedFunction* parent_function = g_ptr_array_index(p_timed_heap, parent);
+        if (parent_function->next_run <= timed_function->next_run) {
+            break;
+        }
+        _timed_heap_set(index, parent_function);
+        index = parent;
+    }
+    _timed_heap_set(index, timed_function);
+}
+
+static void
+_timed_heap_sift_down(guint index)
+{
+    PluginTimedFunction* timed_function = g_ptr_array_index(p_timed_heap, index);
+    guint len = p_timed_heap->len;
+    while (TRUE) {
+        guint child = index * 2 + 1;
+        if (child >= len) {
+            break;
+        }
+        if (child + 1 < len) {
+            PluginTimedFunction* left = g_ptr_array_index(p_timed_heap, child);
+            PluginTimedFunction* right = g_ptr_array_index(p_timed_heap, child + 1);
+            if (right->next_run < left->next_run) {
+                child++;
+            }
+        }
+        PluginTimedFunction* child_function = g_ptr_array_index(p_timed_heap, child);
+        if (timed_function->next_run <= child_function->next_run) {
+            break;
+        }
+        _timed_heap_set(index, child_function);
+        index = child;
+    }
+    _timed_heap_set(index, timed_function);
+}
+
+static void
+_timed_heap_push(PluginTimedFunction* timed_function)
+{
+    g_ptr_array_add(p_timed_heap, timed_function);
+    _timed_heap_sift_up(p_timed_heap->len - 1);
+}
+
+static void
+_timed_heap_remove(PluginTimedFunction* timed_function)
+{
+    guint index = timed_function->heap_index;
+    if (!p_timed_heap || index == TIMED_NOT_SCHEDULED) {
+        return;
+    }
+    timed_function->heap_index = TIMED_NOT_SCHEDULED;
+
+    PluginTimedFunction* last = g_ptr_array_remove_index(p_timed_heap, p_timed_heap->len - 1);
+    if (last == timed_function) {
+        return;
+    }
+    _timed_heap_set(index, last);
+    _timed_heap_sift_up(index);
+    _timed_heap_sift_down(last->heap_index);
+}
+
 static void
 _free_timed_function(PluginTimedFunction* timed_function)
 {
@@ -125,7 +205,7 @@ _free_timed_function(PluginTimedFunction* timed_function)
         timed_function->callback_destroy(timed_function->callback);
     }
 
-    g_timer_destroy(timed_function->timer);
+    _timed_heap_remove(timed_function);
 
     free(timed_function);
 }
@@ -141,6 +221,7 @@ callbacks_init(void)
 {
     p_commands = g_hash_table_new_full(g_str_hash, g_str_equal, free, (GDestroyNotify)_free_command_hash);
     p_timed_functions = g_hash_table_new_full(g_str_hash, g_str_equal, free, (GDestroyNotify)_free_timed_function_list);
+    p_timed_heap = g_ptr_array_new();
     p_window_callbacks = g_hash_table_new_full(g_str_hash, g_str_equal, free, (GDestroyNotify)_free_window_callbacks);
 }
 
@@ -184,10 +265,64 @@ callbacks_close(void)
     p_window_callbacks = NULL;
     g_hash_table_destroy(p_timed_functions);
     p_timed_functions = NULL;
+    g_ptr_array_free(p_timed_heap, TRUE);
+    p_timed_heap = NULL;
     g_hash_table_destroy(p_commands);
     p_commands = NULL;
 }
 
+gsize
+callbacks_memory(const char* const plugin_name, guint* callbacks)
+{
+    gsize bytes = 0;
+    GHashTableIter iter;
+    gpointer key;
+    gpointer value;
+
+    GHashTable* command_hash = g_hash_table_lookup(p_commands, plugin_name);
+    if (command_hash) {
+        bytes += memstats_hash_table(command_hash);
+        g_hash_table_iter_init(&iter, command_hash);
+        while (g_hash_table_iter_next(&iter, &key, &value)) {
+            PluginCommand* command = value;
+            bytes += memstats_str(key) + sizeof(PluginCommand) + memstats_str(command->command_name);
+            if (command->help) {
+                bytes += sizeof(CommandHelp) + memstats_str(command->help->desc);
+                for (int i = 0; command->help->tags[i] != NULL; i++) {
+                    bytes += memstats_str(command->help->tags[i]);
+                }
+                for (int i = 0; command->help->synopsis[i] != NULL; i++) {
+                    bytes += memstats_str(command->help->synopsis[i]);
+                }
+                for (int i = 0; command->help->args[i][0] != NULL; i++) {
+                    bytes += memstats_str(command->help->args[i][0]) + memstats_str(command->help->args[i][1]);
+                }
+                for (int i = 0; command->help->examples[i] != NULL; i++) {
+                    bytes += memstats_str(command->help->examples[i]);
+                }
+            }
+            (*callbacks)++;
+        }
+    }
+
+    GList* timed_functions = g_hash_table_lookup(p_timed_functions, plugin_name);
+    guint timed = g_list_length(timed_functions);
+    bytes += timed * (sizeof(GList) + sizeof(PluginTimedFunction));
+    *callbacks += timed;
+
+    GHashTable* window_callbacks = g_hash_table_lookup(p_window_callbacks, plugin_name);
+    if (window_callbacks) {
+        bytes += memstats_hash_table(window_callbacks);
+        g_hash_table_iter_init(&iter, window_callbacks);
+        while (g_hash_table_iter_next(&iter, &key, NULL)) {
+            bytes += memstats_str(key) + sizeof(PluginWindowCallback);
+            (*callbacks)++;
+        }
+    }
+
+    return bytes;
+}
+
 void
 callbacks_add_command(const char* const plugin_name, PluginCommand* command)
 {
@@ -214,6 +349,12 @@ callbacks_add_timed(const char* const plugin_name, PluginTimedFunction* timed_fu
         timed_function_list = g_list_append(timed_function_list, timed_function);
         g_hash_table_insert(p_timed_functions, strdup(plugin_name), timed_function_list);
     }
+
+    timed_function->heap_index = TIMED_NOT_SCHEDULED;
+    if (timed_function->interval_seconds > 0) {
+        timed_function->next_run = g_get_monotonic_time() + (gint64)timed_function->interval_seconds * G_USEC_PER_SEC;
+        _timed_heap_push(timed_function);
+    }
 }
 
 gboolean
@@ -331,28 +472,35 @@ plugins_get_help(const char* const cmd)
 void
 plugins_run_timed(void)
 {
-    GList* timed_functions_lists = g_hash_table_get_values(p_timed_functions);
+    gint64 now = g_get_monotonic_time();
 
-    GList* curr_list = timed_functions_lists;
-    while (curr_list) {
-        GList* timed_function_list = curr_list->data;
-        GList* curr = timed_function_list;
-        while (curr) {
-            PluginTimedFunction* timed_function = curr->data;
+    while (p_timed_heap->len > 0) {
+        PluginTimedFunction* timed_function = g_ptr_array_index(p_timed_heap, 0);
+        if (timed_function->next_run > now) {
+            break;
+        }
 
-            gdouble elapsed = g_timer_elapsed(timed_function->timer, NULL);
+        // reschedule before running, the callback may unload its own plugin
+        timed_function->next_run = now + (gint64)timed_function->interval_seconds * G_USEC_PER_SEC;
+        _timed_heap_sift_down(0);
+        timed_function->callback_exec(timed_function);
+    }
+}
 
-            if (timed_function->interval_seconds > 0 && elapsed >= timed_function->interval_seconds) {
-                timed_function->callback_exec(timed_function);
-                g_timer_start(timed_function->timer);
-            }
+gint
+plugins_timed_next_wakeup(void)
+{
+    if (!p_timed_heap || p_timed_heap->len == 0) {
+        return -1;
+    }
 
-            curr = g_list_next(curr);
-        }
-        curr_list = g_list_next(curr_list);
+    PluginTimedFunction* timed_function = g_ptr_array_index(p_timed_heap, 0);
+    gint64 remaining = timed_function->next_run - g_get_monotonic_time();
+    if (remaining <= 0) {
+        return 0;
     }
 
-    g_list_free(timed_functions_lists);
+    return (gint)((remaining + 999) / 1000);
 }
 
 GList*
@@ -57,7 +57,8 @@ typedef struct p_timed_function
     void (*callback_exec)(struct p_timed_function* timed_function);
     void (*callback_destroy)(void* callback);
     int interval_seconds;
-    GTimer* timer;
+    gint64 next_run;
+    guint heap_index;
 } PluginTimedFunction;
 
 typedef struct p_window_input_callback
@@ -70,6 +71,8 @@ typedef struct p_window_input_callback
 void callbacks_init(void);
 void callbacks_remove(const char* const plugin_name);
 void callbacks_close(void);
+// approximate bytes held for the plugin's commands, timers and window handlers
+gsize callbacks_memory(const char* const plugin_name, guint* callbacks);
 
 void callbacks_add_command(const char* const plugin_name, PluginCommand* command);
 void callbacks_add_timed(const char* const plugin_name, PluginTimedFunction* timed_function);
@@ -0,0 +1,274 @@
+/*
+ * hook_queue.c
+ * vim: expandtab:ts=4:sts=4:sw=4
+ *
+ * This file is part of Profanity.
+ *
+ * Profanity is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Profanity is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Profanity.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link the code of portions of this program with the OpenSSL library under
+ * certain conditions as described in each individual source file, and
+ * distribute linked combinations including the two.
+ *
+ * You must obey the GNU General Public License in all respects for all of the
+ * code used other than OpenSSL. If you modify file(s) with this exception, you
+ * may extend this exception to your version of the file(s), but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version. If you delete this exception statement from all
+ * source files in the program, then also delete it here.
+ *
+ */
+
+#include "config.h"
+
+#include <stdlib.h>
+#include <pthread.h>
+
+#include <glib.h>
+
+#include "log.h"
+#include "profanity.h"
+#include "plugins/hook_queue.h"
+
+#define HOOK_QUEUE_MAX_THREADS 2
+
+typedef struct hook_queue_job_t
+{
+    hook_queue_func func;
+    void* data;
+    GDestroyNotify destroy;
+} HookQueueJob;
+
+typedef struct plugin_queue_t
+{
+    ProfPlugin* plugin;
+    GQueue jobs;
+    // a pool thread is draining this queue
+    gboolean scheduled;
+    // the plugin is being removed, calls pushed now are dropped
+    gboolean closing;
+} PluginQueue;
+
+static GThreadPool* pool = NULL;
+static GHashTable* queues = NULL;
+static GMutex queue_lock;
+static GCond queue_idle;
+static gboolean closing = FALSE;
+
+static void
+_hook_queue_job_free(HookQueueJob* job)
+{
+    if (job->destroy) {
+        job->destroy(job->data);
+    }
+    free(job);
+}
+
+static void
+_plugin_queue_free(PluginQueue* queue)
+{
+    g_queue_clear_full(&queue->jobs, (GDestroyNotify)_hook_queue_job_free);
+    free(queue);
+}
+
+static void
+_hook_queue_run(gpointer data, gpointer user_data)
+{
+    PluginQueue* queue = data;
+
+    while (TRUE) {
+        g_mutex_lock(&queue_lock);
+        HookQueueJob* job = g_queue_pop_head(&queue->jobs);
+        if (!job) {
+            queue->scheduled = FALSE;
+            g_cond_broadcast(&queue_idle);
+            g_mutex_unlock(&queue_lock);
+            return;
+        }
+        g_mutex_unlock(&queue_lock);
+
+        job->func(queue->plugin, job->data);
+        _hook_queue_job_free(job);
+    }
+}
+
+// Called with the main loop lock held, a queued hook may be waiting for it
+// to make an API call, so release it while waiting. Waits without limit when
+// end_time is negative, returns FALSE if the queue is still busy at end_time.
+static gboolean
+_hook_queue_wait_idle(PluginQueue* queue, gint64 end_time)
+{
+    if (!queue->scheduled) {
+        return TRUE;
+    }
+
+    g_mutex_unlock(&queue_lock);
+    pthread_mutex_unlock(&lock);
+    g_mutex_lock(&queue_lock);
+    while (queue->scheduled) {
+        if (end_time < 0) {
+            g_cond_wait(&queue_idle, &queue_lock);
+        } else if (!g_cond_wait_until(&queue_idle, &queue_lock, end_time)) {
+            break;
+        }
+    }
+    gboolean idle = !queue->scheduled;
+    g_mutex_unlock(&queue_lock);
+    pthread_mutex_lock(&lock);
+    g_mutex_lock(&queue_lock);
+
+    return idle;
+}
+
+void
+hook_queue_init(void)
+{
+    GError* error = NULL;
+    pool = g_thread_pool_new(_hook_queue_run, NULL, HOOK_QUEUE_MAX_THREADS, FALSE, &error);
+    if (!pool) {
+        log_error("[Plugins] Could not create hook worker pool, notifying plugins synchronously: %s", error->message);
+        g_error_free(error);
+    }
+    queues = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, (GDestroyNotify)_plugin_queue_free);
+    closing = FALSE;
+}
+
+gboolean
+hook_queue_drain(gint timeout_ms)
+{
+    if (!queues) {
+        return TRUE;
+    }
+
+    gint64 end_time = g_get_monotonic_time() + (gint64)timeout_ms * G_TIME_SPAN_MILLISECOND;
+    gboolean idle = TRUE;
+
+    g_mutex_lock(&queue_lock);
+    // a plugin may be removed while waiting, look each queue up again
+    GList* plugins = g_hash_table_get_keys(queues);
+    for (GList* curr = plugins; curr; curr = g_list_next(curr)) {
+        PluginQueue* queue = g_hash_table_lookup(queues, curr->data);
+        if (queue && !_hook_queue_wait_idle(queue, end_time)) {
+            log_warning("[Plugins] Timed out waiting for queued hook calls of plugin %s", queue->plugin->name);
+            idle = FALSE;
+        }
+    }
+    g_list_free(plugins);
+    g_mutex_unlock(&queue_lock);
+
+    return idle;
+}
+
+void
+hook_queue_close(void)
+{
+    if (!queues) {
+        return;
+    }
+
+    hook_queue_drain(HOOK_QUEUE_DRAIN_TIMEOUT_MS);
+
+    g_mutex_lock(&queue_lock);
+    closing = TRUE;
+    GList* plugins = g_hash_table_get_keys(queues);
+    for (GList* curr = plugins; curr; curr = g_list_next(curr)) {
+        PluginQueue* queue = g_hash_table_lookup(queues, curr->data);
+        if (!queue) {
+            continue;
+        }
+        guint dropped = g_queue_get_length(&queue->jobs);
+        if (dropped > 0) {
+            log_warning("[Plugins] Dropping %u queued hook calls for plugin %s", dropped, queue->plugin->name);
+        }
+        g_queue_clear_full(&queue->jobs, (GDestroyNotify)_hook_queue_job_free);
+        _hook_queue_wait_idle(queue, -1);
+    }
+    g_list_free(plugins);
+    g_hash_table_destroy(queues);
+    queues = NULL;
+    g_mutex_unlock(&queue_lock);
+
+    if (pool) {
+        g_thread_pool_free(pool, TRUE, TRUE);
+        pool = NULL;
+    }
+}
+
+gboolean
+hook_queue_push(ProfPlugin* plugin, hook_queue_func func, void* data, GDestroyNotify destroy)
+{
+    if (!pool) {
+        return FALSE;
+    }
+
+    HookQueueJob* job = malloc(sizeof(HookQueueJob));
+    job->func = func;
+    job->data = data;
+    job->destroy = destroy;
+
+    g_mutex_lock(&queue_lock);
+    if (closing) {
+        g_mutex_unlock(&queue_lock);
+        _hook_queue_job_free(job);
+        return TRUE;
+    }
+
+    PluginQueue* queue = g_hash_table_lookup(queues, plugin);
+    if (queue && queue->closing) {
+        g_mutex_unlock(&queue_lock);
+        _hook_queue_job_free(job);
+        return TRUE;
+    }
+    if (!queue) {
+        queue = calloc(1, sizeof(PluginQueue));
+        queue->plugin = plugin;
+        g_queue_init(&queue->jobs);
+        g_hash_table_insert(queues, plugin, queue);
+    }
+
+    g_queue_push_tail(&queue->jobs, job);
+    if (!queue->scheduled) {
+        queue->scheduled = TRUE;
+        g_thread_pool_push(pool, queue, NULL);
+    }
+    g_mutex_unlock(&queue_lock);
+
+    return TRUE;
+}
+
+void
+hook_queue_remove_plugin(ProfPlugin* plugin)
+{
+    if (!queues) {
+        return;
+    }
+
+    g_mutex_lock(&queue_lock);
+    PluginQueue* queue = g_hash_table_lookup(queues, plugin);
+    if (queue && !queue->closing) {
+        // stays in the table while waiting so calls pushed meanwhile are
+        // dropped instead of scheduling it again
+        queue->closing = TRUE;
+        guint dropped = g_queue_get_length(&queue->jobs);
+        if (dropped > 0) {
+            log_debug("[Plugins] Dropping %u queued hook calls for unloaded plugin %s", dropped, plugin->name);
+        }
+        g_queue_clear_full(&queue->jobs, (GDestroyNotify)_hook_queue_job_free);
+        _hook_queue_wait_idle(queue, -1);
+        // not scheduled and nothing can schedule it again, safe to free
+        g_hash_table_remove(queues, plugin);
+    }
+    g_mutex_unlock(&queue_lock);
+}
@@ -0,0 +1,64 @@
+/*
+ * hook_queue.h
+ * vim: expandtab:ts=4:sts=4:sw=4
+ *
+ * This file is part of Profanity.
+ *
+ * Profanity is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Profanity is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Profanity.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link the code of portions of this program with the OpenSSL library under
+ * certain conditions as described in each individual source file, and
+ * distribute linked combinations including the two.
+ *
+ * You must obey the GNU General Public License in all respects for all of the
+ * code used other than OpenSSL. If you modify file(s) with this exception, you
+ * may extend this exception to your version of the file(s), but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version. If you delete this exception statement from all
+ * source files in the program, then also delete it here.
+ *
+ */
+
+#ifndef PLUGINS_HOOK_QUEUE_H
+#define PLUGINS_HOOK_QUEUE_H
+
+#include <glib.h>
+
+#include "plugins/plugins.h"
+
+// how long shutdown waits for queued hook calls before dropping them
+#define HOOK_QUEUE_DRAIN_TIMEOUT_MS 5000
+
+typedef void (*hook_queue_func)(ProfPlugin* plugin, void* data);
+
+void hook_queue_init(void);
+// Run what is still queued, see hook_queue_drain(), then drop what is left
+// and stop the workers.
+void hook_queue_close(void);
+
+// Run func on a plugin worker thread. Calls queued for the same plugin run
+// one at a time in the order they were pushed. Calls pushed for a plugin that
+// is being removed are dropped. Returns FALSE, without taking ownership of
+// data, when no worker is available.
+gboolean hook_queue_push(ProfPlugin* plugin, hook_queue_func func, void* data, GDestroyNotify destroy);
+
+// Wait up to timeout_ms for every queued call to run. Returns FALSE if some
+// plugin is still busy when the time is up.
+gboolean hook_queue_drain(gint timeout_ms);
+
+// Drop calls still queued for the plugin and wait for a running one to finish.
+void hook_queue_remove_plugin(ProfPlugin* plugin);
+
+#endif
@@ -42,6 +42,9 @@
 #include "common.h"
 #include "config/files.h"
 #include "config/preferences.h"
+#include "tools/memstats.h"
+#include "tools/metrics.h"
+#include "tools/trace.h"
 #include "event/client_events.h"
 #include "plugins/callbacks.h"
 #include "plugins/autocompleters.h"
@@ -50,6 +53,7 @@
 #include "plugins/themes.h"
 #include "plugins/settings.h"
 #include "plugins/disco.h"
+#include "plugins/hook_queue.h"
 #include "ui/ui.h"
 #include "xmpp/xmpp.h"
 
@@ -65,9 +69,347 @@
 
 static GHashTable* plugins;
 
+// plugins defining each hook, rebuilt whenever the set of loaded plugins changes
+static GList* subscribers[PROF_HOOK_COUNT];
+
+static const char* const hook_names[PROF_HOOK_COUNT] = {
+    [PROF_HOOK_INIT] = "prof_init",
+    [PROF_HOOK_ON_START] = "prof_on_start",
+    [PROF_HOOK_ON_SHUTDOWN] = "prof_on_shutdown",
+    [PROF_HOOK_ON_UNLOAD] = "prof_on_unload",
+    [PROF_HOOK_ON_CONNECT] = "prof_on_connect",
+    [PROF_HOOK_ON_DISCONNECT] = "prof_on_disconnect",
+    [PROF_HOOK_PRE_CHAT_MESSAGE_DISPLAY] = "prof_pre_chat_message_display",
+    [PROF_HOOK_POST_CHAT_MESSAGE_DISPLAY] = "prof_post_chat_message_display",
+    [PROF_HOOK_PRE_CHAT_MESSAGE_SEND] = "prof_pre_chat_message_send",
+    [PROF_HOOK_POST_CHAT_MESSAGE_SEND] = "prof_post_chat_message_send",
+    [PROF_HOOK_PRE_ROOM_MESSAGE_DISPLAY] = "prof_pre_room_message_display",
+    [PROF_HOOK_POST_ROOM_MESSAGE_DISPLAY] = "prof_post_room_message_display",
+    [PROF_HOOK_PRE_ROOM_MESSAGE_SEND] = "prof_pre_room_message_send",
+    [PROF_HOOK_POST_ROOM_MESSAGE_SEND] = "prof_post_room_message_send",
+    [PROF_HOOK_ON_ROOM_HISTORY_MESSAGE] = "prof_on_room_history_message",
+    [PROF_HOOK_PRE_PRIV_MESSAGE_DISPLAY] = "prof_pre_priv_message_display",
+    [PROF_HOOK_POST_PRIV_MESSAGE_DISPLAY] = "prof_post_priv_message_display",
+    [PROF_HOOK_PRE_PRIV_MESSAGE_SEND] = "prof_pre_priv_message_send",
+    [PROF_HOOK_POST_PRIV_MESSAGE_SEND] = "prof_post_priv_message_send",
+    [PROF_HOOK_ON_MESSAGE_STANZA_SEND] = "prof_on_message_stanza_send",
+    [PROF_HOOK_ON_MESSAGE_STANZA_RECEIVE] = "prof_on_message_stanza_receive",
+    [PROF_HOOK_ON_PRESENCE_STANZA_SEND] = "prof_on_presence_stanza_send",
+    [PROF_HOOK_ON_PRESENCE_STANZA_RECEIVE] = "prof_on_presence_stanza_receive",
+    [PROF_HOOK_ON_IQ_STANZA_SEND] = "prof_on_iq_stanza_send",
+    [PROF_HOOK_ON_IQ_STANZA_RECEIVE] = "prof_on_iq_stanza_receive",
+    [PROF_HOOK_ON_CONTACT_OFFLINE] = "prof_on_contact_offline",
+    [PROF_HOOK_ON_CONTACT_PRESENCE] = "prof_on_contact_presence",
+    [PROF_HOOK_ON_CHAT_WIN_FOCUS] = "prof_on_chat_win_focus",
+    [PROF_HOOK_ON_ROOM_WIN_FOCUS] = "prof_on_room_win_focus",
+};
+
+static const gint64 hook_bucket_limits[PLUGINS_HOOK_BUCKETS - 1] = PLUGINS_HOOK_BUCKET_LIMITS;
+// hook calls taking at least this long are logged, 0 disables
+static gint64 slow_hook_us = 0;
+
+// Set by plugin runtimes that must take a lock before running the hook, the
+// Python GIL and on workers the main loop lock, so waiting for it is not
+// counted as time spent in the hook.
+static _Thread_local gint64 hook_clock_start = 0;
+static _Thread_local gint64 hook_clock_stop = 0;
+
+static gint64
+_plugins_hook_start(void)
+{
+    hook_clock_start = 0;
+    hook_clock_stop = 0;
+    return g_get_monotonic_time();
+}
+
+// Called once the hook's runtime lock is held, only the first call counts
+void
+plugins_hook_clock_start(void)
+{
+    if (hook_clock_start == 0) {
+        hook_clock_start = g_get_monotonic_time();
+    }
+}
+
+// Called before the hook's runtime lock is released, the last call counts
+void
+plugins_hook_clock_stop(void)
+{
+    hook_clock_stop = g_get_monotonic_time();
+}
+
+static gboolean
+_plugins_loaded(ProfPlugin* plugin)
+{
+    if (!plugins) {
+        return FALSE;
+    }
+
+    GHashTableIter iter;
+    gpointer value;
+    g_hash_table_iter_init(&iter, plugins);
+    while (g_hash_table_iter_next(&iter, NULL, &value)) {
+        if (value == plugin) {
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+// Hooks run either on the main thread or on a hook worker holding the main
+// loop lock, so the statistics need no further locking.
+static void
+_plugins_hook_done(ProfPlugin* plugin, prof_hook_t hook, gint64 start)
+{
+    // the hook may have unloaded its own plugin
+    if (!_plugins_loaded(plugin)) {
+        return;
+    }
+
+    gint64 end = g_get_monotonic_time();
+    if (hook_clock_start >= start && hook_clock_stop >= hook_clock_start) {
+        start = hook_clock_start;
+        end = hook_clock_stop;
+    }
+
+    if (trace_enabled()) {
+        auto_gchar gchar* detail = g_strdup_printf("%s %s", plugin->name, plugins_hook_name(hook));
+        metrics_record_span(METRIC_PLUGIN_HOOK, start, end, detail);
+    } else {
+        metrics_record_span(METRIC_PLUGIN_HOOK, start, end, NULL);
+    }
+
+    gint64 elapsed = end - start;
+    PluginHookStats* stats = &plugin->hook_stats[hook];
+
+    stats->calls++;
+    stats->total_us += elapsed;
+    if (elapsed > stats->max_us) {
+        stats->max_us = elapsed;
+    }
+
+    int bucket = 0;
+    while (bucket < PLUGINS_HOOK_BUCKETS - 1 && elapsed >= hook_bucket_limits[bucket]) {
+        bucket++;
+    }
+    stats->buckets[bucket]++;
+
+    if (slow_hook_us > 0 && elapsed >= slow_hook_us) {
+        log_warning("[Plugins] Slow hook: %s took %" G_GINT64_FORMAT " ms in %s", plugin->name, elapsed / 1000, plugins_hook_name(hook));
+    }
+}
+
+const PluginHookStats*
+plugins_get_hook_stats(const char* const name, prof_hook_t hook)
+{
+    ProfPlugin* plugin = g_hash_table_lookup(plugins, name);
+    if (!plugin) {
+        return NULL;
+    }
+
+    return &plugin->hook_stats[hook];
+}
+
+void
+plugins_reset_hook_stats(void)
+{
+    GList* values = g_hash_table_get_values(plugins);
+    for (GList* curr = values; curr; curr = g_list_next(curr)) {
+        ProfPlugin* plugin = curr->data;
+        memset(plugin->hook_stats, 0, sizeof(plugin->hook_stats));
+    }
+    g_list_free(values);
+}
+
+void
+plugins_set_slow_hook_threshold(gint ms)
+{
+    slow_hook_us = (gint64)ms * 1000;
+}
+
+typedef struct plugin_hook_call_t
+{
+    prof_hook_t hook;
+    char* args[4];
+    int num;
+} PluginHookCall;
+
+static void
+_plugins_hook_call_free(PluginHookCall* call)
+{
+    for (int i = 0; i < 4; i++) {
+        free(call->args[i]);
+    }
+    free(call);
+}
+
+static void
+_plugins_call_hook(ProfPlugin* plugin, PluginHookCall* call)
+{
+    char** args = call->args;
+    gint64 start = _plugins_hook_start();
+
+    switch (call->hook) {
+    case PROF_HOOK_ON_CONNECT:
+        plugin->on_connect_func(plugin, args[0], args[1]);
+        break;
+    case PROF_HOOK_ON_DISCONNECT:
+        plugin->on_disconnect_func(plugin, args[0], args[1]);
+        break;
+    case PROF_HOOK_POST_CHAT_MESSAGE_DISPLAY:
+        plugin->post_chat_message_display(plugin, args[0], args[1], args[2]);
+        break;
+    case PROF_HOOK_POST_CHAT_MESSAGE_SEND:
+        plugin->post_chat_message_send(plugin, args[0], args[1]);
+        break;
+    case PROF_HOOK_POST_ROOM_MESSAGE_DISPLAY:
+        plugin->post_room_message_display(plugin, args[0], args[1], args[2]);
+        break;
+    case PROF_HOOK_POST_ROOM_MESSAGE_SEND:
+        plugin->post_room_message_send(plugin, args[0], args[1]);
+        break;
+    case PROF_HOOK_ON_ROOM_HISTORY_MESSAGE:
+        plugin->on_room_history_message(plugin, args[0], args[1], args[2], args[3]);
+        break;
+    case PROF_HOOK_POST_PRIV_MESSAGE_DISPLAY:
+        plugin->post_priv_message_display(plugin, args[0], args[1], args[2]);
+        break;
+    case PROF_HOOK_POST_PRIV_MESSAGE_SEND:
+        plugin->post_priv_message_send(plugin, args[0], args[1], args[2]);
+        break;
+    case PROF_HOOK_ON_CONTACT_OFFLINE:
+        plugin->on_contact_offline(plugin, args[0], args[1], args[2]);
+        break;
+    case PROF_HOOK_ON_CONTACT_PRESENCE:
+        plugin->on_contact_presence(plugin, args[0], args[1], args[2], args[3], call->num);
+        break;
+    case PROF_HOOK_ON_CHAT_WIN_FOCUS:
+        plugin->on_chat_win_focus(plugin, args[0]);
+        break;
+    case PROF_HOOK_ON_ROOM_WIN_FOCUS:
+        plugin->on_room_win_focus(plugin, args[0]);
+        break;
+    default:
+        log_error("[Plugins] %s is not a notification hook", plugins_hook_name(call->hook));
+        return;
+    }
+
+    _plugins_hook_done(plugin, call->hook, start);
+}
+
+#ifdef HAVE_PYTHON
+static void
+_plugins_call_hook_threaded(ProfPlugin* plugin, void* data)
+{
+    python_thread_attach();
+    _plugins_call_hook(plugin, data);
+    python_thread_detach();
+}
+#endif
+
+// A hook may load, unload or reload plugins, which rebuilds the subscriber
+// lists. Dispatchers walk a copy and skip the plugins that are gone since.
+static gboolean
+_plugins_subscribed(ProfPlugin* plugin, prof_hook_t hook)
+{
+    return g_list_find(subscribers[hook], plugin) != NULL;
+}
+
+// Notification hooks cannot change what the client does, so Python plugins
+// get them on a hook worker thread to keep a slow plugin from stalling the UI.
+// C plugins call the API directly and are notified synchronously.
+static void
+_plugins_notify(prof_hook_t hook, const char* const arg0, const char* const arg1, const char* const arg2,
+                const char* const arg3, int num)
+{
+    PluginHookCall call = { hook, { (char*)arg0, (char*)arg1, (char*)arg2, (char*)arg3 }, num };
+
+    GList* hooked = g_list_copy(subscribers[hook]);
+    for (GList* curr = hooked; curr; curr = g_list_next(curr)) {
+        ProfPlugin* plugin = curr->data;
+        if (!_plugins_subscribed(plugin, hook)) {
+            continue;
+        }
+#ifdef HAVE_PYTHON
+        if (plugin->lang == LANG_PYTHON) {
+            PluginHookCall* queued = malloc(sizeof(PluginHookCall));
+            queued->hook = hook;
+            for (int i = 0; i < 4; i++) {
+                queued->args[i] = call.args[i] ? strdup(call.args[i]) : NULL;
+            }
+            queued->num = num;
+            if (hook_queue_push(plugin, _plugins_call_hook_threaded, queued, (GDestroyNotify)_plugins_hook_call_free)) {
+                continue;
+            }
+            _plugins_hook_call_free(queued);
+        }
+#endif
+        _plugins_call_hook(plugin, &call);
+    }
+    g_list_free(hooked);
+}
+
+const char*
+plugins_hook_name(prof_hook_t hook)
+{
+    return hook_names[hook];
+}
+
+static void
+_plugins_update_subscribers(void)
+{
+    for (int i = 0; i < PROF_HOOK_COUNT; i++) {
+        g_list_free(subscribers[i]);
+        subscribers[i] = NULL;
+    }
+
+    if (!plugins) {
+        return;
+    }
+
+    GList* values = g_hash_table_get_values(plugins);
+    for (GList* curr = values; curr; curr = g_list_next(curr)) {
+        ProfPlugin* plugin = curr->data;
+        for (int i = 0; i < PROF_HOOK_COUNT; i++) {
+            if (plugin->hooks[i]) {
+                subscribers[i] = g_list_prepend(subscribers[i], plugin);
+            }
+        }
+    }
+    g_list_free(values);
+
+    for (int i = 0; i < PROF_HOOK_COUNT; i++) {
+        subscribers[i] = g_list_reverse(subscribers[i]);
+    }
+}
+
+// Our own bookkeeping for each plugin. What a plugin allocates inside its
+// interpreter or library is not visible here.
+static void
+_plugins_memstats(MemStats* stats)
+{
+    GHashTableIter iter;
+    gpointer key;
+    gpointer value;
+    g_hash_table_iter_init(&iter, plugins);
+    while (g_hash_table_iter_next(&iter, &key, &value)) {
+        ProfPlugin* plugin = value;
+        guint callbacks = 0;
+        gsize bytes = memstats_str(key) + sizeof(ProfPlugin) + memstats_str(plugin->name)
+                      + callbacks_memory(plugin->name, &callbacks)
+                      + autocompleters_memory(plugin->name);
+        auto_gchar gchar* name = g_strdup_printf("plugin %s", plugin->name);
+        memstats_add(stats, name, bytes, callbacks);
+    }
+}
+
 static void
 _plugins_shutdown(void)
 {
+    memstats_unregister("plugins");
+    hook_queue_close();
+
     GList* values = g_hash_table_get_values(plugins);
     GList *curr = values, *next;
 
@@ -102,6 +444,7 @@ _plugins_shutdown(void)
     disco_close();
     g_hash_table_destroy(plugins);
     plugins = NULL;
+    _plugins_update_subscribers();
 }
 
 void
@@ -110,9 +453,12 @@ plugins_init(void)
     prof_add_shutdown_routine(_plugins_shutdown);
     plugins = g_hash_table_new_full(g_str_hash, g_str_equal, free, NULL);
     callbacks_init();
+    hook_queue_init();
+    plugins_set_slow_hook_threshold(prefs_get_plugins_slow_hook());
     autocompleters_init();
     plugin_themes_init();
     plugin_settings_init();
+    memstats_register("plugins", _plugins_memstats);
 
 #ifdef HAVE_PYTHON
     python_env_init();
@@ -154,12 +500,16 @@ plugins_init(void)
         }
     }
 
+    _plugins_update_subscribers();
+
     // initialise plugins
     GList* values = g_hash_table_get_values(plugins);
     GList* curr = values;
     while (curr) {
         ProfPlugin* plugin = curr->data;
+        gint64 start = _plugins_hook_start();
         plugin->init_func(plugin, PACKAGE_VERSION, PACKAGE_STATUS, NULL, NULL);
+        _plugins_hook_done(plugin, PROF_HOOK_INIT, start);
         curr = g_list_next(curr);
     }
     g_list_free(values);
@@ -291,10 +641,15 @@ plugins_load(const char* const name, GString* error_message)
     }
     if (plugin) {
         g_hash_table_insert(plugins, strdup(name), plugin);
+        _plugins_update_subscribers();
         if (connection_get_status() == JABBER_CONNECTED) {
+            gint64 start = _plugins_hook_start();
             plugin->init_func(plugin, PACKAGE_VERSION, PACKAGE_STATUS, session_get_account_name(), connection_get_fulljid());
+            _plugins_hook_done(plugin, PROF_HOOK_INIT, start);
         } else {
+            gint64 start = _plugins_hook_start();
             plugin->init_func(plugin, PACKAGE_VERSION, PACKAGE_STATUS, NULL, NULL);
+            _plugins_hook_done(plugin, PROF_HOOK_INIT, start);
         }
         log_info("Loaded plugin: %s", name);
         prefs_add_plugin(name);
@@ -336,7 +691,10 @@ plugins_unload(const char* const name)
 {
     ProfPlugin* plugin = g_hash_table_lookup(plugins, name);
     if (plugin) {
+        hook_queue_remove_plugin(plugin);
+        gint64 start = _plugins_hook_start();
         plugin->on_unload_func(plugin);
+        _plugins_hook_done(plugin, PROF_HOOK_ON_UNLOAD, start);
 #ifdef HAVE_PYTHON
         if (plugin->lang == LANG_PYTHON) {
             python_plugin_destroy(plugin);
@@ -349,6 +707,7 @@ plugins_unload(const char* const name)
 #endif
         prefs_remove_plugin(name);
         g_hash_table_remove(plugins, name);
+        _plugins_update_subscribers();
 
         caps_reset_ver();
         // resend presence to update server's disco info data for this client
@@ -464,78 +823,76 @@ plugins_close_win(const char* const plugin_name, const char* const tag)
 static void
 _plugins_on_shutdown(void)
 {
-    GList* values = g_hash_table_get_values(plugins);
-    GList* curr = values;
-    while (curr) {
+    // let queued notifications such as on_disconnect run first
+    hook_queue_drain(HOOK_QUEUE_DRAIN_TIMEOUT_MS);
+
+    GList* hooked = g_list_copy(subscribers[PROF_HOOK_ON_SHUTDOWN]);
+    for (GList* curr = hooked; curr; curr = g_list_next(curr)) {
         ProfPlugin* plugin = curr->data;
+        if (!_plugins_subscribed(plugin, PROF_HOOK_ON_SHUTDOWN)) {
+            continue;
+        }
+        gint64 start = _plugins_hook_start();
         plugin->on_shutdown_func(plugin);
-        curr = g_list_next(curr);
+        _plugins_hook_done(plugin, PROF_HOOK_ON_SHUTDOWN, start);
     }
-    g_list_free(values);
+    g_list_free(hooked);
 }
 
 void
 plugins_on_start(void)
 {
     prof_add_shutdown_routine(_plugins_on_shutdown);
-    GList* values = g_hash_table_get_values(plugins);
-    GList* curr = values;
-    while (curr) {
+    GList* hooked = g_list_copy(subscribers[PROF_HOOK_ON_START]);
+    for (GList* curr = hooked; curr; curr = g_list_next(curr)) {
         ProfPlugin* plugin = curr->data;
+        if (!_plugins_subscribed(plugin, PROF_HOOK_ON_START)) {
+            continue;
+        }
+        gint64 start = _plugins_hook_start();
         plugin->on_start_func(plugin);
-        curr = g_list_next(curr);
+        _plugins_hook_done(plugin, PROF_HOOK_ON_START, start);
     }
-    g_list_free(values);
+    g_list_free(hooked);
 }
 
 void
 plugins_on_connect(const char* const account_name, const char* const fulljid)
 {
-    GList* values = g_hash_table_get_values(plugins);
-    GList* curr = values;
-    while (curr) {
-        ProfPlugin* plugin = curr->data;
-        plugin->on_connect_func(plugin, account_name, fulljid);
-        curr = g_list_next(curr);
-    }
-    g_list_free(values);
+    _plugins_notify(PROF_HOOK_ON_CONNECT, account_name, fulljid, NULL, NULL, 0);
 }
 
 void
 plugins_on_disconnect(const char* const account_name, const char* const fulljid)
 {
-    GList* values = g_hash_table_get_values(plugins);
-    GList* curr = values;
-    while (curr) {
-        ProfPlugin* plugin = curr->data;
-        plugin->on_disconnect_func(plugin, account_name, fulljid);
-        curr = g_list_next(curr);
-    }
-    g_list_free(values);
+    _plugins_notify(PROF_HOOK_ON_DISCONNECT, account_name, fulljid, NULL, NULL, 0);
 }
 
 char*
 plugins_pre_chat_message_display(const char* const barejid, const char* const resource, const char* message)
 {
-    GList* values = g_hash_table_get_values(plugins);
-    if (!values) {
+    if (!subscribers[PROF_HOOK_PRE_CHAT_MESSAGE_DISPLAY]) {
         return NULL;
     }
 
     char* new_message = NULL;
     char* curr_message = strdup(message);
 
-    GList* curr = values;
-    while (curr) {
+    GList* hooked = g_list_copy(subscribers[PROF_HOOK_PRE_CHAT_MESSAGE_DISPLAY]);
+    for (GList* curr = hooked; curr; curr = g_list_next(curr)) {
         ProfPlugin* plugin = curr->data;
+        if (!_plugins_subscribed(plugin, PROF_HOOK_PRE_CHAT_MESSAGE_DISPLAY)) {
+            continue;
+        }
+        gint64 start = _plugins_hook_start();
         new_message = plugin->pre_chat_message_display(plugin, barejid, resource, curr_message);
+        _plugins_hook_done(plugin, PROF_HOOK_PRE_CHAT_MESSAGE_DISPLAY, start);
         if (new_message) {
             free(curr_message);
             curr_message = new_message;
         }
-        curr = g_list_next(curr);
     }
-    g_list_free(values);
+    g_list_free(hooked);
 
     return curr_message;
 }
@@ -543,44 +900,37 @@ plugins_pre_chat_message_display(const char* const barejid, const char* const re
 void
 plugins_post_chat_message_display(const char* const barejid, const char* const resource, const char* message)
 {
-    GList* values = g_hash_table_get_values(plugins);
-    GList* curr = values;
-    while (curr) {
-        ProfPlugin* plugin = curr->data;
-        plugin->post_chat_message_display(plugin, barejid, resource, message);
-        curr = g_list_next(curr);
-    }
-    g_list_free(values);
+    _plugins_notify(PROF_HOOK_POST_CHAT_MESSAGE_DISPLAY, barejid, resource, message, NULL, 0);
 }
 
 char*
 plugins_pre_chat_message_send(const char* const barejid, const char* message)
 {
-    GList* values = g_hash_table_get_values(plugins);
-    if (!values) {
+    if (!subscribers[PROF_HOOK_PRE_CHAT_MESSAGE_SEND]) {
         return NULL;
     }
 
     char* new_message = NULL;
     char* curr_message = strdup(message);
 
-    GList* curr = values;
-    while (curr) {
+    GList* hooked = g_list_copy(subscribers[PROF_HOOK_PRE_CHAT_MESSAGE_SEND]);
+    for (GList* curr = hooked; curr; curr = g_list_next(curr)) {
         ProfPlugin* plugin = curr->data;
-        if (plugin->contains_hook(plugin, "prof_pre_chat_message_send")) {
-            new_message = plugin->pre_chat_message_send(plugin, barejid, curr_message);
-            free(curr_message);
-            if (new_message) {
-                curr_message = new_message;
-            } else {
-                g_list_free(values);
-
-                return NULL;
-            }
+        if (!_plugins_subscribed(plugin, PROF_HOOK_PRE_CHAT_MESSAGE_SEND)) {
+            continue;
+        }
+        gint64 start = _plugins_hook_start();
+        new_message = plugin->pre_chat_message_send(plugin, barejid, curr_message);
+        _plugins_hook_done(plugin, PROF_HOOK_PRE_CHAT_MESSAGE_SEND, start);
+        free(curr_message);
+        if (new_message) {
+            curr_message = new_message;
+        } else {
+            curr_message = NULL;
+            break;
         }
-        curr = g_list_next(curr);
     }
-    g_list_free(values);
+    g_list_free(hooked);
 
     return curr_message;
 }
@@ -588,38 +938,34 @@ plugins_pre_chat_message_send(const char* const barejid, const char* message)
 void
 plugins_post_chat_message_send(const char* const barejid, const char* message)
 {
-    GList* values = g_hash_table_get_values(plugins);
-    GList* curr = values;
-    while (curr) {
-        ProfPlugin* plugin = curr->data;
-        plugin->post_chat_message_send(plugin, barejid, message);
-        curr = g_list_next(curr);
-    }
-    g_list_free(values);
+    _plugins_notify(PROF_HOOK_POST_CHAT_MESSAGE_SEND, barejid, message, NULL, NULL, 0);
 }
 
 char*
 plugins_pre_room_message_display(const char* const barejid, const char* const nick, const char* message)
 {
-    GList* values = g_hash_table_get_values(plugins);
-    if (!values) {
+    if (!subscribers[PROF_HOOK_PRE_ROOM_MESSAGE_DISPLAY]) {
         return NULL;
     }
 
     char* new_message = NULL;
     char* curr_message = strdup(message);
 
-    GList* curr = values;
-    while (curr) {
+    GList* hooked = g_list_copy(subscribers[PROF_HOOK_PRE_ROOM_MESSAGE_DISPLAY]);
+    for (GList* curr = hooked; curr; curr = g_list_next(curr)) {
         ProfPlugin* plugin = curr->data;
+        if (!_plugins_subscribed(plugin, PROF_HOOK_PRE_ROOM_MESSAGE_DISPLAY)) {
+            continue;
+        }
+        gint64 start = _plugins_hook_start();
         new_message = plugin->pre_room_message_display(plugin, barejid, nick, curr_message);
+        _plugins_hook_done(plugin, PROF_HOOK_PRE_ROOM_MESSAGE_DISPLAY, start);
         if (new_message) {
             free(curr_message);
             curr_message = new_message;
         }
-        curr = g_list_next(curr);
     }
-    g_list_free(values);
+    g_list_free(hooked);
 
     return curr_message;
 }
@@ -627,44 +973,37 @@ plugins_pre_room_message_display(const char* const barejid, const char* const ni
 void
 plugins_post_room_message_display(const char* const barejid, const char* const nick, const char* message)
 {
-    GList* values = g_hash_table_get_values(plugins);
-    GList* curr = values;
-    while (curr) {
-        ProfPlugin* plugin = curr->data;
-        plugin->post_room_message_display(plugin, barejid, nick, message);
-        curr = g_list_next(curr);
-    }
-    g_list_free(values);
+    _plugins_notify(PROF_HOOK_POST_ROOM_MESSAGE_DISPLAY, barejid, nick, message, NULL, 0);
 }
 
 char*
 plugins_pre_room_message_send(const char* const barejid, const char* message)
 {
-    GList* values = g_hash_table_get_values(plugins);
-    if (!values) {
+    if (!subscribers[PROF_HOOK_PRE_ROOM_MESSAGE_SEND]) {
         return NULL;
     }
 
     char* new_message = NULL;
     char* curr_message = strdup(message);
 
-    GList* curr = values;
-    while (curr) {
+    GList* hooked = g_list_copy(subscribers[PROF_HOOK_PRE_ROOM_MESSAGE_SEND]);
+    for (GList* curr = hooked; curr; curr = g_list_next(curr)) {
         ProfPlugin* plugin = curr->data;
-        if (plugin->contains_hook(plugin, "prof_pre_room_message_send")) {
-            new_message = plugin->pre_room_message_send(plugin, barejid, curr_message);
-            free(curr_message);
-            if (new_message) {
-                curr_message = new_message;
-            } else {
-                g_list_free(values);
-
-                return NULL;
-            }
+        if (!_plugins_subscribed(plugin, PROF_HOOK_PRE_ROOM_MESSAGE_SEND)) {
+            continue;
+        }
+        gint64 start = _plugins_hook_start();
+        new_message = plugin->pre_room_message_send(plugin, barejid, curr_message);
+        _plugins_hook_done(plugin, PROF_HOOK_PRE_ROOM_MESSAGE_SEND, start);
+        free(curr_message);
+        if (new_message) {
+            curr_message = new_message;
+        } else {
+            curr_message = NULL;
+            break;
         }
-        curr = g_list_next(curr);
     }
-    g_list_free(values);
+    g_list_free(hooked);
 
     return curr_message;
 }
@@ -672,20 +1011,17 @@ plugins_pre_room_message_send(const char* const barejid, const char* message)
 void
 plugins_post_room_message_send(const char* const barejid, const char* message)
 {
-    GList* values = g_hash_table_get_values(plugins);
-    GList* curr = values;
-    while (curr) {
-        ProfPlugin* plugin = curr->data;
-        plugin->post_room_message_send(plugin, barejid, message);
-        curr = g_list_next(curr);
-    }
-    g_list_free(values);
+    _plugins_notify(PROF_HOOK_POST_ROOM_MESSAGE_SEND, barejid, message, NULL, NULL, 0);
 }
 
 void
 plugins_on_room_history_message(const char* const barejid, const char* const nick, const char* const message,
                                 GDateTime* timestamp)
 {
+    if (!subscribers[PROF_HOOK_ON_ROOM_HISTORY_MESSAGE]) {
+        return;
+    }
+
     char* timestamp_str = NULL;
     GTimeVal timestamp_tv;
     gboolean res = g_date_time_to_timeval(timestamp, &timestamp_tv);
@@ -693,14 +1029,7 @@ plugins_on_room_history_message(const char* const barejid, const char* const nic
         timestamp_str = g_time_val_to_iso8601(&timestamp_tv);
     }
 
-    GList* values = g_hash_table_get_values(plugins);
-    GList* curr = values;
-    while (curr) {
-        ProfPlugin* plugin = curr->data;
-        plugin->on_room_history_message(plugin, barejid, nick, message, timestamp_str);
-        curr = g_list_next(curr);
-    }
-    g_list_free(values);
+    _plugins_notify(PROF_HOOK_ON_ROOM_HISTORY_MESSAGE, barejid, nick, message, timestamp_str, 0);
 
     free(timestamp_str);
 }
@@ -708,8 +1037,7 @@ plugins_on_room_history_message(const char* const barejid, const char* const nic
 char*
 plugins_pre_priv_message_display(const char* const fulljid, const char* message)
 {
-    GList* values = g_hash_table_get_values(plugins);
-    if (!values) {
+    if (!subscribers[PROF_HOOK_PRE_PRIV_MESSAGE_DISPLAY]) {
         return NULL;
     }
 
@@ -717,40 +1045,39 @@ plugins_pre_priv_message_display(const char* const fulljid, const char* message)
     char* new_message = NULL;
     char* curr_message = strdup(message);
 
-    GList* curr = values;
-    while (curr) {
+    GList* hooked = g_list_copy(subscribers[PROF_HOOK_PRE_PRIV_MESSAGE_DISPLAY]);
+    for (GList* curr = hooked; curr; curr = g_list_next(curr)) {
         ProfPlugin* plugin = curr->data;
+        if (!_plugins_subscribed(plugin, PROF_HOOK_PRE_PRIV_MESSAGE_DISPLAY)) {
+            continue;
+        }
+        gint64 start = _plugins_hook_start();
         new_message = plugin->pre_priv_message_display(plugin, jidp->barejid, jidp->resourcepart, curr_message);
+        _plugins_hook_done(plugin, PROF_HOOK_PRE_PRIV_MESSAGE_DISPLAY, start);
         if (new_message) {
             free(curr_message);
             curr_message = new_message;
         }
-        curr = g_list_next(curr);
     }
-    g_list_free(values);
+    g_list_free(hooked);
     return curr_message;
 }
 
 void
 plugins_post_priv_message_display(const char* const fulljid, const char* message)
 {
-    auto_jid Jid* jidp = jid_create(fulljid);
-
-    GList* values = g_hash_table_get_values(plugins);
-    GList* curr = values;
-    while (curr) {
-        ProfPlugin* plugin = curr->data;
-        plugin->post_priv_message_display(plugin, jidp->barejid, jidp->resourcepart, message);
-        curr = g_list_next(curr);
+    if (!subscribers[PROF_HOOK_POST_PRIV_MESSAGE_DISPLAY]) {
+        return;
     }
-    g_list_free(values);
+
+    auto_jid Jid* jidp = jid_create(fulljid);
+    _plugins_notify(PROF_HOOK_POST_PRIV_MESSAGE_DISPLAY, jidp->barejid, jidp->resourcepart, message, NULL, 0);
 }
 
 char*
 plugins_pre_priv_message_send(const char* const fulljid, const char* const message)
 {
-    GList* values = g_hash_table_get_values(plugins);
-    if (!values) {
+    if (!subscribers[PROF_HOOK_PRE_PRIV_MESSAGE_SEND]) {
         return NULL;
     }
 
@@ -758,23 +1085,24 @@ plugins_pre_priv_message_send(const char* const fulljid, const char* const messa
     char* new_message = NULL;
     char* curr_message = strdup(message);
 
-    GList* curr = values;
-    while (curr) {
+    GList* hooked = g_list_copy(subscribers[PROF_HOOK_PRE_PRIV_MESSAGE_SEND]);
+    for (GList* curr = hooked; curr; curr = g_list_next(curr)) {
         ProfPlugin* plugin = curr->data;
-        if (plugin->contains_hook(plugin, "prof_pre_priv_message_send")) {
-            new_message = plugin->pre_priv_message_send(plugin, jidp->barejid, jidp->resourcepart, curr_message);
-            free(curr_message);
-            if (new_message) {
-                curr_message = new_message;
-            } else {
-                g_list_free(values);
-
-                return NULL;
-            }
+        if (!_plugins_subscribed(plugin, PROF_HOOK_PRE_PRIV_MESSAGE_SEND)) {
+            continue;
+        }
+        gint64 start = _plugins_hook_start();
+        new_message = plugin->pre_priv_message_send(plugin, jidp->barejid, jidp->resourcepart, curr_message);
+        _plugins_hook_done(plugin, PROF_HOOK_PRE_PRIV_MESSAGE_SEND, start);
+        free(curr_message);
+        if (new_message) {
+            curr_message = new_message;
+        } else {
+            curr_message = NULL;
+            break;
         }
-        curr = g_list_next(curr);
     }
-    g_list_free(values);
+    g_list_free(hooked);
 
     return curr_message;
 }
@@ -782,41 +1110,39 @@ plugins_pre_priv_message_send(const char* const fulljid, const char* const messa
 void
 plugins_post_priv_message_send(const char* const fulljid, const char* const message)
 {
-    auto_jid Jid* jidp = jid_create(fulljid);
-
-    GList* values = g_hash_table_get_values(plugins);
-    GList* curr = values;
-    while (curr) {
-        ProfPlugin* plugin = curr->data;
-        plugin->post_priv_message_send(plugin, jidp->barejid, jidp->resourcepart, message);
-        curr = g_list_next(curr);
+    if (!subscribers[PROF_HOOK_POST_PRIV_MESSAGE_SEND]) {
+        return;
     }
 
-    g_list_free(values);
+    auto_jid Jid* jidp = jid_create(fulljid);
+    _plugins_notify(PROF_HOOK_POST_PRIV_MESSAGE_SEND, jidp->barejid, jidp->resourcepart, message, NULL, 0);
 }
 
 char*
 plugins_on_message_stanza_send(const char* const text)
 {
-    GList* values = g_hash_table_get_values(plugins);
-    if (!values) {
+    if (!subscribers[PROF_HOOK_ON_MESSAGE_STANZA_SEND]) {
         return NULL;
     }
 
     char* new_stanza = NULL;
     char* curr_stanza = strdup(text);
 
-    GList* curr = values;
-    while (curr) {
+    GList* hooked = g_list_copy(subscribers[PROF_HOOK_ON_MESSAGE_STANZA_SEND]);
+    for (GList* curr = hooked; curr; curr = g_list_next(curr)) {
         ProfPlugin* plugin = curr->data;
+        if (!_plugins_subscribed(plugin, PROF_HOOK_ON_MESSAGE_STANZA_SEND)) {
+            continue;
+        }
+        gint64 start = _plugins_hook_start();
         new_stanza = plugin->on_message_stanza_send(plugin, curr_stanza);
+        _plugins_hook_done(plugin, PROF_HOOK_ON_MESSAGE_STANZA_SEND, start);
         if (new_stanza) {
             free(curr_stanza);
             curr_stanza = new_stanza;
         }
-        curr = g_list_next(curr);
     }
-    g_list_free(values);
+    g_list_free(hooked);
 
     return curr_stanza;
 }
@@ -826,17 +1152,20 @@ plugins_on_message_stanza_receive(const char* const text)
 {
     gboolean cont = TRUE;
 
-    GList* values = g_hash_table_get_values(plugins);
-    GList* curr = values;
-    while (curr) {
+    GList* hooked = g_list_copy(subscribers[PROF_HOOK_ON_MESSAGE_STANZA_RECEIVE]);
+    for (GList* curr = hooked; curr; curr = g_list_next(curr)) {
         ProfPlugin* plugin = curr->data;
+        if (!_plugins_subscribed(plugin, PROF_HOOK_ON_MESSAGE_STANZA_RECEIVE)) {
+            continue;
+        }
+        gint64 start = _plugins_hook_start();
         gboolean res = plugin->on_message_stanza_receive(plugin, text);
+        _plugins_hook_done(plugin, PROF_HOOK_ON_MESSAGE_STANZA_RECEIVE, start);
         if (res == FALSE) {
             cont = FALSE;
         }
-        curr = g_list_next(curr);
     }
-    g_list_free(values);
+    g_list_free(hooked);
 
     return cont;
 }
@@ -844,25 +1173,28 @@ plugins_on_message_stanza_receive(const char* const text)
 char*
 plugins_on_presence_stanza_send(const char* const text)
 {
-    GList* values = g_hash_table_get_values(plugins);
-    if (!values) {
+    if (!subscribers[PROF_HOOK_ON_PRESENCE_STANZA_SEND]) {
         return NULL;
     }
 
     char* new_stanza = NULL;
     char* curr_stanza = strdup(text);
 
-    GList* curr = values;
-    while (curr) {
+    GList* hooked = g_list_copy(subscribers[PROF_HOOK_ON_PRESENCE_STANZA_SEND]);
+    for (GList* curr = hooked; curr; curr = g_list_next(curr)) {
         ProfPlugin* plugin = curr->data;
+        if (!_plugins_subscribed(plugin, PROF_HOOK_ON_PRESENCE_STANZA_SEND)) {
+            continue;
+        }
+        gint64 start = _plugins_hook_start();
         new_stanza = plugin->on_presence_stanza_send(plugin, curr_stanza);
+        _plugins_hook_done(plugin, PROF_HOOK_ON_PRESENCE_STANZA_SEND, start);
         if (new_stanza) {
             free(curr_stanza);
             curr_stanza = new_stanza;
         }
-        curr = g_list_next(curr);
     }
-    g_list_free(values);
+    g_list_free(hooked);
 
     return curr_stanza;
 }
@@ -872,17 +1204,20 @@ plugins_on_presence_stanza_receive(const char* const text)
 {
     gboolean cont = TRUE;
 
-    GList* values = g_hash_table_get_values(plugins);
-    GList* curr = values;
-    while (curr) {
+    GList* hooked = g_list_copy(subscribers[PROF_HOOK_ON_PRESENCE_STANZA_RECEIVE]);
+    for (GList* curr = hooked; curr; curr = g_list_next(curr)) {
         ProfPlugin* plugin = curr->data;
+        if (!_plugins_subscribed(plugin, PROF_HOOK_ON_PRESENCE_STANZA_RECEIVE)) {
+            continue;
+        }
+        gint64 start = _plugins_hook_start();
         gboolean res = plugin->on_presence_stanza_receive(plugin, text);
+        _plugins_hook_done(plugin, PROF_HOOK_ON_PRESENCE_STANZA_RECEIVE, start);
         if (res == FALSE) {
             cont = FALSE;
         }
-        curr = g_list_next(curr);
     }
-    g_list_free(values);
+    g_list_free(hooked);
 
     return cont;
 }
@@ -890,25 +1225,28 @@ plugins_on_presence_stanza_receive(const char* const text)
 char*
 plugins_on_iq_stanza_send(const char* const text)
 {
-    GList* values = g_hash_table_get_values(plugins);
-    if (!values) {
+    if (!subscribers[PROF_HOOK_ON_IQ_STANZA_SEND]) {
         return NULL;
     }
 
     char* new_stanza = NULL;
     char* curr_stanza = strdup(text);
 
-    GList* curr = values;
-    while (curr) {
+    GList* hooked = g_list_copy(subscribers[PROF_HOOK_ON_IQ_STANZA_SEND]);
+    for (GList* curr = hooked; curr; curr = g_list_next(curr)) {
         ProfPlugin* plugin = curr->data;
+        if (!_plugins_subscribed(plugin, PROF_HOOK_ON_IQ_STANZA_SEND)) {
+            continue;
+        }
+        gint64 start = _plugins_hook_start();
         new_stanza = plugin->on_iq_stanza_send(plugin, curr_stanza);
+        _plugins_hook_done(plugin, PROF_HOOK_ON_IQ_STANZA_SEND, start);
         if (new_stanza) {
             free(curr_stanza);
             curr_stanza = new_stanza;
         }
-        curr = g_list_next(curr);
     }
-    g_list_free(values);
+    g_list_free(hooked);
 
     return curr_stanza;
 }
@@ -918,17 +1256,20 @@ plugins_on_iq_stanza_receive(const char* const text)
 {
     gboolean cont = TRUE;
 
-    GList* values = g_hash_table_get_values(plugins);
-    GList* curr = values;
-    while (curr) {
+    GList* hooked = g_list_copy(subscribers[PROF_HOOK_ON_IQ_STANZA_RECEIVE]);
+    for (GList* curr = hooked; curr; curr = g_list_next(curr)) {
         ProfPlugin* plugin = curr->data;
+        if (!_plugins_subscribed(plugin, PROF_HOOK_ON_IQ_STANZA_RECEIVE)) {
+            continue;
+        }
+        gint64 start = _plugins_hook_start();
         gboolean res = plugin->on_iq_stanza_receive(plugin, text);
+        _plugins_hook_done(plugin, PROF_HOOK_ON_IQ_STANZA_RECEIVE, start);
         if (res == FALSE) {
             cont = FALSE;
         }
-        curr = g_list_next(curr);
     }
-    g_list_free(values);
+    g_list_free(hooked);
 
     return cont;
 }
@@ -936,53 +1277,25 @@ plugins_on_iq_stanza_receive(const char* const text)
 void
 plugins_on_contact_offline(const char* const barejid, const char* const resource, const char* const status)
 {
-    GList* values = g_hash_table_get_values(plugins);
-    GList* curr = values;
-    while (curr) {
-        ProfPlugin* plugin = curr->data;
-        plugin->on_contact_offline(plugin, barejid, resource, status);
-        curr = g_list_next(curr);
-    }
-    g_list_free(values);
+    _plugins_notify(PROF_HOOK_ON_CONTACT_OFFLINE, barejid, resource, status, NULL, 0);
 }
 
 void
 plugins_on_contact_presence(const char* const barejid, const char* const resource, const char* const presence, const char* const status, const int priority)
 {
-    GList* values = g_hash_table_get_values(plugins);
-    GList* curr = values;
-    while (curr) {
-        ProfPlugin* plugin = curr->data;
-        plugin->on_contact_presence(plugin, barejid, resource, presence, status, priority);
-        curr = g_list_next(curr);
-    }
-    g_list_free(values);
+    _plugins_notify(PROF_HOOK_ON_CONTACT_PRESENCE, barejid, resource, presence, status, priority);
 }
 
 void
 plugins_on_chat_win_focus(const char* const barejid)
 {
-    GList* values = g_hash_table_get_values(plugins);
-    GList* curr = values;
-    while (curr) {
-        ProfPlugin* plugin = curr->data;
-        plugin->on_chat_win_focus(plugin, barejid);
-        curr = g_list_next(curr);
-    }
-    g_list_free(values);
+    _plugins_notify(PROF_HOOK_ON_CHAT_WIN_FOCUS, barejid, NULL, NULL, NULL, 0);
 }
 
 void
 plugins_on_room_win_focus(const char* const barejid)
 {
-    GList* values = g_hash_table_get_values(plugins);
-    GList* curr = values;
-    while (curr) {
-        ProfPlugin* plugin = curr->data;
-        plugin->on_room_win_focus(plugin, barejid);
-        curr = g_list_next(curr);
-    }
-    g_list_free(values);
+    _plugins_notify(PROF_HOOK_ON_ROOM_WIN_FOCUS, barejid, NULL, NULL, NULL, 0);
 }
 
 GList*
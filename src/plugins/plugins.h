@@ -43,6 +43,52 @@ typedef enum {
     LANG_C
 } lang_t;
 
+typedef enum {
+    PROF_HOOK_INIT,
+    PROF_HOOK_ON_START,
+    PROF_HOOK_ON_SHUTDOWN,
+    PROF_HOOK_ON_UNLOAD,
+    PROF_HOOK_ON_CONNECT,
+    PROF_HOOK_ON_DISCONNECT,
+    PROF_HOOK_PRE_CHAT_MESSAGE_DISPLAY,
+    PROF_HOOK_POST_CHAT_MESSAGE_DISPLAY,
+    PROF_HOOK_PRE_CHAT_MESSAGE_SEND,
+    PROF_HOOK_POST_CHAT_MESSAGE_SEND,
+    PROF_HOOK_PRE_ROOM_MESSAGE_DISPLAY,
+    PROF_HOOK_POST_ROOM_MESSAGE_DISPLAY,
+    PROF_HOOK_PRE_ROOM_MESSAGE_SEND,
+    PROF_HOOK_POST_ROOM_MESSAGE_SEND,
+    PROF_HOOK_ON_ROOM_HISTORY_MESSAGE,
+    PROF_HOOK_PRE_PRIV_MESSAGE_DISPLAY,
+    PROF_HOOK_POST_PRIV_MESSAGE_DISPLAY,
+    PROF_HOOK_PRE_PRIV_MESSAGE_SEND,
+    PROF_HOOK_POST_PRIV_MESSAGE_SEND,
+    PROF_HOOK_ON_MESSAGE_STANZA_SEND,
+    PROF_HOOK_ON_MESSAGE_STANZA_RECEIVE,
+    PROF_HOOK_ON_PRESENCE_STANZA_SEND,
+    PROF_HOOK_ON_PRESENCE_STANZA_RECEIVE,
+    PROF_HOOK_ON_IQ_STANZA_SEND,
+    PROF_HOOK_ON_IQ_STANZA_RECEIVE,
+    PROF_HOOK_ON_CONTACT_OFFLINE,
+    PROF_HOOK_ON_CONTACT_PRESENCE,
+    PROF_HOOK_ON_CHAT_WIN_FOCUS,
+    PROF_HOOK_ON_ROOM_WIN_FOCUS,
+    PROF_HOOK_COUNT
+} prof_hook_t;
+
+// upper bounds in microseconds of the hook latency histogram buckets, the
+// last bucket counts everything slower
+#define PLUGINS_HOOK_BUCKETS 6
+#define PLUGINS_HOOK_BUCKET_LIMITS { 100, 1000, 10000, 100000, 1000000 }
+
+typedef struct plugin_hook_stats_t
+{
+    guint64 calls;
+    gint64 total_us;
+    gint64 max_us;
+    guint64 buckets[PLUGINS_HOOK_BUCKETS];
+} PluginHookStats;
+
 typedef struct prof_plugins_install_t
 {
     GSList* installed;
@@ -54,6 +100,9 @@ typedef struct prof_plugin_t
     char* name;
     lang_t lang;
     void* module;
+    // resolved at load time: symbol address for C, callable for Python, NULL if undefined
+    void* hooks[PROF_HOOK_COUNT];
+    PluginHookStats hook_stats[PROF_HOOK_COUNT];
     void (*init_func)(struct prof_plugin_t* plugin, const char* const version,
                       const char* const status, const char* const account_name, const char* const fulljid);
 
@@ -109,6 +158,12 @@ typedef struct prof_plugin_t
 } ProfPlugin;
 
 void plugins_init(void);
+const char* plugins_hook_name(prof_hook_t hook);
+const PluginHookStats* plugins_get_hook_stats(const char* const name, prof_hook_t hook);
+void plugins_reset_hook_stats(void);
+void plugins_set_slow_hook_threshold(gint ms);
+void plugins_hook_clock_start(void);
+void plugins_hook_clock_stop(void);
 GSList* plugins_unloaded_list(void);
 GList* plugins_loaded_list(void);
 char* plugins_autocomplete(const char* const input, gboolean previous);
@@ -170,6 +225,7 @@ void plugins_on_room_win_focus(const char* const barejid);
 
 gboolean plugins_run_command(const char* const cmd);
 void plugins_run_timed(void);
+gint plugins_timed_next_wakeup(void);
 GList* plugins_get_command_names(void);
 gchar* plugins_get_dir(void);
 CommandHelp* plugins_get_help(const char* const cmd);
@@ -36,8 +36,11 @@
 #undef _XOPEN_SOURCE
 #include <Python.h>
 
+#include <pthread.h>
+
 #include "log.h"
 #include "config.h"
+#include "profanity.h"
 #include "config/preferences.h"
 #include "config/files.h"
 #include "plugins/api.h"
@@ -48,7 +51,11 @@
 #include "plugins/python_plugins.h"
 #include "ui/ui.h"
 
-static PyThreadState* thread_state;
+static _Thread_local PyThreadState* thread_state;
+// set on plugin hook worker threads, which hold the main loop lock whenever
+// they are outside Python so API calls made by a hook are serialised with it
+static _Thread_local gboolean worker_thread = FALSE;
+static _Thread_local PyGILState_STATE worker_gil;
 static GHashTable* loaded_modules;
 
 static void _python_undefined_error(ProfPlugin* plugin, char* hook, char* type);
@@ -56,17 +63,42 @@ static void _python_type_error(ProfPlugin* plugin, char* hook, char* type);
 
 static char* _handle_string_or_none_result(ProfPlugin* plugin, PyObject* result, char* hook);
 static gboolean _handle_boolean_result(ProfPlugin* plugin, PyObject* result, char* hook);
+static PyObject* _python_get_hook(PyObject* p_module, const char* const hook);
 
 void
 allow_python_threads()
 {
+    plugins_hook_clock_stop();
     thread_state = PyEval_SaveThread();
+    if (worker_thread) {
+        pthread_mutex_lock(&lock);
+    }
 }
 
 void
 disable_python_threads()
 {
+    if (worker_thread) {
+        pthread_mutex_unlock(&lock);
+    }
     PyEval_RestoreThread(thread_state);
+    plugins_hook_clock_start();
+}
+
+void
+python_thread_attach(void)
+{
+    worker_gil = PyGILState_Ensure();
+    worker_thread = TRUE;
+    allow_python_threads();
+}
+
+void
+python_thread_detach(void)
+{
+    disable_python_threads();
+    worker_thread = FALSE;
+    PyGILState_Release(worker_gil);
 }
 
 const char*
@@ -124,7 +156,7 @@ python_plugin_create(const char* const filename)
 
     python_check_error();
     if (p_module) {
-        ProfPlugin* plugin = malloc(sizeof(ProfPlugin));
+        ProfPlugin* plugin = calloc(1, sizeof(ProfPlugin));
         plugin->name = strdup(filename);
         plugin->lang = LANG_PYTHON;
         plugin->module = p_module;
@@ -159,6 +191,10 @@ python_plugin_create(const char* const filename)
         plugin->on_chat_win_focus = python_on_chat_win_focus_hook;
         plugin->on_room_win_focus = python_on_room_win_focus_hook;
 
+        for (int i = 0; i < PROF_HOOK_COUNT; i++) {
+            plugin->hooks[i] = _python_get_hook(p_module, plugins_hook_name(i));
+        }
+
         allow_python_threads();
         return plugin;
     } else {
@@ -171,20 +207,15 @@ void
 python_init_hook(ProfPlugin* plugin, const char* const version, const char* const status, const char* const account_name,
                  const char* const fulljid)
 {
+    PyObject* p_function = plugin->hooks[PROF_HOOK_INIT];
+    if (!p_function) {
+        return;
+    }
+
     disable_python_threads();
     PyObject* p_args = Py_BuildValue("ssss", version, status, account_name, fulljid);
-    PyObject* p_function;
-
-    PyObject* p_module = plugin->module;
-    if (PyObject_HasAttrString(p_module, "prof_init")) {
-        p_function = PyObject_GetAttrString(p_module, "prof_init");
-        python_check_error();
-        if (p_function && PyCallable_Check(p_function)) {
-            PyObject_CallObject(p_function, p_args);
-            python_check_error();
-            Py_XDECREF(p_function);
-        }
-    }
+    PyObject_CallObject(p_function, p_args);
+    python_check_error();
     Py_XDECREF(p_args);
     allow_python_threads();
 }
@@ -208,77 +239,57 @@ python_contains_hook(ProfPlugin* plugin, const char* const hook)
 void
 python_on_start_hook(ProfPlugin* plugin)
 {
-    disable_python_threads();
-    PyObject* p_function;
-
-    PyObject* p_module = plugin->module;
-    if (PyObject_HasAttrString(p_module, "prof_on_start")) {
-        p_function = PyObject_GetAttrString(p_module, "prof_on_start");
-        python_check_error();
-        if (p_function && PyCallable_Check(p_function)) {
-            PyObject_CallObject(p_function, NULL);
-            python_check_error();
-            Py_XDECREF(p_function);
-        }
+    PyObject* p_function = plugin->hooks[PROF_HOOK_ON_START];
+    if (!p_function) {
+        return;
     }
+
+    disable_python_threads();
+    PyObject_CallObject(p_function, NULL);
+    python_check_error();
     allow_python_threads();
 }
 
 void
 python_on_shutdown_hook(ProfPlugin* plugin)
 {
-    disable_python_threads();
-    PyObject* p_function;
-
-    PyObject* p_module = plugin->module;
-    if (PyObject_HasAttrString(p_module, "prof_on_shutdown")) {
-        p_function = PyObject_GetAttrString(p_module, "prof_on_shutdown");
-        python_check_error();
-        if (p_function && PyCallable_Check(p_function)) {
-            PyObject_CallObject(p_function, NULL);
-            python_check_error();
-            Py_XDECREF(p_function);
-        }
+    PyObject* p_function = plugin->hooks[PROF_HOOK_ON_SHUTDOWN];
+    if (!p_function) {
+        return;
     }
+
+    disable_python_threads();
+    PyObject_CallObject(p_function, NULL);
+    python_check_error();
     allow_python_threads();
 }
 
 void
 python_on_unload_hook(ProfPlugin* plugin)
 {
-    disable_python_threads();
-    PyObject* p_function;
-
-    PyObject* p_module = plugin->module;
-    if (PyObject_HasAttrString(p_module, "prof_on_unload")) {
-        p_function = PyObject_GetAttrString(p_module, "prof_on_unload");
-        python_check_error();
-        if (p_function && PyCallable_Check(p_function)) {
-            PyObject_CallObject(p_function, NULL);
-            python_check_error();
-            Py_XDECREF(p_function);
-        }
+    PyObject* p_function = plugin->hooks[PROF_HOOK_ON_UNLOAD];
+    if (!p_function) {
+        return;
     }
+
+    disable_python_threads();
+    PyObject_CallObject(p_function, NULL);
+    python_check_error();
     allow_python_threads();
 }
 
 void
 python_on_connect_hook(ProfPlugin* plugin, const char* const account_name, const char* const fulljid)
 {
+    PyObject* p_function = plugin->hooks[PROF_HOOK_ON_CONNECT];
+    if (!p_function) {
+        return;
+    }
+
     disable_python_threads();
     PyObject* p_args = Py_BuildValue("ss", account_name, fulljid);
-    PyObject* p_function;
-
-    PyObject* p_module = plugin->module;
-    if (PyObject_HasAttrString(p_module, "prof_on_connect")) {
-        p_function = PyObject_GetAttrString(p_module, "prof_on_connect");
-        python_check_error();
-        if (p_function && PyCallable_Check(p_function)) {
-            PyObject_CallObject(p_function, p_args);
-            python_check_error();
-            Py_XDECREF(p_function);
-        }
-    }
+    PyObject_CallObject(p_function, p_args);
+    python_check_error();
     Py_XDECREF(p_args);
     allow_python_threads();
 }
@@ -286,20 +297,15 @@ python_on_connect_hook(ProfPlugin* plugin, const char* const account_name, const
 void
 python_on_disconnect_hook(ProfPlugin* plugin, const char* const account_name, const char* const fulljid)
 {
+    PyObject* p_function = plugin->hooks[PROF_HOOK_ON_DISCONNECT];
+    if (!p_function) {
+        return;
+    }
+
     disable_python_threads();
     PyObject* p_args = Py_BuildValue("ss", account_name, fulljid);
-    PyObject* p_function;
-
-    PyObject* p_module = plugin->module;
-    if (PyObject_HasAttrString(p_module, "prof_on_disconnect")) {
-        p_function = PyObject_GetAttrString(p_module, "prof_on_disconnect");
-        python_check_error();
-        if (p_function && PyCallable_Check(p_function)) {
-            PyObject_CallObject(p_function, p_args);
-            python_check_error();
-            Py_XDECREF(p_function);
-        }
-    }
+    PyObject_CallObject(p_function, p_args);
+    python_check_error();
     Py_XDECREF(p_args);
     allow_python_threads();
 }
@@ -308,6 +314,11 @@ char*
 python_pre_chat_message_display_hook(ProfPlugin* plugin, const char* const barejid, const char* const resource,
                                      const char* message)
 {
+    PyObject* p_function = plugin->hooks[PROF_HOOK_PRE_CHAT_MESSAGE_DISPLAY];
+    if (!p_function) {
+        return NULL;
+    }
+
     disable_python_threads();
     PyObject* p_args = Py_BuildValue("sss", barejid, resource, message);
     if (!p_args) {
@@ -315,42 +326,24 @@ python_pre_chat_message_display_hook(ProfPlugin* plugin, const char* const barej
         allow_python_threads();
         return NULL;
     }
-    PyObject* p_function;
-
-    PyObject* p_module = plugin->module;
-    if (PyObject_HasAttrString(p_module, "prof_pre_chat_message_display")) {
-        p_function = PyObject_GetAttrString(p_module, "prof_pre_chat_message_display");
-        python_check_error();
-        if (p_function && PyCallable_Check(p_function)) {
-            PyObject* result = PyObject_CallObject(p_function, p_args);
-            python_check_error();
-            Py_XDECREF(p_function);
-            Py_XDECREF(p_args);
-            return _handle_string_or_none_result(plugin, result, "prof_pre_chat_message_display");
-        }
-    }
+    PyObject* result = PyObject_CallObject(p_function, p_args);
+    python_check_error();
     Py_XDECREF(p_args);
-    allow_python_threads();
-    return NULL;
+    return _handle_string_or_none_result(plugin, result, "prof_pre_chat_message_display");
 }
 
 void
 python_post_chat_message_display_hook(ProfPlugin* plugin, const char* const barejid, const char* const resource, const char* message)
 {
+    PyObject* p_function = plugin->hooks[PROF_HOOK_POST_CHAT_MESSAGE_DISPLAY];
+    if (!p_function) {
+        return;
+    }
+
     disable_python_threads();
     PyObject* p_args = Py_BuildValue("sss", barejid, resource, message);
-    PyObject* p_function;
-
-    PyObject* p_module = plugin->module;
-    if (PyObject_HasAttrString(p_module, "prof_post_chat_message_display")) {
-        p_function = PyObject_GetAttrString(p_module, "prof_post_chat_message_display");
-        python_check_error();
-        if (p_function && PyCallable_Check(p_function)) {
-            PyObject_CallObject(p_function, p_args);
-            python_check_error();
-            Py_XDECREF(p_function);
-        }
-    }
+    PyObject_CallObject(p_function, p_args);
+    python_check_error();
     Py_XDECREF(p_args);
     allow_python_threads();
 }
@@ -358,44 +351,31 @@ python_post_chat_message_display_hook(ProfPlugin* plugin, const char* const bare
 char*
 python_pre_chat_message_send_hook(ProfPlugin* plugin, const char* const barejid, const char* message)
 {
+    PyObject* p_function = plugin->hooks[PROF_HOOK_PRE_CHAT_MESSAGE_SEND];
+    if (!p_function) {
+        return NULL;
+    }
+
     disable_python_threads();
     PyObject* p_args = Py_BuildValue("ss", barejid, message);
-    PyObject* p_function;
-
-    PyObject* p_module = plugin->module;
-    if (PyObject_HasAttrString(p_module, "prof_pre_chat_message_send")) {
-        p_function = PyObject_GetAttrString(p_module, "prof_pre_chat_message_send");
-        python_check_error();
-        if (p_function && PyCallable_Check(p_function)) {
-            PyObject* result = PyObject_CallObject(p_function, p_args);
-            python_check_error();
-            Py_XDECREF(p_function);
-            Py_XDECREF(p_args);
-            return _handle_string_or_none_result(plugin, result, "prof_pre_chat_message_send");
-        }
-    }
+    PyObject* result = PyObject_CallObject(p_function, p_args);
+    python_check_error();
     Py_XDECREF(p_args);
-    allow_python_threads();
-    return NULL;
+    return _handle_string_or_none_result(plugin, result, "prof_pre_chat_message_send");
 }
 
 void
 python_post_chat_message_send_hook(ProfPlugin* plugin, const char* const barejid, const char* message)
 {
+    PyObject* p_function = plugin->hooks[PROF_HOOK_POST_CHAT_MESSAGE_SEND];
+    if (!p_function) {
+        return;
+    }
+
     disable_python_threads();
     PyObject* p_args = Py_BuildValue("ss", barejid, message);
-    PyObject* p_function;
-
-    PyObject* p_module = plugin->module;
-    if (PyObject_HasAttrString(p_module, "prof_post_chat_message_send")) {
-        p_function = PyObject_GetAttrString(p_module, "prof_post_chat_message_send");
-        python_check_error();
-        if (p_function && PyCallable_Check(p_function)) {
-            PyObject_CallObject(p_function, p_args);
-            python_check_error();
-            Py_XDECREF(p_function);
-        }
-    }
+    PyObject_CallObject(p_function, p_args);
+    python_check_error();
     Py_XDECREF(p_args);
     allow_python_threads();
 }
@@ -403,6 +383,11 @@ python_post_chat_message_send_hook(ProfPlugin* plugin, const char* const barejid
 char*
 python_pre_room_message_display_hook(ProfPlugin* plugin, const char* const barejid, const char* const nick, const char* message)
 {
+    PyObject* p_function = plugin->hooks[PROF_HOOK_PRE_ROOM_MESSAGE_DISPLAY];
+    if (!p_function) {
+        return NULL;
+    }
+
     disable_python_threads();
     PyObject* p_args = Py_BuildValue("sss", barejid, nick, message);
     if (!p_args) {
@@ -411,43 +396,25 @@ python_pre_room_message_display_hook(ProfPlugin* plugin, const char* const barej
         return NULL;
     }
 
-    PyObject* p_function;
-
-    PyObject* p_module = plugin->module;
-    if (PyObject_HasAttrString(p_module, "prof_pre_room_message_display")) {
-        p_function = PyObject_GetAttrString(p_module, "prof_pre_room_message_display");
-        python_check_error();
-        if (p_function && PyCallable_Check(p_function)) {
-            PyObject* result = PyObject_CallObject(p_function, p_args);
-            python_check_error();
-            Py_XDECREF(p_function);
-            Py_XDECREF(p_args);
-            return _handle_string_or_none_result(plugin, result, "prof_pre_room_message_display");
-        }
-    }
+    PyObject* result = PyObject_CallObject(p_function, p_args);
+    python_check_error();
     Py_XDECREF(p_args);
-    allow_python_threads();
-    return NULL;
+    return _handle_string_or_none_result(plugin, result, "prof_pre_room_message_display");
 }
 
 void
 python_post_room_message_display_hook(ProfPlugin* plugin, const char* const barejid, const char* const nick,
                                       const char* message)
 {
+    PyObject* p_function = plugin->hooks[PROF_HOOK_POST_ROOM_MESSAGE_DISPLAY];
+    if (!p_function) {
+        return;
+    }
+
     disable_python_threads();
     PyObject* p_args = Py_BuildValue("sss", barejid, nick, message);
-    PyObject* p_function;
-
-    PyObject* p_module = plugin->module;
-    if (PyObject_HasAttrString(p_module, "prof_post_room_message_display")) {
-        p_function = PyObject_GetAttrString(p_module, "prof_post_room_message_display");
-        python_check_error();
-        if (p_function && PyCallable_Check(p_function)) {
-            PyObject_CallObject(p_function, p_args);
-            python_check_error();
-            Py_XDECREF(p_function);
-        }
-    }
+    PyObject_CallObject(p_function, p_args);
+    python_check_error();
     Py_XDECREF(p_args);
     allow_python_threads();
 }
@@ -455,44 +422,31 @@ python_post_room_message_display_hook(ProfPlugin* plugin, const char* const bare
 char*
 python_pre_room_message_send_hook(ProfPlugin* plugin, const char* const barejid, const char* message)
 {
+    PyObject* p_function = plugin->hooks[PROF_HOOK_PRE_ROOM_MESSAGE_SEND];
+    if (!p_function) {
+        return NULL;
+    }
+
     disable_python_threads();
     PyObject* p_args = Py_BuildValue("ss", barejid, message);
-    PyObject* p_function;
-
-    PyObject* p_module = plugin->module;
-    if (PyObject_HasAttrString(p_module, "prof_pre_room_message_send")) {
-        p_function = PyObject_GetAttrString(p_module, "prof_pre_room_message_send");
-        python_check_error();
-        if (p_function && PyCallable_Check(p_function)) {
-            PyObject* result = PyObject_CallObject(p_function, p_args);
-            python_check_error();
-            Py_XDECREF(p_function);
-            Py_XDECREF(p_args);
-            return _handle_string_or_none_result(plugin, result, "prof_pre_room_message_send");
-        }
-    }
+    PyObject* result = PyObject_CallObject(p_function, p_args);
+    python_check_error();
     Py_XDECREF(p_args);
-    allow_python_threads();
-    return NULL;
+    return _handle_string_or_none_result(plugin, result, "prof_pre_room_message_send");
 }
 
 void
 python_post_room_message_send_hook(ProfPlugin* plugin, const char* const barejid, const char* message)
 {
+    PyObject* p_function = plugin->hooks[PROF_HOOK_POST_ROOM_MESSAGE_SEND];
+    if (!p_function) {
+        return;
+    }
+
     disable_python_threads();
     PyObject* p_args = Py_BuildValue("ss", barejid, message);
-    PyObject* p_function;
-
-    PyObject* p_module = plugin->module;
-    if (PyObject_HasAttrString(p_module, "prof_post_room_message_send")) {
-        p_function = PyObject_GetAttrString(p_module, "prof_post_room_message_send");
-        python_check_error();
-        if (p_function && PyCallable_Check(p_function)) {
-            PyObject_CallObject(p_function, p_args);
-            python_check_error();
-            Py_XDECREF(p_function);
-        }
-    }
+    PyObject_CallObject(p_function, p_args);
+    python_check_error();
     Py_XDECREF(p_args);
     allow_python_threads();
 }
@@ -501,20 +455,15 @@ void
 python_on_room_history_message_hook(ProfPlugin* plugin, const char* const barejid, const char* const nick,
                                     const char* const message, const char* const timestamp)
 {
+    PyObject* p_function = plugin->hooks[PROF_HOOK_ON_ROOM_HISTORY_MESSAGE];
+    if (!p_function) {
+        return;
+    }
+
     disable_python_threads();
     PyObject* p_args = Py_BuildValue("ssss", barejid, nick, message, timestamp);
-    PyObject* p_function;
-
-    PyObject* p_module = plugin->module;
-    if (PyObject_HasAttrString(p_module, "prof_on_room_history_message")) {
-        p_function = PyObject_GetAttrString(p_module, "prof_on_room_history_message");
-        python_check_error();
-        if (p_function && PyCallable_Check(p_function)) {
-            PyObject_CallObject(p_function, p_args);
-            python_check_error();
-            Py_XDECREF(p_function);
-        }
-    }
+    PyObject_CallObject(p_function, p_args);
+    python_check_error();
     Py_XDECREF(p_args);
     allow_python_threads();
 }
@@ -523,45 +472,32 @@ char*
 python_pre_priv_message_display_hook(ProfPlugin* plugin, const char* const barejid, const char* const nick,
                                      const char* message)
 {
+    PyObject* p_function = plugin->hooks[PROF_HOOK_PRE_PRIV_MESSAGE_DISPLAY];
+    if (!p_function) {
+        return NULL;
+    }
+
     disable_python_threads();
     PyObject* p_args = Py_BuildValue("sss", barejid, nick, message);
-    PyObject* p_function;
-
-    PyObject* p_module = plugin->module;
-    if (PyObject_HasAttrString(p_module, "prof_pre_priv_message_display")) {
-        p_function = PyObject_GetAttrString(p_module, "prof_pre_priv_message_display");
-        python_check_error();
-        if (p_function && PyCallable_Check(p_function)) {
-            PyObject* result = PyObject_CallObject(p_function, p_args);
-            python_check_error();
-            Py_XDECREF(p_function);
-            Py_XDECREF(p_args);
-            return _handle_string_or_none_result(plugin, result, "prof_pre_priv_message_display");
-        }
-    }
+    PyObject* result = PyObject_CallObject(p_function, p_args);
+    python_check_error();
     Py_XDECREF(p_args);
-    allow_python_threads();
-    return NULL;
+    return _handle_string_or_none_result(plugin, result, "prof_pre_priv_message_display");
 }
 
 void
 python_post_priv_message_display_hook(ProfPlugin* plugin, const char* const barejid, const char* const nick,
                                       const char* message)
 {
+    PyObject* p_function = plugin->hooks[PROF_HOOK_POST_PRIV_MESSAGE_DISPLAY];
+    if (!p_function) {
+        return;
+    }
+
     disable_python_threads();
     PyObject* p_args = Py_BuildValue("sss", barejid, nick, message);
-    PyObject* p_function;
-
-    PyObject* p_module = plugin->module;
-    if (PyObject_HasAttrString(p_module, "prof_post_priv_message_display")) {
-        p_function = PyObject_GetAttrString(p_module, "prof_post_priv_message_display");
-        python_check_error();
-        if (p_function && PyCallable_Check(p_function)) {
-            PyObject_CallObject(p_function, p_args);
-            python_check_error();
-            Py_XDECREF(p_function);
-        }
-    }
+    PyObject_CallObject(p_function, p_args);
+    python_check_error();
     Py_XDECREF(p_args);
     allow_python_threads();
 }
@@ -570,45 +506,32 @@ char*
 python_pre_priv_message_send_hook(ProfPlugin* plugin, const char* const barejid, const char* const nick,
                                   const char* const message)
 {
+    PyObject* p_function = plugin->hooks[PROF_HOOK_PRE_PRIV_MESSAGE_SEND];
+    if (!p_function) {
+        return NULL;
+    }
+
     disable_python_threads();
     PyObject* p_args = Py_BuildValue("sss", barejid, nick, message);
-    PyObject* p_function;
-
-    PyObject* p_module = plugin->module;
-    if (PyObject_HasAttrString(p_module, "prof_pre_priv_message_send")) {
-        p_function = PyObject_GetAttrString(p_module, "prof_pre_priv_message_send");
-        python_check_error();
-        if (p_function && PyCallable_Check(p_function)) {
-            PyObject* result = PyObject_CallObject(p_function, p_args);
-            python_check_error();
-            Py_XDECREF(p_function);
-            Py_XDECREF(p_args);
-            return _handle_string_or_none_result(plugin, result, "prof_pre_priv_message_send");
-        }
-    }
+    PyObject* result = PyObject_CallObject(p_function, p_args);
+    python_check_error();
     Py_XDECREF(p_args);
-    allow_python_threads();
-    return NULL;
+    return _handle_string_or_none_result(plugin, result, "prof_pre_priv_message_send");
 }
 
 void
 python_post_priv_message_send_hook(ProfPlugin* plugin, const char* const barejid, const char* const nick,
                                    const char* const message)
 {
+    PyObject* p_function = plugin->hooks[PROF_HOOK_POST_PRIV_MESSAGE_SEND];
+    if (!p_function) {
+        return;
+    }
+
     disable_python_threads();
     PyObject* p_args = Py_BuildValue("sss", barejid, nick, message);
-    PyObject* p_function;
-
-    PyObject* p_module = plugin->module;
-    if (PyObject_HasAttrString(p_module, "prof_post_priv_message_send")) {
-        p_function = PyObject_GetAttrString(p_module, "prof_post_priv_message_send");
-        python_check_error();
-        if (p_function && PyCallable_Check(p_function)) {
-            PyObject_CallObject(p_function, p_args);
-            python_check_error();
-            Py_XDECREF(p_function);
-        }
-    }
+    PyObject_CallObject(p_function, p_args);
+    python_check_error();
     Py_XDECREF(p_args);
     allow_python_threads();
 }
@@ -616,165 +539,112 @@ python_post_priv_message_send_hook(ProfPlugin* plugin, const char* const barejid
 char*
 python_on_message_stanza_send_hook(ProfPlugin* plugin, const char* const text)
 {
+    PyObject* p_function = plugin->hooks[PROF_HOOK_ON_MESSAGE_STANZA_SEND];
+    if (!p_function) {
+        return NULL;
+    }
+
     disable_python_threads();
     PyObject* p_args = Py_BuildValue("(s)", text);
-    PyObject* p_function;
-
-    PyObject* p_module = plugin->module;
-    if (PyObject_HasAttrString(p_module, "prof_on_message_stanza_send")) {
-        p_function = PyObject_GetAttrString(p_module, "prof_on_message_stanza_send");
-        python_check_error();
-        if (p_function && PyCallable_Check(p_function)) {
-            PyObject* result = PyObject_CallObject(p_function, p_args);
-            python_check_error();
-            Py_XDECREF(p_function);
-            Py_XDECREF(p_args);
-            return _handle_string_or_none_result(plugin, result, "prof_on_message_stanza_send");
-        }
-    }
+    PyObject* result = PyObject_CallObject(p_function, p_args);
+    python_check_error();
     Py_XDECREF(p_args);
-    allow_python_threads();
-    return NULL;
+    return _handle_string_or_none_result(plugin, result, "prof_on_message_stanza_send");
 }
 
 gboolean
 python_on_message_stanza_receive_hook(ProfPlugin* plugin, const char* const text)
 {
+    PyObject* p_function = plugin->hooks[PROF_HOOK_ON_MESSAGE_STANZA_RECEIVE];
+    if (!p_function) {
+        return TRUE;
+    }
+
     disable_python_threads();
     PyObject* p_args = Py_BuildValue("(s)", text);
-    PyObject* p_function;
-
-    PyObject* p_module = plugin->module;
-    if (PyObject_HasAttrString(p_module, "prof_on_message_stanza_receive")) {
-        p_function = PyObject_GetAttrString(p_module, "prof_on_message_stanza_receive");
-        python_check_error();
-        if (p_function && PyCallable_Check(p_function)) {
-            PyObject* result = PyObject_CallObject(p_function, p_args);
-            python_check_error();
-            Py_XDECREF(p_function);
-            Py_XDECREF(p_args);
-            return _handle_boolean_result(plugin, result, "prof_on_message_stanza_receive");
-        }
-    }
+    PyObject* result = PyObject_CallObject(p_function, p_args);
+    python_check_error();
     Py_XDECREF(p_args);
-    allow_python_threads();
-    return TRUE;
+    return _handle_boolean_result(plugin, result, "prof_on_message_stanza_receive");
 }
 
 char*
 python_on_presence_stanza_send_hook(ProfPlugin* plugin, const char* const text)
 {
+    PyObject* p_function = plugin->hooks[PROF_HOOK_ON_PRESENCE_STANZA_SEND];
+    if (!p_function) {
+        return NULL;
+    }
+
     disable_python_threads();
     PyObject* p_args = Py_BuildValue("(s)", text);
-    PyObject* p_function;
-
-    PyObject* p_module = plugin->module;
-    if (PyObject_HasAttrString(p_module, "prof_on_presence_stanza_send")) {
-        p_function = PyObject_GetAttrString(p_module, "prof_on_presence_stanza_send");
-        python_check_error();
-        if (p_function && PyCallable_Check(p_function)) {
-            PyObject* result = PyObject_CallObject(p_function, p_args);
-            python_check_error();
-            Py_XDECREF(p_function);
-            Py_XDECREF(p_args);
-            return _handle_string_or_none_result(plugin, result, "prof_on_presence_stanza_send");
-        }
-    }
+    PyObject* result = PyObject_CallObject(p_function, p_args);
+    python_check_error();
     Py_XDECREF(p_args);
-    allow_python_threads();
-    return NULL;
+    return _handle_string_or_none_result(plugin, result, "prof_on_presence_stanza_send");
 }
 
 gboolean
 python_on_presence_stanza_receive_hook(ProfPlugin* plugin, const char* const text)
 {
+    PyObject* p_function = plugin->hooks[PROF_HOOK_ON_PRESENCE_STANZA_RECEIVE];
+    if (!p_function) {
+        return TRUE;
+    }
+
     disable_python_threads();
     PyObject* p_args = Py_BuildValue("(s)", text);
-    PyObject* p_function;
-
-    PyObject* p_module = plugin->module;
-    if (PyObject_HasAttrString(p_module, "prof_on_presence_stanza_receive")) {
-        p_function = PyObject_GetAttrString(p_module, "prof_on_presence_stanza_receive");
-        python_check_error();
-        if (p_function && PyCallable_Check(p_function)) {
-            PyObject* result = PyObject_CallObject(p_function, p_args);
-            python_check_error();
-            Py_XDECREF(p_function);
-            Py_XDECREF(p_args);
-            return _handle_boolean_result(plugin, result, "prof_on_presence_stanza_receive");
-        }
-    }
+    PyObject* result = PyObject_CallObject(p_function, p_args);
+    python_check_error();
     Py_XDECREF(p_args);
-    allow_python_threads();
-    return TRUE;
+    return _handle_boolean_result(plugin, result, "prof_on_presence_stanza_receive");
 }
 
 char*
 python_on_iq_stanza_send_hook(ProfPlugin* plugin, const char* const text)
 {
+    PyObject* p_function = plugin->hooks[PROF_HOOK_ON_IQ_STANZA_SEND];
+    if (!p_function) {
+        return NULL;
+    }
+
     disable_python_threads();
     PyObject* p_args = Py_BuildValue("(s)", text);
-    PyObject* p_function;
-
-    PyObject* p_module = plugin->module;
-    if (PyObject_HasAttrString(p_module, "prof_on_iq_stanza_send")) {
-        p_function = PyObject_GetAttrString(p_module, "prof_on_iq_stanza_send");
-        python_check_error();
-        if (p_function && PyCallable_Check(p_function)) {
-            PyObject* result = PyObject_CallObject(p_function, p_args);
-            python_check_error();
-            Py_XDECREF(p_function);
-            Py_XDECREF(p_args);
-            return _handle_string_or_none_result(plugin, result, "prof_on_iq_stanza_send");
-        }
-    }
+    PyObject* result = PyObject_CallObject(p_function, p_args);
+    python_check_error();
     Py_XDECREF(p_args);
-    allow_python_threads();
-    return NULL;
+    return _handle_string_or_none_result(plugin, result, "prof_on_iq_stanza_send");
 }
 
 gboolean
 python_on_iq_stanza_receive_hook(ProfPlugin* plugin, const char* const text)
 {
+    PyObject* p_function = plugin->hooks[PROF_HOOK_ON_IQ_STANZA_RECEIVE];
+    if (!p_function) {
+        return TRUE;
+    }
+
     disable_python_threads();
     PyObject* p_args = Py_BuildValue("(s)", text);
-    PyObject* p_function;
-
-    PyObject* p_module = plugin->module;
-    if (PyObject_HasAttrString(p_module, "prof_on_iq_stanza_receive")) {
-        p_function = PyObject_GetAttrString(p_module, "prof_on_iq_stanza_receive");
-        python_check_error();
-        if (p_function && PyCallable_Check(p_function)) {
-            PyObject* result = PyObject_CallObject(p_function, p_args);
-            python_check_error();
-            Py_XDECREF(p_function);
-            Py_XDECREF(p_args);
-            return _handle_boolean_result(plugin, result, "prof_on_iq_stanza_receive");
-        }
-    }
+    PyObject* result = PyObject_CallObject(p_function, p_args);
+    python_check_error();
     Py_XDECREF(p_args);
-    allow_python_threads();
-    return TRUE;
+    return _handle_boolean_result(plugin, result, "prof_on_iq_stanza_receive");
 }
 
 void
 python_on_contact_offline_hook(ProfPlugin* plugin, const char* const barejid, const char* const resource,
                                const char* const status)
 {
+    PyObject* p_function = plugin->hooks[PROF_HOOK_ON_CONTACT_OFFLINE];
+    if (!p_function) {
+        return;
+    }
+
     disable_python_threads();
     PyObject* p_args = Py_BuildValue("sss", barejid, resource, status);
-    PyObject* p_function;
-
-    PyObject* p_module = plugin->module;
-    if (PyObject_HasAttrString(p_module, "prof_on_contact_offline")) {
-        p_function = PyObject_GetAttrString(p_module, "prof_on_contact_offline");
-        python_check_error();
-        if (p_function && PyCallable_Check(p_function)) {
-            PyObject_CallObject(p_function, p_args);
-            python_check_error();
-            Py_XDECREF(p_function);
-        }
-    }
+    PyObject_CallObject(p_function, p_args);
+    python_check_error();
     Py_XDECREF(p_args);
     allow_python_threads();
 }
@@ -783,20 +653,15 @@ void
 python_on_contact_presence_hook(ProfPlugin* plugin, const char* const barejid, const char* const resource,
                                 const char* const presence, const char* const status, const int priority)
 {
+    PyObject* p_function = plugin->hooks[PROF_HOOK_ON_CONTACT_PRESENCE];
+    if (!p_function) {
+        return;
+    }
+
     disable_python_threads();
     PyObject* p_args = Py_BuildValue("ssssi", barejid, resource, presence, status, priority);
-    PyObject* p_function;
-
-    PyObject* p_module = plugin->module;
-    if (PyObject_HasAttrString(p_module, "prof_on_contact_presence")) {
-        p_function = PyObject_GetAttrString(p_module, "prof_on_contact_presence");
-        python_check_error();
-        if (p_function && PyCallable_Check(p_function)) {
-            PyObject_CallObject(p_function, p_args);
-            python_check_error();
-            Py_XDECREF(p_function);
-        }
-    }
+    PyObject_CallObject(p_function, p_args);
+    python_check_error();
     Py_XDECREF(p_args);
     allow_python_threads();
 }
@@ -804,20 +669,15 @@ python_on_contact_presence_hook(ProfPlugin* plugin, const char* const barejid, c
 void
 python_on_chat_win_focus_hook(ProfPlugin* plugin, const char* const barejid)
 {
+    PyObject* p_function = plugin->hooks[PROF_HOOK_ON_CHAT_WIN_FOCUS];
+    if (!p_function) {
+        return;
+    }
+
     disable_python_threads();
     PyObject* p_args = Py_BuildValue("(s)", barejid);
-    PyObject* p_function;
-
-    PyObject* p_module = plugin->module;
-    if (PyObject_HasAttrString(p_module, "prof_on_chat_win_focus")) {
-        p_function = PyObject_GetAttrString(p_module, "prof_on_chat_win_focus");
-        python_check_error();
-        if (p_function && PyCallable_Check(p_function)) {
-            PyObject_CallObject(p_function, p_args);
-            python_check_error();
-            Py_XDECREF(p_function);
-        }
-    }
+    PyObject_CallObject(p_function, p_args);
+    python_check_error();
     Py_XDECREF(p_args);
     allow_python_threads();
 }
@@ -825,20 +685,15 @@ python_on_chat_win_focus_hook(ProfPlugin* plugin, const char* const barejid)
 void
 python_on_room_win_focus_hook(ProfPlugin* plugin, const char* const barejid)
 {
+    PyObject* p_function = plugin->hooks[PROF_HOOK_ON_ROOM_WIN_FOCUS];
+    if (!p_function) {
+        return;
+    }
+
     disable_python_threads();
     PyObject* p_args = Py_BuildValue("(s)", barejid);
-    PyObject* p_function;
-
-    PyObject* p_module = plugin->module;
-    if (PyObject_HasAttrString(p_module, "prof_on_room_win_focus")) {
-        p_function = PyObject_GetAttrString(p_module, "prof_on_room_win_focus");
-        python_check_error();
-        if (p_function && PyCallable_Check(p_function)) {
-            PyObject_CallObject(p_function, p_args);
-            python_check_error();
-            Py_XDECREF(p_function);
-        }
-    }
+    PyObject_CallObject(p_function, p_args);
+    python_check_error();
     Py_XDECREF(p_args);
     allow_python_threads();
 }
@@ -859,6 +714,9 @@ python_plugin_destroy(ProfPlugin* plugin)
     disable_python_threads();
     callbacks_remove(plugin->name);
     disco_remove_features(plugin->name);
+    for (int i = 0; i < PROF_HOOK_COUNT; i++) {
+        Py_XDECREF((PyObject*)plugin->hooks[i]);
+    }
     free(plugin->name);
     free(plugin);
     allow_python_threads();
@@ -872,6 +730,23 @@ python_shutdown(void)
     Py_Finalize();
 }
 
+static PyObject*
+_python_get_hook(PyObject* p_module, const char* const hook)
+{
+    if (!PyObject_HasAttrString(p_module, hook)) {
+        return NULL;
+    }
+
+    PyObject* p_function = PyObject_GetAttrString(p_module, hook);
+    python_check_error();
+    if (p_function && !PyCallable_Check(p_function)) {
+        Py_DECREF(p_function);
+        return NULL;
+    }
+
+    return p_function;
+}
+
 static void
 _python_undefined_error(ProfPlugin* plugin, char* hook, char* type)
 {
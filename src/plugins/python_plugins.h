@@ -43,6 +43,8 @@ void python_plugin_destroy(ProfPlugin* plugin);
 void python_check_error(void);
 void allow_python_threads();
 void disable_python_threads();
+void python_thread_attach(void);
+void python_thread_detach(void);
 
 const char* python_get_version_string(void);
 gchar* python_get_version_number(void);
@@ -61,6 +61,10 @@
 #include "command/cmd_defs.h"
 #include "plugins/plugins.h"
 #include "event/client_events.h"
+#include "tools/http_transfer.h"
+#include "tools/memstats.h"
+#include "tools/metrics.h"
+#include "tools/trace.h"
 #include "ui/ui.h"
 #include "ui/window_list.h"
 #include "xmpp/resource.h"
@@ -70,6 +74,7 @@
 #include "xmpp/chat_session.h"
 #include "xmpp/chat_state.h"
 #include "xmpp/contact.h"
+#include "xmpp/jid.h"
 #include "xmpp/roster_list.h"
 
 #ifdef HAVE_LIBOTR
@@ -115,10 +120,13 @@ prof_run(gchar* log_level, gchar* account_name, gchar* config_file, gchar* log_f
     g_timer_stop(waittimer);
     int waittime;
     while (cont && !force_quit) {
+        gint64 iteration = g_get_monotonic_time();
+        gint64 phase = iteration;
         log_stderr_handler();
         session_check_autoaway();
 
         line = commands ? *commands : inp_readline();
+        phase = trace_phase("loop.readline", phase);
         if (commands && line && memcmp(line, "/sleep", 6) == 0) {
             if (!g_timer_is_active(waittimer)) {
                 gchar* err_msg;
@@ -156,17 +164,29 @@ prof_run(gchar* log_level, gchar* account_name, gchar* config_file, gchar* log_f
             cont = TRUE;
         }
 
+        phase = trace_phase("loop.input", phase);
+
 #ifdef HAVE_LIBOTR
         otr_poll();
 #endif
         plugins_run_timed();
+        phase = trace_phase("loop.plugins_timed", phase);
         notify_remind();
         session_process_events();
+        phase = trace_phase("loop.session_events", phase);
+        http_transfer_process_events();
+        metrics_tick();
+        memstats_tick();
         iq_autoping_check();
+        flush_keyfiles(FALSE);
+        phase = trace_phase("loop.housekeeping", phase);
         ui_update();
+        phase = trace_phase("loop.ui_update", phase);
 #ifdef HAVE_GTK
         tray_update();
+        trace_phase("loop.tray", phase);
 #endif
+        trace_phase("loop", iteration);
     }
     g_timer_destroy(waittimer);
     g_timer_elapsed(runtime, NULL) < min_runtime ? sleep(min_runtime) : (void)NULL;
@@ -220,6 +240,10 @@ _init(char* log_level, char* config_file, char* log_file, char* theme_name)
     auto_gchar gchar* prof_version = prof_get_version();
     log_info("Starting Profanity (%s)…", prof_version);
 
+    metrics_init();
+    metrics_set_dump_interval(prefs_get_stats_dump());
+    memstats_set_log_interval(prefs_get_memory_log());
+
     chatlog_init();
     accounts_load();
 
@@ -241,6 +265,7 @@ _init(char* log_level, char* config_file, char* log_file, char* theme_name)
     log_info("Initialising contact list");
     muc_init();
     tlscerts_init();
+    http_transfer_init(prefs_get_http_transfers());
     scripts_init();
 #ifdef HAVE_LIBOTR
     otr_init();
@@ -298,6 +323,8 @@ _call_and_free_shutdown_routine(struct shutdown_routine* r)
 void
 prof_shutdown(void)
 {
+    trace_stop();
+
     if (shutdown_routines) {
         g_list_free_full(shutdown_routines, (GDestroyNotify)_call_and_free_shutdown_routine);
         shutdown_routines = NULL;
@@ -320,6 +347,8 @@ _shutdown(void)
         cl_ev_disconnect();
     }
     prof_shutdown();
+    jid_cache_clear();
+    memstats_close();
     /* Prefs and logs have to be closed in swapped order, so they're no using the automatic
      * shutdown mechanism. */
     prefs_close();
@@ -43,7 +43,6 @@
 #include <sys/types.h>
 #include <curl/curl.h>
 #include <gio/gio.h>
-#include <pthread.h>
 #include <assert.h>
 #include <errno.h>
 
@@ -57,11 +56,47 @@
 #include "ui/window.h"
 #include "common.h"
 
-void*
-aesgcm_file_get(void* userdata)
+static void
+_aesgcm_download_free(AESGCMDownload* aesgcm_dl)
 {
-    AESGCMDownload* aesgcm_dl = (AESGCMDownload*)userdata;
+    free(aesgcm_dl->cmd_template);
+    free(aesgcm_dl->id);
+    free(aesgcm_dl->filename);
+    free(aesgcm_dl->url);
+    free(aesgcm_dl);
+}
+
+static void
+_aesgcm_download_done(HTTPDownload* http_dl, gboolean success)
+{
+    AESGCMDownload* aesgcm_dl = (AESGCMDownload*)http_dl->userdata;
+
+    // only run the command on files that were received and authenticated
+    if (success && aesgcm_dl->cmd_template != NULL) {
+        gchar** argv = format_call_external_argv(aesgcm_dl->cmd_template,
+                                                 aesgcm_dl->filename,
+                                                 aesgcm_dl->filename);
+
+        // TODO: Log the error.
+        if (!call_external(argv)) {
+            http_print_transfer_update(aesgcm_dl->window, aesgcm_dl->id,
+                                       "Downloading '%s' failed: Unable to call "
+                                       "command '%s' with file at '%s' (%s).",
+                                       aesgcm_dl->url,
+                                       aesgcm_dl->cmd_template,
+                                       aesgcm_dl->filename,
+                                       "TODO: Log the error");
+        }
+
+        g_strfreev(argv);
+    }
+
+    _aesgcm_download_free(aesgcm_dl);
+}
 
+void
+aesgcm_file_get(AESGCMDownload* aesgcm_dl)
+{
     auto_char char* https_url = NULL;
     auto_char char* fragment = NULL;
 
@@ -72,102 +107,36 @@ aesgcm_file_get(void* userdata)
         http_print_transfer_update(aesgcm_dl->window, aesgcm_dl->id,
                                    "Download failed: Cannot parse URL '%s'.",
                                    aesgcm_dl->url);
-        return NULL;
+        _aesgcm_download_free(aesgcm_dl);
+        return;
     }
 
-    // Create a temporary file used for storing the ciphertext that is to be
-    // retrieved from the https:// URL.
-    auto_gchar gchar* tmpname = NULL;
-    auto_gfd gint tmpfd = 0;
-    if ((tmpfd = g_file_open_tmp("profanity.XXXXXX", &tmpname, NULL)) == -1) {
-        http_print_transfer_update(aesgcm_dl->window, aesgcm_dl->id,
-                                   "Downloading '%s' failed: Unable to create "
-                                   "temporary ciphertext file for writing "
-                                   "(%s).",
-                                   https_url, g_strerror(errno));
-        return NULL;
-    }
-
-    // Open the target file for storing the cleartext.
-    auto_FILE FILE* outfh = fopen(aesgcm_dl->filename, "wb");
-    if (outfh == NULL) {
+    gcry_error_t crypt_res;
+    OmemoFileStream* stream = omemo_decrypt_stream_new(fragment, &crypt_res);
+    if (stream == NULL) {
         http_print_transfer_update(aesgcm_dl->window, aesgcm_dl->id,
-                                   "Downloading '%s' failed: Unable to open "
-                                   "output file at '%s' for writing (%s).",
-                                   https_url, aesgcm_dl->filename,
-                                   g_strerror(errno));
-        return NULL;
+                                   "Downloading '%s' failed: Failed to decrypt "
+                                   "file (%s).",
+                                   https_url, gcry_strerror(crypt_res));
+        _aesgcm_download_free(aesgcm_dl);
+        return;
     }
 
-    // We wrap the HTTPDownload tool and use it for retrieving the ciphertext
-    // and storing it in the temporary file previously opened.
+    // We wrap the HTTPDownload tool and let it decrypt the ciphertext while
+    // it is received, writing the cleartext straight to the target file.
     HTTPDownload* http_dl = calloc(1, sizeof(HTTPDownload));
     http_dl->window = aesgcm_dl->window;
-    http_dl->worker = aesgcm_dl->worker;
     http_dl->id = strdup(aesgcm_dl->id);
     http_dl->url = strdup(https_url);
-    http_dl->filename = strdup(tmpname);
+    http_dl->filename = strdup(aesgcm_dl->filename);
     http_dl->cmd_template = NULL;
     http_dl->silent = FALSE;
-    http_dl->return_bytes_received = TRUE;
-    aesgcm_dl->http_dl = http_dl;
-
-    ssize_t* p_bytes_received = http_file_get(http_dl);
-    if (!p_bytes_received) {
-        return NULL;
-    }
-    ssize_t bytes_received = *p_bytes_received;
-    free(p_bytes_received);
+    http_dl->omemo_stream = stream;
+    http_dl->on_complete = _aesgcm_download_done;
+    http_dl->userdata = aesgcm_dl;
 
-    FILE* tmpfh = fopen(tmpname, "rb");
-    if (tmpfh == NULL) {
-        http_print_transfer_update(aesgcm_dl->window, aesgcm_dl->id,
-                                   "Downloading '%s' failed: Unable to open "
-                                   "temporary file at '%s' for reading (%s).",
-                                   aesgcm_dl->url, tmpname,
-                                   g_strerror(errno));
-        return NULL;
-    }
-
-    gcry_error_t crypt_res;
-    crypt_res = omemo_decrypt_file(tmpfh, outfh,
-                                   bytes_received, fragment);
-    fclose(tmpfh);
-    remove(tmpname);
-
-    if (crypt_res != GPG_ERR_NO_ERROR) {
-        http_print_transfer_update(aesgcm_dl->window, aesgcm_dl->id,
-                                   "Downloading '%s' failed: Failed to decrypt "
-                                   "file (%s).",
-                                   https_url, gcry_strerror(crypt_res));
-    }
-
-    if (aesgcm_dl->cmd_template != NULL) {
-        gchar** argv = format_call_external_argv(aesgcm_dl->cmd_template,
-                                                 aesgcm_dl->filename,
-                                                 aesgcm_dl->filename);
-
-        // TODO: Log the error.
-        if (!call_external(argv)) {
-            http_print_transfer_update(aesgcm_dl->window, aesgcm_dl->id,
-                                       "Downloading '%s' failed: Unable to call "
-                                       "command '%s' with file at '%s' (%s).",
-                                       aesgcm_dl->url,
-                                       aesgcm_dl->cmd_template,
-                                       aesgcm_dl->filename,
-                                       "TODO: Log the error");
-        }
-
-        g_strfreev(argv);
-        free(aesgcm_dl->cmd_template);
-    }
-
-    free(aesgcm_dl->id);
-    free(aesgcm_dl->filename);
-    free(aesgcm_dl->url);
-    free(aesgcm_dl);
-
-    return NULL;
+    http_download_add_download(http_dl);
+    http_file_get(http_dl);
 }
 
 void
@@ -175,9 +144,3 @@ aesgcm_download_cancel_processes(ProfWin* window)
 {
     http_download_cancel_processes(window);
 }
-
-void
-aesgcm_download_add_download(AESGCMDownload* aesgcm_dl)
-{
-    http_download_add_download(aesgcm_dl->http_dl);
-}
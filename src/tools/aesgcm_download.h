@@ -55,13 +55,10 @@ typedef struct aesgcm_download_t
     char* filename;
     char* cmd_template;
     ProfWin* window;
-    pthread_t worker;
-    HTTPDownload* http_dl;
 } AESGCMDownload;
 
-void* aesgcm_file_get(void* userdata);
+void aesgcm_file_get(AESGCMDownload* download);
 
 void aesgcm_download_cancel_processes(ProfWin* window);
-void aesgcm_download_add_download(AESGCMDownload* download);
 
 #endif
@@ -0,0 +1,196 @@
+/*
+ * annotations.c
+ * vim: expandtab:ts=4:sts=4:sw=4
+ *
+ * This file is part of Profanity.
+ *
+ * Profanity is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Profanity is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Profanity.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link the code of portions of this program with the OpenSSL library under
+ * certain conditions as described in each individual source file, and
+ * distribute linked combinations including the two.
+ *
+ * You must obey the GNU General Public License in all respects for all of the
+ * code used other than OpenSSL. If you modify file(s) with this exception, you
+ * may extend this exception to your version of the file(s), but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version. If you delete this exception statement from all
+ * source files in the program, then also delete it here.
+ *
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <glib.h>
+
+#include "common.h"
+#include "config/preferences.h"
+#include "tools/annotations.h"
+#include "tools/trigger_matcher.h"
+
+static const char* const url_schemes[] = { "https://", "http://", "aesgcm://" };
+
+// same character class as the URL regex that was used before:
+// (https?|aesgcm)://[\w\-.~:/?#\[\]@!$&'()*+,;=%]+
+static gboolean
+_is_url_char(gunichar ch)
+{
+    if (ch < 0x80) {
+        return g_ascii_isalnum(ch) || strchr("_-.~:/?#[]@!$&'()*+,;=%", ch) != NULL;
+    }
+
+    return g_unichar_isalnum(ch) || g_unichar_ismark(ch);
+}
+
+// length of the URL scheme starting at text, 0 if there is none or nothing follows it
+static gsize
+_url_scheme_len(const gchar* const text)
+{
+    if (text[0] != 'h' && text[0] != 'a') {
+        return 0;
+    }
+
+    for (guint i = 0; i < G_N_ELEMENTS(url_schemes); i++) {
+        if (g_str_has_prefix(text, url_schemes[i])) {
+            gsize len = strlen(url_schemes[i]);
+            if (text[len] != '\0' && _is_url_char(g_utf8_get_char(text + len))) {
+                return len;
+            }
+        }
+    }
+
+    return 0;
+}
+
+// mention offsets are in characters, which are single bytes in ASCII text
+static gsize
+_skip_chars(const gchar* const text, gsize from, glong count, gboolean ascii)
+{
+    return ascii ? from + count : g_utf8_offset_to_pointer(text + from, count) - text;
+}
+
+static GArray*
+_mention_spans(const char* const text, GSList* mentions, const char* const mynick, gboolean ascii)
+{
+    GArray* spans = g_array_new(FALSE, FALSE, sizeof(TriggerMatch));
+    glong mynick_len = g_utf8_strlen(mynick, -1);
+    glong last_pos = 0;
+    gsize last_end = 0;
+
+    for (GSList* curr = mentions; curr; curr = g_slist_next(curr)) {
+        glong pos = GPOINTER_TO_INT(curr->data);
+        glong end_pos = pos + mynick_len;
+        gsize end = _skip_chars(text, last_end, end_pos - last_pos, ascii);
+
+        if (spans->len > 0 && pos < last_pos) {
+            // continues the previous mention
+            g_array_index(spans, TriggerMatch, spans->len - 1).end = end;
+        } else {
+            TriggerMatch span = { _skip_chars(text, last_end, pos - last_pos, ascii), end, 0 };
+            g_array_append_val(spans, span);
+        }
+
+        last_pos = end_pos;
+        last_end = end;
+    }
+
+    return spans;
+}
+
+MessageAnnotations*
+message_annotate(const char* const text, const char* const mynick)
+{
+    MessageAnnotations* annotations = g_new0(MessageAnnotations, 1);
+    annotations->urls = g_ptr_array_new_with_free_func(g_free);
+    annotations->ascii = TRUE;
+
+    if (text == NULL) {
+        return annotations;
+    }
+
+    annotations->is_me = g_str_has_prefix(text, "/me ");
+
+    TriggerMatcher* matcher = mynick ? prefs_get_room_trigger_matcher() : NULL;
+    GArray* matches = matcher ? g_array_new(FALSE, FALSE, sizeof(TriggerMatch)) : NULL;
+    TriggerScan scan;
+    trigger_scan_init(&scan, matcher);
+
+    const gchar* url_start = NULL;
+    const gchar* curr = text;
+    while (*curr != '\0') {
+        gunichar ch = g_utf8_get_char(curr);
+        const gchar* next = g_utf8_next_char(curr);
+
+        if (ch >= 0x80) {
+            annotations->ascii = FALSE;
+        }
+
+        if (url_start && !_is_url_char(ch)) {
+            g_ptr_array_add(annotations->urls, g_strndup(url_start, curr - url_start));
+            url_start = NULL;
+        }
+        if (!url_start && _url_scheme_len(curr) > 0) {
+            url_start = curr;
+        }
+
+        if (matches) {
+            trigger_scan_feed(&scan, ch, curr - text, next - text, matches);
+        }
+
+        curr = next;
+    }
+    if (url_start) {
+        g_ptr_array_add(annotations->urls, g_strndup(url_start, curr - url_start));
+    }
+    trigger_scan_clear(&scan);
+
+    if (matches) {
+        annotations->triggers = prefs_room_triggers_from_matches(matches);
+        trigger_matches_to_spans(matches);
+        annotations->trigger_spans = matches;
+    }
+
+    // mentions honour their own case sensitivity and whole word settings
+    if (mynick) {
+        annotations->mentions = get_mentions(prefs_get_boolean(PREF_NOTIFY_MENTION_WHOLE_WORD),
+                                             prefs_get_boolean(PREF_NOTIFY_MENTION_CASE_SENSITIVE), text, mynick);
+    }
+    if (annotations->mentions) {
+        annotations->mention_spans = _mention_spans(text, annotations->mentions, mynick, annotations->ascii);
+    }
+
+    return annotations;
+}
+
+void
+message_annotations_free(MessageAnnotations* annotations)
+{
+    if (annotations == NULL) {
+        return;
+    }
+
+    g_ptr_array_free(annotations->urls, TRUE);
+    g_slist_free(annotations->mentions);
+    g_list_free_full(annotations->triggers, free);
+    if (annotations->trigger_spans) {
+        g_array_free(annotations->trigger_spans, TRUE);
+    }
+    if (annotations->mention_spans) {
+        g_array_free(annotations->mention_spans, TRUE);
+    }
+    g_free(annotations);
+}
@@ -0,0 +1,64 @@
+/*
+ * annotations.h
+ * vim: expandtab:ts=4:sts=4:sw=4
+ *
+ * This file is part of Profanity.
+ *
+ * Profanity is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Profanity is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Profanity.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link the code of portions of this program with the OpenSSL library under
+ * certain conditions as described in each individual source file, and
+ * distribute linked combinations including the two.
+ *
+ * You must obey the GNU General Public License in all respects for all of the
+ * code used other than OpenSSL. If you modify file(s) with this exception, you
+ * may extend this exception to your version of the file(s), but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version. If you delete this exception statement from all
+ * source files in the program, then also delete it here.
+ *
+ */
+
+#ifndef TOOLS_ANNOTATIONS_H
+#define TOOLS_ANNOTATIONS_H
+
+#include <glib.h>
+
+// What the completers, notifier and renderer need to know about a displayed
+// message, collected in one walk over the text
+typedef struct message_annotations_t
+{
+    // starts with "/me "
+    gboolean is_me;
+    // every character is ASCII, so one byte is one column
+    gboolean ascii;
+    // URLs in order of appearance
+    GPtrArray* urls;
+    // character offsets of the own nick, see get_mentions()
+    GSList* mentions;
+    // non overlapping TriggerMatch spans of the mentions to highlight, a nick
+    // that overlaps itself, like "aa" in "aaa", gives one span
+    GArray* mention_spans;
+    // room triggers found, in configured order
+    GList* triggers;
+    // non overlapping TriggerMatch spans to highlight
+    GArray* trigger_spans;
+} MessageAnnotations;
+
+// mynick is the own nick in a room, NULL skips mention and trigger detection
+MessageAnnotations* message_annotate(const char* const text, const char* const mynick);
+void message_annotations_free(MessageAnnotations* annotations);
+
+#endif
@@ -0,0 +1,171 @@
+/*
+ * arena.c
+ * vim: expandtab:ts=4:sts=4:sw=4
+ *
+ * This file is part of Profanity.
+ *
+ * Profanity is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Profanity is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Profanity.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link the code of portions of this program with the OpenSSL library under
+ * certain conditions as described in each individual source file, and
+ * distribute linked combinations including the two.
+ *
+ * You must obey the GNU General Public License in all respects for all of the
+ * code used other than OpenSSL. If you modify file(s) with this exception, you
+ * may extend this exception to your version of the file(s), but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version. If you delete this exception statement from all
+ * source files in the program, then also delete it here.
+ *
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <glib.h>
+
+#include "tools/arena.h"
+
+#define ARENA_ALIGN (2 * sizeof(void*))
+
+typedef struct arena_block_t
+{
+    struct arena_block_t* next;
+    gsize size;
+    gsize used;
+    // aligned start of the usable memory
+    char* data;
+} ArenaBlock;
+
+struct arena_t
+{
+    guint refcnt;
+    gsize block_size;
+    gsize reserved;
+    // newest first, allocations are carved from the head
+    ArenaBlock* blocks;
+};
+
+static ArenaBlock*
+_arena_add_block(Arena* arena, gsize size)
+{
+    gsize header = (sizeof(ArenaBlock) + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1);
+    ArenaBlock* block = g_malloc(header + size);
+    block->size = size;
+    block->used = 0;
+    block->data = (char*)block + header;
+    arena->reserved += header + size;
+
+    // keep the partly used head for further small allocations
+    if (arena->blocks && size > arena->block_size) {
+        block->next = arena->blocks->next;
+        arena->blocks->next = block;
+    } else {
+        block->next = arena->blocks;
+        arena->blocks = block;
+    }
+
+    return block;
+}
+
+Arena*
+arena_new(gsize block_size)
+{
+    Arena* arena = g_new0(Arena, 1);
+    arena->refcnt = 1;
+    arena->block_size = (MAX(block_size, ARENA_ALIGN) + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1);
+
+    return arena;
+}
+
+Arena*
+arena_ref(Arena* arena)
+{
+    arena->refcnt++;
+    return arena;
+}
+
+void
+arena_unref(Arena* arena)
+{
+    if (arena == NULL) {
+        return;
+    }
+    if (--arena->refcnt > 0) {
+        return;
+    }
+
+    ArenaBlock* block = arena->blocks;
+    while (block) {
+        ArenaBlock* next = block->next;
+        g_free(block);
+        block = next;
+    }
+    g_free(arena);
+}
+
+gpointer
+arena_alloc(Arena* arena, gsize size)
+{
+    size = (MAX(size, 1) + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1);
+
+    ArenaBlock* block = arena->blocks;
+    if (block == NULL || block->size - block->used < size) {
+        block = _arena_add_block(arena, MAX(size, arena->block_size));
+    }
+
+    gpointer result = block->data + block->used;
+    block->used += size;
+    memset(result, 0, size);
+
+    return result;
+}
+
+char*
+arena_strdup(Arena* arena, const char* const str)
+{
+    if (str == NULL) {
+        return NULL;
+    }
+
+    gsize len = strlen(str) + 1;
+    char* result = arena_alloc(arena, len);
+    memcpy(result, str, len);
+
+    return result;
+}
+
+gboolean
+arena_owns(Arena* arena, gconstpointer ptr)
+{
+    if (arena == NULL || ptr == NULL) {
+        return FALSE;
+    }
+
+    for (ArenaBlock* block = arena->blocks; block; block = block->next) {
+        if ((const char*)ptr >= block->data && (const char*)ptr < block->data + block->size) {
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+gsize
+arena_size(Arena* arena)
+{
+    return arena ? arena->reserved : 0;
+}
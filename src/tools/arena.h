@@ -0,0 +1,58 @@
+/*
+ * arena.h
+ * vim: expandtab:ts=4:sts=4:sw=4
+ *
+ * This file is part of Profanity.
+ *
+ * Profanity is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Profanity is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Profanity.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link the code of portions of this program with the OpenSSL library under
+ * certain conditions as described in each individual source file, and
+ * distribute linked combinations including the two.
+ *
+ * You must obey the GNU General Public License in all respects for all of the
+ * code used other than OpenSSL. If you modify file(s) with this exception, you
+ * may extend this exception to your version of the file(s), but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version. If you delete this exception statement from all
+ * source files in the program, then also delete it here.
+ *
+ */
+
+#ifndef TOOLS_ARENA_H
+#define TOOLS_ARENA_H
+
+#include <glib.h>
+
+// A reference counted bump allocator. Allocations are never freed one by
+// one, everything is released together with the last reference.
+typedef struct arena_t Arena;
+
+// block_size is the size of each block to carve allocations from, larger
+// allocations get a block of their own
+Arena* arena_new(gsize block_size);
+Arena* arena_ref(Arena* arena);
+void arena_unref(Arena* arena);
+
+// zero filled, aligned for any type
+gpointer arena_alloc(Arena* arena, gsize size);
+// NULL for NULL
+char* arena_strdup(Arena* arena, const char* const str);
+gboolean arena_owns(Arena* arena, gconstpointer ptr);
+
+// bytes reserved from the system
+gsize arena_size(Arena* arena);
+
+#endif
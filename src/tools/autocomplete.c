@@ -42,6 +42,7 @@
 
 #include "common.h"
 #include "tools/autocomplete.h"
+#include "tools/memstats.h"
 #include "tools/parser.h"
 #include "ui/ui.h"
 
@@ -106,6 +107,21 @@ autocomplete_length(Autocomplete ac)
     }
 }
 
+gsize
+autocomplete_memory(Autocomplete ac)
+{
+    if (!ac) {
+        return 0;
+    }
+
+    gsize bytes = sizeof(struct autocomplete_t) + memstats_list(ac->items) + memstats_str(ac->search_str);
+    for (GList* curr = ac->items; curr; curr = g_list_next(curr)) {
+        bytes += memstats_str(curr->data);
+    }
+
+    return bytes;
+}
+
 void
 autocomplete_update(Autocomplete ac, char** items)
 {
@@ -62,6 +62,8 @@ gchar* autocomplete_complete(Autocomplete ac, const gchar* search_str, gboolean
 
 GList* autocomplete_create_list(Autocomplete ac);
 gint autocomplete_length(Autocomplete ac);
+// approximate bytes held by the autocompleter and its items, see tools/memstats.h
+gsize autocomplete_memory(Autocomplete ac);
 
 char* autocomplete_param_with_func(const char* const input, char* command,
                                    autocomplete_func func, gboolean previous, void* context);
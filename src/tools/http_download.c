@@ -44,123 +44,270 @@
 #include <sys/types.h>
 #include <curl/curl.h>
 #include <gio/gio.h>
-#include <pthread.h>
 #include <assert.h>
 #include <errno.h>
+#include <unistd.h>
 
 #include "profanity.h"
+#include "log.h"
 #include "event/client_events.h"
 #include "tools/http_download.h"
+#include "tools/http_transfer.h"
 #include "config/cafile.h"
 #include "config/preferences.h"
 #include "ui/ui.h"
 #include "ui/window.h"
 #include "common.h"
 
-GSList* download_processes = NULL;
-gboolean silent = FALSE;
+#ifdef HAVE_OMEMO
+#include "omemo/omemo.h"
+#endif
 
-static int
-_xferinfo(void* userdata, curl_off_t dltotal, curl_off_t dlnow, curl_off_t ultotal, curl_off_t ulnow)
+#define HTTP_DOWNLOAD_PART_SUFFIX      ".part"
+#define HTTP_DOWNLOAD_VALIDATOR_SUFFIX ".validator"
+#define HTTP_DOWNLOAD_MAX_RETRIES      5
+#define HTTP_DOWNLOAD_LOW_SPEED_TIME   60
+#define HTTP_DOWNLOAD_SEGMENTS         4
+#define HTTP_DOWNLOAD_SEGMENT_MIN_SIZE (8 * 1024 * 1024)
+
+typedef struct http_download_segment_t
 {
-    HTTPDownload* download = (HTTPDownload*)userdata;
+    HTTPDownload* download;
+    CURL* curl;
+    struct curl_slist* headers;
+    int cancel;
+    int retries;
+    gboolean checked;
+    curl_off_t start;
+    curl_off_t end;
+    // next byte to write, advanced by the transfer thread
+    curl_off_t pos;
+    // pos when the current request was started
+    curl_off_t base;
+    curl_off_t dlnow;
+} HTTPDownloadSegment;
+
+GSList* download_processes = NULL;
 
-    pthread_mutex_lock(&lock);
+static void _download_start(HTTPDownload* download);
+static void _download_split(HTTPDownload* download, curl_off_t length);
+static void _segment_start(HTTPDownloadSegment* segment);
+static void _segment_done(void* userdata, CURL* curl, CURLcode res);
 
-    if (download->cancel) {
-        pthread_mutex_unlock(&lock);
-        return 1;
+static gboolean
+_is_transient(CURLcode res)
+{
+    switch (res) {
+    case CURLE_COULDNT_RESOLVE_HOST:
+    case CURLE_COULDNT_CONNECT:
+    case CURLE_OPERATION_TIMEDOUT:
+    case CURLE_PARTIAL_FILE:
+    case CURLE_GOT_NOTHING:
+    case CURLE_SEND_ERROR:
+    case CURLE_RECV_ERROR:
+    case CURLE_SSL_CONNECT_ERROR:
+    case CURLE_HTTP2:
+    case CURLE_HTTP2_STREAM:
+        return TRUE;
+    default:
+        return FALSE;
     }
+}
 
-    if (download->bytes_received == dlnow) {
-        pthread_mutex_unlock(&lock);
-        return 0;
-    } else {
-        download->bytes_received = dlnow;
+static void
+_download_show_progress(HTTPDownload* download, curl_off_t now, curl_off_t total)
+{
+    if (download->cancel || download->bytes_received == now) {
+        return;
     }
+    download->bytes_received = now;
 
     unsigned int dlperc = 0;
-    if (dltotal != 0) {
-        dlperc = (100 * dlnow) / dltotal;
+    if (total != 0) {
+        dlperc = (100 * now) / total;
     }
 
-    if (!silent)
-        http_print_transfer_update(download->window, download->url,
+    if (!download->silent) {
+        http_print_transfer_update(download->window, download->id,
                                    "Downloading '%s': %d%%", download->url, dlperc);
+    }
+}
 
-    pthread_mutex_unlock(&lock);
+static void
+_download_segments_progress(HTTPDownload* download)
+{
+    curl_off_t received = 0;
+    for (GSList* curr = download->segments; curr; curr = g_slist_next(curr)) {
+        HTTPDownloadSegment* s = curr->data;
+        received += s->base - s->start + s->dlnow;
+    }
 
-    return 0;
+    _download_show_progress(download, received, download->total_size);
 }
 
-#if LIBCURL_VERSION_NUM < 0x072000
-static int
-_older_progress(void* p, double dltotal, double dlnow, double ultotal, double ulnow)
+static void
+_download_progress(void* userdata, curl_off_t dltotal, curl_off_t dlnow, curl_off_t ultotal, curl_off_t ulnow)
 {
-    return _xferinfo(p, (curl_off_t)dltotal, (curl_off_t)dlnow, (curl_off_t)ultotal, (curl_off_t)ulnow);
+    HTTPDownload* download = (HTTPDownload*)userdata;
+
+    curl_off_t split_length = __atomic_load_n(&download->split_length, __ATOMIC_ACQUIRE);
+    if (split_length > 0 && !download->segments && !download->cancel) {
+        _download_split(download, split_length);
+    }
+
+    if (download->segments) {
+        HTTPDownloadSegment* first = download->segments->data;
+        first->dlnow = dlnow;
+        _download_segments_progress(download);
+        return;
+    }
+
+    // curl counts from the start of the requested range
+    curl_off_t offset = __atomic_load_n(&download->offset, __ATOMIC_RELAXED);
+    _download_show_progress(download, offset + dlnow, dltotal ? offset + dltotal : 0);
 }
-#endif
 
-void*
-http_file_get(void* userdata)
+// Remember which version of the file the part holds. Without a validator a
+// later attempt cannot tell whether the file changed and starts over.
+static void
+_download_save_validator(HTTPDownload* download)
 {
-    HTTPDownload* download = (HTTPDownload*)userdata;
-    ssize_t* ret = NULL;
+    g_free(download->validator);
+    download->validator = g_strdup(download->etag ? download->etag : download->last_modified);
 
-    char* err = NULL;
+    // encrypted downloads never resume from an earlier attempt
+    if (download->omemo_stream) {
+        return;
+    }
 
-    CURL* curl;
-    CURLcode res;
-    silent = download->silent;
+    if (!download->validator) {
+        remove(download->validatorname);
+        return;
+    }
 
-    download->cancel = 0;
-    download->bytes_received = 0;
+    GError* error = NULL;
+    if (!g_file_set_contents(download->validatorname, download->validator, -1, &error)) {
+        log_warning("[HTTP] Unable to save '%s': %s", download->validatorname, error->message);
+        g_error_free(error);
+    }
+}
 
-    pthread_mutex_lock(&lock);
-    if (!silent) {
-        http_print_transfer(download->window, download->id,
-                            "Downloading '%s': 0%%", download->url);
+// The part did not match, or the server ignored the range, and the body is
+// the whole file, so write it from the start.
+static gboolean
+_download_restart(HTTPDownload* download)
+{
+    if (fflush(download->filehandle) != 0 || ftruncate(fileno(download->filehandle), 0) != 0) {
+        return FALSE;
     }
+    __atomic_store_n(&download->offset, 0, __ATOMIC_RELAXED);
+    download->received = 0;
 
-    FILE* outfh = fopen(download->filename, "wb");
-    if (outfh == NULL) {
-        http_print_transfer_update(download->window, download->id,
-                                   "Downloading '%s' failed: Unable to open "
-                                   "output file at '%s' for writing (%s).",
-                                   download->url, download->filename,
-                                   g_strerror(errno));
-        goto out;
+    return TRUE;
+}
+
+static size_t
+_write_callback(char* ptr, size_t size, size_t nmemb, void* userdata)
+{
+    HTTPDownload* download = (HTTPDownload*)userdata;
+    size_t len = size * nmemb;
+
+    if (!download->checked) {
+        download->checked = TRUE;
+        long http_code = 0;
+        curl_easy_getinfo(download->curl, CURLINFO_RESPONSE_CODE, &http_code);
+        if (http_code >= 400) {
+            // don't store error pages in the partial file, _download_done() reports the code
+            return 0;
+        }
+        if (download->offset > 0 && http_code != 206) {
+            if (download->omemo_stream) {
+                // the decryption already saw the start, drop it
+                download->skip = download->offset;
+            } else if (_download_restart(download)) {
+                _download_save_validator(download);
+            } else {
+                return 0;
+            }
+        } else if (download->offset == 0) {
+            _download_save_validator(download);
+        }
+        // the other ranges are only safe to fetch with If-Range
+        if (download->offset == 0 && http_code == 200 && download->ranges && download->validator
+            && !download->omemo_stream) {
+            curl_off_t length = -1;
+            curl_easy_getinfo(download->curl, CURLINFO_CONTENT_LENGTH_DOWNLOAD_T, &length);
+            if (length >= HTTP_DOWNLOAD_SEGMENT_MIN_SIZE) {
+                // split on the main thread, see _download_progress()
+                __atomic_store_n(&download->split_length, length, __ATOMIC_RELEASE);
+            }
+        }
+    }
+
+    if (download->skip > 0) {
+        size_t skipped = MIN(len, (size_t)download->skip);
+        download->skip -= skipped;
+        ptr += skipped;
+        len -= skipped;
+        if (len == 0) {
+            return size * nmemb;
+        }
+    }
+
+    // once split, the other ranges fetch what follows the first one, -1 when one of them failed
+    gboolean stop = FALSE;
+    curl_off_t limit = __atomic_load_n(&download->limit, __ATOMIC_ACQUIRE);
+    if (limit < 0) {
+        return 0;
+    }
+    if (limit > 0 && download->received + (curl_off_t)len > limit) {
+        len = download->received < limit ? limit - download->received : 0;
+        stop = TRUE;
+    }
+
+#ifdef HAVE_OMEMO
+    if (download->omemo_stream) {
+        gcry_error_t res = omemo_decrypt_stream_write(download->omemo_stream, ptr, len, download->filehandle);
+        if (res != GPG_ERR_NO_ERROR) {
+            return 0;
+        }
+        download->received += len;
+        return size * nmemb;
+    }
+#endif
+
+    if (fwrite(ptr, 1, len, download->filehandle) != len) {
+        return 0;
     }
+    download->received += len;
+    return stop ? 0 : size * nmemb;
+}
 
-    gchar* cert_path = prefs_get_string(PREF_TLS_CERTPATH);
-    gchar* cafile = cafile_get_name();
+static CURL*
+_download_curl_new(HTTPDownload* download)
+{
+    auto_gchar gchar* cert_path = prefs_get_string(PREF_TLS_CERTPATH);
+    auto_gchar gchar* cafile = cafile_get_name();
     ProfAccount* account = accounts_get_account(session_get_account_name());
     gboolean insecure = FALSE;
     if (account) {
         insecure = account->tls_policy && strcmp(account->tls_policy, "trust") == 0;
     }
     account_free(account);
-    pthread_mutex_unlock(&lock);
 
-    curl_global_init(CURL_GLOBAL_ALL);
-    curl = curl_easy_init();
+    CURL* curl = curl_easy_init();
 
     curl_easy_setopt(curl, CURLOPT_URL, download->url);
 
-#if LIBCURL_VERSION_NUM >= 0x072000
-    curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, _xferinfo);
-    curl_easy_setopt(curl, CURLOPT_XFERINFODATA, download);
-#else
-    curl_easy_setopt(curl, CURLOPT_PROGRESSFUNCTION, _older_progress);
-    curl_easy_setopt(curl, CURLOPT_PROGRESSDATA, download);
-#endif
-    curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
-
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void*)outfh);
-
     curl_easy_setopt(curl, CURLOPT_USERAGENT, "profanity");
 
     curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+    // don't store error pages in the partial file
+    curl_easy_setopt(curl, CURLOPT_FAILONERROR, 1L);
+
+    // give up on stalled connections so they can be resumed
+    curl_easy_setopt(curl, CURLOPT_LOW_SPEED_LIMIT, 1L);
+    curl_easy_setopt(curl, CURLOPT_LOW_SPEED_TIME, (long)HTTP_DOWNLOAD_LOW_SPEED_TIME);
 
     if (cafile) {
         curl_easy_setopt(curl, CURLOPT_CAINFO, cafile);
@@ -173,24 +320,71 @@ http_file_get(void* userdata)
         curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L);
     }
 
-    if ((res = curl_easy_perform(curl)) != CURLE_OK) {
-        err = strdup(curl_easy_strerror(res));
+    return curl;
+}
+
+static size_t
+_download_header_callback(char* buffer, size_t size, size_t nitems, void* userdata)
+{
+    HTTPDownload* download = (HTTPDownload*)userdata;
+    size_t len = size * nitems;
+
+    // a new response starts with every redirect
+    if (len >= 5 && strncmp(buffer, "HTTP/", 5) == 0) {
+        download->ranges = FALSE;
+        download->range_total = -1;
+        g_free(download->etag);
+        download->etag = NULL;
+        g_free(download->last_modified);
+        download->last_modified = NULL;
+        return len;
     }
 
-    if (ftell(outfh) == 0) {
-        err = strdup("Output file is empty.");
+    const char* colon = memchr(buffer, ':', len);
+    if (!colon) {
+        return len;
+    }
+    auto_gchar gchar* name = g_strndup(buffer, colon - buffer);
+    auto_gchar gchar* value = g_strndup(colon + 1, len - (colon + 1 - buffer));
+    g_strstrip(value);
+
+    if (g_ascii_strcasecmp(name, "accept-ranges") == 0) {
+        download->ranges = g_ascii_strcasecmp(value, "bytes") == 0;
+    } else if (g_ascii_strcasecmp(name, "etag") == 0) {
+        // weak validators cannot be used with If-Range
+        if (!g_str_has_prefix(value, "W/")) {
+            g_free(download->etag);
+            download->etag = g_steal_pointer(&value);
+        }
+    } else if (g_ascii_strcasecmp(name, "last-modified") == 0) {
+        g_free(download->last_modified);
+        download->last_modified = g_steal_pointer(&value);
+    } else if (g_ascii_strcasecmp(name, "content-range") == 0) {
+        // "bytes start-end/total", or "bytes */total" with a 416
+        const char* slash = strrchr(value, '/');
+        if (slash && g_ascii_isdigit(slash[1])) {
+            download->range_total = g_ascii_strtoll(slash + 1, NULL, 10);
+        }
     }
 
-    curl_easy_cleanup(curl);
-    curl_global_cleanup();
+    return len;
+}
 
-    if (fclose(outfh) == EOF) {
-        err = strdup(g_strerror(errno));
+// Only accept a range of the file the part came from, a changed file is sent whole
+static struct curl_slist*
+_download_if_range(HTTPDownload* download)
+{
+    if (!download->validator) {
+        return NULL;
     }
 
-    pthread_mutex_lock(&lock);
-    g_free(cafile);
-    g_free(cert_path);
+    auto_gchar gchar* header = g_strdup_printf("If-Range: %s", download->validator);
+    return curl_slist_append(NULL, header);
+}
+
+static void
+_download_finish(HTTPDownload* download, const char* err)
+{
     if (err) {
         if (download->cancel) {
             http_print_transfer_update(download->window, download->id,
@@ -202,18 +396,11 @@ http_file_get(void* userdata)
                                        "Downloading '%s' failed: %s",
                                        download->url, err);
         }
-        free(err);
-    } else {
-        if (!download->cancel && !silent) {
-            http_print_transfer_update(download->window, download->id,
-                                       "Downloading '%s': done\nSaved to '%s'",
-                                       download->url, download->filename);
-            win_mark_received(download->window, download->id);
-            if (download->return_bytes_received) {
-                ret = malloc(sizeof(*ret));
-                *ret = download->bytes_received;
-            }
-        }
+    } else if (!download->cancel && !download->silent) {
+        http_print_transfer_update(download->window, download->id,
+                                   "Downloading '%s': done\nSaved to '%s'",
+                                   download->url, download->filename);
+        win_mark_received(download->window, download->id);
     }
 
     if (download->cmd_template != NULL) {
@@ -236,17 +423,443 @@ http_file_get(void* userdata)
         free(download->cmd_template);
     }
 
-out:
+    if (download->on_complete) {
+        download->on_complete(download, err == NULL && !download->cancel);
+    }
 
     download_processes = g_slist_remove(download_processes, download);
-    pthread_mutex_unlock(&lock);
 
+    // the part was renamed, a failed download keeps it for the next attempt
+    if (!err) {
+        remove(download->validatorname);
+    }
+
+#ifdef HAVE_OMEMO
+    omemo_file_stream_free(download->omemo_stream);
+#endif
+
+    curl_slist_free_all(download->headers);
+    g_free(download->etag);
+    g_free(download->last_modified);
+    g_free(download->validator);
+    g_free(download->validatorname);
+    g_free(download->partname);
     free(download->filename);
     free(download->url);
     free(download->id);
     free(download);
+}
+
+// the initial transfer of a split download ended, it fetched the first range
+static void
+_download_first_done(HTTPDownload* download, CURLcode res)
+{
+    HTTPDownloadSegment* first = download->segments->data;
+    first->curl = NULL;
+    first->pos = download->received;
+
+    // later retries of the range write with pwrite()
+    if (fflush(download->filehandle) != 0 && res == CURLE_OK) {
+        res = CURLE_WRITE_ERROR;
+    }
+    // stopping at the end of the range is how this transfer finishes
+    if (res == CURLE_WRITE_ERROR && first->pos > first->end) {
+        res = CURLE_OK;
+    }
+
+    _segment_done(first, NULL, res);
+}
+
+static void
+_download_done(void* userdata, CURL* curl, CURLcode res)
+{
+    HTTPDownload* download = (HTTPDownload*)userdata;
+    FILE* outfh = download->filehandle;
+
+    auto_char char* err = NULL;
+
+    download->curl = NULL;
+    curl_slist_free_all(download->headers);
+    download->headers = NULL;
+
+    if (download->segments) {
+        _download_first_done(download, res);
+        return;
+    }
+
+    long http_code = 0;
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
+    if (http_code == 416 && download->offset > 0 && download->range_total == download->offset) {
+        log_info("[HTTP] Download of '%s' was already complete", download->url);
+        res = CURLE_OK;
+    } else if (http_code == 416 && download->offset > 0 && !download->omemo_stream
+               && download->retries < HTTP_DOWNLOAD_MAX_RETRIES) {
+        download->retries++;
+        log_info("[HTTP] Partial download of '%s' does not match the file, starting over", download->url);
+        fclose(outfh);
+        download->filehandle = NULL;
+        download->offset = 0;
+        _download_start(download);
+        return;
+    } else if (http_code >= 400) {
+        err = g_strdup_printf("The requested URL returned error: %ld", http_code);
+    }
+
+    if (!err && res != CURLE_OK && !download->cancel && _is_transient(res)
+        && download->retries < HTTP_DOWNLOAD_MAX_RETRIES) {
+        download->retries++;
+        if (!download->validator && !download->omemo_stream) {
+            // nothing tells whether the file changed in between
+            fclose(outfh);
+            download->filehandle = NULL;
+            download->offset = 0;
+            log_info("[HTTP] Download of '%s' interrupted (%s), starting over",
+                     download->url, curl_easy_strerror(res));
+            _download_start(download);
+            return;
+        }
+        download->offset = download->received;
+        log_info("[HTTP] Download of '%s' interrupted (%s), resuming at %" CURL_FORMAT_CURL_OFF_T " bytes",
+                 download->url, curl_easy_strerror(res), download->offset);
+        _download_start(download);
+        return;
+    }
+
+    if (!err && res != CURLE_OK) {
+        err = strdup(curl_easy_strerror(res));
+    }
+
+#ifdef HAVE_OMEMO
+    if (!err && download->omemo_stream) {
+        gcry_error_t crypt_res = omemo_decrypt_stream_finish(download->omemo_stream, outfh);
+        if (crypt_res != GPG_ERR_NO_ERROR) {
+            err = g_strdup_printf("Failed to decrypt file (%s).", gcry_strerror(crypt_res));
+        }
+    }
+#endif
 
-    return ret;
+    // a resumed part holds data already
+    if (!err && download->offset == 0 && ftell(outfh) == 0) {
+        err = strdup("Output file is empty.");
+    }
+
+    if (fclose(outfh) == EOF && !err) {
+        err = strdup(g_strerror(errno));
+    }
+    download->filehandle = NULL;
+
+#ifdef HAVE_OMEMO
+    // never leave unauthenticated plaintext behind
+    if (err && download->omemo_stream) {
+        remove(download->partname);
+    }
+#endif
+
+    if (!err && rename(download->partname, download->filename) != 0) {
+        err = strdup(g_strerror(errno));
+    }
+
+    _download_finish(download, err);
+}
+
+static void
+_download_start(HTTPDownload* download)
+{
+    if (download->filehandle == NULL) {
+        if (download->offset == 0) {
+            // the first bytes record the version they belong to again
+            g_free(download->validator);
+            download->validator = NULL;
+            remove(download->validatorname);
+        }
+        download->filehandle = fopen(download->partname, download->offset > 0 ? "ab" : "wb");
+        if (download->filehandle == NULL) {
+            auto_gchar gchar* err = g_strdup_printf("Unable to open output file at '%s' for writing (%s).",
+                                                    download->partname, g_strerror(errno));
+            _download_finish(download, err);
+            return;
+        }
+    }
+
+    download->received = download->offset;
+    download->skip = 0;
+    download->checked = FALSE;
+
+    CURL* curl = _download_curl_new(download);
+    if (download->offset > 0) {
+        curl_easy_setopt(curl, CURLOPT_RESUME_FROM_LARGE, download->offset);
+        download->headers = _download_if_range(download);
+        if (download->headers) {
+            curl_easy_setopt(curl, CURLOPT_HTTPHEADER, download->headers);
+        }
+    }
+    // a 416 may mean the part is complete, see _download_done()
+    curl_easy_setopt(curl, CURLOPT_FAILONERROR, 0L);
+    curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, _download_header_callback);
+    curl_easy_setopt(curl, CURLOPT_HEADERDATA, (void*)download);
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, _write_callback);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void*)download);
+
+    download->curl = curl;
+    http_transfer_submit(curl, &download->cancel, _download_progress, _download_done, download);
+}
+
+static void
+_segment_progress(void* userdata, curl_off_t dltotal, curl_off_t dlnow, curl_off_t ultotal, curl_off_t ulnow)
+{
+    HTTPDownloadSegment* segment = (HTTPDownloadSegment*)userdata;
+
+    segment->dlnow = dlnow;
+    _download_segments_progress(segment->download);
+}
+
+static size_t
+_segment_write_callback(char* ptr, size_t size, size_t nmemb, void* userdata)
+{
+    HTTPDownloadSegment* segment = (HTTPDownloadSegment*)userdata;
+    size_t len = size * nmemb;
+
+    if (!segment->checked) {
+        segment->checked = TRUE;
+        long http_code = 0;
+        curl_easy_getinfo(segment->curl, CURLINFO_RESPONSE_CODE, &http_code);
+        if (http_code != 206) {
+            log_error("[HTTP] Range request for '%s' answered with %ld", segment->download->url, http_code);
+            return 0;
+        }
+    }
+
+    if (segment->pos + (curl_off_t)len > segment->end + 1) {
+        return 0;
+    }
+
+    int fd = fileno(segment->download->filehandle);
+    size_t written = 0;
+    while (written < len) {
+        ssize_t res = pwrite(fd, ptr + written, len - written, segment->pos + written);
+        if (res < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return 0;
+        }
+        written += res;
+    }
+    segment->pos += len;
+
+    return len;
+}
+
+static void
+_download_segments_finish(HTTPDownload* download)
+{
+    auto_char char* err = download->error;
+    download->error = NULL;
+
+    if (err) {
+        // keep the part that arrived in order, a later attempt resumes from it
+        curl_off_t complete = 0;
+        for (GSList* curr = download->segments; curr; curr = g_slist_next(curr)) {
+            HTTPDownloadSegment* segment = curr->data;
+            complete = segment->pos;
+            if (segment->pos <= segment->end) {
+                break;
+            }
+        }
+        if (ftruncate(fileno(download->filehandle), complete) != 0) {
+            log_warning("[HTTP] Unable to truncate '%s': %s", download->partname, g_strerror(errno));
+        }
+    }
+
+    if (fclose(download->filehandle) == EOF && !err) {
+        err = strdup(g_strerror(errno));
+    }
+    download->filehandle = NULL;
+
+    g_slist_free_full(download->segments, free);
+    download->segments = NULL;
+
+    if (!err && rename(download->partname, download->filename) != 0) {
+        err = strdup(g_strerror(errno));
+    }
+
+    _download_finish(download, err);
+}
+
+static void
+_segment_done(void* userdata, CURL* curl, CURLcode res)
+{
+    HTTPDownloadSegment* segment = (HTTPDownloadSegment*)userdata;
+    HTTPDownload* download = segment->download;
+
+    download->segments_running--;
+    segment->curl = NULL;
+    curl_slist_free_all(segment->headers);
+    segment->headers = NULL;
+
+    if (res == CURLE_OK && segment->pos <= segment->end) {
+        res = CURLE_PARTIAL_FILE;
+    }
+
+    if (res != CURLE_OK) {
+        if (!download->cancel && !segment->cancel && _is_transient(res)
+            && segment->retries < HTTP_DOWNLOAD_MAX_RETRIES) {
+            segment->retries++;
+            log_info("[HTTP] Range of '%s' interrupted (%s), resuming at %" CURL_FORMAT_CURL_OFF_T,
+                     download->url, curl_easy_strerror(res), segment->pos);
+            _segment_start(segment);
+            return;
+        }
+
+        if (!download->error) {
+            download->error = strdup(curl_easy_strerror(res));
+        }
+
+        // the download failed, no need to wait for the other ranges
+        for (GSList* curr = download->segments; curr; curr = g_slist_next(curr)) {
+            HTTPDownloadSegment* s = curr->data;
+            g_atomic_int_set(&s->cancel, 1);
+        }
+        // the initial transfer still fetching the first range checks its limit
+        __atomic_store_n(&download->limit, -1, __ATOMIC_RELEASE);
+    }
+
+    if (download->segments_running == 0) {
+        _download_segments_finish(download);
+    }
+}
+
+static void
+_segment_start(HTTPDownloadSegment* segment)
+{
+    HTTPDownload* download = segment->download;
+
+    segment->base = segment->pos;
+    segment->dlnow = 0;
+    segment->checked = FALSE;
+
+    auto_gchar gchar* range = g_strdup_printf("%" CURL_FORMAT_CURL_OFF_T "-%" CURL_FORMAT_CURL_OFF_T,
+                                              segment->pos, segment->end);
+
+    CURL* curl = _download_curl_new(download);
+    curl_easy_setopt(curl, CURLOPT_RANGE, range);
+    // a changed file comes back whole and fails the range check
+    segment->headers = _download_if_range(download);
+    if (segment->headers) {
+        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, segment->headers);
+    }
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, _segment_write_callback);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void*)segment);
+
+    segment->curl = curl;
+    download->segments_running++;
+    http_transfer_submit(curl, &segment->cancel, _segment_progress, _segment_done, segment);
+}
+
+// The server takes ranges and the file is large. The running transfer keeps
+// the first range and the others are fetched in parallel.
+static void
+_download_split(HTTPDownload* download, curl_off_t length)
+{
+    download->total_size = length;
+
+    curl_off_t chunk = length / HTTP_DOWNLOAD_SEGMENTS;
+    for (int i = 0; i < HTTP_DOWNLOAD_SEGMENTS; i++) {
+        HTTPDownloadSegment* segment = calloc(1, sizeof(HTTPDownloadSegment));
+        segment->download = download;
+        segment->start = i * chunk;
+        segment->end = i == HTTP_DOWNLOAD_SEGMENTS - 1 ? length - 1 : (i + 1) * chunk - 1;
+        segment->pos = segment->start;
+        download->segments = g_slist_append(download->segments, segment);
+    }
+
+    HTTPDownloadSegment* first = download->segments->data;
+    first->curl = download->curl;
+    download->segments_running = 1;
+    __atomic_store_n(&download->limit, first->end + 1, __ATOMIC_RELEASE);
+
+    log_debug("[HTTP] Downloading '%s' in %d ranges", download->url, HTTP_DOWNLOAD_SEGMENTS);
+    for (GSList* curr = g_slist_next(download->segments); curr; curr = g_slist_next(curr)) {
+        _segment_start(curr->data);
+    }
+}
+
+static void
+_probe_done(void* userdata, CURL* curl, CURLcode res)
+{
+    HTTPDownload* download = (HTTPDownload*)userdata;
+
+    if (download->cancel) {
+        _download_finish(download, "Download was canceled");
+        return;
+    }
+
+    long http_code = 0;
+    curl_off_t length = -1;
+    if (res == CURLE_OK) {
+        curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
+        curl_easy_getinfo(curl, CURLINFO_CONTENT_LENGTH_DOWNLOAD_T, &length);
+    }
+
+    // a failing probe is not fatal, the download reports the actual error
+    if (http_code == 200 && g_strcmp0(download->validator, download->etag) != 0
+        && g_strcmp0(download->validator, download->last_modified) != 0) {
+        log_info("[HTTP] '%s' changed since the partial download, starting over", download->url);
+        download->offset = 0;
+        _download_start(download);
+        return;
+    }
+    if (http_code == 200 && length >= 0 && length == download->offset) {
+        log_info("[HTTP] Download of '%s' was already complete", download->url);
+        _download_finish(download, rename(download->partname, download->filename) == 0 ? NULL : g_strerror(errno));
+        return;
+    }
+    if (http_code == 200 && length >= 0 && length < download->offset) {
+        log_info("[HTTP] Partial download of '%s' is larger than the file, starting over", download->url);
+        download->offset = 0;
+    }
+
+    _download_start(download);
+}
+
+// ask for the size and validators of the file an earlier attempt left a part of
+static void
+_download_probe(HTTPDownload* download)
+{
+    CURL* curl = _download_curl_new(download);
+    curl_easy_setopt(curl, CURLOPT_NOBODY, 1L);
+    curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, _download_header_callback);
+    curl_easy_setopt(curl, CURLOPT_HEADERDATA, (void*)download);
+
+    http_transfer_submit(curl, &download->cancel, NULL, _probe_done, download);
+}
+
+void
+http_file_get(HTTPDownload* download)
+{
+    download->cancel = 0;
+    download->bytes_received = 0;
+    download->range_total = -1;
+    download->partname = g_strdup_printf("%s%s", download->filename, HTTP_DOWNLOAD_PART_SUFFIX);
+    download->validatorname = g_strdup_printf("%s%s", download->partname, HTTP_DOWNLOAD_VALIDATOR_SUFFIX);
+
+    if (!download->silent) {
+        http_print_transfer(download->window, download->id,
+                            "Downloading '%s': 0%%", download->url);
+    }
+
+    // Continue where an earlier attempt stopped if it recorded which version
+    // of the file it got. Encrypted downloads start over, the decryption
+    // state of that attempt is gone.
+    struct stat st;
+    if (!download->omemo_stream && stat(download->partname, &st) == 0 && st.st_size > 0
+        && g_file_get_contents(download->validatorname, &download->validator, NULL, NULL)) {
+        log_info("[HTTP] Resuming download of '%s' at %lld bytes", download->url, (long long)st.st_size);
+        download->offset = st.st_size;
+        _download_probe(download);
+    } else {
+        _download_start(download);
+    }
 }
 
 void
@@ -256,7 +869,11 @@ http_download_cancel_processes(ProfWin* window)
     while (download_process) {
         HTTPDownload* download = download_process->data;
         if (download->window == window) {
-            download->cancel = 1;
+            g_atomic_int_set(&download->cancel, 1);
+            for (GSList* curr = download->segments; curr; curr = g_slist_next(curr)) {
+                HTTPDownloadSegment* segment = curr->data;
+                g_atomic_int_set(&segment->cancel, 1);
+            }
             break;
         }
         download_process = g_slist_next(download_process);
@@ -53,15 +53,47 @@ typedef struct http_download_t
     char* url;
     char* filename;
     char* cmd_template;
+    FILE* filehandle;
     curl_off_t bytes_received;
     ProfWin* window;
-    pthread_t worker;
     int cancel;
     gboolean silent;
-    gboolean return_bytes_received;
+    // decrypts the data as it is received, NULL for plain downloads
+    struct omemo_file_stream_t* omemo_stream;
+    // called once the download finished, right before it is freed
+    void (*on_complete)(struct http_download_t* download, gboolean success);
+    void* userdata;
+    // transfer state, the data is received into partname first
+    char* partname;
+    CURL* curl;
+    struct curl_slist* headers;
+    int retries;
+    gboolean ranges;
+    gboolean checked;
+    // validators of the last response
+    gchar* etag;
+    gchar* last_modified;
+    // validator of the response the part was written from, sent as If-Range
+    // when resuming and kept in validatorname for later attempts
+    gchar* validator;
+    char* validatorname;
+    // file size from the last Content-Range, -1 when there was none
+    curl_off_t range_total;
+    curl_off_t offset;
+    curl_off_t received;
+    curl_off_t skip;
+    // set by the transfer thread once the download can be split in ranges
+    curl_off_t split_length;
+    // end of the first range, where the initial transfer stops once split,
+    // -1 stops it at once
+    curl_off_t limit;
+    curl_off_t total_size;
+    GSList* segments;
+    guint segments_running;
+    char* error;
 } HTTPDownload;
 
-void* http_file_get(void* userdata);
+void http_file_get(HTTPDownload* download);
 
 void http_download_cancel_processes(ProfWin* window);
 void http_download_add_download(HTTPDownload* download);
@@ -0,0 +1,416 @@
+/*
+ * http_transfer.c
+ * vim: expandtab:ts=4:sts=4:sw=4
+ *
+ * This file is part of Profanity.
+ *
+ * Profanity is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Profanity is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Profanity.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link the code of portions of this program with the OpenSSL library under
+ * certain conditions as described in each individual source file, and
+ * distribute linked combinations including the two.
+ *
+ * You must obey the GNU General Public License in all respects for all of the
+ * code used other than OpenSSL. If you modify file(s) with this exception, you
+ * may extend this exception to your version of the file(s), but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version. If you delete this exception statement from all
+ * source files in the program, then also delete it here.
+ *
+ */
+
+#include "config.h"
+
+#include <stdlib.h>
+#include <pthread.h>
+#include <curl/curl.h>
+#include <glib.h>
+
+#include "log.h"
+#include "common.h"
+#include "tools/http_transfer.h"
+
+// how long the worker waits in curl before looking for canceled transfers,
+// new requests wake it up
+#define HTTP_TRANSFER_POLL_MS 100
+// progress is shown at most 4 times a second
+#define HTTP_TRANSFER_PROGRESS_INTERVAL_MS 250
+
+#define _counter_set(counter, value) __atomic_store_n(&(counter), (value), __ATOMIC_RELAXED)
+#define _counter_get(counter)        __atomic_load_n(&(counter), __ATOMIC_RELAXED)
+
+typedef struct http_transfer_t
+{
+    CURL* curl;
+    int* cancel;
+    http_transfer_progress_cb on_progress;
+    http_transfer_done_cb on_done;
+    void* userdata;
+    // published by the transfer thread, see _counter_set()
+    curl_off_t dltotal;
+    curl_off_t dlnow;
+    curl_off_t ultotal;
+    curl_off_t ulnow;
+    // last progress passed to on_progress, main thread only
+    curl_off_t shown_dlnow;
+    curl_off_t shown_ulnow;
+} HTTPTransfer;
+
+typedef struct http_transfer_event_t
+{
+    struct http_transfer_event_t* next;
+    HTTPTransfer* transfer;
+    CURLcode res;
+} HTTPTransferEvent;
+
+static CURLM* multi = NULL;
+static CURLSH* share = NULL;
+// easy handles using the share are cleaned up on the main thread
+static pthread_mutex_t share_locks[CURL_LOCK_DATA_LAST];
+// guarded by queue_lock
+static guint transfer_limit = 1;
+
+static pthread_t worker;
+static gboolean worker_running = FALSE;
+static pthread_mutex_t queue_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t queue_cond = PTHREAD_COND_INITIALIZER;
+// guarded by queue_lock
+static GQueue* pending = NULL;
+static gboolean stopping = FALSE;
+// transfers added to the multi handle, worker thread only
+static GList* active = NULL;
+
+// submitted and not yet finished, main thread only
+static GList* transfers = NULL;
+static gint64 progress_shown = 0;
+
+// Completions for the main thread, pushed by the worker with a compare-and-swap
+// and taken as a whole by the main loop, newest first.
+static gpointer events = NULL;
+
+static void
+_share_lock(CURL* handle, curl_lock_data data, curl_lock_access access, void* userptr)
+{
+    pthread_mutex_lock(&share_locks[data]);
+}
+
+static void
+_share_unlock(CURL* handle, curl_lock_data data, void* userptr)
+{
+    pthread_mutex_unlock(&share_locks[data]);
+}
+
+static void
+_wake_worker(void)
+{
+#if LIBCURL_VERSION_NUM >= 0x074400
+    curl_multi_wakeup(multi);
+#endif
+}
+
+static void
+_post_event(HTTPTransferEvent* event)
+{
+    gpointer head;
+    do {
+        head = g_atomic_pointer_get(&events);
+        event->next = head;
+    } while (!g_atomic_pointer_compare_and_exchange(&events, head, event));
+}
+
+static void
+_post_done(HTTPTransfer* transfer, CURLcode res)
+{
+    HTTPTransferEvent* event = calloc(1, sizeof(HTTPTransferEvent));
+    event->transfer = transfer;
+    event->res = res;
+    _post_event(event);
+}
+
+static int
+_xferinfo(void* userdata, curl_off_t dltotal, curl_off_t dlnow, curl_off_t ultotal, curl_off_t ulnow)
+{
+    HTTPTransfer* transfer = (HTTPTransfer*)userdata;
+
+    if (transfer->cancel && g_atomic_int_get(transfer->cancel)) {
+        return 1;
+    }
+
+    // the main loop picks these up at its own pace
+    _counter_set(transfer->dltotal, dltotal);
+    _counter_set(transfer->dlnow, dlnow);
+    _counter_set(transfer->ultotal, ultotal);
+    _counter_set(transfer->ulnow, ulnow);
+
+    return 0;
+}
+
+#if LIBCURL_VERSION_NUM < 0x072000
+static int
+_older_progress(void* p, double dltotal, double dlnow, double ultotal, double ulnow)
+{
+    return _xferinfo(p, (curl_off_t)dltotal, (curl_off_t)dlnow, (curl_off_t)ultotal, (curl_off_t)ulnow);
+}
+#endif
+
+static void
+_start_transfer(HTTPTransfer* transfer)
+{
+    CURL* curl = transfer->curl;
+
+    curl_easy_setopt(curl, CURLOPT_PRIVATE, transfer);
+    curl_easy_setopt(curl, CURLOPT_SHARE, share);
+#if LIBCURL_VERSION_NUM >= 0x072000
+    curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, _xferinfo);
+    curl_easy_setopt(curl, CURLOPT_XFERINFODATA, transfer);
+#else
+    curl_easy_setopt(curl, CURLOPT_PROGRESSFUNCTION, _older_progress);
+    curl_easy_setopt(curl, CURLOPT_PROGRESSDATA, transfer);
+#endif
+    curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
+
+    CURLMcode res = curl_multi_add_handle(multi, curl);
+    if (res != CURLM_OK) {
+        log_error("[HTTP] Unable to start transfer: %s", curl_multi_strerror(res));
+        _post_done(transfer, CURLE_FAILED_INIT);
+        return;
+    }
+
+    active = g_list_prepend(active, transfer);
+}
+
+static void
+_collect_finished(void)
+{
+    CURLMsg* msg;
+    int queued;
+    while ((msg = curl_multi_info_read(multi, &queued))) {
+        if (msg->msg != CURLMSG_DONE) {
+            continue;
+        }
+
+        // msg is invalidated by removing the handle
+        CURL* curl = msg->easy_handle;
+        CURLcode res = msg->data.result;
+        char* priv = NULL;
+        curl_easy_getinfo(curl, CURLINFO_PRIVATE, &priv);
+        HTTPTransfer* transfer = (HTTPTransfer*)priv;
+
+        curl_multi_remove_handle(multi, curl);
+        active = g_list_remove(active, transfer);
+        _post_done(transfer, res);
+    }
+}
+
+static void*
+_worker_run(void* arg)
+{
+    pthread_mutex_lock(&queue_lock);
+    while (TRUE) {
+        while (!stopping && !active && g_queue_is_empty(pending)) {
+            pthread_cond_wait(&queue_cond, &queue_lock);
+        }
+        if (stopping) {
+            break;
+        }
+        while (g_list_length(active) < transfer_limit && !g_queue_is_empty(pending)) {
+            _start_transfer(g_queue_pop_head(pending));
+        }
+        pthread_mutex_unlock(&queue_lock);
+
+        int running = 0;
+        curl_multi_perform(multi, &running);
+        _collect_finished();
+        if (active) {
+#if LIBCURL_VERSION_NUM >= 0x074400
+            curl_multi_poll(multi, NULL, 0, HTTP_TRANSFER_POLL_MS, NULL);
+#else
+            curl_multi_wait(multi, NULL, 0, HTTP_TRANSFER_POLL_MS, NULL);
+#endif
+        }
+
+        pthread_mutex_lock(&queue_lock);
+    }
+
+    // abort whatever is left, the main loop is gone already
+    HTTPTransfer* transfer;
+    while ((transfer = g_queue_pop_head(pending))) {
+        _post_done(transfer, CURLE_ABORTED_BY_CALLBACK);
+    }
+    pthread_mutex_unlock(&queue_lock);
+
+    for (GList* curr = active; curr; curr = g_list_next(curr)) {
+        transfer = curr->data;
+        curl_multi_remove_handle(multi, transfer->curl);
+        _post_done(transfer, CURLE_ABORTED_BY_CALLBACK);
+    }
+    g_list_free(active);
+    active = NULL;
+
+    return NULL;
+}
+
+static void
+_http_transfer_shutdown(void)
+{
+    if (worker_running) {
+        pthread_mutex_lock(&queue_lock);
+        stopping = TRUE;
+        pthread_cond_signal(&queue_cond);
+        pthread_mutex_unlock(&queue_lock);
+        _wake_worker();
+        pthread_join(worker, NULL);
+        worker_running = FALSE;
+    }
+
+    // release the transfers and their easy handles before the shared caches
+    http_transfer_process_events();
+
+    curl_multi_cleanup(multi);
+    multi = NULL;
+    curl_share_cleanup(share);
+    share = NULL;
+    for (int i = 0; i < CURL_LOCK_DATA_LAST; i++) {
+        pthread_mutex_destroy(&share_locks[i]);
+    }
+    g_queue_free(pending);
+    pending = NULL;
+    curl_global_cleanup();
+}
+
+void
+http_transfer_init(guint max_active)
+{
+    // must run before any other thread uses curl
+    curl_global_init(CURL_GLOBAL_ALL);
+
+    transfer_limit = MAX(max_active, 1);
+    pending = g_queue_new();
+
+    // Keeping one multi handle alive lets curl reuse its connection pool,
+    // the share handle adds DNS results and TLS sessions on top of that.
+    multi = curl_multi_init();
+    share = curl_share_init();
+    for (int i = 0; i < CURL_LOCK_DATA_LAST; i++) {
+        pthread_mutex_init(&share_locks[i], NULL);
+    }
+    curl_share_setopt(share, CURLSHOPT_LOCKFUNC, _share_lock);
+    curl_share_setopt(share, CURLSHOPT_UNLOCKFUNC, _share_unlock);
+    curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+
+    prof_add_shutdown_routine(_http_transfer_shutdown);
+}
+
+void
+http_transfer_submit(CURL* curl, int* cancel, http_transfer_progress_cb on_progress, http_transfer_done_cb on_done, void* userdata)
+{
+    HTTPTransfer* transfer = calloc(1, sizeof(HTTPTransfer));
+    transfer->curl = curl;
+    transfer->cancel = cancel;
+    transfer->on_progress = on_progress;
+    transfer->on_done = on_done;
+    transfer->userdata = userdata;
+    transfers = g_list_prepend(transfers, transfer);
+
+    pthread_mutex_lock(&queue_lock);
+    if (!worker_running) {
+        if (pthread_create(&worker, NULL, _worker_run, NULL) != 0) {
+            pthread_mutex_unlock(&queue_lock);
+            log_error("[HTTP] Unable to start transfer thread");
+            _post_done(transfer, CURLE_FAILED_INIT);
+            return;
+        }
+        worker_running = TRUE;
+    }
+    g_queue_push_tail(pending, transfer);
+    pthread_cond_signal(&queue_cond);
+    pthread_mutex_unlock(&queue_lock);
+
+    // the worker may be waiting in curl for the running transfers
+    _wake_worker();
+}
+
+void
+http_transfer_set_max_active(guint max_active)
+{
+    pthread_mutex_lock(&queue_lock);
+    transfer_limit = MAX(max_active, 1);
+    pthread_cond_signal(&queue_cond);
+    pthread_mutex_unlock(&queue_lock);
+
+    // start queued transfers right away if the limit was raised
+    _wake_worker();
+}
+
+static void
+_show_progress(void)
+{
+    gint64 now = g_get_monotonic_time();
+    if (now - progress_shown < HTTP_TRANSFER_PROGRESS_INTERVAL_MS * 1000) {
+        return;
+    }
+    progress_shown = now;
+
+    for (GList* curr = transfers; curr; curr = g_list_next(curr)) {
+        HTTPTransfer* transfer = curr->data;
+        if (!transfer->on_progress) {
+            continue;
+        }
+
+        curl_off_t dlnow = _counter_get(transfer->dlnow);
+        curl_off_t ulnow = _counter_get(transfer->ulnow);
+        if (dlnow == transfer->shown_dlnow && ulnow == transfer->shown_ulnow) {
+            continue;
+        }
+        transfer->shown_dlnow = dlnow;
+        transfer->shown_ulnow = ulnow;
+
+        transfer->on_progress(transfer->userdata, _counter_get(transfer->dltotal), dlnow, _counter_get(transfer->ultotal), ulnow);
+    }
+}
+
+void
+http_transfer_process_events(void)
+{
+    gpointer head;
+    do {
+        head = g_atomic_pointer_get(&events);
+    } while (head && !g_atomic_pointer_compare_and_exchange(&events, head, NULL));
+
+    // restore the order the worker posted them in
+    HTTPTransferEvent* ordered = NULL;
+    HTTPTransferEvent* event = head;
+    while (event) {
+        HTTPTransferEvent* next = event->next;
+        event->next = ordered;
+        ordered = event;
+        event = next;
+    }
+
+    while (ordered) {
+        event = ordered;
+        ordered = event->next;
+
+        HTTPTransfer* transfer = event->transfer;
+        transfers = g_list_remove(transfers, transfer);
+        transfer->on_done(transfer->userdata, transfer->curl, event->res);
+        curl_easy_cleanup(transfer->curl);
+        free(transfer);
+        free(event);
+    }
+
+    _show_progress();
+}
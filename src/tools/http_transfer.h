@@ -0,0 +1,51 @@
+/*
+ * http_transfer.h
+ * vim: expandtab:ts=4:sts=4:sw=4
+ *
+ * This file is part of Profanity.
+ *
+ * Profanity is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Profanity is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Profanity.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link the code of portions of this program with the OpenSSL library under
+ * certain conditions as described in each individual source file, and
+ * distribute linked combinations including the two.
+ *
+ * You must obey the GNU General Public License in all respects for all of the
+ * code used other than OpenSSL. If you modify file(s) with this exception, you
+ * may extend this exception to your version of the file(s), but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version. If you delete this exception statement from all
+ * source files in the program, then also delete it here.
+ *
+ */
+
+#ifndef TOOLS_HTTP_TRANSFER_H
+#define TOOLS_HTTP_TRANSFER_H
+
+#include <curl/curl.h>
+#include <glib.h>
+
+// Both callbacks are called on the main thread from http_transfer_process_events(),
+// progress at a fixed rate and only when it changed
+typedef void (*http_transfer_progress_cb)(void* userdata, curl_off_t dltotal, curl_off_t dlnow, curl_off_t ultotal, curl_off_t ulnow);
+typedef void (*http_transfer_done_cb)(void* userdata, CURL* curl, CURLcode res);
+
+// max_active transfers run at the same time, further ones are queued
+void http_transfer_init(guint max_active);
+void http_transfer_set_max_active(guint max_active);
+void http_transfer_submit(CURL* curl, int* cancel, http_transfer_progress_cb on_progress, http_transfer_done_cb on_done, void* userdata);
+void http_transfer_process_events(void);
+
+#endif
@@ -42,89 +42,71 @@
 #include <sys/types.h>
 #include <curl/curl.h>
 #include <gio/gio.h>
-#include <pthread.h>
 #include <assert.h>
 
 #include "profanity.h"
 #include "event/client_events.h"
 #include "tools/http_upload.h"
+#include "tools/http_transfer.h"
 #include "config/cafile.h"
 #include "config/preferences.h"
 #include "ui/ui.h"
 #include "ui/window.h"
 #include "common.h"
 
+#ifdef HAVE_OMEMO
+#include "omemo/omemo.h"
+#endif
+
 #define FALLBACK_MIMETYPE           "application/octet-stream"
 #define FALLBACK_CONTENTTYPE_HEADER "Content-Type: application/octet-stream"
 #define FALLBACK_MSG                ""
 #define FILE_HEADER_BYTES           512
 
-struct curl_data_t
-{
-    char* buffer;
-    size_t size;
-};
-
 GSList* upload_processes = NULL;
 
-static int
-_xferinfo(void* userdata, curl_off_t dltotal, curl_off_t dlnow, curl_off_t ultotal, curl_off_t ulnow)
+static void
+_upload_progress(void* userdata, curl_off_t dltotal, curl_off_t dlnow, curl_off_t ultotal, curl_off_t ulnow)
 {
     HTTPUpload* upload = (HTTPUpload*)userdata;
 
-    pthread_mutex_lock(&lock);
-
-    if (upload->cancel) {
-        pthread_mutex_unlock(&lock);
-        return 1;
-    }
-
-    if (upload->bytes_sent == ulnow) {
-        pthread_mutex_unlock(&lock);
-        return 0;
-    } else {
-        upload->bytes_sent = ulnow;
+    if (upload->cancel || upload->bytes_sent == ulnow) {
+        return;
     }
+    upload->bytes_sent = ulnow;
 
     unsigned int ulperc = 0;
     if (ultotal != 0) {
         ulperc = (100 * ulnow) / ultotal;
     }
 
-    gchar* msg = g_strdup_printf("Uploading '%s': %d%%", upload->filename, ulperc);
+    auto_gchar gchar* msg = g_strdup_printf("Uploading '%s': %d%%", upload->filename, ulperc);
     if (!msg) {
         msg = g_strdup(FALLBACK_MSG);
     }
     win_update_entry_message(upload->window, upload->put_url, msg);
-    g_free(msg);
-
-    pthread_mutex_unlock(&lock);
-
-    return 0;
 }
 
-#if LIBCURL_VERSION_NUM < 0x072000
-static int
-_older_progress(void* p, double dltotal, double dlnow, double ultotal, double ulnow)
+static size_t
+_data_callback(void* ptr, size_t size, size_t nmemb, void* data)
 {
-    return _xferinfo(p, (curl_off_t)dltotal, (curl_off_t)dlnow, (curl_off_t)ultotal, (curl_off_t)ulnow);
+    // the response body is of no interest
+    return size * nmemb;
 }
-#endif
 
 static size_t
-_data_callback(void* ptr, size_t size, size_t nmemb, void* data)
+_read_callback(char* buffer, size_t size, size_t nitems, void* userdata)
 {
-    size_t realsize = size * nmemb;
-    struct curl_data_t* mem = (struct curl_data_t*)data;
-    mem->buffer = realloc(mem->buffer, mem->size + realsize + 1);
-
-    if (mem->buffer) {
-        memcpy(&(mem->buffer[mem->size]), ptr, realsize);
-        mem->size += realsize;
-        mem->buffer[mem->size] = 0;
+    HTTPUpload* upload = (HTTPUpload*)userdata;
+
+#ifdef HAVE_OMEMO
+    if (upload->omemo_stream) {
+        ssize_t res = omemo_encrypt_stream_read(upload->omemo_stream, buffer, size * nitems);
+        return res < 0 ? CURL_READFUNC_ABORT : (size_t)res;
     }
+#endif
 
-    return realsize;
+    return fread(buffer, size, nitems, upload->filehandle);
 }
 
 int
@@ -156,146 +138,33 @@ out:
     return ret;
 }
 
-void*
-http_file_put(void* userdata)
+static void
+_upload_done(void* userdata, CURL* curl, CURLcode res)
 {
     HTTPUpload* upload = (HTTPUpload*)userdata;
 
-    FILE* fh = NULL;
-
     auto_char char* err = NULL;
 
-    CURL* curl;
-    CURLcode res;
-
-    upload->cancel = 0;
-    upload->bytes_sent = 0;
-
-    pthread_mutex_lock(&lock);
-    auto_gchar gchar* msg = g_strdup_printf("Uploading '%s': 0%%", upload->filename);
-    if (!msg) {
-        msg = g_strdup(FALLBACK_MSG);
-    }
-    win_print_http_transfer(upload->window, msg, upload->put_url);
-
-    auto_gchar gchar* cert_path = prefs_get_string(PREF_TLS_CERTPATH);
-    auto_gchar gchar* cafile = cafile_get_name();
-    gboolean insecure = FALSE;
-    ProfAccount* account = accounts_get_account(session_get_account_name());
-    if (account) {
-        insecure = account->tls_policy && strcmp(account->tls_policy, "trust") == 0;
-    }
-    account_free(account);
-    pthread_mutex_unlock(&lock);
-
-    curl_global_init(CURL_GLOBAL_ALL);
-    curl = curl_easy_init();
-
-    curl_easy_setopt(curl, CURLOPT_URL, upload->put_url);
-    curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, "PUT");
-
-    struct curl_slist* headers = NULL;
-    auto_gchar gchar* content_type_header = g_strdup_printf("Content-Type: %s", upload->mime_type);
-    if (!content_type_header) {
-        content_type_header = g_strdup(FALLBACK_CONTENTTYPE_HEADER);
-    }
-    headers = curl_slist_append(headers, content_type_header);
-    headers = curl_slist_append(headers, "Expect:");
-
-    // Optional headers
-    auto_gchar gchar* auth_header = NULL;
-    if (upload->authorization) {
-        auth_header = g_strdup_printf("Authorization: %s", upload->authorization);
-        if (!auth_header) {
-            auth_header = g_strdup(FALLBACK_MSG);
-        }
-        headers = curl_slist_append(headers, auth_header);
-    }
-    auto_gchar gchar* cookie_header = NULL;
-    if (upload->cookie) {
-        cookie_header = g_strdup_printf("Cookie: %s", upload->cookie);
-        if (!cookie_header) {
-            cookie_header = g_strdup(FALLBACK_MSG);
-        }
-        headers = curl_slist_append(headers, cookie_header);
-    }
-    auto_gchar gchar* expires_header = NULL;
-    if (upload->expires) {
-        expires_header = g_strdup_printf("Expires: %s", upload->expires);
-        if (!expires_header) {
-            expires_header = g_strdup(FALLBACK_MSG);
-        }
-        headers = curl_slist_append(headers, expires_header);
-    }
-
-    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-
-#if LIBCURL_VERSION_NUM >= 0x072000
-    curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, _xferinfo);
-    curl_easy_setopt(curl, CURLOPT_XFERINFODATA, upload);
-#else
-    curl_easy_setopt(curl, CURLOPT_PROGRESSFUNCTION, _older_progress);
-    curl_easy_setopt(curl, CURLOPT_PROGRESSDATA, upload);
-#endif
-    curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
-
-    struct curl_data_t output;
-    output.buffer = NULL;
-    output.size = 0;
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, _data_callback);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void*)&output);
-
-    curl_easy_setopt(curl, CURLOPT_USERAGENT, "profanity");
-
-    fh = upload->filehandle;
-
-    if (cafile) {
-        curl_easy_setopt(curl, CURLOPT_CAINFO, cafile);
-    }
-    if (cert_path) {
-        curl_easy_setopt(curl, CURLOPT_CAPATH, cert_path);
-    }
-    if (insecure) {
-        curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 0L);
-        curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L);
-    }
-
-    curl_easy_setopt(curl, CURLOPT_READDATA, fh);
-    curl_easy_setopt(curl, CURLOPT_INFILESIZE_LARGE, (curl_off_t)(upload->filesize));
-    curl_easy_setopt(curl, CURLOPT_UPLOAD, 1L);
-
-    if ((res = curl_easy_perform(curl)) != CURLE_OK) {
+    if (res != CURLE_OK) {
         err = strdup(curl_easy_strerror(res));
     } else {
         long http_code = 0;
         curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
 
-        if (output.buffer) {
-            output.buffer[output.size++] = '\0';
-        }
-
         // XEP-0363 specifies 201 but prosody returns 200
         if (http_code != 200 && http_code != 201) {
             err = g_strdup_printf("Server returned %lu", http_code);
         }
-
-#if 0
-        printf("HTTP Status: %lu\n", http_code);
-        printf("%s\n", output.buffer);
-        printf("%lu bytes retrieved\n", (long)output.size);
-#endif
     }
 
-    curl_easy_cleanup(curl);
-    curl_global_cleanup();
-    curl_slist_free_all(headers);
+    curl_slist_free_all(upload->headers);
 
-    if (fh) {
-        fclose(fh);
+#ifdef HAVE_OMEMO
+    omemo_file_stream_free(upload->omemo_stream);
+#endif
+    if (upload->filehandle) {
+        fclose(upload->filehandle);
     }
-    free(output.buffer);
-
-    pthread_mutex_lock(&lock);
 
     if (err) {
         auto_gchar gchar* err_msg = NULL;
@@ -361,7 +230,6 @@ http_file_put(void* userdata)
     }
 
     upload_processes = g_slist_remove(upload_processes, upload);
-    pthread_mutex_unlock(&lock);
 
     free(upload->filename);
     free(upload->mime_type);
@@ -373,8 +241,93 @@ http_file_put(void* userdata)
     free(upload->cookie);
     free(upload->expires);
     free(upload);
+}
+
+void
+http_file_put(HTTPUpload* upload)
+{
+    upload->cancel = 0;
+    upload->bytes_sent = 0;
+
+    auto_gchar gchar* msg = g_strdup_printf("Uploading '%s': 0%%", upload->filename);
+    if (!msg) {
+        msg = g_strdup(FALLBACK_MSG);
+    }
+    win_print_http_transfer(upload->window, msg, upload->put_url);
+
+    auto_gchar gchar* cert_path = prefs_get_string(PREF_TLS_CERTPATH);
+    auto_gchar gchar* cafile = cafile_get_name();
+    gboolean insecure = FALSE;
+    ProfAccount* account = accounts_get_account(session_get_account_name());
+    if (account) {
+        insecure = account->tls_policy && strcmp(account->tls_policy, "trust") == 0;
+    }
+    account_free(account);
+
+    CURL* curl = curl_easy_init();
+
+    curl_easy_setopt(curl, CURLOPT_URL, upload->put_url);
+    curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, "PUT");
+
+    struct curl_slist* headers = NULL;
+    auto_gchar gchar* content_type_header = g_strdup_printf("Content-Type: %s", upload->mime_type);
+    if (!content_type_header) {
+        content_type_header = g_strdup(FALLBACK_CONTENTTYPE_HEADER);
+    }
+    headers = curl_slist_append(headers, content_type_header);
+    headers = curl_slist_append(headers, "Expect:");
+
+    // Optional headers
+    auto_gchar gchar* auth_header = NULL;
+    if (upload->authorization) {
+        auth_header = g_strdup_printf("Authorization: %s", upload->authorization);
+        if (!auth_header) {
+            auth_header = g_strdup(FALLBACK_MSG);
+        }
+        headers = curl_slist_append(headers, auth_header);
+    }
+    auto_gchar gchar* cookie_header = NULL;
+    if (upload->cookie) {
+        cookie_header = g_strdup_printf("Cookie: %s", upload->cookie);
+        if (!cookie_header) {
+            cookie_header = g_strdup(FALLBACK_MSG);
+        }
+        headers = curl_slist_append(headers, cookie_header);
+    }
+    auto_gchar gchar* expires_header = NULL;
+    if (upload->expires) {
+        expires_header = g_strdup_printf("Expires: %s", upload->expires);
+        if (!expires_header) {
+            expires_header = g_strdup(FALLBACK_MSG);
+        }
+        headers = curl_slist_append(headers, expires_header);
+    }
+
+    // curl keeps using the list until the transfer is done
+    upload->headers = headers;
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, _data_callback);
+
+    curl_easy_setopt(curl, CURLOPT_USERAGENT, "profanity");
+
+    if (cafile) {
+        curl_easy_setopt(curl, CURLOPT_CAINFO, cafile);
+    }
+    if (cert_path) {
+        curl_easy_setopt(curl, CURLOPT_CAPATH, cert_path);
+    }
+    if (insecure) {
+        curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 0L);
+        curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L);
+    }
+
+    curl_easy_setopt(curl, CURLOPT_READFUNCTION, _read_callback);
+    curl_easy_setopt(curl, CURLOPT_READDATA, upload);
+    curl_easy_setopt(curl, CURLOPT_INFILESIZE_LARGE, (curl_off_t)(upload->filesize));
+    curl_easy_setopt(curl, CURLOPT_UPLOAD, 1L);
 
-    return NULL;
+    http_transfer_submit(curl, &upload->cancel, _upload_progress, _upload_done, upload);
 }
 
 char*
@@ -414,7 +367,7 @@ http_upload_cancel_processes(ProfWin* window)
     while (upload_process) {
         HTTPUpload* upload = upload_process->data;
         if (upload->window == window) {
-            upload->cancel = 1;
+            g_atomic_int_set(&upload->cancel, 1);
             break;
         }
         upload_process = g_slist_next(upload_process);
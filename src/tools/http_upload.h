@@ -56,17 +56,19 @@ typedef struct http_upload_t
     char* put_url;
     char* alt_scheme;
     char* alt_fragment;
+    // encrypts the file while curl reads it, NULL for plain uploads
+    struct omemo_file_stream_t* omemo_stream;
     ProfWin* window;
-    pthread_t worker;
     int cancel;
     // Additional headers
     // (NULL if they shouldn't be send in the PUT)
     char* authorization;
     char* cookie;
     char* expires;
+    struct curl_slist* headers;
 } HTTPUpload;
 
-void* http_file_put(void* userdata);
+void http_file_put(HTTPUpload* upload);
 
 char* file_mime_type(const char* const filename);
 off_t file_size(int filedes);
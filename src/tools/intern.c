@@ -0,0 +1,111 @@
+/*
+ * intern.c
+ * vim: expandtab:ts=4:sts=4:sw=4
+ *
+ * This file is part of Profanity.
+ *
+ * Profanity is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Profanity is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Profanity.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link the code of portions of this program with the OpenSSL library under
+ * certain conditions as described in each individual source file, and
+ * distribute linked combinations including the two.
+ *
+ * You must obey the GNU General Public License in all respects for all of the
+ * code used other than OpenSSL. If you modify file(s) with this exception, you
+ * may extend this exception to your version of the file(s), but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version. If you delete this exception statement from all
+ * source files in the program, then also delete it here.
+ *
+ */
+
+#include "config.h"
+
+#include <glib.h>
+
+#include "log.h"
+#include "tools/intern.h"
+#include "tools/memstats.h"
+
+// string -> reference count, the keys are the shared copies. There is no
+// key destroy function: re-inserting an existing key would free it.
+static GHashTable* strings;
+
+static void
+_intern_memstats(MemStats* stats)
+{
+    gsize bytes = memstats_hash_table(strings);
+    GHashTableIter iter;
+    gpointer key;
+    g_hash_table_iter_init(&iter, strings);
+    while (g_hash_table_iter_next(&iter, &key, NULL)) {
+        bytes += memstats_str(key);
+    }
+    memstats_add(stats, "intern", bytes, g_hash_table_size(strings));
+}
+
+const char*
+intern_ref(const char* const str)
+{
+    if (str == NULL) {
+        return NULL;
+    }
+
+    if (strings == NULL) {
+        strings = g_hash_table_new(g_str_hash, g_str_equal);
+        memstats_register("intern", _intern_memstats);
+    }
+
+    gpointer shared;
+    gpointer refs;
+    if (g_hash_table_lookup_extended(strings, str, &shared, &refs)) {
+        g_hash_table_insert(strings, shared, GUINT_TO_POINTER(GPOINTER_TO_UINT(refs) + 1));
+        return shared;
+    }
+
+    gchar* copy = g_strdup(str);
+    g_hash_table_insert(strings, copy, GUINT_TO_POINTER(1));
+
+    return copy;
+}
+
+void
+intern_unref(const char* const str)
+{
+    if (str == NULL) {
+        return;
+    }
+
+    gpointer shared;
+    gpointer refs;
+    if (strings == NULL || !g_hash_table_lookup_extended(strings, str, &shared, &refs) || shared != str) {
+        log_error("intern_unref: %s was not interned", str);
+        return;
+    }
+
+    guint count = GPOINTER_TO_UINT(refs) - 1;
+    if (count == 0) {
+        g_hash_table_remove(strings, shared);
+        g_free(shared);
+    } else {
+        g_hash_table_insert(strings, shared, GUINT_TO_POINTER(count));
+    }
+}
+
+guint
+intern_count(void)
+{
+    return strings ? g_hash_table_size(strings) : 0;
+}
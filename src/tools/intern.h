@@ -0,0 +1,51 @@
+/*
+ * intern.h
+ * vim: expandtab:ts=4:sts=4:sw=4
+ *
+ * This file is part of Profanity.
+ *
+ * Profanity is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Profanity is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Profanity.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link the code of portions of this program with the OpenSSL library under
+ * certain conditions as described in each individual source file, and
+ * distribute linked combinations including the two.
+ *
+ * You must obey the GNU General Public License in all respects for all of the
+ * code used other than OpenSSL. If you modify file(s) with this exception, you
+ * may extend this exception to your version of the file(s), but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version. If you delete this exception statement from all
+ * source files in the program, then also delete it here.
+ *
+ */
+
+#ifndef TOOLS_INTERN_H
+#define TOOLS_INTERN_H
+
+#include <glib.h>
+
+// Shared, immutable, reference counted copies of strings that recur across
+// many structures, such as JIDs and nicks. Two interned strings are equal
+// exactly when their pointers are.
+
+// returns the shared copy of str and takes a reference on it, NULL for NULL
+const char* intern_ref(const char* const str);
+// drops a reference taken with intern_ref(), the copy is freed with the last one
+void intern_unref(const char* const str);
+
+// number of distinct strings currently interned
+guint intern_count(void);
+
+#endif
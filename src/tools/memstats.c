@@ -0,0 +1,238 @@
+/*
+ * memstats.c
+ * vim: expandtab:ts=4:sts=4:sw=4
+ *
+ * This file is part of Profanity.
+ *
+ * Profanity is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Profanity is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Profanity.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link the code of portions of this program with the OpenSSL library under
+ * certain conditions as described in each individual source file, and
+ * distribute linked combinations including the two.
+ *
+ * You must obey the GNU General Public License in all respects for all of the
+ * code used other than OpenSSL. If you modify file(s) with this exception, you
+ * may extend this exception to your version of the file(s), but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version. If you delete this exception statement from all
+ * source files in the program, then also delete it here.
+ *
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <glib.h>
+
+#include "log.h"
+#include "common.h"
+#include "tools/memstats.h"
+
+// entries named in the periodic log line
+#define MEMSTATS_LOG_TOP 5
+
+typedef struct memstats_reporter_t
+{
+    gchar* name;
+    MemStatsReporter reporter;
+} Reporter;
+
+static GSList* reporters;
+
+static gint64 log_interval_us = 0;
+static gint64 last_log = 0;
+
+static void
+_reporter_free(Reporter* reporter)
+{
+    g_free(reporter->name);
+    g_free(reporter);
+}
+
+static GSList*
+_reporter_find(const char* const name)
+{
+    for (GSList* curr = reporters; curr; curr = g_slist_next(curr)) {
+        Reporter* reporter = curr->data;
+        if (g_strcmp0(reporter->name, name) == 0) {
+            return curr;
+        }
+    }
+
+    return NULL;
+}
+
+void
+memstats_register(const char* const name, MemStatsReporter reporter)
+{
+    GSList* found = _reporter_find(name);
+    if (found) {
+        ((Reporter*)found->data)->reporter = reporter;
+        return;
+    }
+
+    Reporter* new_reporter = g_new0(Reporter, 1);
+    new_reporter->name = g_strdup(name);
+    new_reporter->reporter = reporter;
+    reporters = g_slist_append(reporters, new_reporter);
+}
+
+void
+memstats_unregister(const char* const name)
+{
+    GSList* found = _reporter_find(name);
+    if (found) {
+        _reporter_free(found->data);
+        reporters = g_slist_delete_link(reporters, found);
+    }
+}
+
+void
+memstats_close(void)
+{
+    g_slist_free_full(reporters, (GDestroyNotify)_reporter_free);
+    reporters = NULL;
+}
+
+static void
+_entry_free(MemStatsEntry* entry)
+{
+    g_free(entry->name);
+    g_free(entry);
+}
+
+void
+memstats_add(MemStats* stats, const char* const name, gsize bytes, guint items)
+{
+    MemStatsEntry* entry = g_new0(MemStatsEntry, 1);
+    entry->name = g_strdup(name);
+    entry->bytes = bytes;
+    entry->items = items;
+    g_ptr_array_add(stats->entries, entry);
+    stats->total += bytes;
+}
+
+static gint
+_entry_cmp(gconstpointer a, gconstpointer b)
+{
+    const MemStatsEntry* entry_a = *(MemStatsEntry* const*)a;
+    const MemStatsEntry* entry_b = *(MemStatsEntry* const*)b;
+
+    if (entry_a->bytes != entry_b->bytes) {
+        return entry_a->bytes < entry_b->bytes ? 1 : -1;
+    }
+    return g_strcmp0(entry_a->name, entry_b->name);
+}
+
+MemStats*
+memstats_collect(void)
+{
+    MemStats* stats = g_new0(MemStats, 1);
+    stats->entries = g_ptr_array_new_with_free_func((GDestroyNotify)_entry_free);
+
+    for (GSList* curr = reporters; curr; curr = g_slist_next(curr)) {
+        Reporter* reporter = curr->data;
+        reporter->reporter(stats);
+    }
+    g_ptr_array_sort(stats->entries, _entry_cmp);
+
+    return stats;
+}
+
+void
+memstats_free(MemStats* stats)
+{
+    if (stats) {
+        g_ptr_array_free(stats->entries, TRUE);
+        g_free(stats);
+    }
+}
+
+gsize
+memstats_str(const char* const str)
+{
+    return str ? strlen(str) + 1 : 0;
+}
+
+// GHashTable keeps a key, a value and a hash per slot and grows to keep at
+// most three quarters of its slots in use, starting from 8.
+gsize
+memstats_hash_table(GHashTable* table)
+{
+    if (table == NULL) {
+        return 0;
+    }
+
+    gsize slots = 8;
+    guint size = g_hash_table_size(table);
+    while (slots * 3 / 4 < size) {
+        slots *= 2;
+    }
+
+    return 12 * sizeof(gpointer) + slots * (2 * sizeof(gpointer) + sizeof(guint));
+}
+
+gsize
+memstats_list(GList* list)
+{
+    return g_list_length(list) * sizeof(GList);
+}
+
+gsize
+memstats_slist(GSList* list)
+{
+    return g_slist_length(list) * sizeof(GSList);
+}
+
+void
+memstats_set_log_interval(gint seconds)
+{
+    log_interval_us = (gint64)seconds * G_USEC_PER_SEC;
+    last_log = g_get_monotonic_time();
+}
+
+void
+memstats_log(void)
+{
+    MemStats* stats = memstats_collect();
+    auto_gchar gchar* total = g_format_size(stats->total);
+    GString* line = g_string_new(NULL);
+    g_string_append_printf(line, "[Memory] %s in %u entries", total, stats->entries->len);
+
+    for (guint i = 0; i < stats->entries->len && i < MEMSTATS_LOG_TOP; i++) {
+        MemStatsEntry* entry = g_ptr_array_index(stats->entries, i);
+        auto_gchar gchar* size = g_format_size(entry->bytes);
+        g_string_append_printf(line, "%s %s %s", i == 0 ? ", top:" : ",", entry->name, size);
+    }
+
+    log_info("%s", line->str);
+    g_string_free(line, TRUE);
+    memstats_free(stats);
+}
+
+void
+memstats_tick(void)
+{
+    if (log_interval_us <= 0) {
+        return;
+    }
+
+    gint64 now = g_get_monotonic_time();
+    if (now - last_log >= log_interval_us) {
+        last_log = now;
+        memstats_log();
+    }
+}
@@ -0,0 +1,84 @@
+/*
+ * memstats.h
+ * vim: expandtab:ts=4:sts=4:sw=4
+ *
+ * This file is part of Profanity.
+ *
+ * Profanity is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Profanity is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Profanity.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link the code of portions of this program with the OpenSSL library under
+ * certain conditions as described in each individual source file, and
+ * distribute linked combinations including the two.
+ *
+ * You must obey the GNU General Public License in all respects for all of the
+ * code used other than OpenSSL. If you modify file(s) with this exception, you
+ * may extend this exception to your version of the file(s), but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version. If you delete this exception statement from all
+ * source files in the program, then also delete it here.
+ *
+ */
+
+#ifndef TOOLS_MEMSTATS_H
+#define TOOLS_MEMSTATS_H
+
+#include <glib.h>
+
+// Approximate heap footprint of long lived structures. Subsystems register a
+// reporter that adds one or more named entries when a report is collected.
+// Sizes count the structures and the strings they own, not allocator
+// overhead, so they are lower bounds meant to show what grows.
+
+typedef struct memstats_entry_t
+{
+    gchar* name;
+    gsize bytes;
+    // number of elements, such as messages, contacts or sessions
+    guint items;
+} MemStatsEntry;
+
+typedef struct memstats_t
+{
+    // MemStatsEntry*, largest first once collected
+    GPtrArray* entries;
+    gsize total;
+} MemStats;
+
+typedef void (*MemStatsReporter)(MemStats* stats);
+
+// registering a name again replaces its reporter
+void memstats_register(const char* const name, MemStatsReporter reporter);
+void memstats_unregister(const char* const name);
+void memstats_close(void);
+
+void memstats_add(MemStats* stats, const char* const name, gsize bytes, guint items);
+
+MemStats* memstats_collect(void);
+void memstats_free(MemStats* stats);
+
+// estimates for the usual building blocks, 0 for NULL
+gsize memstats_str(const char* const str);
+gsize memstats_hash_table(GHashTable* table);
+gsize memstats_list(GList* list);
+gsize memstats_slist(GSList* list);
+
+// log the largest consumers every seconds, 0 to stop
+void memstats_set_log_interval(gint seconds);
+void memstats_log(void);
+
+// called from the main loop, writes the periodic log line
+void memstats_tick(void);
+
+#endif
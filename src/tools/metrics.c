@@ -0,0 +1,283 @@
+/*
+ * metrics.c
+ * vim: expandtab:ts=4:sts=4:sw=4
+ *
+ * This file is part of Profanity.
+ *
+ * Profanity is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Profanity is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Profanity.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link the code of portions of this program with the OpenSSL library under
+ * certain conditions as described in each individual source file, and
+ * distribute linked combinations including the two.
+ *
+ * You must obey the GNU General Public License in all respects for all of the
+ * code used other than OpenSSL. If you modify file(s) with this exception, you
+ * may extend this exception to your version of the file(s), but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version. If you delete this exception statement from all
+ * source files in the program, then also delete it here.
+ *
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+
+#include <glib.h>
+
+#include "log.h"
+#include "common.h"
+#include "config/files.h"
+#include "tools/metrics.h"
+#include "tools/trace.h"
+
+// Log-linear histogram: values below 4us get their own bucket, above that
+// every power of two is split into 4 linear sub-buckets, so bucket bounds are
+// within 25% of any recorded value. 160 buckets cover up to about 6 days.
+#define METRICS_SUB_BITS 2
+#define METRICS_SUB      (1 << METRICS_SUB_BITS)
+#define METRICS_BUCKETS  160
+
+#define METRICS_RATE_WINDOW_US (5 * G_USEC_PER_SEC)
+
+typedef struct metric_counter_t
+{
+    guint64 count;
+    guint64 total_us;
+    guint64 max_us;
+    guint64 buckets[METRICS_BUCKETS];
+} Metric;
+
+static const char* const metric_names[METRIC_COUNT] = {
+    [METRIC_MESSAGE_STANZA] = "stanza.message",
+    [METRIC_IQ_STANZA] = "stanza.iq",
+    [METRIC_PRESENCE_STANZA] = "stanza.presence",
+    [METRIC_DB_ADD] = "db.add",
+    [METRIC_UI_UPDATE] = "ui.update",
+    [METRIC_WIN_REDRAW] = "ui.redraw",
+    [METRIC_KEYFILE_SAVE] = "keyfile.save",
+    [METRIC_OMEMO_ENCRYPT] = "omemo.encrypt",
+    [METRIC_OMEMO_DECRYPT] = "omemo.decrypt",
+    [METRIC_PLUGIN_HOOK] = "plugins.hook",
+};
+
+// Recorded from the main thread and from transfer and plugin workers, so
+// all updates are relaxed atomics.
+static Metric metrics[METRIC_COUNT];
+
+// counts at the start of the rate window, only touched on the main thread
+static guint64 window_counts[METRIC_COUNT];
+static gint64 window_start = 0;
+static guint64 last_counts[METRIC_COUNT];
+static gint64 last_start = 0;
+
+static gint64 dump_interval_us = 0;
+static gint64 last_dump = 0;
+
+guint64
+metrics_histogram_bucket(guint64 value_us)
+{
+    if (value_us < METRICS_SUB) {
+        return value_us;
+    }
+
+    guint64 msb = 63 - __builtin_clzll(value_us);
+    guint64 sub = (value_us >> (msb - METRICS_SUB_BITS)) & (METRICS_SUB - 1);
+    guint64 bucket = (msb - METRICS_SUB_BITS + 1) * METRICS_SUB + sub;
+
+    return MIN(bucket, METRICS_BUCKETS - 1);
+}
+
+// smallest value that falls into the next bucket
+guint64
+metrics_histogram_upper(guint64 bucket)
+{
+    bucket++;
+    if (bucket < METRICS_SUB) {
+        return bucket;
+    }
+
+    guint64 msb = bucket / METRICS_SUB + METRICS_SUB_BITS - 1;
+    guint64 sub = bucket % METRICS_SUB;
+
+    return (METRICS_SUB + sub) << (msb - METRICS_SUB_BITS);
+}
+
+void
+metrics_init(void)
+{
+    metrics_reset();
+}
+
+void
+metrics_reset(void)
+{
+    for (int i = 0; i < METRIC_COUNT; i++) {
+        __atomic_store_n(&metrics[i].count, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&metrics[i].total_us, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&metrics[i].max_us, 0, __ATOMIC_RELAXED);
+        for (int b = 0; b < METRICS_BUCKETS; b++) {
+            __atomic_store_n(&metrics[i].buckets[b], 0, __ATOMIC_RELAXED);
+        }
+        window_counts[i] = 0;
+        last_counts[i] = 0;
+    }
+    window_start = g_get_monotonic_time();
+    last_start = window_start;
+}
+
+void
+metrics_record(metric_t metric, gint64 start)
+{
+    metrics_record_detail(metric, start, NULL);
+}
+
+void
+metrics_record_detail(metric_t metric, gint64 start, const char* const detail)
+{
+    metrics_record_span(metric, start, g_get_monotonic_time(), detail);
+}
+
+void
+metrics_record_span(metric_t metric, gint64 start, gint64 end, const char* const detail)
+{
+    gint64 elapsed = end - start;
+    guint64 value = elapsed > 0 ? elapsed : 0;
+    Metric* m = &metrics[metric];
+
+    __atomic_fetch_add(&m->count, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&m->total_us, value, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&m->buckets[metrics_histogram_bucket(value)], 1, __ATOMIC_RELAXED);
+
+    guint64 max = __atomic_load_n(&m->max_us, __ATOMIC_RELAXED);
+    while (value > max && !__atomic_compare_exchange_n(&m->max_us, &max, value, TRUE, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+
+    if (trace_enabled()) {
+        trace_complete(metric_names[metric], detail, start, end);
+    }
+}
+
+static guint64
+_metrics_percentile(const guint64* buckets, guint64 count, double percentile)
+{
+    guint64 rank = (guint64)(count * percentile);
+    if (rank >= count) {
+        rank = count - 1;
+    }
+
+    guint64 seen = 0;
+    for (int b = 0; b < METRICS_BUCKETS; b++) {
+        seen += buckets[b];
+        if (seen > rank) {
+            return metrics_histogram_upper(b);
+        }
+    }
+
+    return 0;
+}
+
+void
+metrics_get(metric_t metric, MetricSnapshot* snapshot)
+{
+    Metric* m = &metrics[metric];
+    guint64 buckets[METRICS_BUCKETS];
+    guint64 count = 0;
+
+    // sum the buckets rather than reading count, so percentiles are
+    // consistent with the histogram while events are still recorded
+    for (int b = 0; b < METRICS_BUCKETS; b++) {
+        buckets[b] = __atomic_load_n(&m->buckets[b], __ATOMIC_RELAXED);
+        count += buckets[b];
+    }
+
+    snapshot->name = metric_names[metric];
+    snapshot->count = count;
+    snapshot->total_us = __atomic_load_n(&m->total_us, __ATOMIC_RELAXED);
+    snapshot->max_us = __atomic_load_n(&m->max_us, __ATOMIC_RELAXED);
+
+    if (count == 0) {
+        snapshot->p50_us = snapshot->p90_us = snapshot->p99_us = 0;
+    } else {
+        snapshot->p50_us = MIN(_metrics_percentile(buckets, count, 0.50), snapshot->max_us);
+        snapshot->p90_us = MIN(_metrics_percentile(buckets, count, 0.90), snapshot->max_us);
+        snapshot->p99_us = MIN(_metrics_percentile(buckets, count, 0.99), snapshot->max_us);
+    }
+
+    gint64 elapsed = g_get_monotonic_time() - last_start;
+    guint64 current = __atomic_load_n(&m->count, __ATOMIC_RELAXED);
+    if (elapsed > 0 && current >= last_counts[metric]) {
+        snapshot->rate = (double)(current - last_counts[metric]) * G_USEC_PER_SEC / elapsed;
+    } else {
+        snapshot->rate = 0;
+    }
+}
+
+void
+metrics_set_dump_interval(gint seconds)
+{
+    dump_interval_us = (gint64)seconds * G_USEC_PER_SEC;
+    last_dump = g_get_monotonic_time();
+}
+
+gboolean
+metrics_dump(void)
+{
+    GString* contents = g_string_new(NULL);
+    GDateTime* now = g_date_time_new_now_local();
+    auto_gchar gchar* time = g_date_time_format_iso8601(now);
+    g_date_time_unref(now);
+    g_string_append_printf(contents, "# %s\n", time);
+    g_string_append(contents, "# metric count rate/s total_us max_us p50_us p90_us p99_us\n");
+
+    for (int i = 0; i < METRIC_COUNT; i++) {
+        MetricSnapshot snapshot;
+        metrics_get(i, &snapshot);
+        g_string_append_printf(contents, "%s %" G_GUINT64_FORMAT " %.2f %" G_GUINT64_FORMAT " %" G_GUINT64_FORMAT " %" G_GUINT64_FORMAT " %" G_GUINT64_FORMAT " %" G_GUINT64_FORMAT "\n",
+                               snapshot.name, snapshot.count, snapshot.rate, snapshot.total_us,
+                               snapshot.max_us, snapshot.p50_us, snapshot.p90_us, snapshot.p99_us);
+    }
+
+    auto_gchar gchar* filename = files_get_data_path(FILE_STATS);
+    GError* error = NULL;
+    gboolean res = g_file_set_contents(filename, contents->str, contents->len, &error);
+    if (!res) {
+        log_error("[Metrics] Could not write %s: %s", filename, error->message);
+        g_error_free(error);
+    }
+    g_string_free(contents, TRUE);
+
+    return res;
+}
+
+void
+metrics_tick(void)
+{
+    gint64 now = g_get_monotonic_time();
+
+    if (now - window_start >= METRICS_RATE_WINDOW_US) {
+        for (int i = 0; i < METRIC_COUNT; i++) {
+            last_counts[i] = window_counts[i];
+            window_counts[i] = __atomic_load_n(&metrics[i].count, __ATOMIC_RELAXED);
+        }
+        last_start = window_start;
+        window_start = now;
+    }
+
+    if (dump_interval_us > 0 && now - last_dump >= dump_interval_us) {
+        last_dump = now;
+        metrics_dump();
+    }
+}
@@ -0,0 +1,88 @@
+/*
+ * metrics.h
+ * vim: expandtab:ts=4:sts=4:sw=4
+ *
+ * This file is part of Profanity.
+ *
+ * Profanity is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Profanity is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Profanity.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link the code of portions of this program with the OpenSSL library under
+ * certain conditions as described in each individual source file, and
+ * distribute linked combinations including the two.
+ *
+ * You must obey the GNU General Public License in all respects for all of the
+ * code used other than OpenSSL. If you modify file(s) with this exception, you
+ * may extend this exception to your version of the file(s), but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version. If you delete this exception statement from all
+ * source files in the program, then also delete it here.
+ *
+ */
+
+#ifndef TOOLS_METRICS_H
+#define TOOLS_METRICS_H
+
+#include <glib.h>
+
+// each metric counts events and keeps a histogram of how long they took
+typedef enum {
+    METRIC_MESSAGE_STANZA,
+    METRIC_IQ_STANZA,
+    METRIC_PRESENCE_STANZA,
+    METRIC_DB_ADD,
+    METRIC_UI_UPDATE,
+    METRIC_WIN_REDRAW,
+    METRIC_KEYFILE_SAVE,
+    METRIC_OMEMO_ENCRYPT,
+    METRIC_OMEMO_DECRYPT,
+    METRIC_PLUGIN_HOOK,
+    METRIC_COUNT
+} metric_t;
+
+typedef struct metric_snapshot_t
+{
+    const char* name;
+    guint64 count;
+    // events per second over the last 5 to 10 seconds
+    double rate;
+    guint64 total_us;
+    guint64 max_us;
+    guint64 p50_us;
+    guint64 p90_us;
+    guint64 p99_us;
+} MetricSnapshot;
+
+void metrics_init(void);
+void metrics_reset(void);
+
+#define metrics_start() g_get_monotonic_time()
+void metrics_record(metric_t metric, gint64 start);
+// detail is only used when tracing, see tools/trace.h
+void metrics_record_detail(metric_t metric, gint64 start, const char* const detail);
+// for callers that measured the end themselves
+void metrics_record_span(metric_t metric, gint64 start, gint64 end, const char* const detail);
+
+void metrics_get(metric_t metric, MetricSnapshot* snapshot);
+guint64 metrics_histogram_bucket(guint64 value_us);
+guint64 metrics_histogram_upper(guint64 bucket);
+
+// write a snapshot to FILE_STATS every seconds, 0 to stop
+void metrics_set_dump_interval(gint seconds);
+gboolean metrics_dump(void);
+
+// called from the main loop, rolls the rate window and writes periodic dumps
+void metrics_tick(void);
+
+#endif
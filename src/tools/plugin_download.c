@@ -43,7 +43,6 @@
 #include <sys/types.h>
 #include <curl/curl.h>
 #include <gio/gio.h>
-#include <pthread.h>
 #include <assert.h>
 #include <errno.h>
 
@@ -57,20 +56,16 @@
 #include "ui/window.h"
 #include "common.h"
 
-void*
-plugin_download_install(void* userdata)
+static void
+_plugin_download_done(HTTPDownload* plugin_dl, gboolean success)
 {
-    HTTPDownload* plugin_dl = (HTTPDownload*)userdata;
+    const char* path = plugin_dl->filename;
 
-    /* We need to dup those, because they're free'd inside `http_file_get()` */
-    auto_char char* path = strdup(plugin_dl->filename);
-    auto_char char* https_url = strdup(plugin_dl->url);
-
-    http_file_get(plugin_dl);
-
-    if (is_regular_file(path)) {
+    if (!success) {
+        // the failure was reported by the download itself
+    } else if (is_regular_file(path)) {
         GString* error_message = g_string_new(NULL);
-        auto_char char* plugin_name = basename_from_url(https_url);
+        auto_char char* plugin_name = basename_from_url(plugin_dl->url);
         gboolean result = plugins_install(plugin_name, path, error_message);
         if (result) {
             cons_show("Plugin installed and loaded: %s", plugin_name);
@@ -83,8 +78,13 @@ plugin_download_install(void* userdata)
     }
 
     remove(path);
+}
 
-    return NULL;
+void
+plugin_download_install(HTTPDownload* plugin_dl)
+{
+    plugin_dl->on_complete = _plugin_download_done;
+    http_file_get(plugin_dl);
 }
 
 void
@@ -48,7 +48,7 @@
 
 #include "ui/win_types.h"
 
-void* plugin_download_install(void* userdata);
+void plugin_download_install(HTTPDownload* download);
 
 void plugin_download_add_download(HTTPDownload* download);
 
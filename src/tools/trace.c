@@ -0,0 +1,251 @@
+/*
+ * trace.c
+ * vim: expandtab:ts=4:sts=4:sw=4
+ *
+ * This file is part of Profanity.
+ *
+ * Profanity is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Profanity is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Profanity.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link the code of portions of this program with the OpenSSL library under
+ * certain conditions as described in each individual source file, and
+ * distribute linked combinations including the two.
+ *
+ * You must obey the GNU General Public License in all respects for all of the
+ * code used other than OpenSSL. If you modify file(s) with this exception, you
+ * may extend this exception to your version of the file(s), but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version. If you delete this exception statement from all
+ * source files in the program, then also delete it here.
+ *
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib.h>
+
+#include "log.h"
+#include "tools/trace.h"
+
+// events waiting for the writer, further ones are dropped
+#define TRACE_MAX_PENDING  (1 << 20)
+#define TRACE_FLUSH_PERIOD G_USEC_PER_SEC
+
+// Writes Chrome trace-event JSON (chrome://tracing, ui.perfetto.dev).
+// Spans are recorded as complete ("X") events into an in-memory buffer that
+// a background thread appends to the trace file once a second.
+
+typedef struct trace_event_t
+{
+    const char* name;
+    char* detail;
+    gint64 ts;
+    gint64 dur;
+    guint tid;
+} TraceEvent;
+
+gint trace_active = 0;
+
+static GMutex trace_lock;
+static GCond trace_cond;
+static GArray* pending = NULL;
+static guint dropped = 0;
+static GThread* writer = NULL;
+static FILE* trace_file = NULL;
+static gchar* trace_filename = NULL;
+static gboolean first_event = TRUE;
+
+static guint next_tid = 0;
+static _Thread_local guint thread_tid = 0;
+
+static guint
+_trace_tid(void)
+{
+    if (thread_tid == 0) {
+        thread_tid = g_atomic_int_add(&next_tid, 1) + 1;
+    }
+    return thread_tid;
+}
+
+static void
+_trace_write_string(const char* str)
+{
+    fputc('"', trace_file);
+    for (const char* c = str; *c; c++) {
+        if (*c == '"' || *c == '\\') {
+            fputc('\\', trace_file);
+            fputc(*c, trace_file);
+        } else if ((unsigned char)*c < 0x20) {
+            fprintf(trace_file, "\\u%04x", *c);
+        } else {
+            fputc(*c, trace_file);
+        }
+    }
+    fputc('"', trace_file);
+}
+
+static void
+_trace_write_events(GArray* events)
+{
+    for (guint i = 0; i < events->len; i++) {
+        TraceEvent* event = &g_array_index(events, TraceEvent, i);
+        fputs(first_event ? "\n" : ",\n", trace_file);
+        first_event = FALSE;
+        fputs("{\"name\":", trace_file);
+        _trace_write_string(event->name);
+        fprintf(trace_file, ",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%" G_GINT64_FORMAT ",\"dur\":%" G_GINT64_FORMAT,
+                event->tid, event->ts, event->dur);
+        if (event->detail) {
+            fputs(",\"args\":{\"detail\":", trace_file);
+            _trace_write_string(event->detail);
+            fputc('}', trace_file);
+            free(event->detail);
+        }
+        fputc('}', trace_file);
+    }
+    g_array_set_size(events, 0);
+    fflush(trace_file);
+}
+
+static gpointer
+_trace_writer(gpointer data)
+{
+    GArray* batch = g_array_new(FALSE, FALSE, sizeof(TraceEvent));
+
+    g_mutex_lock(&trace_lock);
+    while (g_atomic_int_get(&trace_active)) {
+        gint64 deadline = g_get_monotonic_time() + TRACE_FLUSH_PERIOD;
+        g_cond_wait_until(&trace_cond, &trace_lock, deadline);
+
+        GArray* tmp = pending;
+        pending = batch;
+        batch = tmp;
+        g_mutex_unlock(&trace_lock);
+
+        _trace_write_events(batch);
+
+        g_mutex_lock(&trace_lock);
+    }
+    g_mutex_unlock(&trace_lock);
+
+    g_array_free(batch, TRUE);
+    return NULL;
+}
+
+gboolean
+trace_start(const char* const filename)
+{
+    if (g_atomic_int_get(&trace_active)) {
+        return FALSE;
+    }
+
+    trace_file = fopen(filename, "w");
+    if (!trace_file) {
+        log_error("[Trace] Could not open %s: %s", filename, g_strerror(errno));
+        return FALSE;
+    }
+
+    trace_filename = g_strdup(filename);
+    first_event = TRUE;
+    dropped = 0;
+    pending = g_array_new(FALSE, FALSE, sizeof(TraceEvent));
+
+    fprintf(trace_file, "[{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"main\"}}", _trace_tid());
+    first_event = FALSE;
+
+    g_atomic_int_set(&trace_active, 1);
+    writer = g_thread_new("trace", _trace_writer, NULL);
+    log_info("[Trace] Recording to %s", filename);
+
+    return TRUE;
+}
+
+void
+trace_stop(void)
+{
+    if (!g_atomic_int_get(&trace_active)) {
+        return;
+    }
+
+    g_mutex_lock(&trace_lock);
+    g_atomic_int_set(&trace_active, 0);
+    g_cond_signal(&trace_cond);
+    g_mutex_unlock(&trace_lock);
+    g_thread_join(writer);
+    writer = NULL;
+
+    g_mutex_lock(&trace_lock);
+    GArray* rest = pending;
+    pending = NULL;
+    g_mutex_unlock(&trace_lock);
+    _trace_write_events(rest);
+    g_array_free(rest, TRUE);
+
+    fputs("\n]\n", trace_file);
+    fclose(trace_file);
+    trace_file = NULL;
+
+    if (dropped > 0) {
+        log_warning("[Trace] Dropped %u events, the writer could not keep up", dropped);
+    }
+    log_info("[Trace] Stopped recording to %s", trace_filename);
+    g_free(trace_filename);
+    trace_filename = NULL;
+}
+
+const char*
+trace_get_filename(void)
+{
+    return trace_filename;
+}
+
+void
+trace_complete(const char* const name, const char* const detail, gint64 start, gint64 end)
+{
+    if (!trace_enabled()) {
+        return;
+    }
+
+    TraceEvent event = {
+        .name = name,
+        .detail = detail ? strdup(detail) : NULL,
+        .ts = start,
+        .dur = end - start,
+        .tid = _trace_tid(),
+    };
+
+    g_mutex_lock(&trace_lock);
+    if (pending && pending->len < TRACE_MAX_PENDING) {
+        g_array_append_val(pending, event);
+    } else {
+        dropped++;
+        free(event.detail);
+    }
+    g_mutex_unlock(&trace_lock);
+}
+
+gint64
+trace_phase(const char* const name, gint64 start)
+{
+    gint64 now = g_get_monotonic_time();
+    if (trace_enabled()) {
+        trace_complete(name, NULL, start, now);
+    }
+    return now;
+}
@@ -0,0 +1,55 @@
+/*
+ * trace.h
+ * vim: expandtab:ts=4:sts=4:sw=4
+ *
+ * This file is part of Profanity.
+ *
+ * Profanity is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Profanity is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Profanity.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link the code of portions of this program with the OpenSSL library under
+ * certain conditions as described in each individual source file, and
+ * distribute linked combinations including the two.
+ *
+ * You must obey the GNU General Public License in all respects for all of the
+ * code used other than OpenSSL. If you modify file(s) with this exception, you
+ * may extend this exception to your version of the file(s), but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version. If you delete this exception statement from all
+ * source files in the program, then also delete it here.
+ *
+ */
+
+#ifndef TOOLS_TRACE_H
+#define TOOLS_TRACE_H
+
+#include <glib.h>
+
+// set while a trace is being recorded, check with trace_enabled()
+extern gint trace_active;
+
+#define trace_enabled() G_UNLIKELY(g_atomic_int_get(&trace_active))
+
+gboolean trace_start(const char* const filename);
+void trace_stop(void);
+const char* trace_get_filename(void);
+
+// Record a span from start to end, monotonic microseconds. name must be a
+// static string, detail is copied and may be NULL.
+void trace_complete(const char* const name, const char* const detail, gint64 start, gint64 end);
+
+// Record a span from start until now if tracing, return now.
+gint64 trace_phase(const char* const name, gint64 start);
+
+#endif
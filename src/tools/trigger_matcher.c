@@ -0,0 +1,260 @@
+/*
+ * trigger_matcher.c
+ * vim: expandtab:ts=4:sts=4:sw=4
+ *
+ * This file is part of Profanity.
+ *
+ * Profanity is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Profanity is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Profanity.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link the code of portions of this program with the OpenSSL library under
+ * certain conditions as described in each individual source file, and
+ * distribute linked combinations including the two.
+ *
+ * You must obey the GNU General Public License in all respects for all of the
+ * code used other than OpenSSL. If you modify file(s) with this exception, you
+ * may extend this exception to your version of the file(s), but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version. If you delete this exception statement from all
+ * source files in the program, then also delete it here.
+ *
+ */
+
+#include "config.h"
+
+#include <glib.h>
+
+#include "tools/trigger_matcher.h"
+
+typedef struct trigger_node_t
+{
+    // case folded character -> child node index, NULL for leaves
+    GHashTable* children;
+    // longest proper suffix that is also a prefix of some pattern
+    guint fail;
+    // nearest node on the fail chain that ends a pattern, 0 if none
+    guint output;
+    // length in characters
+    guint depth;
+    // pattern ending at this node, -1 if none
+    gint pattern;
+} TriggerNode;
+
+struct trigger_matcher_t
+{
+    // node 0 is the root, it is never a child so 0 doubles as "no node"
+    GArray* nodes;
+    guint max_depth;
+};
+
+#define _node(matcher, index) (&g_array_index((matcher)->nodes, TriggerNode, (index)))
+
+static guint
+_child(TriggerMatcher* matcher, guint node, gunichar ch)
+{
+    GHashTable* children = _node(matcher, node)->children;
+    if (!children) {
+        return 0;
+    }
+
+    return GPOINTER_TO_UINT(g_hash_table_lookup(children, GUINT_TO_POINTER(ch)));
+}
+
+static guint
+_add_child(TriggerMatcher* matcher, guint parent, gunichar ch)
+{
+    TriggerNode child = { NULL, 0, 0, _node(matcher, parent)->depth + 1, -1 };
+    g_array_append_val(matcher->nodes, child);
+    guint index = matcher->nodes->len - 1;
+
+    TriggerNode* parent_node = _node(matcher, parent);
+    if (!parent_node->children) {
+        parent_node->children = g_hash_table_new(g_direct_hash, g_direct_equal);
+    }
+    g_hash_table_insert(parent_node->children, GUINT_TO_POINTER(ch), GUINT_TO_POINTER(index));
+
+    return index;
+}
+
+static void
+_build_links(TriggerMatcher* matcher)
+{
+    // breadth first, so the fail target of a node is always complete before the node
+    GQueue queue = G_QUEUE_INIT;
+    g_queue_push_tail(&queue, GUINT_TO_POINTER(0));
+
+    while (!g_queue_is_empty(&queue)) {
+        guint parent = GPOINTER_TO_UINT(g_queue_pop_head(&queue));
+        GHashTable* children = _node(matcher, parent)->children;
+        if (!children) {
+            continue;
+        }
+
+        GHashTableIter iter;
+        gpointer key, value;
+        g_hash_table_iter_init(&iter, children);
+        while (g_hash_table_iter_next(&iter, &key, &value)) {
+            gunichar ch = GPOINTER_TO_UINT(key);
+            guint child = GPOINTER_TO_UINT(value);
+
+            guint fail = 0;
+            if (parent != 0) {
+                fail = _node(matcher, parent)->fail;
+                while (fail != 0 && _child(matcher, fail, ch) == 0) {
+                    fail = _node(matcher, fail)->fail;
+                }
+                fail = _child(matcher, fail, ch);
+            }
+
+            TriggerNode* fail_node = _node(matcher, fail);
+            TriggerNode* child_node = _node(matcher, child);
+            child_node->fail = fail;
+            child_node->output = fail_node->pattern >= 0 ? fail : fail_node->output;
+
+            g_queue_push_tail(&queue, GUINT_TO_POINTER(child));
+        }
+    }
+}
+
+TriggerMatcher*
+trigger_matcher_new(gchar** patterns, gsize count)
+{
+    TriggerMatcher* matcher = g_new0(TriggerMatcher, 1);
+    matcher->nodes = g_array_new(FALSE, FALSE, sizeof(TriggerNode));
+
+    TriggerNode root = { NULL, 0, 0, 0, -1 };
+    g_array_append_val(matcher->nodes, root);
+
+    for (gsize i = 0; i < count; i++) {
+        guint node = 0;
+        for (const gchar* curr = patterns[i]; *curr != '\0'; curr = g_utf8_next_char(curr)) {
+            gunichar ch = g_unichar_tolower(g_utf8_get_char(curr));
+            guint next = _child(matcher, node, ch);
+            node = next ? next : _add_child(matcher, node, ch);
+        }
+
+        // patterns differing only in case share a node, the first one is reported
+        TriggerNode* end = _node(matcher, node);
+        if (node != 0 && end->pattern < 0) {
+            end->pattern = i;
+            matcher->max_depth = MAX(matcher->max_depth, end->depth);
+        }
+    }
+
+    _build_links(matcher);
+
+    return matcher;
+}
+
+void
+trigger_matcher_free(TriggerMatcher* matcher)
+{
+    if (matcher == NULL) {
+        return;
+    }
+
+    for (guint i = 0; i < matcher->nodes->len; i++) {
+        GHashTable* children = _node(matcher, i)->children;
+        if (children) {
+            g_hash_table_destroy(children);
+        }
+    }
+    g_array_free(matcher->nodes, TRUE);
+    g_free(matcher);
+}
+
+void
+trigger_scan_init(TriggerScan* scan, TriggerMatcher* matcher)
+{
+    scan->matcher = matcher;
+    scan->node = 0;
+    scan->pos = 0;
+    // byte offsets of the last max_depth characters, to map a match back
+    // from its length in characters to where it starts in the text
+    scan->starts = matcher && matcher->max_depth > 0 ? g_new(gsize, matcher->max_depth) : NULL;
+}
+
+void
+trigger_scan_feed(TriggerScan* scan, gunichar ch, gsize start, gsize end, GArray* matches)
+{
+    TriggerMatcher* matcher = scan->matcher;
+    if (scan->starts == NULL) {
+        return;
+    }
+
+    scan->starts[scan->pos % matcher->max_depth] = start;
+
+    ch = g_unichar_tolower(ch);
+    guint node = scan->node;
+    while (node != 0 && _child(matcher, node, ch) == 0) {
+        node = _node(matcher, node)->fail;
+    }
+    node = _child(matcher, node, ch);
+
+    guint out = _node(matcher, node)->pattern >= 0 ? node : _node(matcher, node)->output;
+    while (out != 0) {
+        TriggerNode* out_node = _node(matcher, out);
+        TriggerMatch match = {
+            .start = scan->starts[(scan->pos + 1 - out_node->depth) % matcher->max_depth],
+            .end = end,
+            .pattern = out_node->pattern,
+        };
+        g_array_append_val(matches, match);
+        out = out_node->output;
+    }
+
+    scan->node = node;
+    scan->pos++;
+}
+
+void
+trigger_scan_clear(TriggerScan* scan)
+{
+    g_free(scan->starts);
+    scan->starts = NULL;
+}
+
+static gint
+_cmp_leftmost_longest(gconstpointer a, gconstpointer b)
+{
+    const TriggerMatch* first = a;
+    const TriggerMatch* second = b;
+
+    if (first->start != second->start) {
+        return first->start < second->start ? -1 : 1;
+    }
+    if (first->end != second->end) {
+        return first->end > second->end ? -1 : 1;
+    }
+
+    return 0;
+}
+
+void
+trigger_matches_to_spans(GArray* matches)
+{
+    g_array_sort(matches, _cmp_leftmost_longest);
+
+    guint kept = 0;
+    gsize last_end = 0;
+    for (guint i = 0; i < matches->len; i++) {
+        TriggerMatch* match = &g_array_index(matches, TriggerMatch, i);
+        if (kept > 0 && match->start < last_end) {
+            continue;
+        }
+        g_array_index(matches, TriggerMatch, kept++) = *match;
+        last_end = match->end;
+    }
+    g_array_set_size(matches, kept);
+}
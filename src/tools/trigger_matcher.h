@@ -0,0 +1,72 @@
+/*
+ * trigger_matcher.h
+ * vim: expandtab:ts=4:sts=4:sw=4
+ *
+ * This file is part of Profanity.
+ *
+ * Profanity is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Profanity is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Profanity.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link the code of portions of this program with the OpenSSL library under
+ * certain conditions as described in each individual source file, and
+ * distribute linked combinations including the two.
+ *
+ * You must obey the GNU General Public License in all respects for all of the
+ * code used other than OpenSSL. If you modify file(s) with this exception, you
+ * may extend this exception to your version of the file(s), but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version. If you delete this exception statement from all
+ * source files in the program, then also delete it here.
+ *
+ */
+
+#ifndef TOOLS_TRIGGER_MATCHER_H
+#define TOOLS_TRIGGER_MATCHER_H
+
+#include <glib.h>
+
+// Aho-Corasick automaton matching a fixed set of patterns case-insensitively
+typedef struct trigger_matcher_t TriggerMatcher;
+
+// an occurrence of a pattern, offsets are bytes into the searched text
+typedef struct trigger_match_t
+{
+    gsize start;
+    gsize end;
+    guint pattern;
+} TriggerMatch;
+
+// incremental matching for callers that walk the text themselves
+typedef struct trigger_scan_t
+{
+    TriggerMatcher* matcher;
+    guint node;
+    gsize pos;
+    gsize* starts;
+} TriggerScan;
+
+// compile the patterns, empty patterns are ignored
+TriggerMatcher* trigger_matcher_new(gchar** patterns, gsize count);
+void trigger_matcher_free(TriggerMatcher* matcher);
+
+// keep the non overlapping occurrences for highlighting, the leftmost wins
+// and the longest of those starting at the same offset
+void trigger_matches_to_spans(GArray* matches);
+
+// feed the character at byte offsets start..end, occurrences ending with it are appended to matches
+void trigger_scan_init(TriggerScan* scan, TriggerMatcher* matcher);
+void trigger_scan_feed(TriggerScan* scan, gunichar ch, gsize start, gsize end, GArray* matches);
+void trigger_scan_clear(TriggerScan* scan);
+
+#endif
@@ -51,6 +51,8 @@
 #endif
 
 #include "log.h"
+#include "tools/intern.h"
+#include "tools/memstats.h"
 #include "ui/window.h"
 #include "ui/buffer.h"
 
@@ -82,6 +84,21 @@ buffer_size(ProfBuff buffer)
     return g_slist_length(buffer->entries);
 }
 
+gsize
+buffer_memory(ProfBuff buffer)
+{
+    gsize bytes = sizeof(struct prof_buff_t) + memstats_slist(buffer->entries);
+    for (GSList* curr = buffer->entries; curr; curr = g_slist_next(curr)) {
+        ProfBuffEntry* entry = curr->data;
+        bytes += sizeof(ProfBuffEntry) + memstats_str(entry->show_char) + memstats_str(entry->message) + memstats_str(entry->id);
+        if (entry->receipt) {
+            bytes += sizeof(DeliveryReceipt);
+        }
+    }
+
+    return bytes;
+}
+
 void
 buffer_free(ProfBuff buffer)
 {
@@ -198,8 +215,8 @@ _create_entry(const char* show_char, int pad_indent, GDateTime* time, int flags,
     e->flags = flags;
     e->theme_item = theme_item;
     e->time = g_date_time_ref(time);
-    e->display_from = STRDUP_OR_NULL(display_from);
-    e->from_jid = STRDUP_OR_NULL(from_jid);
+    e->display_from = intern_ref(display_from);
+    e->from_jid = intern_ref(from_jid);
     e->message = STRDUP_OR_NULL(message);
     e->receipt = receipt;
     e->id = STRDUP_OR_NULL(id);
@@ -215,8 +232,8 @@ _free_entry(ProfBuffEntry* entry)
 {
     free(entry->id);
     free(entry->message);
-    free(entry->from_jid);
-    free(entry->display_from);
+    intern_unref(entry->from_jid);
+    intern_unref(entry->display_from);
     g_date_time_unref(entry->time);
     free(entry->show_char);
     free(entry->receipt);
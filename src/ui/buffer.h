@@ -60,8 +60,9 @@ typedef struct prof_buff_entry_t
     theme_item_t theme_item;
     // from as it is displayed
     // might be nick, jid..
-    char* display_from;
-    char* from_jid;
+    // both are interned, see tools/intern.h
+    const char* display_from;
+    const char* from_jid;
     char* message;
     DeliveryReceipt* receipt;
     // message id, in case we have it
@@ -77,6 +78,8 @@ void buffer_prepend(ProfBuff buffer, const char* show_char, int pad_indent, GDat
 void buffer_remove_entry_by_id(ProfBuff buffer, const char* const id);
 void buffer_remove_entry(ProfBuff buffer, int entry);
 int buffer_size(ProfBuff buffer);
+// approximate bytes held by the entries, interned strings are counted by tools/intern
+gsize buffer_memory(ProfBuff buffer);
 ProfBuffEntry* buffer_get_entry(ProfBuff buffer, int entry);
 ProfBuffEntry* buffer_get_entry_by_id(ProfBuff buffer, const char* const id);
 gboolean buffer_mark_received(ProfBuff buffer, const char* const id);
@@ -355,7 +355,7 @@ chatwin_incoming_msg(ProfChatWin* chatwin, ProfMessage* message, gboolean win_cr
                 flash();
             }
 
-            chatwin->unread++;
+            wins_add_unread(window);
         }
 
         // TODO: so far we don't ask for MAM when incoming message occurs.
@@ -61,6 +61,7 @@
 #include "command/cmd_ac.h"
 #include "config/preferences.h"
 #include "config/theme.h"
+#include "tools/metrics.h"
 #include "ui/ui.h"
 #include "ui/titlebar.h"
 #include "ui/statusbar.h"
@@ -146,6 +147,7 @@ ui_sigwinch_handler(int sig)
 void
 ui_update(void)
 {
+    gint64 start = metrics_start();
     ProfWin* current = wins_get_current();
     if (current->layout->paged == 0) {
         win_move_to_end(current);
@@ -165,6 +167,7 @@ ui_update(void)
         perform_resize = FALSE;
         ui_resize();
     }
+    metrics_record(METRIC_UI_UPDATE, start);
 }
 
 unsigned long
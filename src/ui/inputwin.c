@@ -65,6 +65,7 @@
 #include "config/accounts.h"
 #include "config/preferences.h"
 #include "config/theme.h"
+#include "plugins/plugins.h"
 #include "ui/ui.h"
 #include "ui/screen.h"
 #include "ui/statusbar.h"
@@ -173,8 +174,13 @@ create_input_window(void)
 char*
 inp_readline(void)
 {
-    p_rl_timeout.tv_sec = inp_timeout / 1000;
-    p_rl_timeout.tv_usec = inp_timeout % 1000 * 1000;
+    gint timeout = inp_timeout;
+    gint timed_wakeup = plugins_timed_next_wakeup();
+    if (timed_wakeup >= 0 && timed_wakeup < timeout) {
+        timeout = timed_wakeup;
+    }
+    p_rl_timeout.tv_sec = timeout / 1000;
+    p_rl_timeout.tv_usec = timeout % 1000 * 1000;
     FD_ZERO(&fds);
     FD_SET(fileno(rl_instream), &fds);
     errno = 0;
@@ -887,7 +893,7 @@ _inp_rl_win_attention_handler(int count, int key)
 {
     ProfWin* current = wins_get_current();
     if (current) {
-        gboolean attention = win_toggle_attention(current);
+        gboolean attention = wins_toggle_attention(current);
         if (attention) {
             win_println(current, THEME_DEFAULT, "!", "Attention flag has been activated");
         } else {
@@ -45,6 +45,7 @@
 #include "log.h"
 #include "config/preferences.h"
 #include "plugins/plugins.h"
+#include "tools/trigger_matcher.h"
 #include "ui/window.h"
 #include "ui/win_types.h"
 #include "ui/window_list.h"
@@ -369,141 +370,58 @@ mucwin_history(ProfMucWin* mucwin, const ProfMessage* const message)
 
     char* nick = message->from_jid->resourcepart;
     const char* const mynick = muc_nick(mucwin->roomjid);
-    GSList* mentions = get_mentions(prefs_get_boolean(PREF_NOTIFY_MENTION_WHOLE_WORD), prefs_get_boolean(PREF_NOTIFY_MENTION_CASE_SENSITIVE), message->plain, mynick);
-    GList* triggers = prefs_message_get_triggers(message->plain);
+    MessageAnnotations* annotations = message_annotate(message->plain, mynick);
 
-    mucwin_incoming_msg(mucwin, message, mentions, triggers, FALSE);
+    mucwin_incoming_msg(mucwin, message, annotations, FALSE);
 
-    g_slist_free(mentions);
-    g_list_free_full(triggers, free);
+    message_annotations_free(annotations);
 
     plugins_on_room_history_message(mucwin->roomjid, nick, message->plain, message->timestamp);
 }
 
 static void
-_mucwin_print_mention(ProfWin* window, const char* const message, const char* const from, const char* const mynick, GSList* mentions, const char* const ch, int flags)
+_mucwin_print_mention(ProfWin* window, const char* const message, const char* const from, const MessageAnnotations* const annotations, const char* const ch, int flags)
 {
-    int last_pos = 0;
-    int pos;
-    GSList* curr = mentions;
-    glong mynick_len = g_utf8_strlen(mynick, -1);
+    GArray* spans = annotations->mention_spans;
+    gsize last_end = 0;
 
-    while (curr) {
-        pos = GPOINTER_TO_INT(curr->data);
+    for (guint i = 0; i < spans->len; i++) {
+        TriggerMatch* span = &g_array_index(spans, TriggerMatch, i);
 
-        auto_gchar gchar* before_str = g_utf8_substring(message, last_pos, pos);
-
-        if (last_pos == 0 && strncmp(before_str, "/me ", 4) == 0) {
+        if (i == 0 && annotations->is_me && span->start >= 4) {
             win_print_them(window, THEME_ROOMMENTION, ch, flags, "");
             win_append_highlight(window, THEME_ROOMMENTION, "*%s ", from);
-            win_append_highlight(window, THEME_ROOMMENTION, "%s", before_str + 4);
+            win_append_highlight(window, THEME_ROOMMENTION, "%.*s", (int)(span->start - 4), message + 4);
         } else {
             // print time and nick only once at beginning of the line
-            if (last_pos == 0) {
+            if (i == 0) {
                 win_print_them(window, THEME_ROOMMENTION, ch, flags, from);
             }
-            win_append_highlight(window, THEME_ROOMMENTION, "%s", before_str);
+            win_append_highlight(window, THEME_ROOMMENTION, "%.*s", (int)(span->start - last_end), message + last_end);
         }
 
-        auto_gchar gchar* mynick_str = g_utf8_substring(message, pos, pos + mynick_len);
-        win_append_highlight(window, THEME_ROOMMENTION_TERM, "%s", mynick_str);
-
-        last_pos = pos + mynick_len;
+        win_append_highlight(window, THEME_ROOMMENTION_TERM, "%.*s", (int)(span->end - span->start), message + span->start);
 
-        curr = g_slist_next(curr);
+        last_end = span->end;
     }
 
-    glong message_len = g_utf8_strlen(message, -1);
-    if (last_pos < message_len) {
-        // get tail without allocating a new string
-        gchar* rest = g_utf8_offset_to_pointer(message, last_pos);
-        win_appendln_highlight(window, THEME_ROOMMENTION, "%s", rest);
-    } else {
-        win_appendln_highlight(window, THEME_ROOMMENTION, "");
-    }
-}
-
-gint
-_cmp_trigger_weight(gconstpointer a, gconstpointer b)
-{
-    int alen = strlen((char*)a);
-    int blen = strlen((char*)b);
-
-    if (alen > blen)
-        return -1;
-    if (alen < blen)
-        return 1;
-
-    return 0;
+    win_appendln_highlight(window, THEME_ROOMMENTION, "%s", message + last_end);
 }
 
 static void
-_mucwin_print_triggers(ProfWin* window, const char* const message, GList* triggers)
-{
-    GList* weighted_triggers = NULL;
-    GList* curr = triggers;
-    while (curr) {
-        weighted_triggers = g_list_insert_sorted(weighted_triggers, curr->data, (GCompareFunc)_cmp_trigger_weight);
-        curr = g_list_next(curr);
-    }
-
-    auto_gchar gchar* message_lower = g_utf8_strdown(message, -1);
-
-    // find earliest trigger in message
-    int first_trigger_pos = -1;
-    int first_trigger_len = -1;
-    curr = weighted_triggers;
-    while (curr) {
-        auto_gchar gchar* trigger_lower = g_utf8_strdown(curr->data, -1);
-        gchar* trigger_ptr = g_strstr_len(message_lower, -1, trigger_lower);
-
-        // not found, try next
-        if (trigger_ptr == NULL) {
-            curr = g_list_next(curr);
-            continue;
-        }
-
-        // found, replace vars if earlier than previous
-        int trigger_pos = trigger_ptr - message_lower;
-        if (first_trigger_pos == -1 || trigger_pos < first_trigger_pos) {
-            first_trigger_pos = trigger_pos;
-            first_trigger_len = strlen(trigger_lower);
-        }
-
-        curr = g_list_next(curr);
-    }
-
-    g_list_free(weighted_triggers);
-
-    // no triggers found
-    if (first_trigger_pos == -1) {
-        win_appendln_highlight(window, THEME_ROOMTRIGGER, "%s", message);
-    } else {
-        if (first_trigger_pos > 0) {
-            char message_section[strlen(message) + 1];
-            int i = 0;
-            while (i < first_trigger_pos) {
-                message_section[i] = message[i];
-                i++;
-            }
-            message_section[i] = '\0';
-            win_append_highlight(window, THEME_ROOMTRIGGER, "%s", message_section);
-        }
-        char trigger_section[first_trigger_len + 1];
-        int i = 0;
-        while (i < first_trigger_len) {
-            trigger_section[i] = message[first_trigger_pos + i];
-            i++;
-        }
-        trigger_section[i] = '\0';
-
-        if (first_trigger_pos + first_trigger_len < strlen(message)) {
-            win_append_highlight(window, THEME_ROOMTRIGGER_TERM, "%s", trigger_section);
-            _mucwin_print_triggers(window, &message[first_trigger_pos + first_trigger_len], triggers);
-        } else {
-            win_appendln_highlight(window, THEME_ROOMTRIGGER_TERM, "%s", trigger_section);
+_mucwin_print_triggers(ProfWin* window, const char* const message, const MessageAnnotations* const annotations)
+{
+    GArray* spans = annotations->trigger_spans;
+    gsize last_end = 0;
+    for (guint i = 0; i < spans->len; i++) {
+        TriggerMatch* span = &g_array_index(spans, TriggerMatch, i);
+        if (span->start > last_end) {
+            win_append_highlight(window, THEME_ROOMTRIGGER, "%.*s", (int)(span->start - last_end), message + last_end);
         }
+        win_append_highlight(window, THEME_ROOMTRIGGER_TERM, "%.*s", (int)(span->end - span->start), message + span->start);
+        last_end = span->end;
     }
+    win_appendln_highlight(window, THEME_ROOMTRIGGER, "%s", message + last_end);
 }
 
 void
@@ -528,7 +446,7 @@ mucwin_outgoing_msg(ProfMucWin* mucwin, const char* const message, const char* c
 }
 
 void
-mucwin_incoming_msg(ProfMucWin* mucwin, const ProfMessage* const message, GSList* mentions, GList* triggers, gboolean filter_reflection)
+mucwin_incoming_msg(ProfMucWin* mucwin, const ProfMessage* const message, const MessageAnnotations* const annotations, gboolean filter_reflection)
 {
     assert(mucwin != NULL);
     int flags = 0;
@@ -548,19 +466,18 @@ mucwin_incoming_msg(ProfMucWin* mucwin, const ProfMessage* const message, GSList
     }
 
     ProfWin* window = (ProfWin*)mucwin;
-    const char* const mynick = muc_nick(mucwin->roomjid);
 
     auto_char char* ch = get_enc_char(message->enc, mucwin->message_char);
 
     win_insert_last_read_position_marker((ProfWin*)mucwin, mucwin->roomjid);
-    wins_add_urls_ac(window, message, FALSE);
+    wins_add_annotated_urls_ac(window, annotations, FALSE);
     wins_add_quotes_ac(window, message->plain, FALSE);
 
-    if (g_slist_length(mentions) > 0) {
-        _mucwin_print_mention(window, message->plain, message->from_jid->resourcepart, mynick, mentions, ch, flags);
-    } else if (triggers) {
+    if (annotations->mentions) {
+        _mucwin_print_mention(window, message->plain, message->from_jid->resourcepart, annotations, ch, flags);
+    } else if (annotations->triggers) {
         win_print_them(window, THEME_ROOMTRIGGER, ch, flags, message->from_jid->resourcepart);
-        _mucwin_print_triggers(window, message->plain, triggers);
+        _mucwin_print_triggers(window, message->plain, annotations);
     } else {
         win_println_incoming_muc_msg(window, ch, flags, message);
     }
@@ -153,7 +153,7 @@ occupantswin_occupants(const char* const roomjid)
                         _occuptantswin_occupant(layout, roster_curr, mucwin->showjid, false);
                     }
                     roster_curr = g_list_next(roster_curr);
-                    online_occupants = g_list_append(online_occupants, occupant->jid);
+                    online_occupants = g_list_append(online_occupants, (gpointer)occupant->jid);
                 }
 
                 role = g_string_new(prefix->str);
@@ -171,7 +171,7 @@ occupantswin_occupants(const char* const roomjid)
                         _occuptantswin_occupant(layout, roster_curr, mucwin->showjid, false);
                     }
                     roster_curr = g_list_next(roster_curr);
-                    online_occupants = g_list_append(online_occupants, occupant->jid);
+                    online_occupants = g_list_append(online_occupants, (gpointer)occupant->jid);
                 }
 
                 role = g_string_new(prefix->str);
@@ -189,7 +189,7 @@ occupantswin_occupants(const char* const roomjid)
                         _occuptantswin_occupant(layout, roster_curr, mucwin->showjid, false);
                     }
                     roster_curr = g_list_next(roster_curr);
-                    online_occupants = g_list_append(online_occupants, occupant->jid);
+                    online_occupants = g_list_append(online_occupants, (gpointer)occupant->jid);
                 }
 
                 if (mucwin->showoffline) {
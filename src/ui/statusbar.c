@@ -71,6 +71,8 @@ typedef struct _status_bar_t
     char* prompt;
     char* fulljid;
     GHashTable* tabs;
+    // number of tabs with highlight set
+    guint highlighted;
     int current_tab;
 } StatusBar;
 
@@ -107,6 +109,7 @@ status_bar_init(void)
     console->identifier = strdup("console");
     console->display_name = NULL;
     g_hash_table_insert(statusbar->tabs, GINT_TO_POINTER(1), console);
+    statusbar->highlighted = 0;
     statusbar->current_tab = 1;
 
     int row = screen_statusbar_row();
@@ -158,6 +161,7 @@ void
 status_bar_set_all_inactive(void)
 {
     g_hash_table_remove_all(statusbar->tabs);
+    statusbar->highlighted = 0;
 }
 
 void
@@ -180,6 +184,10 @@ status_bar_inactive(const int win)
         true_win = 10;
     }
 
+    StatusBarTab* tab = g_hash_table_lookup(statusbar->tabs, GINT_TO_POINTER(true_win));
+    if (tab && tab->highlight) {
+        statusbar->highlighted--;
+    }
     g_hash_table_remove(statusbar->tabs, GINT_TO_POINTER(true_win));
 
     status_bar_draw();
@@ -219,6 +227,13 @@ _create_tab(const int win, win_type_t wintype, char* identifier, gboolean highli
         }
     }
 
+    StatusBarTab* old_tab = g_hash_table_lookup(statusbar->tabs, GINT_TO_POINTER(true_win));
+    if (old_tab && old_tab->highlight) {
+        statusbar->highlighted--;
+    }
+    if (highlight) {
+        statusbar->highlighted++;
+    }
     g_hash_table_replace(statusbar->tabs, GINT_TO_POINTER(true_win), tab);
 
     status_bar_draw();
@@ -327,14 +342,8 @@ _status_bar_draw_tabs(int pos)
         pos = _status_bar_draw_extended_tabs(pos, FALSE, start, end, is_static);
     } else {
         pos++;
-        guint print_act = 0;
+        guint print_act = statusbar->highlighted;
         guint tabnum = g_hash_table_size(statusbar->tabs);
-        for (guint i = 1; i <= tabnum; ++i) {
-            StatusBarTab* tab = g_hash_table_lookup(statusbar->tabs, GINT_TO_POINTER(i));
-            if (tab && tab->highlight) {
-                print_act++;
-            }
-        }
         if (print_act) {
             pos = _status_bar_draw_bracket(FALSE, pos, "[");
             mvwprintw(statusbar_win, 0, pos, "Act: ");
@@ -367,7 +376,7 @@ _has_new_msgs_beyond_range_on_side(gboolean left_side, int display_tabs_start, i
 {
     gint max_tabs = prefs_get_statusbartabs();
     int tabs_count = g_hash_table_size(statusbar->tabs);
-    if (tabs_count <= max_tabs) {
+    if (tabs_count <= max_tabs || statusbar->highlighted == 0) {
         return FALSE;
     }
 
@@ -43,6 +43,7 @@
 #include "config/account.h"
 #include "config/preferences.h"
 #include "command/cmd_funcs.h"
+#include "tools/annotations.h"
 #include "ui/win_types.h"
 #include "xmpp/message.h"
 #include "xmpp/muc.h"
@@ -163,7 +164,7 @@ void mucwin_occupant_role_and_affiliation_change(ProfMucWin* mucwin, const char*
 void mucwin_roster(ProfMucWin* mucwin, GList* occupants, const char* const presence);
 void mucwin_history(ProfMucWin* mucwin, const ProfMessage* const message);
 void mucwin_outgoing_msg(ProfMucWin* mucwin, const char* const message, const char* const id, prof_enc_t enc_mode, const char* const replace_id);
-void mucwin_incoming_msg(ProfMucWin* mucwin, const ProfMessage* const message, GSList* mentions, GList* triggers, gboolean filter_reflection);
+void mucwin_incoming_msg(ProfMucWin* mucwin, const ProfMessage* const message, const MessageAnnotations* const annotations, gboolean filter_reflection);
 void mucwin_subject(ProfMucWin* mucwin, const char* const nick, const char* const subject);
 void mucwin_requires_config(ProfMucWin* mucwin);
 void mucwin_info(ProfMucWin* mucwin);
@@ -383,6 +384,7 @@ ProfWin* win_create_plugin(const char* const plugin_name, const char* const tag)
 ProfWin* win_create_vcard(vCard* vcard);
 void win_update_virtual(ProfWin* window);
 void win_free(ProfWin* window);
+gsize win_memory(ProfWin* window, guint* entries);
 gboolean win_notify_remind(ProfWin* window);
 int win_unread(ProfWin* window);
 void win_resize(ProfWin* window);
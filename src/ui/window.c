@@ -56,6 +56,7 @@
 #include "log.h"
 #include "config/theme.h"
 #include "config/preferences.h"
+#include "tools/metrics.h"
 #include "ui/ui.h"
 #include "ui/window.h"
 #include "ui/screen.h"
@@ -67,6 +68,13 @@ static const char* LOADING_MESSAGE = "Loading older messages…";
 static const char* CONS_WIN_TITLE = "Profanity. Type /help for help information.";
 static const char* XML_WIN_TITLE = "XML Console";
 
+// a pad keeps a character cell for every position, whether printed or not
+#if NCURSES_WIDECHAR
+#define PAD_CELL_SIZE sizeof(cchar_t)
+#else
+#define PAD_CELL_SIZE sizeof(chtype)
+#endif
+
 #define CEILING(X) (X - (int)(X) > 0 ? (int)(X + 1) : (int)(X))
 
 static void
@@ -558,6 +566,30 @@ win_show_subwin(ProfWin* window)
     win_redraw(window);
 }
 
+static gsize
+_win_pad_memory(WINDOW* pad)
+{
+    if (pad == NULL) {
+        return 0;
+    }
+
+    return (gsize)getmaxy(pad) * getmaxx(pad) * PAD_CELL_SIZE;
+}
+
+// the pads and the scrollback buffer, the rest of a window is small and fixed
+gsize
+win_memory(ProfWin* window, guint* entries)
+{
+    *entries = buffer_size(window->layout->buffer);
+    gsize bytes = _win_pad_memory(window->layout->win) + buffer_memory(window->layout->buffer);
+    if (window->layout->type == LAYOUT_SPLIT) {
+        ProfLayoutSplit* layout = (ProfLayoutSplit*)window->layout;
+        bytes += _win_pad_memory(layout->subwin);
+    }
+
+    return bytes;
+}
+
 void
 win_free(ProfWin* window)
 {
@@ -1655,7 +1687,8 @@ win_update_entry_message(ProfWin* window, const char* const id, const char* cons
     if (window->type == WIN_CONSOLE)
         return;
     ProfBuffEntry* entry = buffer_get_entry_by_id(window->layout->buffer, id);
-    if (entry) {
+    // redrawing the whole window is expensive, skip when nothing changed
+    if (entry && g_strcmp0(entry->message, message) != 0) {
         free(entry->message);
         entry->message = strdup(message);
         win_redraw(window);
@@ -1970,6 +2003,7 @@ win_print_trackbar(ProfWin* window)
 void
 win_redraw(ProfWin* window)
 {
+    gint64 start = metrics_start();
     int size = buffer_size(window->layout->buffer);
     werase(window->layout->win);
 
@@ -1986,6 +2020,7 @@ win_redraw(ProfWin* window)
         }
         e->y_end_pos = getcury(window->layout->win);
     }
+    metrics_record(METRIC_WIN_REDRAW, start);
 }
 
 void
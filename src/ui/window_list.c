@@ -51,26 +51,56 @@
 #include "xmpp/xmpp.h"
 #include "xmpp/roster_list.h"
 #include "tools/http_upload.h"
+#include "tools/memstats.h"
 
 #ifdef HAVE_OMEMO
 #include "omemo/omemo.h"
 #endif
 
 static GHashTable* windows;
+// barejid, roomjid, fulljid or tag -> window, one table per window type,
+// keyed independently of window numbers so swapping and tidying keep them valid
+static GHashTable* chat_index;
+static GHashTable* muc_index;
+static GHashTable* conf_index;
+static GHashTable* private_index;
+static GHashTable* plugin_index;
+// window -> number, the inverse of windows
+static GHashTable* nums;
+// running unread total and the sets of windows with unread messages or
+// attention flags, kept up to date as messages arrive and windows are read
+static int total_unread;
+static GHashTable* unread_wins;
+static GHashTable* attention_wins;
 static int current;
 static Autocomplete wins_ac;
 static Autocomplete wins_close_ac;
 
 static int _wins_cmp_num(gconstpointer a, gconstpointer b);
 static int _wins_get_next_available_num(GList* used);
+static void _wins_index_add(ProfWin* window);
+static void _wins_index_remove(ProfWin* window);
+static void _wins_put(int num, ProfWin* window);
+static int* _wins_unread_counter(ProfWin* window);
+static GList* _wins_sorted_nums(GHashTable* set);
+static void _wins_memstats(MemStats* stats);
 
 void
 wins_init(void)
 {
     windows = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, (GDestroyNotify)win_free);
+    chat_index = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+    muc_index = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+    conf_index = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+    private_index = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+    plugin_index = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+    nums = g_hash_table_new(g_direct_hash, g_direct_equal);
+    unread_wins = g_hash_table_new(g_direct_hash, g_direct_equal);
+    attention_wins = g_hash_table_new(g_direct_hash, g_direct_equal);
+    total_unread = 0;
 
     ProfWin* console = win_create_console();
-    g_hash_table_insert(windows, GINT_TO_POINTER(1), console);
+    _wins_put(1, console);
 
     current = 1;
 
@@ -80,6 +110,8 @@ wins_init(void)
     wins_close_ac = autocomplete_new();
     autocomplete_add(wins_close_ac, "all");
     autocomplete_add(wins_close_ac, "read");
+
+    memstats_register("windows", _wins_memstats);
 }
 
 ProfWin*
@@ -98,23 +130,11 @@ wins_chat_exists(const char* const barejid)
 ProfChatWin*
 wins_get_chat(const char* const barejid)
 {
-    GList* values = g_hash_table_get_values(windows);
-    GList* curr = values;
-
-    while (curr) {
-        ProfWin* window = curr->data;
-        if (window->type == WIN_CHAT) {
-            ProfChatWin* chatwin = (ProfChatWin*)window;
-            if (g_strcmp0(chatwin->barejid, barejid) == 0) {
-                g_list_free(values);
-                return chatwin;
-            }
-        }
-        curr = g_list_next(curr);
+    if (barejid == NULL) {
+        return NULL;
     }
 
-    g_list_free(values);
-    return NULL;
+    return g_hash_table_lookup(chat_index, barejid);
 }
 
 static gint
@@ -149,89 +169,41 @@ wins_get_chat_unsubscribed(void)
 ProfConfWin*
 wins_get_conf(const char* const roomjid)
 {
-    GList* values = g_hash_table_get_values(windows);
-    GList* curr = values;
-
-    while (curr) {
-        ProfWin* window = curr->data;
-        if (window->type == WIN_CONFIG) {
-            ProfConfWin* confwin = (ProfConfWin*)window;
-            if (g_strcmp0(confwin->roomjid, roomjid) == 0) {
-                g_list_free(values);
-                return confwin;
-            }
-        }
-        curr = g_list_next(curr);
+    if (roomjid == NULL) {
+        return NULL;
     }
 
-    g_list_free(values);
-    return NULL;
+    return g_hash_table_lookup(conf_index, roomjid);
 }
 
 ProfMucWin*
 wins_get_muc(const char* const roomjid)
 {
-    GList* values = g_hash_table_get_values(windows);
-    GList* curr = values;
-
-    while (curr) {
-        ProfWin* window = curr->data;
-        if (window->type == WIN_MUC) {
-            ProfMucWin* mucwin = (ProfMucWin*)window;
-            if (g_strcmp0(mucwin->roomjid, roomjid) == 0) {
-                g_list_free(values);
-                return mucwin;
-            }
-        }
-        curr = g_list_next(curr);
+    if (roomjid == NULL) {
+        return NULL;
     }
 
-    g_list_free(values);
-    return NULL;
+    return g_hash_table_lookup(muc_index, roomjid);
 }
 
 ProfPrivateWin*
 wins_get_private(const char* const fulljid)
 {
-    GList* values = g_hash_table_get_values(windows);
-    GList* curr = values;
-
-    while (curr) {
-        ProfWin* window = curr->data;
-        if (window->type == WIN_PRIVATE) {
-            ProfPrivateWin* privatewin = (ProfPrivateWin*)window;
-            if (g_strcmp0(privatewin->fulljid, fulljid) == 0) {
-                g_list_free(values);
-                return privatewin;
-            }
-        }
-        curr = g_list_next(curr);
+    if (fulljid == NULL) {
+        return NULL;
     }
 
-    g_list_free(values);
-    return NULL;
+    return g_hash_table_lookup(private_index, fulljid);
 }
 
 ProfPluginWin*
 wins_get_plugin(const char* const tag)
 {
-    GList* values = g_hash_table_get_values(windows);
-    GList* curr = values;
-
-    while (curr) {
-        ProfWin* window = curr->data;
-        if (window->type == WIN_PLUGIN) {
-            ProfPluginWin* pluginwin = (ProfPluginWin*)window;
-            if (g_strcmp0(pluginwin->tag, tag) == 0) {
-                g_list_free(values);
-                return pluginwin;
-            }
-        }
-        curr = g_list_next(curr);
+    if (tag == NULL) {
+        return NULL;
     }
 
-    g_list_free(values);
-    return NULL;
+    return g_hash_table_lookup(plugin_index, tag);
 }
 
 void
@@ -280,10 +252,12 @@ wins_private_nick_change(const char* const roomjid, const char* const oldnick, c
 
     ProfPrivateWin* privwin = wins_get_private(oldjid->fulljid);
     if (privwin) {
+        _wins_index_remove((ProfWin*)privwin);
         free(privwin->fulljid);
 
         auto_jid Jid* newjid = jid_create_from_bare_and_resource(roomjid, newnick);
         privwin->fulljid = strdup(newjid->fulljid);
+        _wins_index_add((ProfWin*)privwin);
         win_println((ProfWin*)privwin, THEME_THEM, "!", "** %s is now known as %s.", oldjid->resourcepart, newjid->resourcepart);
 
         autocomplete_remove(wins_ac, oldjid->fulljid);
@@ -344,18 +318,17 @@ wins_set_current_by_num(int i)
         if (window->type == WIN_CHAT) {
             ProfChatWin* chatwin = (ProfChatWin*)window;
             assert(chatwin->memcheck == PROFCHATWIN_MEMCHECK);
-            chatwin->unread = 0;
+            wins_clear_unread(window);
             plugins_on_chat_win_focus(chatwin->barejid);
         } else if (window->type == WIN_MUC) {
             ProfMucWin* mucwin = (ProfMucWin*)window;
             assert(mucwin->memcheck == PROFMUCWIN_MEMCHECK);
-            mucwin->unread = 0;
+            wins_clear_unread(window);
             mucwin->unread_mentions = FALSE;
             mucwin->unread_triggers = FALSE;
             plugins_on_room_win_focus(mucwin->roomjid);
         } else if (window->type == WIN_PRIVATE) {
-            ProfPrivateWin* privatewin = (ProfPrivateWin*)window;
-            privatewin->unread = 0;
+            wins_clear_unread(window);
         }
 
         // if we switched to console
@@ -490,20 +463,11 @@ wins_get_previous(void)
 int
 wins_get_num(ProfWin* window)
 {
-    GList* keys = g_hash_table_get_keys(windows);
-    GList* curr = keys;
-
-    while (curr) {
-        gconstpointer num_p = curr->data;
-        ProfWin* curr_win = g_hash_table_lookup(windows, num_p);
-        if (curr_win == window) {
-            g_list_free(keys);
-            return GPOINTER_TO_INT(num_p);
-        }
-        curr = g_list_next(curr);
+    gpointer num_p;
+    if (window && g_hash_table_lookup_extended(nums, window, NULL, &num_p)) {
+        return GPOINTER_TO_INT(num_p);
     }
 
-    g_list_free(keys);
     return -1;
 }
 
@@ -593,6 +557,11 @@ wins_close_by_num(int i)
             default:
                 break;
             }
+
+            _wins_index_remove(window);
+            wins_clear_unread(window);
+            g_hash_table_remove(attention_wins, window);
+            g_hash_table_remove(nums, window);
         }
 
         g_hash_table_remove(windows, GINT_TO_POINTER(i));
@@ -619,7 +588,7 @@ wins_new_xmlconsole(void)
     int result = _wins_get_next_available_num(keys);
     g_list_free(keys);
     ProfWin* newwin = win_create_xmlconsole();
-    g_hash_table_insert(windows, GINT_TO_POINTER(result), newwin);
+    _wins_put(result, newwin);
     autocomplete_add(wins_ac, "xmlconsole");
     autocomplete_add(wins_close_ac, "xmlconsole");
     return newwin;
@@ -632,7 +601,8 @@ wins_new_chat(const char* const barejid)
     int result = _wins_get_next_available_num(keys);
     g_list_free(keys);
     ProfWin* newwin = win_create_chat(barejid);
-    g_hash_table_insert(windows, GINT_TO_POINTER(result), newwin);
+    _wins_put(result, newwin);
+    _wins_index_add(newwin);
 
     autocomplete_add(wins_ac, barejid);
     autocomplete_add(wins_close_ac, barejid);
@@ -657,7 +627,8 @@ wins_new_muc(const char* const roomjid)
     int result = _wins_get_next_available_num(keys);
     g_list_free(keys);
     ProfWin* newwin = win_create_muc(roomjid);
-    g_hash_table_insert(windows, GINT_TO_POINTER(result), newwin);
+    _wins_put(result, newwin);
+    _wins_index_add(newwin);
     autocomplete_add(wins_ac, roomjid);
     autocomplete_add(wins_close_ac, roomjid);
     newwin->urls_ac = autocomplete_new();
@@ -673,7 +644,8 @@ wins_new_config(const char* const roomjid, DataForm* form, ProfConfWinCallback s
     int result = _wins_get_next_available_num(keys);
     g_list_free(keys);
     ProfWin* newwin = win_create_config(roomjid, form, submit, cancel, userdata);
-    g_hash_table_insert(windows, GINT_TO_POINTER(result), newwin);
+    _wins_put(result, newwin);
+    _wins_index_add(newwin);
 
     return newwin;
 }
@@ -685,7 +657,8 @@ wins_new_private(const char* const fulljid)
     int result = _wins_get_next_available_num(keys);
     g_list_free(keys);
     ProfWin* newwin = win_create_private(fulljid);
-    g_hash_table_insert(windows, GINT_TO_POINTER(result), newwin);
+    _wins_put(result, newwin);
+    _wins_index_add(newwin);
     autocomplete_add(wins_ac, fulljid);
     autocomplete_add(wins_close_ac, fulljid);
     newwin->urls_ac = autocomplete_new();
@@ -701,7 +674,8 @@ wins_new_plugin(const char* const plugin_name, const char* const tag)
     int result = _wins_get_next_available_num(keys);
     g_list_free(keys);
     ProfWin* newwin = win_create_plugin(plugin_name, tag);
-    g_hash_table_insert(windows, GINT_TO_POINTER(result), newwin);
+    _wins_put(result, newwin);
+    _wins_index_add(newwin);
     autocomplete_add(wins_ac, tag);
     autocomplete_add(wins_close_ac, tag);
     return newwin;
@@ -714,7 +688,7 @@ wins_new_vcard(vCard* vcard)
     int result = _wins_get_next_available_num(keys);
     g_list_free(keys);
     ProfWin* newwin = win_create_vcard(vcard);
-    g_hash_table_insert(windows, GINT_TO_POINTER(result), newwin);
+    _wins_put(result, newwin);
 
     return newwin;
 }
@@ -740,17 +714,46 @@ wins_do_notify_remind(void)
 int
 wins_get_total_unread(void)
 {
-    int result = 0;
-    GList* values = g_hash_table_get_values(windows);
-    GList* curr = values;
+    return total_unread;
+}
 
-    while (curr) {
-        ProfWin* window = curr->data;
-        result += win_unread(window);
-        curr = g_list_next(curr);
+void
+wins_add_unread(ProfWin* window)
+{
+    int* unread = _wins_unread_counter(window);
+    if (unread == NULL) {
+        return;
     }
-    g_list_free(values);
-    return result;
+
+    (*unread)++;
+    total_unread++;
+    g_hash_table_add(unread_wins, window);
+}
+
+void
+wins_clear_unread(ProfWin* window)
+{
+    int* unread = _wins_unread_counter(window);
+    if (unread == NULL) {
+        return;
+    }
+
+    total_unread -= *unread;
+    *unread = 0;
+    g_hash_table_remove(unread_wins, window);
+}
+
+gboolean
+wins_toggle_attention(ProfWin* window)
+{
+    gboolean attention = win_toggle_attention(window);
+    if (attention) {
+        g_hash_table_add(attention_wins, window);
+    } else {
+        g_hash_table_remove(attention_wins, window);
+    }
+
+    return attention;
 }
 
 void
@@ -943,7 +946,7 @@ wins_swap(int source_win, int target_win)
         // target window empty
         if (target == NULL) {
             g_hash_table_steal(windows, GINT_TO_POINTER(source_win));
-            g_hash_table_insert(windows, GINT_TO_POINTER(target_win), source);
+            _wins_put(target_win, source);
             status_bar_inactive(source_win);
             auto_char char* identifier = win_get_tab_identifier(source);
             if (win_unread(source) > 0) {
@@ -960,8 +963,8 @@ wins_swap(int source_win, int target_win)
         } else {
             g_hash_table_steal(windows, GINT_TO_POINTER(source_win));
             g_hash_table_steal(windows, GINT_TO_POINTER(target_win));
-            g_hash_table_insert(windows, GINT_TO_POINTER(source_win), target);
-            g_hash_table_insert(windows, GINT_TO_POINTER(target_win), source);
+            _wins_put(source_win, target);
+            _wins_put(target_win, source);
             auto_char char* source_identifier = win_get_tab_identifier(source);
             auto_char char* target_identifier = win_get_tab_identifier(target);
             if (win_unread(source) > 0) {
@@ -1052,6 +1055,135 @@ _wins_get_next_available_num(GList* used)
     }
 }
 
+static GHashTable*
+_wins_index_for(ProfWin* window, const char** key)
+{
+    switch (window->type) {
+    case WIN_CHAT:
+        *key = ((ProfChatWin*)window)->barejid;
+        return chat_index;
+    case WIN_MUC:
+        *key = ((ProfMucWin*)window)->roomjid;
+        return muc_index;
+    case WIN_CONFIG:
+        *key = ((ProfConfWin*)window)->roomjid;
+        return conf_index;
+    case WIN_PRIVATE:
+        *key = ((ProfPrivateWin*)window)->fulljid;
+        return private_index;
+    case WIN_PLUGIN:
+        *key = ((ProfPluginWin*)window)->tag;
+        return plugin_index;
+    default:
+        *key = NULL;
+        return NULL;
+    }
+}
+
+static void
+_wins_index_add(ProfWin* window)
+{
+    const char* key = NULL;
+    GHashTable* index = _wins_index_for(window, &key);
+    if (index && key && !g_hash_table_contains(index, key)) {
+        g_hash_table_insert(index, g_strdup(key), window);
+    }
+}
+
+static void
+_wins_index_remove(ProfWin* window)
+{
+    const char* key = NULL;
+    GHashTable* index = _wins_index_for(window, &key);
+    if (index == NULL || key == NULL || g_hash_table_lookup(index, key) != window) {
+        return;
+    }
+
+    g_hash_table_remove(index, key);
+
+    // another window may share the key, e.g. two config forms for one room
+    GHashTableIter iter;
+    gpointer value;
+    g_hash_table_iter_init(&iter, windows);
+    while (g_hash_table_iter_next(&iter, NULL, &value)) {
+        ProfWin* other = value;
+        const char* other_key = NULL;
+        if (other != window && other->type == window->type && _wins_index_for(other, &other_key) && g_strcmp0(other_key, key) == 0) {
+            g_hash_table_insert(index, g_strdup(key), other);
+            break;
+        }
+    }
+}
+
+static void
+_wins_put(int num, ProfWin* window)
+{
+    g_hash_table_insert(windows, GINT_TO_POINTER(num), window);
+    g_hash_table_insert(nums, window, GINT_TO_POINTER(num));
+}
+
+static int*
+_wins_unread_counter(ProfWin* window)
+{
+    switch (window->type) {
+    case WIN_CHAT:
+        return &((ProfChatWin*)window)->unread;
+    case WIN_MUC:
+        return &((ProfMucWin*)window)->unread;
+    case WIN_PRIVATE:
+        return &((ProfPrivateWin*)window)->unread;
+    default:
+        return NULL;
+    }
+}
+
+// numbers of the windows in set, in window order
+static GList*
+_wins_sorted_nums(GHashTable* set)
+{
+    GList* result = NULL;
+
+    GHashTableIter iter;
+    gpointer window;
+    g_hash_table_iter_init(&iter, set);
+    while (g_hash_table_iter_next(&iter, &window, NULL)) {
+        result = g_list_prepend(result, GINT_TO_POINTER(wins_get_num(window)));
+    }
+
+    return g_list_sort(result, _wins_cmp_num);
+}
+
+// one entry per window, named by its number and what it shows
+static void
+_wins_memstats(MemStats* stats)
+{
+    GHashTableIter iter;
+    gpointer key;
+    gpointer value;
+    g_hash_table_iter_init(&iter, windows);
+    while (g_hash_table_iter_next(&iter, &key, &value)) {
+        ProfWin* window = value;
+        guint entries = 0;
+        gsize bytes = win_memory(window, &entries);
+        auto_char char* identifier = win_get_tab_identifier(window);
+        auto_gchar gchar* name = g_strdup_printf("win %d %s", GPOINTER_TO_INT(key), identifier ? identifier : "");
+        memstats_add(stats, name, bytes, entries);
+    }
+
+    gsize index_bytes = memstats_hash_table(windows) + memstats_hash_table(nums)
+                        + memstats_hash_table(unread_wins) + memstats_hash_table(attention_wins);
+    GHashTable* indexes[] = { chat_index, muc_index, conf_index, private_index, plugin_index };
+    for (size_t i = 0; i < ARRAY_SIZE(indexes); i++) {
+        index_bytes += memstats_hash_table(indexes[i]);
+        g_hash_table_iter_init(&iter, indexes[i]);
+        while (g_hash_table_iter_next(&iter, &key, NULL)) {
+            index_bytes += memstats_str(key);
+        }
+    }
+    index_bytes += autocomplete_memory(wins_ac) + autocomplete_memory(wins_close_ac);
+    memstats_add(stats, "windows.index", index_bytes, g_hash_table_size(windows));
+}
+
 gboolean
 wins_tidy(void)
 {
@@ -1085,6 +1217,7 @@ wins_tidy(void)
             g_hash_table_steal(windows, curr->data);
             if (num == 10) {
                 g_hash_table_insert(new_windows, GINT_TO_POINTER(0), window);
+                g_hash_table_insert(nums, window, GINT_TO_POINTER(0));
                 if (win_unread(window) > 0) {
                     status_bar_new(0, window->type, identifier);
                 } else {
@@ -1092,6 +1225,7 @@ wins_tidy(void)
                 }
             } else {
                 g_hash_table_insert(new_windows, GINT_TO_POINTER(num), window);
+                g_hash_table_insert(nums, window, GINT_TO_POINTER(num));
                 if (win_unread(window) > 0) {
                     status_bar_new(num, window->type, identifier);
                 } else {
@@ -1124,26 +1258,15 @@ wins_create_summary(gboolean unread)
 
     GSList* result = NULL;
 
-    GList* keys = g_hash_table_get_keys(windows);
-    keys = g_list_sort(keys, _wins_cmp_num);
+    GList* keys = unread ? _wins_sorted_nums(unread_wins) : g_list_sort(g_hash_table_get_keys(windows), _wins_cmp_num);
     GList* curr = keys;
 
     while (curr) {
         ProfWin* window = g_hash_table_lookup(windows, curr->data);
-        if (!unread || (unread && win_unread(window) > 0)) {
-            GString* line = g_string_new("");
-
+        auto_gchar gchar* winstring = win_to_string(window);
+        if (winstring) {
             int ui_index = GPOINTER_TO_INT(curr->data);
-            auto_gchar gchar* winstring = win_to_string(window);
-            if (!winstring) {
-                g_string_free(line, TRUE);
-                continue;
-            }
-
-            g_string_append_printf(line, "%d: %s", ui_index, winstring);
-
-            result = g_slist_append(result, strdup(line->str));
-            g_string_free(line, TRUE);
+            result = g_slist_append(result, g_strdup_printf("%d: %s", ui_index, winstring));
         }
 
         curr = g_list_next(curr);
@@ -1159,36 +1282,15 @@ wins_create_summary_attention()
 {
     GSList* result = NULL;
 
-    GList* keys = g_hash_table_get_keys(windows);
-    keys = g_list_sort(keys, _wins_cmp_num);
+    GList* keys = _wins_sorted_nums(attention_wins);
     GList* curr = keys;
 
     while (curr) {
         ProfWin* window = g_hash_table_lookup(windows, curr->data);
-        gboolean has_attention = FALSE;
-        if (window->type == WIN_CHAT) {
-            ProfChatWin* chatwin = (ProfChatWin*)window;
-            assert(chatwin->memcheck == PROFCHATWIN_MEMCHECK);
-            has_attention = chatwin->has_attention;
-        } else if (window->type == WIN_MUC) {
-            ProfMucWin* mucwin = (ProfMucWin*)window;
-            assert(mucwin->memcheck == PROFMUCWIN_MEMCHECK);
-            has_attention = mucwin->has_attention;
-        }
-        if (has_attention) {
-            GString* line = g_string_new("");
-
+        auto_gchar gchar* winstring = win_to_string(window);
+        if (winstring) {
             int ui_index = GPOINTER_TO_INT(curr->data);
-            auto_gchar gchar* winstring = win_to_string(window);
-            if (!winstring) {
-                g_string_free(line, TRUE);
-                continue;
-            }
-
-            g_string_append_printf(line, "%d: %s", ui_index, winstring);
-
-            result = g_slist_append(result, strdup(line->str));
-            g_string_free(line, TRUE);
+            result = g_slist_append(result, g_strdup_printf("%d: %s", ui_index, winstring));
         }
         curr = g_list_next(curr);
     }
@@ -1225,8 +1327,26 @@ win_close_reset_search_attempts(void)
 void
 wins_destroy(void)
 {
+    memstats_unregister("windows");
     g_hash_table_destroy(windows);
     windows = NULL;
+    g_hash_table_destroy(chat_index);
+    chat_index = NULL;
+    g_hash_table_destroy(muc_index);
+    muc_index = NULL;
+    g_hash_table_destroy(conf_index);
+    conf_index = NULL;
+    g_hash_table_destroy(private_index);
+    private_index = NULL;
+    g_hash_table_destroy(plugin_index);
+    plugin_index = NULL;
+    g_hash_table_destroy(nums);
+    nums = NULL;
+    g_hash_table_destroy(unread_wins);
+    unread_wins = NULL;
+    g_hash_table_destroy(attention_wins);
+    attention_wins = NULL;
+    total_unread = 0;
     autocomplete_free(wins_ac);
     wins_ac = NULL;
     autocomplete_free(wins_close_ac);
@@ -1236,89 +1356,72 @@ wins_destroy(void)
 ProfWin*
 wins_get_next_unread(void)
 {
-    // get and sort win nums
-    GList* values = g_hash_table_get_keys(windows);
-    values = g_list_sort(values, _wins_cmp_num);
-    GList* curr = values;
-
-    while (curr) {
-        int curr_win_num = GPOINTER_TO_INT(curr->data);
-        ProfWin* window = wins_get_by_num(curr_win_num);
-
-        // test if window has unread messages
-        if (win_unread(window) > 0) {
-            g_list_free(values);
-            return window;
+    ProfWin* result = NULL;
+    int result_num = 0;
+
+    GHashTableIter iter;
+    gpointer window;
+    g_hash_table_iter_init(&iter, unread_wins);
+    while (g_hash_table_iter_next(&iter, &window, NULL)) {
+        int num = wins_get_num(window);
+        if (result == NULL || _wins_cmp_num(GINT_TO_POINTER(num), GINT_TO_POINTER(result_num)) < 0) {
+            result = window;
+            result_num = num;
         }
-
-        curr = g_list_next(curr);
     }
 
-    g_list_free(values);
-    return NULL;
+    return result;
 }
 
 ProfWin*
 wins_get_next_attention(void)
 {
-    // get and sort win nums
-    GList* values = g_hash_table_get_values(windows);
-    values = g_list_sort(values, _wins_cmp_num);
-    GList* curr = values;
-
     ProfWin* current_window = wins_get_by_num(current);
-
-    // search the current window
-    while (curr) {
-        ProfWin* window = curr->data;
-        if (current_window == window) {
-            current_window = window;
-            curr = g_list_next(curr);
-            break;
-        }
-        curr = g_list_next(curr);
+    if (current_window == NULL) {
+        return NULL;
     }
 
-    // Start from current window
-    while (current_window && curr) {
-        ProfWin* window = curr->data;
-        if (win_has_attention(window)) {
-            g_list_free(values);
-            return window;
-        }
-        curr = g_list_next(curr);
-    }
-    // Start from begin
-    curr = values;
-    while (current_window && curr) {
-        ProfWin* window = curr->data;
-        if (current_window == window) {
-            // we are at current again
-            break;
+    // the first window after the current one, wrapping around to the start
+    ProfWin* after = NULL;
+    int after_num = 0;
+    ProfWin* before = NULL;
+    int before_num = 0;
+
+    GHashTableIter iter;
+    gpointer window;
+    g_hash_table_iter_init(&iter, attention_wins);
+    while (g_hash_table_iter_next(&iter, &window, NULL)) {
+        if (window == current_window) {
+            continue;
         }
-        if (win_has_attention(window)) {
-            g_list_free(values);
-            return window;
+        gpointer num_p = GINT_TO_POINTER(wins_get_num(window));
+        if (_wins_cmp_num(num_p, GINT_TO_POINTER(current)) > 0) {
+            if (after == NULL || _wins_cmp_num(num_p, GINT_TO_POINTER(after_num)) < 0) {
+                after = window;
+                after_num = GPOINTER_TO_INT(num_p);
+            }
+        } else if (before == NULL || _wins_cmp_num(num_p, GINT_TO_POINTER(before_num)) < 0) {
+            before = window;
+            before_num = GPOINTER_TO_INT(num_p);
         }
-        curr = g_list_next(curr);
     }
 
-    g_list_free(values);
-    return NULL;
+    return after ? after : before;
 }
 
 void
 wins_add_urls_ac(const ProfWin* const win, const ProfMessage* const message, const gboolean flip)
 {
-    GRegex* regex;
-    GMatchInfo* match_info;
-
-    // https://stackoverflow.com/questions/43588699/regex-for-matching-any-url-character
-    regex = g_regex_new("(https?|aesgcm)://[\\w\\-.~:/?#\\[\\]@!$&'()*+,;=%]+", 0, 0, NULL);
-    g_regex_match(regex, message->plain, 0, &match_info);
+    MessageAnnotations* annotations = message_annotate(message->plain, NULL);
+    wins_add_annotated_urls_ac(win, annotations, flip);
+    message_annotations_free(annotations);
+}
 
-    while (g_match_info_matches(match_info)) {
-        auto_gchar gchar* word = g_match_info_fetch(match_info, 0);
+void
+wins_add_annotated_urls_ac(const ProfWin* const win, const MessageAnnotations* const annotations, const gboolean flip)
+{
+    for (guint i = 0; i < annotations->urls->len; i++) {
+        const gchar* word = g_ptr_array_index(annotations->urls, i);
 
         if (flip) {
             autocomplete_add_unsorted(win->urls_ac, word, FALSE);
@@ -1327,12 +1430,7 @@ wins_add_urls_ac(const ProfWin* const win, const ProfMessage* const message, con
         }
         // for people who run profanity a long time, we don't want to waste a lot of memory
         autocomplete_remove_older_than_max_reverse(win->urls_ac, 20);
-
-        g_match_info_next(match_info, NULL);
     }
-
-    g_match_info_free(match_info);
-    g_regex_unref(regex);
 }
 
 void
@@ -83,6 +83,9 @@ void wins_close_by_num(int i);
 gboolean wins_is_current(ProfWin* window);
 gboolean wins_do_notify_remind(void);
 int wins_get_total_unread(void);
+void wins_add_unread(ProfWin* window);
+void wins_clear_unread(ProfWin* window);
+gboolean wins_toggle_attention(ProfWin* window);
 void wins_resize_all(void);
 GSList* wins_get_chat_recipients(void);
 GSList* wins_get_prune_wins(void);
@@ -103,6 +106,7 @@ char* win_close_autocomplete(const char* const search_str, gboolean previous, vo
 void win_close_reset_search_attempts(void);
 
 void wins_add_urls_ac(const ProfWin* const win, const ProfMessage* const message, const gboolean flip);
+void wins_add_annotated_urls_ac(const ProfWin* const win, const MessageAnnotations* const annotations, const gboolean flip);
 char* wins_get_url(const char* const search_str, gboolean previous, void* context);
 void wins_add_quotes_ac(const ProfWin* const win, const char* const message, const gboolean flip);
 char* wins_get_quote(const char* const search_str, gboolean previous, void* context);
@@ -49,6 +49,7 @@
 #include "plugins/plugins.h"
 #include "config/files.h"
 #include "config/preferences.h"
+#include "tools/memstats.h"
 #include "xmpp/xmpp.h"
 #include "xmpp/stanza.h"
 #include "xmpp/form.h"
@@ -61,6 +62,15 @@ static GKeyFile* cache;
 static GHashTable* jid_to_ver;
 static GHashTable* jid_to_caps;
 
+// parsed cache entries by ver, avoids rebuilding from the keyfile on each lookup
+static GHashTable* ver_to_caps;
+
+typedef struct caps_cache_entry_t
+{
+    EntityCapabilities* caps;
+    GHashTable* features;
+} CapsCacheEntry;
+
 static GHashTable* prof_features;
 static gchar* my_sha1;
 
@@ -68,15 +78,23 @@ static void _save_cache(void);
 static EntityCapabilities* _caps_by_ver(const char* const ver);
 static EntityCapabilities* _caps_by_jid(const char* const jid);
 static EntityCapabilities* _caps_copy(EntityCapabilities* caps);
+static CapsCacheEntry* _caps_entry_by_ver(const char* const ver);
+static CapsCacheEntry* _caps_entry_new(EntityCapabilities* caps);
+static void _caps_entry_destroy(CapsCacheEntry* entry);
+static void _caps_memstats(MemStats* stats);
 
 static void
 _caps_close(void)
 {
+    memstats_unregister("caps");
     caps_reset_ver();
     free_keyfile(&caps_prof_keyfile);
     cache = NULL;
     g_hash_table_destroy(jid_to_ver);
     g_hash_table_destroy(jid_to_caps);
+    g_hash_table_destroy(ver_to_caps);
+    ver_to_caps = NULL;
+    caps_pending_close();
     g_free(cache_loc);
     cache_loc = NULL;
     g_hash_table_destroy(prof_features);
@@ -95,6 +113,8 @@ caps_init(void)
 
     jid_to_ver = g_hash_table_new_full(g_str_hash, g_str_equal, free, free);
     jid_to_caps = g_hash_table_new_full(g_str_hash, g_str_equal, free, (GDestroyNotify)caps_destroy);
+    ver_to_caps = g_hash_table_new_full(g_str_hash, g_str_equal, free, (GDestroyNotify)_caps_entry_destroy);
+    caps_pending_init();
 
     prof_features = g_hash_table_new_full(g_str_hash, g_str_equal, free, NULL);
     g_hash_table_add(prof_features, strdup(STANZA_NS_CAPS));
@@ -120,6 +140,8 @@ caps_init(void)
     }
 
     my_sha1 = NULL;
+
+    memstats_register("caps", _caps_memstats);
 }
 
 void
@@ -275,6 +297,8 @@ caps_add_by_ver(const char* const ver, EntityCapabilities* caps)
         g_key_file_set_string_list(cache, ver, "features", features_list, num);
     }
 
+    g_hash_table_replace(ver_to_caps, strdup(ver), _caps_entry_new(_caps_copy(caps)));
+
     _save_cache();
 }
 
@@ -293,7 +317,7 @@ caps_map_jid_to_ver(const char* const jid, const char* const ver)
 gboolean
 caps_cache_contains(const char* const ver)
 {
-    return (g_key_file_has_group(cache, ver));
+    return (g_hash_table_contains(ver_to_caps, ver) || g_key_file_has_group(cache, ver));
 }
 
 EntityCapabilities*
@@ -321,18 +345,18 @@ caps_lookup(const char* const jid)
 gboolean
 caps_jid_has_feature(const char* const jid, const char* const feature)
 {
-    EntityCapabilities* caps = caps_lookup(jid);
+    char* ver = g_hash_table_lookup(jid_to_ver, jid);
+    if (ver) {
+        CapsCacheEntry* entry = _caps_entry_by_ver(ver);
+        return entry && g_hash_table_contains(entry->features, feature);
+    }
 
+    EntityCapabilities* caps = _caps_by_jid(jid);
     if (caps == NULL) {
         return FALSE;
     }
 
-    GSList* found = g_slist_find_custom(caps->features, feature, (GCompareFunc)g_strcmp0);
-    gboolean result = found != NULL;
-
-    caps_destroy(caps);
-
-    return result;
+    return g_slist_find_custom(caps->features, feature, (GCompareFunc)g_strcmp0) != NULL;
 }
 
 char*
@@ -359,6 +383,22 @@ caps_reset_ver(void)
 static EntityCapabilities*
 _caps_by_ver(const char* const ver)
 {
+    CapsCacheEntry* entry = _caps_entry_by_ver(ver);
+    if (entry == NULL) {
+        return NULL;
+    }
+
+    return _caps_copy(entry->caps);
+}
+
+static CapsCacheEntry*
+_caps_entry_by_ver(const char* const ver)
+{
+    CapsCacheEntry* entry = g_hash_table_lookup(ver_to_caps, ver);
+    if (entry) {
+        return entry;
+    }
+
     if (!g_key_file_has_group(cache, ver)) {
         return NULL;
     }
@@ -381,14 +421,44 @@ _caps_by_ver(const char* const ver)
         }
     }
 
-    EntityCapabilities* result = caps_create(
+    EntityCapabilities* caps = caps_create(
         category, type, name,
         software, software_version, os, os_version,
         features);
 
     g_slist_free(features);
 
-    return result;
+    entry = _caps_entry_new(caps);
+    g_hash_table_insert(ver_to_caps, strdup(ver), entry);
+
+    return entry;
+}
+
+static CapsCacheEntry*
+_caps_entry_new(EntityCapabilities* caps)
+{
+    CapsCacheEntry* entry = malloc(sizeof(CapsCacheEntry));
+    entry->caps = caps;
+
+    // feature strings are shared by many vers, intern them once
+    entry->features = g_hash_table_new(g_str_hash, g_str_equal);
+    GSList* curr = caps->features;
+    while (curr) {
+        g_hash_table_add(entry->features, (gpointer)g_intern_string(curr->data));
+        curr = g_slist_next(curr);
+    }
+
+    return entry;
+}
+
+static void
+_caps_entry_destroy(CapsCacheEntry* entry)
+{
+    if (entry) {
+        caps_destroy(entry->caps);
+        g_hash_table_destroy(entry->features);
+        free(entry);
+    }
 }
 
 static EntityCapabilities*
@@ -452,8 +522,61 @@ caps_destroy(EntityCapabilities* caps)
     }
 }
 
+static gsize
+_caps_memory(EntityCapabilities* caps)
+{
+    gsize bytes = sizeof(EntityCapabilities) + memstats_slist(caps->features);
+    for (GSList* curr = caps->features; curr; curr = g_slist_next(curr)) {
+        bytes += memstats_str(curr->data);
+    }
+    if (caps->identity) {
+        bytes += sizeof(DiscoIdentity) + memstats_str(caps->identity->category)
+                 + memstats_str(caps->identity->type) + memstats_str(caps->identity->name);
+    }
+    if (caps->software_version) {
+        bytes += sizeof(SoftwareVersion) + memstats_str(caps->software_version->software)
+                 + memstats_str(caps->software_version->software_version)
+                 + memstats_str(caps->software_version->os) + memstats_str(caps->software_version->os_version);
+    }
+
+    return bytes;
+}
+
+// parsed entries by ver, and the caps and vers known for each JID. The
+// keyfile itself is not counted.
+static void
+_caps_memstats(MemStats* stats)
+{
+    GHashTableIter iter;
+    gpointer key;
+    gpointer value;
+
+    gsize bytes = memstats_hash_table(ver_to_caps);
+    g_hash_table_iter_init(&iter, ver_to_caps);
+    while (g_hash_table_iter_next(&iter, &key, &value)) {
+        CapsCacheEntry* entry = value;
+        bytes += memstats_str(key) + sizeof(CapsCacheEntry) + _caps_memory(entry->caps) + memstats_hash_table(entry->features);
+    }
+    memstats_add(stats, "caps.cache", bytes, g_hash_table_size(ver_to_caps));
+
+    bytes = memstats_hash_table(jid_to_ver) + memstats_hash_table(jid_to_caps);
+    g_hash_table_iter_init(&iter, jid_to_ver);
+    while (g_hash_table_iter_next(&iter, &key, &value)) {
+        bytes += memstats_str(key) + memstats_str(value);
+    }
+    g_hash_table_iter_init(&iter, jid_to_caps);
+    while (g_hash_table_iter_next(&iter, &key, &value)) {
+        bytes += memstats_str(key) + _caps_memory(value);
+    }
+    memstats_add(stats, "caps.jids", bytes, g_hash_table_size(jid_to_ver) + g_hash_table_size(jid_to_caps));
+
+    guint waiting = 0;
+    bytes = caps_pending_memory(&waiting);
+    memstats_add(stats, "caps.pending", bytes, waiting);
+}
+
 static void
 _save_cache(void)
 {
-    save_keyfile(&caps_prof_keyfile);
+    save_keyfile_deferred(&caps_prof_keyfile);
 }
@@ -41,6 +41,7 @@
 #include <strophe.h>
 
 #include "xmpp/xmpp.h"
+#include "xmpp/caps_pending.h"
 
 void caps_init(void);
 
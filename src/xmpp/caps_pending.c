@@ -0,0 +1,165 @@
+/*
+ * caps_pending.c
+ * vim: expandtab:ts=4:sts=4:sw=4
+ *
+ * This file is part of Profanity.
+ *
+ * Profanity is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Profanity is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Profanity.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link the code of portions of this program with the OpenSSL library under
+ * certain conditions as described in each individual source file, and
+ * distribute linked combinations including the two.
+ *
+ * You must obey the GNU General Public License in all respects for all of the
+ * code used other than OpenSSL. If you modify file(s) with this exception, you
+ * may extend this exception to your version of the file(s), but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version. If you delete this exception statement from all
+ * source files in the program, then also delete it here.
+ *
+ */
+
+#include "config.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib.h>
+
+#include "log.h"
+#include "tools/memstats.h"
+#include "xmpp/capabilities.h"
+#include "xmpp/caps_pending.h"
+
+typedef struct caps_pending_t
+{
+    gint64 sent;
+    GHashTable* jids;
+} CapsPending;
+
+static GHashTable* ver_to_pending;
+
+static void
+_caps_pending_destroy(CapsPending* pending)
+{
+    if (pending) {
+        g_hash_table_destroy(pending->jids);
+        free(pending);
+    }
+}
+
+void
+caps_pending_init(void)
+{
+    caps_pending_close();
+    ver_to_pending = g_hash_table_new_full(g_str_hash, g_str_equal, free, (GDestroyNotify)_caps_pending_destroy);
+}
+
+void
+caps_pending_close(void)
+{
+    if (ver_to_pending) {
+        g_hash_table_destroy(ver_to_pending);
+        ver_to_pending = NULL;
+    }
+}
+
+gboolean
+caps_pending_add(const char* const ver, const char* const jid)
+{
+    return caps_pending_add_at(ver, jid, g_get_monotonic_time());
+}
+
+gboolean
+caps_pending_add_at(const char* const ver, const char* const jid, gint64 now)
+{
+    CapsPending* pending = g_hash_table_lookup(ver_to_pending, ver);
+
+    if (pending && (now - pending->sent) < CAPS_PENDING_TIMEOUT * G_USEC_PER_SEC) {
+        g_hash_table_add(pending->jids, strdup(jid));
+        log_debug("Capabilities request for %s already in flight, %s waiting.", ver, jid);
+        return TRUE;
+    }
+
+    if (pending) {
+        log_debug("Capabilities request for %s timed out, resending.", ver);
+        pending->sent = now;
+    } else {
+        pending = malloc(sizeof(CapsPending));
+        pending->sent = now;
+        pending->jids = g_hash_table_new_full(g_str_hash, g_str_equal, free, NULL);
+        g_hash_table_insert(ver_to_pending, strdup(ver), pending);
+    }
+    g_hash_table_add(pending->jids, strdup(jid));
+
+    return FALSE;
+}
+
+void
+caps_pending_resolve(const char* const ver)
+{
+    CapsPending* pending = g_hash_table_lookup(ver_to_pending, ver);
+    if (pending == NULL) {
+        return;
+    }
+
+    if (caps_cache_contains(ver)) {
+        log_debug("Capabilities %s resolved for %d waiting JIDs.", ver, g_hash_table_size(pending->jids));
+        GHashTableIter iter;
+        gpointer jid;
+        g_hash_table_iter_init(&iter, pending->jids);
+        while (g_hash_table_iter_next(&iter, &jid, NULL)) {
+            caps_map_jid_to_ver(jid, ver);
+        }
+    }
+
+    g_hash_table_remove(ver_to_pending, ver);
+}
+
+void
+caps_pending_clear(void)
+{
+    if (ver_to_pending) {
+        g_hash_table_remove_all(ver_to_pending);
+    }
+}
+
+gsize
+caps_pending_memory(guint* waiting)
+{
+    *waiting = 0;
+    if (ver_to_pending == NULL) {
+        return 0;
+    }
+
+    gsize bytes = memstats_hash_table(ver_to_pending);
+    GHashTableIter iter;
+    gpointer key;
+    gpointer value;
+    g_hash_table_iter_init(&iter, ver_to_pending);
+    while (g_hash_table_iter_next(&iter, &key, &value)) {
+        CapsPending* pending = value;
+        bytes += memstats_str(key) + sizeof(CapsPending) + memstats_hash_table(pending->jids);
+        GHashTableIter jids;
+        gpointer jid;
+        g_hash_table_iter_init(&jids, pending->jids);
+        while (g_hash_table_iter_next(&jids, &jid, NULL)) {
+            bytes += memstats_str(jid);
+            (*waiting)++;
+        }
+    }
+
+    return bytes;
+}
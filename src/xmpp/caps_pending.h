@@ -0,0 +1,60 @@
+/*
+ * caps_pending.h
+ * vim: expandtab:ts=4:sts=4:sw=4
+ *
+ * This file is part of Profanity.
+ *
+ * Profanity is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Profanity is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Profanity.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * In addition, as a special exception, the copyright holders give permission to
+ * link the code of portions of this program with the OpenSSL library under
+ * certain conditions as described in each individual source file, and
+ * distribute linked combinations including the two.
+ *
+ * You must obey the GNU General Public License in all respects for all of the
+ * code used other than OpenSSL. If you modify file(s) with this exception, you
+ * may extend this exception to your version of the file(s), but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version. If you delete this exception statement from all
+ * source files in the program, then also delete it here.
+ *
+ */
+
+#ifndef XMPP_CAPS_PENDING_H
+#define XMPP_CAPS_PENDING_H
+
+#include <glib.h>
+
+// disco#info requests in flight by ver, with the JIDs waiting on the result
+
+// seconds after which an unanswered request no longer blocks a new one
+#define CAPS_PENDING_TIMEOUT 30
+
+void caps_pending_init(void);
+void caps_pending_close(void);
+
+// Adds jid to the JIDs waiting for ver. Returns TRUE when a request for ver
+// is already in flight, FALSE when the caller has to send one.
+gboolean caps_pending_add(const char* const ver, const char* const jid);
+// as caps_pending_add(), now is monotonic time in microseconds
+gboolean caps_pending_add_at(const char* const ver, const char* const jid, gint64 now);
+
+// maps the waiting JIDs to ver if it is cached now, and forgets the request
+void caps_pending_resolve(const char* const ver);
+void caps_pending_clear(void);
+
+// approximate bytes held, see tools/memstats.h
+gsize caps_pending_memory(guint* waiting);
+
+#endif
@@ -43,14 +43,17 @@
 
 #include "common.h"
 #include "tools/autocomplete.h"
+#include "tools/intern.h"
+#include "tools/memstats.h"
 #include "xmpp/resource.h"
 #include "xmpp/contact.h"
 
 struct p_contact_t
 {
-    char* barejid;
+    // barejid and name are interned, see tools/intern.h
+    const char* barejid;
     gchar* barejid_collate_key;
-    char* name;
+    const char* name;
     gchar* name_collate_key;
     GSList* groups;
     char* subscription;
@@ -67,11 +70,11 @@ p_contact_new(const char* const barejid, const char* const name,
               const char* const offline_message, gboolean pending_out)
 {
     PContact contact = malloc(sizeof(struct p_contact_t));
-    contact->barejid = strdup(barejid);
+    contact->barejid = intern_ref(barejid);
     contact->barejid_collate_key = g_utf8_collate_key(contact->barejid, -1);
 
     if (name) {
-        contact->name = strdup(name);
+        contact->name = intern_ref(name);
         contact->name_collate_key = g_utf8_collate_key(contact->name, -1);
     } else {
         contact->name = NULL;
@@ -101,13 +104,43 @@ p_contact_new(const char* const barejid, const char* const name,
     return contact;
 }
 
+// interned barejid and name are counted by tools/intern
+gsize
+p_contact_memory(PContact contact)
+{
+    gsize bytes = sizeof(struct p_contact_t)
+                  + memstats_str(contact->barejid_collate_key)
+                  + memstats_str(contact->name_collate_key)
+                  + memstats_str(contact->subscription)
+                  + memstats_str(contact->offline_message)
+                  + memstats_slist(contact->groups)
+                  + memstats_hash_table(contact->available_resources)
+                  + autocomplete_memory(contact->resource_ac);
+
+    for (GSList* curr = contact->groups; curr; curr = g_slist_next(curr)) {
+        bytes += memstats_str(curr->data);
+    }
+
+    GHashTableIter iter;
+    gpointer key;
+    gpointer value;
+    g_hash_table_iter_init(&iter, contact->available_resources);
+    while (g_hash_table_iter_next(&iter, &key, &value)) {
+        Resource* resource = value;
+        bytes += memstats_str(key) + sizeof(Resource) + memstats_str(resource->name) + memstats_str(resource->status);
+    }
+
+    return bytes;
+}
+
 void
 p_contact_set_name(const PContact contact, const char* const name)
 {
-    FREE_SET_NULL(contact->name);
+    intern_unref(contact->name);
+    contact->name = NULL;
     FREE_SET_NULL(contact->name_collate_key);
     if (name) {
-        contact->name = strdup(name);
+        contact->name = intern_ref(name);
         contact->name_collate_key = g_utf8_collate_key(contact->name, -1);
     }
 }
@@ -156,9 +189,9 @@ void
 p_contact_free(PContact contact)
 {
     if (contact) {
-        free(contact->barejid);
+        intern_unref(contact->barejid);
         free(contact->barejid_collate_key);
-        free(contact->name);
+        intern_unref(contact->name);
         free(contact->name_collate_key);
         free(contact->subscription);
         free(contact->offline_message);
@@ -46,6 +46,7 @@ PContact p_contact_new(const char* const barejid, const char* const name, GSList
 void p_contact_add_resource(PContact contact, Resource* resource);
 gboolean p_contact_remove_resource(PContact contact, const char* const resource);
 void p_contact_free(PContact contact);
+gsize p_contact_memory(PContact contact);
 const char* p_contact_barejid(PContact contact);
 const char* p_contact_barejid_collate_key(PContact contact);
 const char* p_contact_name(PContact contact);
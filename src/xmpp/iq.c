@@ -48,6 +48,8 @@
 #include "event/server_events.h"
 #include "plugins/plugins.h"
 #include "tools/http_upload.h"
+#include "tools/memstats.h"
+#include "tools/metrics.h"
 #include "ui/ui.h"
 #include "ui/window_list.h"
 #include "xmpp/xmpp.h"
@@ -117,6 +119,7 @@ typedef struct late_delivery_userdata
 } LateDeliveryUserdata;
 
 static int _iq_handler(xmpp_conn_t* const conn, xmpp_stanza_t* const stanza, void* const userdata);
+static int _handle_iq_stanza(xmpp_stanza_t* const stanza);
 
 static void _error_handler(xmpp_stanza_t* const stanza);
 static void _disco_info_get_handler(xmpp_stanza_t* const stanza);
@@ -158,6 +161,7 @@ static void _iq_free_room_data(ProfRoomInfoData* roominfo);
 static void _iq_free_affiliation_set(ProfPrivilegeSet* affiliation_set);
 static void _iq_free_affiliation_list(ProfAffiliationList* affiliation_list);
 static void _iq_id_handler_free(ProfIqHandler* handler);
+static void _iq_memstats(MemStats* stats);
 
 // scheduled
 static int _autoping_timed_send(xmpp_conn_t* const conn, void* const userdata);
@@ -174,6 +178,16 @@ static gboolean received_disco_items = FALSE;
 
 static int
 _iq_handler(xmpp_conn_t* const conn, xmpp_stanza_t* const stanza, void* const userdata)
+{
+    gint64 start = metrics_start();
+    int res = _handle_iq_stanza(stanza);
+    metrics_record(METRIC_IQ_STANZA, start);
+
+    return res;
+}
+
+static int
+_handle_iq_stanza(xmpp_stanza_t* const stanza)
 {
     log_debug("iq stanza handler fired");
     autoping_timer_extend();
@@ -265,6 +279,8 @@ iq_handlers_init(void)
 
     id_handlers = g_hash_table_new_full(g_str_hash, g_str_equal, free, (GDestroyNotify)_iq_id_handler_free);
     rooms_cache = g_hash_table_new_full(g_str_hash, g_str_equal, free, (GDestroyNotify)xmpp_stanza_release);
+
+    memstats_register("iq", _iq_memstats);
 }
 
 struct iq_win_finder
@@ -332,6 +348,7 @@ iq_handlers_remove_win(ProfWin* window)
 void
 iq_handlers_clear(void)
 {
+    memstats_unregister("iq");
     iq_rooms_cache_clear();
     if (id_handlers) {
         g_hash_table_destroy(id_handlers);
@@ -355,6 +372,41 @@ _iq_id_handler_free(ProfIqHandler* handler)
     free(handler);
 }
 
+// handler userdata is opaque, only the handlers themselves are counted.
+// Cached room lists are counted as their serialised size.
+static void
+_iq_memstats(MemStats* stats)
+{
+    GHashTableIter iter;
+    gpointer key;
+    gpointer value;
+
+    gsize bytes = memstats_hash_table(id_handlers);
+    g_hash_table_iter_init(&iter, id_handlers);
+    while (g_hash_table_iter_next(&iter, &key, NULL)) {
+        bytes += memstats_str(key) + sizeof(ProfIqHandler);
+    }
+    bytes += memstats_slist(late_delivery_windows);
+    memstats_add(stats, "iq.id_handlers", bytes, g_hash_table_size(id_handlers));
+
+    if (rooms_cache == NULL) {
+        return;
+    }
+
+    bytes = memstats_hash_table(rooms_cache);
+    g_hash_table_iter_init(&iter, rooms_cache);
+    while (g_hash_table_iter_next(&iter, &key, &value)) {
+        char* text;
+        size_t text_size;
+        if (xmpp_stanza_to_text(value, &text, &text_size) == XMPP_EOK) {
+            bytes += text_size;
+            xmpp_free(connection_get_ctx(), text);
+        }
+        bytes += memstats_str(key);
+    }
+    memstats_add(stats, "iq.rooms_cache", bytes, g_hash_table_size(rooms_cache));
+}
+
 void
 iq_id_handler_add(const char* const id, ProfIqCallback func, ProfIqFreeCallback free_func, void* userdata)
 {
@@ -603,7 +655,7 @@ iq_send_caps_request(const char* const to, const char* const id,
     xmpp_stanza_t* iq = stanza_create_disco_info_iq(ctx, id, to, node_str->str);
     g_string_free(node_str, TRUE);
 
-    iq_id_handler_add(id, _caps_response_id_handler, NULL, NULL);
+    iq_id_handler_add(id, _caps_response_id_handler, free, strdup(ver));
 
     iq_send_stanza(iq);
     xmpp_stanza_release(iq);
@@ -899,6 +951,7 @@ _caps_response_id_handler(xmpp_stanza_t* const stanza, void* const userdata)
 {
     const char* id = xmpp_stanza_get_id(stanza);
     xmpp_stanza_t* query = xmpp_stanza_get_child_by_name(stanza, STANZA_NAME_QUERY);
+    char* expected_ver = (char*)userdata;
 
     const char* type = xmpp_stanza_get_type(stanza);
     // ignore non result
@@ -915,6 +968,7 @@ _caps_response_id_handler(xmpp_stanza_t* const stanza, void* const userdata)
     const char* from = xmpp_stanza_get_from(stanza);
     if (!from) {
         log_info("_caps_response_id_handler(): No from attribute");
+        caps_pending_resolve(expected_ver);
         return 0;
     }
 
@@ -922,17 +976,20 @@ _caps_response_id_handler(xmpp_stanza_t* const stanza, void* const userdata)
     if (g_strcmp0(type, STANZA_TYPE_ERROR) == 0) {
         auto_char char* error_message = stanza_get_error_message(stanza);
         log_warning("Error received for capabilities response from %s: ", from, error_message);
+        caps_pending_resolve(expected_ver);
         return 0;
     }
 
     if (query == NULL) {
         log_info("_caps_response_id_handler(): No query element found.");
+        caps_pending_resolve(expected_ver);
         return 0;
     }
 
     const char* node = xmpp_stanza_get_attribute(query, STANZA_ATTR_NODE);
     if (node == NULL) {
         log_info("_caps_response_id_handler(): No node attribute found");
+        caps_pending_resolve(expected_ver);
         return 0;
     }
 
@@ -961,6 +1018,9 @@ _caps_response_id_handler(xmpp_stanza_t* const stanza, void* const userdata)
         caps_map_jid_to_ver(from, given_sha1);
     }
 
+    // fan the result out to every JID that advertised the same ver meanwhile
+    caps_pending_resolve(expected_ver);
+
     return 0;
 }
 
@@ -2495,8 +2555,8 @@ _http_upload_response_id_handler(xmpp_stanza_t* const stanza, void* const userda
                 }
             }
 
-            pthread_create(&(upload->worker), NULL, &http_file_put, upload);
             http_upload_add_upload(upload);
+            http_file_put(upload);
         } else {
             log_error("Invalid XML in HTTP Upload slot");
             return 1;
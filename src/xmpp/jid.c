@@ -41,10 +41,33 @@
 #include <glib.h>
 
 #include "common.h"
+#include "tools/memstats.h"
 #include "xmpp/jid.h"
 
-Jid*
-jid_create(const gchar* const str)
+#define JID_CACHE_SIZE 512
+
+// recently parsed JIDs keyed by the string they were parsed from, with the
+// most recently used at the head of jid_lru. The cache holds one reference
+// on each Jid, so everything jid_create() returns is shared and must not
+// be modified.
+static GHashTable* jid_cache;
+static GQueue jid_lru = G_QUEUE_INIT;
+
+static void
+_jid_cache_memstats(MemStats* stats)
+{
+    gsize bytes = memstats_hash_table(jid_cache) + jid_lru.length * sizeof(GList);
+    for (GList* curr = jid_lru.head; curr; curr = g_list_next(curr)) {
+        Jid* jid = curr->data;
+        bytes += sizeof(struct jid_t) + memstats_str(jid->str) + memstats_str(jid->localpart)
+                 + memstats_str(jid->domainpart) + memstats_str(jid->resourcepart)
+                 + memstats_str(jid->barejid) + memstats_str(jid->fulljid);
+    }
+    memstats_add(stats, "jid.cache", bytes, jid_lru.length);
+}
+
+static Jid*
+_jid_parse(const gchar* const str)
 {
     Jid* result = NULL;
 
@@ -108,6 +131,60 @@ jid_create(const gchar* const str)
     return result;
 }
 
+Jid*
+jid_create(const gchar* const str)
+{
+    if (str == NULL) {
+        return NULL;
+    }
+
+    if (jid_cache == NULL) {
+        jid_cache = g_hash_table_new(g_str_hash, g_str_equal);
+        memstats_register("jid.cache", _jid_cache_memstats);
+    }
+
+    GList* link = g_hash_table_lookup(jid_cache, str);
+    if (link) {
+        g_queue_unlink(&jid_lru, link);
+        g_queue_push_head_link(&jid_lru, link);
+        Jid* jid = link->data;
+        jid_ref(jid);
+        return jid;
+    }
+
+    Jid* jid = _jid_parse(str);
+    if (jid == NULL) {
+        return NULL;
+    }
+
+    jid_ref(jid);
+    g_queue_push_head(&jid_lru, jid);
+    g_hash_table_insert(jid_cache, jid->str, jid_lru.head);
+
+    if (jid_lru.length > JID_CACHE_SIZE) {
+        Jid* oldest = g_queue_pop_tail(&jid_lru);
+        g_hash_table_remove(jid_cache, oldest->str);
+        jid_destroy(oldest);
+    }
+
+    return jid;
+}
+
+void
+jid_cache_clear(void)
+{
+    memstats_unregister("jid.cache");
+    if (jid_cache) {
+        g_hash_table_destroy(jid_cache);
+        jid_cache = NULL;
+    }
+
+    Jid* jid;
+    while ((jid = g_queue_pop_head(&jid_lru))) {
+        jid_destroy(jid);
+    }
+}
+
 Jid*
 jid_create_from_bare_and_resource(const char* const barejid, const char* const resource)
 {
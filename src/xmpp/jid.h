@@ -51,10 +51,13 @@ struct jid_t
 
 typedef struct jid_t Jid;
 
+// the result is shared with other callers through a cache and must be
+// treated as immutable, release it with jid_destroy()
 Jid* jid_create(const gchar* const str);
 Jid* jid_create_from_bare_and_resource(const char* const barejid, const char* const resource);
 void jid_destroy(Jid* jid);
 void jid_ref(Jid* jid);
+void jid_cache_clear(void);
 
 void jid_auto_destroy(Jid** str);
 #define auto_jid __attribute__((__cleanup__(jid_auto_destroy)))
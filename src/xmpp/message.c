@@ -44,6 +44,7 @@
 #include "profanity.h"
 #include "log.h"
 #include "config/preferences.h"
+#include "tools/metrics.h"
 #include "event/server_events.h"
 #include "pgp/gpg.h"
 #include "pgp/ox.h"
@@ -75,6 +76,7 @@ typedef struct p_message_handle_t
 } ProfMessageHandler;
 
 static int _message_handler(xmpp_conn_t* const conn, xmpp_stanza_t* const stanza, void* const userdata);
+static int _handle_message_stanza(xmpp_stanza_t* const stanza);
 static void _handle_error(xmpp_stanza_t* const stanza);
 static void _handle_groupchat(xmpp_stanza_t* const stanza);
 static void _handle_muc_user(xmpp_stanza_t* const stanza);
@@ -163,6 +165,16 @@ _handle_chat_states(xmpp_stanza_t* const stanza, Jid* const jid)
 
 static int
 _message_handler(xmpp_conn_t* const conn, xmpp_stanza_t* const stanza, void* const userdata)
+{
+    gint64 start = metrics_start();
+    int res = _handle_message_stanza(stanza);
+    metrics_record(METRIC_MESSAGE_STANZA, start);
+
+    return res;
+}
+
+static int
+_handle_message_stanza(xmpp_stanza_t* const stanza)
 {
     log_debug("Message stanza handler fired");
     autoping_timer_extend();
@@ -353,8 +365,17 @@ message_handlers_init(void)
 ProfMessage*
 message_init(void)
 {
-    ProfMessage* message = calloc(1, sizeof(ProfMessage));
+    return message_init_in(NULL);
+}
 
+ProfMessage*
+message_init_in(Arena* arena)
+{
+    // most messages fit their ids and text in one block
+    arena = arena ? arena_ref(arena) : arena_new(1024);
+
+    ProfMessage* message = arena_alloc(arena, sizeof(ProfMessage));
+    message->arena = arena;
     message->enc = PROF_MSG_ENC_NONE;
     message->trusted = true;
     message->type = PROF_MSG_TYPE_UNINITIALIZED;
@@ -362,6 +383,29 @@ message_init(void)
     return message;
 }
 
+char*
+message_strdup(ProfMessage* message, const char* const str)
+{
+    return arena_strdup(message->arena, str);
+}
+
+void
+message_set_plain(ProfMessage* message, char* plain)
+{
+    if (message->plain && !arena_owns(message->arena, message->plain)) {
+        free(message->plain);
+    }
+    message->plain = plain;
+}
+
+static void
+_message_xmpp_free(ProfMessage* message, xmpp_ctx_t* ctx, char* str)
+{
+    if (str && !arena_owns(message->arena, str)) {
+        xmpp_free(ctx, str);
+    }
+}
+
 void
 message_free(ProfMessage* message)
 {
@@ -374,39 +418,21 @@ message_free(ProfMessage* message)
         jid_destroy(message->to_jid);
     }
 
-    if (message->id) {
-        xmpp_free(ctx, message->id);
-    }
-
-    if (message->originid) {
-        xmpp_free(ctx, message->originid);
-    }
-
-    if (message->stanzaid) {
-        xmpp_free(ctx, message->stanzaid);
-    }
-
-    if (message->replace_id) {
-        xmpp_free(ctx, message->replace_id);
-    }
-
-    if (message->body) {
-        xmpp_free(ctx, message->body);
-    }
-
-    if (message->encrypted) {
-        xmpp_free(ctx, message->encrypted);
-    }
-
-    if (message->plain) {
-        free(message->plain);
-    }
+    // fields may still point outside the arena, e.g. text from libstrophe
+    // or a decrypted body
+    _message_xmpp_free(message, ctx, message->id);
+    _message_xmpp_free(message, ctx, message->originid);
+    _message_xmpp_free(message, ctx, message->stanzaid);
+    _message_xmpp_free(message, ctx, message->replace_id);
+    _message_xmpp_free(message, ctx, message->body);
+    _message_xmpp_free(message, ctx, message->encrypted);
+    message_set_plain(message, NULL);
 
     if (message->timestamp) {
         g_date_time_unref(message->timestamp);
     }
 
-    free(message);
+    arena_unref(message->arena);
 }
 
 void
@@ -1086,7 +1112,7 @@ _handle_groupchat(xmpp_stanza_t* const stanza)
 
     const char* id = xmpp_stanza_get_id(stanza);
     if (id) {
-        message->id = strdup(id);
+        message->id = message_strdup(message, id);
     }
 
     char* stanzaid = NULL;
@@ -1094,7 +1120,7 @@ _handle_groupchat(xmpp_stanza_t* const stanza)
     if (stanzaidst) {
         stanzaid = (char*)xmpp_stanza_get_attribute(stanzaidst, STANZA_ATTR_ID);
         if (stanzaid) {
-            message->stanzaid = strdup(stanzaid);
+            message->stanzaid = message_strdup(message, stanzaid);
         }
     }
 
@@ -1102,7 +1128,7 @@ _handle_groupchat(xmpp_stanza_t* const stanza)
     if (origin) {
         char* originid = (char*)xmpp_stanza_get_attribute(origin, STANZA_ATTR_ID);
         if (originid) {
-            message->originid = strdup(originid);
+            message->originid = message_strdup(message, originid);
         }
     }
 
@@ -1120,7 +1146,7 @@ _handle_groupchat(xmpp_stanza_t* const stanza)
         log_info("Message received without body for room: %s", from_jid->str);
         goto out;
     } else if (!message->plain) {
-        message->plain = strdup(message->body);
+        message->plain = message_strdup(message, message->body);
     }
 
     // determine if the notifications happened whilst offline (MUC history)
@@ -1155,7 +1181,7 @@ _handle_groupchat(xmpp_stanza_t* const stanza)
         if (replace_id_stanza) {
             const char* replace_id = xmpp_stanza_get_id(replace_id_stanza);
             if (replace_id) {
-                message->replace_id = strdup(replace_id);
+                message->replace_id = message_strdup(message, replace_id);
             }
         }
         sv_ev_room_message(message);
@@ -1265,7 +1291,7 @@ _handle_muc_private_message(xmpp_stanza_t* const stanza)
     // message stanza id
     const char* id = xmpp_stanza_get_id(stanza);
     if (id) {
-        message->id = strdup(id);
+        message->id = message_strdup(message, id);
     }
 
     // check omemo encryption
@@ -1283,7 +1309,7 @@ _handle_muc_private_message(xmpp_stanza_t* const stanza)
         log_info("Message received without body from: %s", message->from_jid->str);
         goto out;
     } else if (!message->plain) {
-        message->plain = strdup(message->body);
+        message->plain = message_strdup(message, message->body);
     }
 
     if (message->timestamp) {
@@ -1389,13 +1415,13 @@ _handle_chat(xmpp_stanza_t* const stanza, gboolean is_mam, gboolean is_carbon, c
     // message stanza id
     const char* id = xmpp_stanza_get_id(stanza);
     if (id) {
-        message->id = strdup(id);
+        message->id = message_strdup(message, id);
     }
 
     if (is_mam) {
         // MAM has XEP-0359 stanza-id as <result id="">
         if (result_id) {
-            message->stanzaid = strdup(result_id);
+            message->stanzaid = message_strdup(message, result_id);
         } else {
             log_warning("MAM received with no result id");
         }
@@ -1406,7 +1432,7 @@ _handle_chat(xmpp_stanza_t* const stanza, gboolean is_mam, gboolean is_carbon, c
         if (stanzaidst) {
             stanzaid = (char*)xmpp_stanza_get_attribute(stanzaidst, STANZA_ATTR_ID);
             if (stanzaid) {
-                message->stanzaid = strdup(stanzaid);
+                message->stanzaid = message_strdup(message, stanzaid);
             }
         }
     }
@@ -1416,7 +1442,7 @@ _handle_chat(xmpp_stanza_t* const stanza, gboolean is_mam, gboolean is_carbon, c
     if (replace_id_stanza) {
         const char* replace_id = xmpp_stanza_get_id(replace_id_stanza);
         if (replace_id) {
-            message->replace_id = strdup(replace_id);
+            message->replace_id = message_strdup(message, replace_id);
         }
     }
 
@@ -42,7 +42,10 @@ typedef int (*ProfMessageCallback)(xmpp_stanza_t* const stanza, void* const user
 typedef void (*ProfMessageFreeCallback)(void* userdata);
 
 ProfMessage* message_init(void);
+ProfMessage* message_init_in(Arena* arena);
 void message_free(ProfMessage* message);
+char* message_strdup(ProfMessage* message, const char* const str);
+void message_set_plain(ProfMessage* message, char* plain);
 void message_handlers_init(void);
 void message_handlers_clear(void);
 void message_pubsub_event_handler_add(const char* const node, ProfMessageCallback func, ProfMessageFreeCallback free_func, void* userdata);
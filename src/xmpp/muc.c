@@ -43,6 +43,8 @@
 
 #include "common.h"
 #include "tools/autocomplete.h"
+#include "tools/intern.h"
+#include "tools/memstats.h"
 #include "ui/ui.h"
 #include "ui/window_list.h"
 #include "xmpp/jid.h"
@@ -90,10 +92,12 @@ static char* _affiliation_to_string(muc_affiliation_t affiliation);
 static Occupant* _muc_occupant_new(const char* const nick, const char* const jid, muc_role_t role,
                                    muc_affiliation_t affiliation, resource_presence_t presence, const char* const status);
 static void _occupant_free(Occupant* occupant);
+static void _muc_memstats(MemStats* stats);
 
 static void
 _muc_close(void)
 {
+    memstats_unregister("muc");
     g_hash_table_destroy(invite_passwords);
     invite_passwords = NULL;
     g_hash_table_destroy(rooms);
@@ -112,6 +116,7 @@ muc_init(void)
     confservers_ac = autocomplete_new();
     rooms = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify)_free_room);
     invite_passwords = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+    memstats_register("muc", _muc_memstats);
 }
 
 void
@@ -228,7 +233,7 @@ muc_join(const char* const room, const char* const nick, const char* const passw
     new_room->subject = NULL;
     new_room->pending_broadcasts = NULL;
     new_room->pending_config = FALSE;
-    new_room->roster = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify)_occupant_free);
+    new_room->roster = g_hash_table_new_full(g_str_hash, g_str_equal, (GDestroyNotify)intern_unref, (GDestroyNotify)_occupant_free);
     new_room->members = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
     new_room->nick_ac = autocomplete_new();
     new_room->jid_ac = autocomplete_new();
@@ -493,7 +498,7 @@ muc_roster_add(const char* const room, const char* const nick, const char* const
         muc_role_t role_t = _role_from_string(role);
         muc_affiliation_t affiliation_t = _affiliation_from_string(affiliation);
         Occupant* occupant = _muc_occupant_new(nick, jid, role_t, affiliation_t, presence, status);
-        g_hash_table_replace(chat_room->roster, strdup(nick), occupant);
+        g_hash_table_replace(chat_room->roster, (gpointer)intern_ref(nick), occupant);
 
         if (jid) {
             auto_jid Jid* jidp = jid_create(jid);
@@ -1049,7 +1054,7 @@ _muc_occupant_new(const char* const nick, const char* const jid, muc_role_t role
     Occupant* occupant = malloc(sizeof(Occupant));
 
     if (nick) {
-        occupant->nick = strdup(nick);
+        occupant->nick = intern_ref(nick);
         occupant->nick_collate_key = g_utf8_collate_key(occupant->nick, -1);
     } else {
         occupant->nick = NULL;
@@ -1057,7 +1062,7 @@ _muc_occupant_new(const char* const nick, const char* const jid, muc_role_t role
     }
 
     if (jid) {
-        occupant->jid = strdup(jid);
+        occupant->jid = intern_ref(jid);
     } else {
         occupant->jid = NULL;
     }
@@ -1080,10 +1085,74 @@ static void
 _occupant_free(Occupant* occupant)
 {
     if (occupant) {
-        free(occupant->nick);
+        intern_unref(occupant->nick);
         free(occupant->nick_collate_key);
-        free(occupant->jid);
+        intern_unref(occupant->jid);
         free(occupant->status);
         free(occupant);
     }
 }
+
+// interned nicks and jids are counted by tools/intern
+static gsize
+_room_memory(ChatRoom* room)
+{
+    gsize bytes = sizeof(ChatRoom)
+                  + memstats_str(room->room)
+                  + memstats_str(room->nick)
+                  + memstats_str(room->password)
+                  + memstats_str(room->subject)
+                  + memstats_str(room->autocomplete_prefix)
+                  + memstats_list(room->pending_broadcasts)
+                  + memstats_hash_table(room->roster)
+                  + memstats_hash_table(room->members)
+                  + memstats_hash_table(room->nick_changes)
+                  + autocomplete_memory(room->nick_ac)
+                  + autocomplete_memory(room->jid_ac);
+
+    for (GList* curr = room->pending_broadcasts; curr; curr = g_list_next(curr)) {
+        bytes += memstats_str(curr->data);
+    }
+
+    GHashTableIter iter;
+    gpointer key;
+    gpointer value;
+    g_hash_table_iter_init(&iter, room->roster);
+    while (g_hash_table_iter_next(&iter, &key, &value)) {
+        Occupant* occupant = value;
+        bytes += sizeof(Occupant) + memstats_str(occupant->nick_collate_key) + memstats_str(occupant->status);
+    }
+    g_hash_table_iter_init(&iter, room->members);
+    while (g_hash_table_iter_next(&iter, &key, NULL)) {
+        bytes += memstats_str(key);
+    }
+    g_hash_table_iter_init(&iter, room->nick_changes);
+    while (g_hash_table_iter_next(&iter, &key, &value)) {
+        bytes += memstats_str(key) + memstats_str(value);
+    }
+
+    return bytes;
+}
+
+static void
+_muc_memstats(MemStats* stats)
+{
+    GHashTableIter iter;
+    gpointer key;
+    gpointer value;
+    g_hash_table_iter_init(&iter, rooms);
+    while (g_hash_table_iter_next(&iter, &key, &value)) {
+        ChatRoom* room = value;
+        auto_gchar gchar* name = g_strdup_printf("muc %s", room->room);
+        memstats_add(stats, name, memstats_str(key) + _room_memory(room),
+                     g_hash_table_size(room->roster) + g_hash_table_size(room->members));
+    }
+
+    gsize bytes = memstats_hash_table(rooms) + memstats_hash_table(invite_passwords)
+                  + autocomplete_memory(invite_ac) + autocomplete_memory(confservers_ac);
+    g_hash_table_iter_init(&iter, invite_passwords);
+    while (g_hash_table_iter_next(&iter, &key, &value)) {
+        bytes += memstats_str(key) + memstats_str(value);
+    }
+    memstats_add(stats, "muc.invites", bytes, autocomplete_length(invite_ac));
+}
@@ -72,9 +72,10 @@ typedef enum {
 
 typedef struct _muc_occupant_t
 {
-    char* nick;
+    // nick and jid are interned, see tools/intern.h
+    const char* nick;
     gchar* nick_collate_key;
-    char* jid;
+    const char* jid;
     muc_role_t role;
     muc_affiliation_t affiliation;
     resource_presence_t presence;
@@ -48,6 +48,7 @@
 #include "log.h"
 #include "common.h"
 #include "config/preferences.h"
+#include "tools/metrics.h"
 #include "event/server_events.h"
 #include "plugins/plugins.h"
 #include "ui/ui.h"
@@ -64,6 +65,7 @@
 static Autocomplete sub_requests_ac;
 
 static int _presence_handler(xmpp_conn_t* const conn, xmpp_stanza_t* const stanza, void* const userdata);
+static int _handle_presence_stanza(xmpp_stanza_t* const stanza);
 
 static void _presence_error_handler(xmpp_stanza_t* const stanza);
 static void _unavailable_handler(xmpp_stanza_t* const stanza);
@@ -351,6 +353,16 @@ presence_leave_chat_room(const char* const room_jid)
 
 static int
 _presence_handler(xmpp_conn_t* const conn, xmpp_stanza_t* const stanza, void* const userdata)
+{
+    gint64 start = metrics_start();
+    int res = _handle_presence_stanza(stanza);
+    metrics_record(METRIC_PRESENCE_STANZA, start);
+
+    return res;
+}
+
+static int
+_handle_presence_stanza(xmpp_stanza_t* const stanza)
 {
     log_debug("Presence stanza handler fired");
     autoping_timer_extend();
@@ -559,6 +571,8 @@ _handle_caps(const char* const jid, XMPPCaps* caps)
             if (caps_cache_contains(caps->ver)) {
                 log_debug("Capabilities cache hit: %s, for %s.", caps->ver, jid);
                 caps_map_jid_to_ver(jid, caps->ver);
+            } else if (caps_pending_add(caps->ver, jid)) {
+                log_debug("Capabilities cache miss: %s, for %s, request already in flight", caps->ver, jid);
             } else {
                 log_debug("Capabilities cache miss: %s, for %s, sending service discovery request", caps->ver, jid);
                 auto_char char* id = connection_create_stanza_id();
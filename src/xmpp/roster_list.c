@@ -43,6 +43,7 @@
 
 #include "config/preferences.h"
 #include "tools/autocomplete.h"
+#include "tools/memstats.h"
 #include "xmpp/roster_list.h"
 #include "xmpp/resource.h"
 #include "xmpp/contact.h"
@@ -85,6 +86,7 @@ static gboolean _key_equals(void* key1, void* key2);
 static gboolean _datetimes_equal(GDateTime* dt1, GDateTime* dt2);
 static void _replace_name(const char* const current_name, const char* const new_name, const char* const barejid);
 static void _add_name_and_barejid(const char* const name, const char* const barejid);
+static void _roster_memstats(MemStats* stats);
 
 void
 roster_create(void)
@@ -102,6 +104,35 @@ roster_create(void)
 
     roster_received = FALSE;
     roster_pending_presence = NULL;
+
+    memstats_register("roster", _roster_memstats);
+}
+
+static void
+_roster_memstats(MemStats* stats)
+{
+    gsize bytes = sizeof(ProfRoster) + memstats_hash_table(roster->contacts);
+    GHashTableIter iter;
+    gpointer key;
+    gpointer value;
+    g_hash_table_iter_init(&iter, roster->contacts);
+    while (g_hash_table_iter_next(&iter, &key, &value)) {
+        bytes += memstats_str(key) + p_contact_memory(value);
+    }
+    memstats_add(stats, "roster", bytes, g_hash_table_size(roster->contacts));
+
+    bytes = autocomplete_memory(roster->name_ac) + autocomplete_memory(roster->barejid_ac)
+            + autocomplete_memory(roster->fulljid_ac) + autocomplete_memory(roster->groups_ac)
+            + memstats_hash_table(roster->name_to_barejid) + memstats_hash_table(roster->group_count);
+    g_hash_table_iter_init(&iter, roster->name_to_barejid);
+    while (g_hash_table_iter_next(&iter, &key, &value)) {
+        bytes += memstats_str(key) + memstats_str(value);
+    }
+    g_hash_table_iter_init(&iter, roster->group_count);
+    while (g_hash_table_iter_next(&iter, &key, NULL)) {
+        bytes += memstats_str(key);
+    }
+    memstats_add(stats, "roster.autocomplete", bytes, autocomplete_length(roster->fulljid_ac));
 }
 
 static void
@@ -120,6 +151,7 @@ roster_destroy(void)
 {
     assert(roster != NULL);
 
+    memstats_unregister("roster");
     g_hash_table_destroy(roster->contacts);
     autocomplete_free(roster->name_ac);
     autocomplete_free(roster->barejid_ac);
@@ -233,6 +233,7 @@ session_disconnect(void)
         accounts_set_last_activity(session_get_account_name());
 
         iq_handlers_clear();
+        caps_pending_clear();
 
         connection_disconnect();
         message_handlers_clear();
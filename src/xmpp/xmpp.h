@@ -44,6 +44,7 @@
 
 #include "config/accounts.h"
 #include "config/tlscerts.h"
+#include "tools/arena.h"
 #include "tools/autocomplete.h"
 #include "tools/http_upload.h"
 #include "xmpp/contact.h"
@@ -175,6 +176,9 @@ typedef struct prof_message_t
     gboolean trusted;
     gboolean is_mam;
     prof_msg_type_t type;
+    /* Holds the message itself and the strings copied with message_strdup(),
+     * released in one go by message_free(). May be shared by a batch. */
+    Arena* arena;
 } ProfMessage;
 
 void session_init(void);
@@ -0,0 +1,167 @@
+#include <glib.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+
+#define BENCH_MAX_ITERATIONS 100000000
+
+typedef struct bench_result_t
+{
+    gchar* name;
+    guint64 iterations;
+    double ns_per_op;
+    double allocs_per_op;
+} BenchResult;
+
+static GArray* results;
+static gchar* bench_filter;
+static gint64 bench_min_time_us;
+
+#ifdef __GLIBC__
+// Count heap allocations by interposing the allocator entry points, GLib
+// allocates through malloc() so g_malloc() and g_new() are covered as well.
+extern void* __libc_malloc(size_t size);
+extern void* __libc_calloc(size_t nmemb, size_t size);
+extern void* __libc_realloc(void* ptr, size_t size);
+
+static guint64 alloc_count;
+
+void*
+malloc(size_t size)
+{
+    __atomic_add_fetch(&alloc_count, 1, __ATOMIC_RELAXED);
+    return __libc_malloc(size);
+}
+
+void*
+calloc(size_t nmemb, size_t size)
+{
+    __atomic_add_fetch(&alloc_count, 1, __ATOMIC_RELAXED);
+    return __libc_calloc(nmemb, size);
+}
+
+void*
+realloc(void* ptr, size_t size)
+{
+    __atomic_add_fetch(&alloc_count, 1, __ATOMIC_RELAXED);
+    return __libc_realloc(ptr, size);
+}
+
+static guint64
+_bench_allocs(void)
+{
+    return __atomic_load_n(&alloc_count, __ATOMIC_RELAXED);
+}
+
+static const gboolean allocs_counted = TRUE;
+#else
+static guint64
+_bench_allocs(void)
+{
+    return 0;
+}
+
+static const gboolean allocs_counted = FALSE;
+#endif
+
+static void
+_bench_result_clear(BenchResult* result)
+{
+    g_free(result->name);
+}
+
+void
+bench_init(const char* const filter, gint64 min_time_us)
+{
+    results = g_array_new(FALSE, TRUE, sizeof(BenchResult));
+    g_array_set_clear_func(results, (GDestroyNotify)_bench_result_clear);
+    bench_filter = g_strdup(filter);
+    bench_min_time_us = min_time_us;
+
+    printf("%-40s %12s %14s %12s\n", "benchmark", "iterations", "ns/op", "allocs/op");
+}
+
+void
+bench_run(const char* const name, bench_func_t func, void* data)
+{
+    if (bench_filter && !strstr(name, bench_filter)) {
+        return;
+    }
+
+    guint64 iterations = 1;
+    gint64 elapsed = 0;
+    guint64 allocs = 0;
+
+    while (TRUE) {
+        guint64 allocs_before = _bench_allocs();
+        gint64 start = g_get_monotonic_time();
+        func(iterations, data);
+        elapsed = g_get_monotonic_time() - start;
+        allocs = _bench_allocs() - allocs_before;
+
+        if (elapsed >= bench_min_time_us || iterations >= BENCH_MAX_ITERATIONS) {
+            break;
+        }
+
+        // aim a little past the minimum time, growing at least 2x and at most 100x per round
+        guint64 next = iterations * 100;
+        if (elapsed > 0) {
+            next = iterations * bench_min_time_us * 6 / 5 / elapsed;
+        }
+        next = CLAMP(next, iterations * 2, iterations * 100);
+        iterations = MIN(next, BENCH_MAX_ITERATIONS);
+    }
+
+    BenchResult result = {
+        .name = g_strdup(name),
+        .iterations = iterations,
+        .ns_per_op = (double)elapsed * 1000.0 / iterations,
+        .allocs_per_op = allocs_counted ? (double)allocs / iterations : -1.0,
+    };
+    g_array_append_val(results, result);
+
+    printf("%-40s %12" G_GUINT64_FORMAT " %14.1f %12.2f\n", result.name, result.iterations, result.ns_per_op, result.allocs_per_op);
+    fflush(stdout);
+}
+
+gboolean
+bench_write_results(const char* const filename)
+{
+    GString* json = g_string_new("{\n");
+    g_string_append_printf(json, "  \"allocations_counted\": %s,\n", allocs_counted ? "true" : "false");
+    g_string_append(json, "  \"benchmarks\": [");
+
+    for (guint i = 0; i < results->len; i++) {
+        BenchResult* result = &g_array_index(results, BenchResult, i);
+        g_string_append_printf(json, "%s\n    {\"name\": \"%s\", \"iterations\": %" G_GUINT64_FORMAT ", ",
+                               i == 0 ? "" : ",", result->name, result->iterations);
+        // %g is locale dependent, JSON always wants a dot
+        char ns[G_ASCII_DTOSTR_BUF_SIZE];
+        char allocs[G_ASCII_DTOSTR_BUF_SIZE];
+        g_ascii_formatd(ns, sizeof(ns), "%.1f", result->ns_per_op);
+        g_ascii_formatd(allocs, sizeof(allocs), "%.2f", result->allocs_per_op);
+        g_string_append_printf(json, "\"ns_per_op\": %s, \"allocs_per_op\": %s}", ns, allocs);
+    }
+    g_string_append(json, "\n  ]\n}\n");
+
+    GError* error = NULL;
+    gboolean ok = g_file_set_contents(filename, json->str, json->len, &error);
+    if (!ok) {
+        fprintf(stderr, "Could not write %s: %s\n", filename, error->message);
+        g_error_free(error);
+    }
+    g_string_free(json, TRUE);
+
+    return ok;
+}
+
+void
+bench_close(void)
+{
+    g_array_free(results, TRUE);
+    results = NULL;
+    g_free(bench_filter);
+    bench_filter = NULL;
+}
@@ -0,0 +1,17 @@
+#include <glib.h>
+
+typedef void (*bench_func_t)(guint64 iterations, void* data);
+
+void bench_init(const char* const filter, gint64 min_time_us);
+void bench_run(const char* const name, bench_func_t func, void* data);
+gboolean bench_write_results(const char* const filename);
+void bench_close(void);
+
+void bench_autocomplete(void);
+void bench_common(void);
+void bench_jid(void);
+void bench_buffer(void);
+void bench_window(void);
+void bench_roster(void);
+void bench_muc(void);
+void bench_database(void);
@@ -0,0 +1,56 @@
+#include <glib.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+#include "database.h"
+#include "config/account.h"
+#include "xmpp/jid.h"
+#include "xmpp/message.h"
+#include "xmpp/xmpp.h"
+
+typedef struct bench_db_message_t
+{
+    const char* replace_id;
+    guint64 counter;
+} BenchDbMessage;
+
+static void
+_log_database_add_incoming(guint64 iterations, void* data)
+{
+    BenchDbMessage* bench_msg = data;
+    for (guint64 i = 0; i < iterations; i++) {
+        ProfMessage* message = message_init();
+        message->from_jid = jid_create("contact@example.org/phone");
+        message->to_jid = jid_create("bench@example.org/profanity");
+        message->id = g_strdup_printf("bench-%" G_GUINT64_FORMAT, bench_msg->counter++);
+        message->replace_id = g_strdup(bench_msg->replace_id);
+        message->plain = strdup("Hello there, this is a message that ends up in the chat log database");
+        message->timestamp = g_date_time_new_now_local();
+        message->type = PROF_MSG_TYPE_CHAT;
+
+        log_database_add_incoming(message);
+        message_free(message);
+    }
+}
+
+void
+bench_database(void)
+{
+    // history reads need a connected account jid, only the write path is covered here
+    ProfAccount account = { 0 };
+    account.jid = "bench@example.org";
+    if (!log_database_init(&account)) {
+        fprintf(stderr, "Could not open the chat log database, skipping database benchmarks\n");
+        return;
+    }
+
+    BenchDbMessage plain = { .replace_id = NULL, .counter = 0 };
+    bench_run("log_database_add_incoming", _log_database_add_incoming, &plain);
+
+    BenchDbMessage correction = { .replace_id = "bench-0", .counter = 1000000000 };
+    bench_run("log_database_add_incoming_lmc", _log_database_add_incoming, &correction);
+
+    log_database_close();
+}
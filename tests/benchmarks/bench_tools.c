@@ -0,0 +1,123 @@
+#include <glib.h>
+#include <stdlib.h>
+
+#include "bench.h"
+#include "common.h"
+#include "tools/annotations.h"
+#include "tools/autocomplete.h"
+#include "xmpp/jid.h"
+
+#define AC_ITEMS 5000
+
+static const char* const mention_message = "hey bob, did boba or bobby tell you? Bob said bob's server is down again, bob";
+
+static void
+_ac_complete(guint64 iterations, void* data)
+{
+    Autocomplete ac = data;
+    for (guint64 i = 0; i < iterations; i++) {
+        gchar* result = autocomplete_complete(ac, "user42", FALSE, FALSE);
+        g_free(result);
+        autocomplete_reset(ac);
+    }
+}
+
+static void
+_ac_complete_cycle(guint64 iterations, void* data)
+{
+    Autocomplete ac = data;
+    for (guint64 i = 0; i < iterations; i++) {
+        gchar* result = autocomplete_complete(ac, "user", FALSE, FALSE);
+        g_free(result);
+    }
+    autocomplete_reset(ac);
+}
+
+static void
+_ac_add_remove(guint64 iterations, void* data)
+{
+    Autocomplete ac = data;
+    for (guint64 i = 0; i < iterations; i++) {
+        autocomplete_add(ac, "user2500x");
+        autocomplete_remove(ac, "user2500x");
+    }
+}
+
+static void
+_ac_contains(guint64 iterations, void* data)
+{
+    Autocomplete ac = data;
+    for (guint64 i = 0; i < iterations; i++) {
+        autocomplete_contains(ac, "user4999");
+    }
+}
+
+void
+bench_autocomplete(void)
+{
+    Autocomplete ac = autocomplete_new();
+    for (int i = 0; i < AC_ITEMS; i++) {
+        auto_gchar gchar* item = g_strdup_printf("user%d", i);
+        autocomplete_add(ac, item);
+    }
+
+    bench_run("autocomplete_complete", _ac_complete, ac);
+    bench_run("autocomplete_complete_cycle", _ac_complete_cycle, ac);
+    bench_run("autocomplete_add_remove", _ac_add_remove, ac);
+    bench_run("autocomplete_contains", _ac_contains, ac);
+
+    autocomplete_free(ac);
+}
+
+static void
+_prof_occurrences(guint64 iterations, void* data)
+{
+    for (guint64 i = 0; i < iterations; i++) {
+        GSList* result = NULL;
+        result = prof_occurrences("bob", mention_message, 0, TRUE, &result);
+        g_slist_free(result);
+    }
+}
+
+static void
+_get_mentions(guint64 iterations, void* data)
+{
+    for (guint64 i = 0; i < iterations; i++) {
+        GSList* result = get_mentions(TRUE, FALSE, mention_message, "Bob");
+        g_slist_free(result);
+    }
+}
+
+static void
+_message_annotate(guint64 iterations, void* data)
+{
+    for (guint64 i = 0; i < iterations; i++) {
+        message_annotations_free(message_annotate(data, NULL));
+    }
+}
+
+void
+bench_common(void)
+{
+    bench_run("prof_occurrences", _prof_occurrences, NULL);
+    bench_run("get_mentions", _get_mentions, NULL);
+    bench_run("message_annotate", _message_annotate, "see https://example.org/some/path?q=1 and https://example.com/other");
+}
+
+static void
+_jid_create(guint64 iterations, void* data)
+{
+    const char* const str = data;
+    for (guint64 i = 0; i < iterations; i++) {
+        Jid* jid = jid_create(str);
+        jid_destroy(jid);
+    }
+}
+
+void
+bench_jid(void)
+{
+    bench_run("jid_create_bare", _jid_create, "someuser@server.example.org");
+    bench_run("jid_create_full", _jid_create, "someuser@server.example.org/profanity.Xy1z");
+    bench_run("jid_create_room", _jid_create, "room@conference.example.org/some nick");
+}
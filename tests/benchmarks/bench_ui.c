@@ -0,0 +1,139 @@
+#include "config.h"
+
+#include <glib.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef HAVE_NCURSESW_NCURSES_H
+#include <ncursesw/ncurses.h>
+#elif HAVE_NCURSES_H
+#include <ncurses.h>
+#elif HAVE_CURSES_H
+#include <curses.h>
+#endif
+
+#include "bench.h"
+#include "config/preferences.h"
+#include "config/theme.h"
+#include "ui/buffer.h"
+#include "ui/window.h"
+
+#define BUFFER_ENTRIES 200
+
+static const char* const long_message = "Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do eiusmod tempor "
+                                        "incididunt ut labore et dolore magna aliqua. Ut enim ad minim veniam, quis nostrud "
+                                        "exercitation ullamco laboris nisi ut aliquip ex ea commodo consequat. Grüße, "
+                                        "schöne Grüße und 你好 to everyone in the room!";
+
+static void
+_buffer_append(guint64 iterations, void* data)
+{
+    ProfBuff buffer = data;
+    GDateTime* now = g_date_time_new_now_local();
+    for (guint64 i = 0; i < iterations; i++) {
+        buffer_append(buffer, "-", 0, now, 0, THEME_TEXT, "someone", "someone@example.org", long_message, NULL, "id", 0, 2);
+    }
+    g_date_time_unref(now);
+}
+
+static void
+_buffer_get_entry_by_id(guint64 iterations, void* data)
+{
+    ProfBuff buffer = data;
+    for (guint64 i = 0; i < iterations; i++) {
+        buffer_get_entry_by_id(buffer, "missing-id");
+    }
+}
+
+static void
+_buffer_get_entry(guint64 iterations, void* data)
+{
+    ProfBuff buffer = data;
+    for (guint64 i = 0; i < iterations; i++) {
+        buffer_get_entry(buffer, i % BUFFER_ENTRIES);
+    }
+}
+
+void
+bench_buffer(void)
+{
+    ProfBuff buffer = buffer_create();
+    GDateTime* now = g_date_time_new_now_local();
+    for (int i = 0; i < BUFFER_ENTRIES; i++) {
+        auto_gchar gchar* id = g_strdup_printf("id%d", i);
+        buffer_append(buffer, "-", 0, now, 0, THEME_TEXT, "someone", "someone@example.org", long_message, NULL, id, 0, 2);
+    }
+    g_date_time_unref(now);
+
+    bench_run("buffer_append", _buffer_append, buffer);
+    bench_run("buffer_get_entry_by_id", _buffer_get_entry_by_id, buffer);
+    bench_run("buffer_get_entry", _buffer_get_entry, buffer);
+
+    buffer_free(buffer);
+}
+
+static void
+_theme_attrs(guint64 iterations, void* data)
+{
+    for (guint64 i = 0; i < iterations; i++) {
+        theme_attrs(THEME_ROSTER_ONLINE);
+    }
+}
+
+static void
+_theme_hash_attrs(guint64 iterations, void* data)
+{
+    for (guint64 i = 0; i < iterations; i++) {
+        theme_hash_attrs("someone@example.org");
+    }
+}
+
+static void
+_win_println(guint64 iterations, void* data)
+{
+    ProfWin* window = data;
+    for (guint64 i = 0; i < iterations; i++) {
+        win_println(window, THEME_TEXT, "-", "%s", long_message);
+    }
+}
+
+void
+bench_window(void)
+{
+    // draw into an offscreen terminal, nothing is ever refreshed to a tty,
+    // the theme lookups need it too for their colour pair cache
+    FILE* out = fopen("/dev/null", "w");
+    FILE* in = fopen("/dev/null", "r");
+    const char* term = getenv("TERM");
+    SCREEN* screen = (out && in) ? newterm(term ? term : "xterm", out, in) : NULL;
+    if (!screen) {
+        fprintf(stderr, "Could not create offscreen terminal, skipping theme and window benchmarks\n");
+        if (out) {
+            fclose(out);
+        }
+        if (in) {
+            fclose(in);
+        }
+        return;
+    }
+    set_term(screen);
+    if (has_colors()) {
+        use_default_colors();
+        start_color();
+        theme_init_colours();
+    }
+
+    bench_run("theme_attrs", _theme_attrs, NULL);
+    bench_run("theme_hash_attrs", _theme_hash_attrs, NULL);
+
+    prefs_set_boolean(PREF_WRAP, TRUE);
+    ProfWin* console = win_create_console();
+
+    bench_run("win_println_wrapped", _win_println, console);
+
+    win_free(console);
+    endwin();
+    delscreen(screen);
+    fclose(out);
+    fclose(in);
+}
@@ -0,0 +1,91 @@
+#include <glib.h>
+#include <stdlib.h>
+
+#include "bench.h"
+#include "xmpp/muc.h"
+#include "xmpp/roster_list.h"
+
+#define ROSTER_CONTACTS 2000
+#define MUC_OCCUPANTS   3000
+
+static const char* const bench_room = "bench@conference.example.org";
+
+static void
+_roster_get_contacts(guint64 iterations, void* data)
+{
+    roster_ord_t order = GPOINTER_TO_INT(data);
+    for (guint64 i = 0; i < iterations; i++) {
+        GSList* contacts = roster_get_contacts(order);
+        g_slist_free(contacts);
+    }
+}
+
+static void
+_roster_get_contact(guint64 iterations, void* data)
+{
+    for (guint64 i = 0; i < iterations; i++) {
+        roster_get_contact("contact1999@example.org");
+    }
+}
+
+void
+bench_roster(void)
+{
+    roster_create();
+    for (int i = 0; i < ROSTER_CONTACTS; i++) {
+        auto_gchar gchar* barejid = g_strdup_printf("contact%d@example.org", i);
+        auto_gchar gchar* name = g_strdup_printf("Contact %d", ROSTER_CONTACTS - i);
+        roster_add(barejid, name, NULL, "both", FALSE);
+    }
+
+    bench_run("roster_get_contacts_name", _roster_get_contacts, GINT_TO_POINTER(ROSTER_ORD_NAME));
+    bench_run("roster_get_contacts_presence", _roster_get_contacts, GINT_TO_POINTER(ROSTER_ORD_PRESENCE));
+    bench_run("roster_get_contact", _roster_get_contact, NULL);
+
+    roster_destroy();
+}
+
+static void
+_muc_roster(guint64 iterations, void* data)
+{
+    for (guint64 i = 0; i < iterations; i++) {
+        GList* occupants = muc_roster(bench_room);
+        g_list_free(occupants);
+    }
+}
+
+static void
+_muc_roster_item(guint64 iterations, void* data)
+{
+    for (guint64 i = 0; i < iterations; i++) {
+        muc_roster_item(bench_room, "nick2999");
+    }
+}
+
+static void
+_muc_roster_add_remove(guint64 iterations, void* data)
+{
+    for (guint64 i = 0; i < iterations; i++) {
+        muc_roster_add(bench_room, "newcomer", "newcomer@example.org/res", "participant", "none", NULL, NULL);
+        muc_roster_remove(bench_room, "newcomer");
+    }
+}
+
+void
+bench_muc(void)
+{
+    muc_init();
+    muc_join(bench_room, "me", NULL, FALSE);
+    for (int i = 0; i < MUC_OCCUPANTS; i++) {
+        auto_gchar gchar* nick = g_strdup_printf("nick%d", i);
+        auto_gchar gchar* jid = g_strdup_printf("user%d@example.org/res", i);
+        muc_roster_add(bench_room, nick, jid, "participant", "member", NULL, NULL);
+    }
+    muc_roster_set_complete(bench_room);
+
+    bench_run("muc_roster", _muc_roster, NULL);
+    bench_run("muc_roster_item", _muc_roster_item, NULL);
+    bench_run("muc_roster_add_remove", _muc_roster_add_remove, NULL);
+
+    muc_leave(bench_room);
+}
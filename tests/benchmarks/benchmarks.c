@@ -0,0 +1,106 @@
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <locale.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bench.h"
+#include "log.h"
+#include "profanity.h"
+#include "config/files.h"
+#include "config/preferences.h"
+#include "config/theme.h"
+#include "tools/metrics.h"
+#include "xmpp/xmpp.h"
+
+void prof_shutdown(void);
+
+static void
+_remove_tree(const char* const path)
+{
+    GDir* dir = g_dir_open(path, 0, NULL);
+    if (dir) {
+        const gchar* name;
+        while ((name = g_dir_read_name(dir))) {
+            auto_gchar gchar* child = g_build_filename(path, name, NULL);
+            _remove_tree(child);
+        }
+        g_dir_close(dir);
+    }
+    g_remove(path);
+}
+
+int
+main(int argc, char* argv[])
+{
+    gchar* output = NULL;
+    gchar* filter = NULL;
+    gint min_time_ms = 200;
+
+    GOptionEntry entries[] = {
+        { "output", 'o', 0, G_OPTION_ARG_FILENAME, &output, "Write results as JSON to FILE (default benchmarks.json)", "FILE" },
+        { "filter", 'f', 0, G_OPTION_ARG_STRING, &filter, "Only run benchmarks whose name contains FILTER", "FILTER" },
+        { "min-time", 't', 0, G_OPTION_ARG_INT, &min_time_ms, "Minimum run time per benchmark in milliseconds (default 200)", "MS" },
+        { NULL }
+    };
+
+    GError* error = NULL;
+    GOptionContext* context = g_option_context_new(NULL);
+    g_option_context_add_main_entries(context, entries, NULL);
+    if (!g_option_context_parse(context, &argc, &argv, &error)) {
+        fprintf(stderr, "%s\n", error->message);
+        g_option_context_free(context);
+        g_error_free(error);
+        return EXIT_FAILURE;
+    }
+    g_option_context_free(context);
+
+    setlocale(LC_ALL, "");
+
+    // keep the user's configuration, logs and chat history out of it
+    gchar* tmpdir = g_dir_make_tmp("profanity-bench-XXXXXX", &error);
+    if (!tmpdir) {
+        fprintf(stderr, "%s\n", error->message);
+        g_error_free(error);
+        return EXIT_FAILURE;
+    }
+    auto_gchar gchar* config_home = g_build_filename(tmpdir, "config", NULL);
+    auto_gchar gchar* data_home = g_build_filename(tmpdir, "data", NULL);
+    setenv("XDG_CONFIG_HOME", config_home, 1);
+    setenv("XDG_DATA_HOME", data_home, 1);
+
+    pthread_mutex_init(&lock, NULL);
+    pthread_mutex_lock(&lock);
+    files_create_directories();
+    prefs_load(NULL);
+    log_init(PROF_LEVEL_ERROR, NULL);
+    metrics_init();
+    theme_init("default");
+    session_init();
+
+    bench_init(filter, (gint64)min_time_ms * 1000);
+
+    bench_autocomplete();
+    bench_common();
+    bench_jid();
+    bench_buffer();
+    bench_window();
+    bench_roster();
+    bench_muc();
+    bench_database();
+
+    int result = bench_write_results(output ? output : "benchmarks.json") ? EXIT_SUCCESS : EXIT_FAILURE;
+
+    bench_close();
+    prof_shutdown();
+    prefs_close();
+    log_close();
+    pthread_mutex_unlock(&lock);
+
+    _remove_tree(tmpdir);
+    g_free(tmpdir);
+    g_free(output);
+    g_free(filter);
+
+    return result;
+}
@@ -1,5 +1,6 @@
 #include <sys/stat.h>
 #include <sys/wait.h>
+#include <sys/resource.h>
 #include <glib.h>
 
 #include <setjmp.h>
@@ -123,13 +124,19 @@ _cleanup_dirs(void)
 
 void
 prof_start(void)
+{
+    prof_start_script("./tests/functionaltests/start_profanity.sh");
+}
+
+void
+prof_start_script(const char *script)
 {
     // helper script sets terminal columns, avoids assertions failing
     // based on the test runner terminal size
     fd = exp_spawnl("sh",
         "sh",
         "-c",
-        "./tests/functionaltests/start_profanity.sh",
+        script,
         NULL);
     FILE *fp = fdopen(fd, "r+");
 
@@ -141,7 +148,13 @@ prof_start(void)
 int
 init_prof_test(void **state)
 {
-    if (stbbr_start(STBBR_LOGDEBUG ,5230, 0) != 0) {
+    return init_prof_test_script("./tests/functionaltests/start_profanity.sh", STBBR_LOGDEBUG);
+}
+
+int
+init_prof_test_script(const char *script, int stbbr_loglevel)
+{
+    if (stbbr_start(stbbr_loglevel, 5230, 0) != 0) {
         assert_true(FALSE);
         return -1;
     }
@@ -159,7 +172,7 @@ init_prof_test(void **state)
     _create_chatlogs_dir();
     _create_logs_dir();
 
-    prof_start();
+    prof_start_script(script);
     assert_true(prof_output_exact("Profanity"));
 
     // set UI options to make expect assertions faster and more reliable
@@ -195,9 +208,16 @@ init_prof_test(void **state)
 
 int
 close_prof_test(void **state)
+{
+    return close_prof_test_rusage(NULL);
+}
+
+int
+close_prof_test_rusage(struct rusage *usage)
 {
     prof_input("/quit");
-    waitpid(exp_pid, NULL, 0);
+    // the rusage of the shell includes the profanity process it waited for
+    wait4(exp_pid, NULL, 0, usage);
     _cleanup_dirs();
 
     setenv("XDG_CONFIG_HOME", config_orig, 1);
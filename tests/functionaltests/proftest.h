@@ -4,10 +4,15 @@
 #define XDG_CONFIG_HOME "./tests/functionaltests/files/xdg_config_home"
 #define XDG_DATA_HOME   "./tests/functionaltests/files/xdg_data_home"
 
+struct rusage;
+
 int init_prof_test(void **state);
 int close_prof_test(void **state);
+int init_prof_test_script(const char *script, int stbbr_loglevel);
+int close_prof_test_rusage(struct rusage *usage);
 
 void prof_start(void);
+void prof_start_script(const char *script);
 void prof_connect(void);
 void prof_connect_with_roster(const char *roster);
 void prof_input(const char *input);
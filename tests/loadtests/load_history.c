@@ -0,0 +1,99 @@
+#include <glib.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <stabber.h>
+#include <expect.h>
+
+#include "proftest.h"
+#include "loadtest.h"
+
+#define MAM_MESSAGES     10000
+#define SENT_MESSAGES    100
+#define RECEIPTS         10000
+
+void
+mam_catch_up(void **state)
+{
+    prof_connect();
+
+    load_begin("mam_catch_up", MAM_MESSAGES);
+
+    GDateTime *stamp = g_date_time_new_utc(2024, 1, 1, 0, 0, 0);
+    for (int i = 0; i < MAM_MESSAGES; i++) {
+        GDateTime *next = g_date_time_add_seconds(stamp, 30);
+        g_date_time_unref(stamp);
+        stamp = next;
+        gchar *stamp_str = g_date_time_format(stamp, "%Y-%m-%dT%H:%M:%SZ");
+
+        gchar *result = g_strdup_printf(
+            "<message to='stabber@localhost/profanity'>"
+                "<result xmlns='urn:xmpp:mam:2' queryid='loadtest' id='archive-%d'>"
+                    "<forwarded xmlns='urn:xmpp:forward:0'>"
+                        "<delay xmlns='urn:xmpp:delay' stamp='%s'/>"
+                        "<message xmlns='jabber:client' type='chat' from='buddy%d@localhost/phone' to='stabber@localhost/profanity' id='mam-%d'>"
+                            "<body>archived message %d</body>"
+                        "</message>"
+                    "</forwarded>"
+                "</result>"
+            "</message>", i, stamp_str, i % 2 + 1, i, i);
+        load_send(result);
+        g_free(result);
+        g_free(stamp_str);
+    }
+    g_date_time_unref(stamp);
+
+    load_send(
+        "<iq type='result' to='stabber@localhost/profanity' id='loadtest'>"
+            "<fin xmlns='urn:xmpp:mam:2' complete='true'/>"
+        "</iq>");
+
+    load_probe(
+        "<message type='chat' to='stabber@localhost/profanity' from='probe@localhost/laptop'>"
+            "<body>probe</body>"
+        "</message>",
+        "<< chat message: probe@localhost");
+
+    load_end();
+}
+
+void
+receipt_flood(void **state)
+{
+    prof_input("/receipts request on");
+
+    prof_connect();
+
+    prof_input("/msg Buddy1");
+    for (int i = 0; i < SENT_MESSAGES; i++) {
+        gchar *message = g_strdup_printf("outgoing message %d", i);
+        prof_input(message);
+        g_free(message);
+    }
+    gchar *last = g_strdup_printf("outgoing message %d", SENT_MESSAGES - 1);
+    assert_true(prof_output_exact(last));
+    g_free(last);
+
+    load_begin("receipt_flood", RECEIPTS);
+
+    for (int i = 0; i < RECEIPTS; i++) {
+        gchar *receipt = g_strdup_printf(
+            "<message to='stabber@localhost/profanity' from='buddy1@localhost/laptop' id='r%d'>"
+                "<received xmlns='urn:xmpp:receipts' id='unknown-%d'/>"
+            "</message>", i, i);
+        load_send(receipt);
+        g_free(receipt);
+    }
+
+    load_probe(
+        "<message type='chat' to='stabber@localhost/profanity' from='buddy1@localhost/laptop'>"
+            "<body>probe-receipts</body>"
+        "</message>",
+        "probe-receipts");
+
+    load_end();
+}
@@ -0,0 +1,2 @@
+void mam_catch_up(void **state);
+void receipt_flood(void **state);
@@ -0,0 +1,125 @@
+#include <glib.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <stabber.h>
+#include <expect.h>
+
+#include "proftest.h"
+#include "loadtest.h"
+
+#define LARGE_ROOM_OCCUPANTS 3000
+
+#define TRAFFIC_ROOMS    50
+#define TRAFFIC_RATE     200
+#define TRAFFIC_SECONDS  30
+
+static void
+_join_room(const char *room, int occupants)
+{
+    gchar *join = g_strdup_printf("/join %s", room);
+    prof_input(join);
+    g_free(join);
+
+    gchar *join_presence = g_strdup_printf(
+        "<presence id='*' to='%s/stabber'>"
+            "<x xmlns='http://jabber.org/protocol/muc'/>"
+            "<c hash='sha-1' xmlns='http://jabber.org/protocol/caps' ver='*' node='http://profanity-im.github.io'/>"
+        "</presence>", room);
+    assert_true(stbbr_received(join_presence));
+    g_free(join_presence);
+
+    for (int i = 0; i < occupants; i++) {
+        gchar *presence = g_strdup_printf(
+            "<presence to='stabber@localhost/profanity' from='%s/occupant%d'>"
+                "<x xmlns='http://jabber.org/protocol/muc#user'>"
+                    "<item role='participant' jid='user%d@localhost/res' affiliation='%s'/>"
+                "</x>"
+            "</presence>", room, i, i, i % 50 ? "none" : "member");
+        load_send(presence);
+        g_free(presence);
+    }
+
+    // self presence comes last, see XEP-0045 7.2.3
+    gchar *self_presence = g_strdup_printf(
+        "<presence to='stabber@localhost/profanity' from='%s/stabber'>"
+            "<x xmlns='http://jabber.org/protocol/muc#user'>"
+                "<item role='participant' jid='stabber@localhost/profanity' affiliation='none'/>"
+            "</x>"
+            "<status code='110'/>"
+        "</presence>", room);
+    load_send(self_presence);
+    g_free(self_presence);
+
+    assert_true(prof_output_exact("-> You have joined the room as stabber, role: participant, affiliation: none"));
+}
+
+void
+muc_join_large_room(void **state)
+{
+    prof_connect();
+
+    load_begin("muc_join_large_room", LARGE_ROOM_OCCUPANTS + 1);
+
+    _join_room("bigroom@conference.localhost", LARGE_ROOM_OCCUPANTS);
+
+    load_probe(
+        "<message type='groupchat' to='stabber@localhost/profanity' from='bigroom@conference.localhost/occupant2999'>"
+            "<body>probe-large-room</body>"
+        "</message>",
+        "probe-large-room");
+
+    load_end();
+}
+
+void
+muc_sustained_traffic(void **state)
+{
+    prof_connect();
+
+    for (int i = 0; i < TRAFFIC_ROOMS; i++) {
+        gchar *room = g_strdup_printf("room%d@conference.localhost", i);
+        _join_room(room, 10);
+        g_free(room);
+    }
+
+    // the last room joined is the focused one, every message to it is a probe
+    int total = TRAFFIC_RATE * TRAFFIC_SECONDS;
+    gint64 interval = G_USEC_PER_SEC / TRAFFIC_RATE;
+
+    load_begin("muc_sustained_200_per_s", total);
+    gint64 start = g_get_monotonic_time();
+
+    for (int i = 0; i < total; i++) {
+        gint64 due = start + i * interval;
+        gint64 now = g_get_monotonic_time();
+        if (due > now) {
+            g_usleep(due - now);
+        }
+
+        int room = i % TRAFFIC_ROOMS;
+        if (room == TRAFFIC_ROOMS - 1) {
+            gchar *body = g_strdup_printf("probe-traffic-%d", i);
+            gchar *message = g_strdup_printf(
+                "<message type='groupchat' to='stabber@localhost/profanity' from='room%d@conference.localhost/occupant%d'>"
+                    "<body>%s</body>"
+                "</message>", room, i % 10, body);
+            load_probe(message, body);
+            g_free(message);
+            g_free(body);
+        } else {
+            gchar *message = g_strdup_printf(
+                "<message type='groupchat' to='stabber@localhost/profanity' from='room%d@conference.localhost/occupant%d'>"
+                    "<body>message %d, with some text to make it look like a real one</body>"
+                "</message>", room, i % 10, i);
+            load_send(message);
+            g_free(message);
+        }
+    }
+
+    load_end();
+}
@@ -0,0 +1,2 @@
+void muc_join_large_room(void **state);
+void muc_sustained_traffic(void **state);
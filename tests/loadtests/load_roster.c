@@ -0,0 +1,51 @@
+#include <glib.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <stabber.h>
+#include <expect.h>
+
+#include "proftest.h"
+#include "loadtest.h"
+
+#define ROSTER_CONTACTS 5000
+
+void
+roster_push_with_presence_storm(void **state)
+{
+    GString *roster = g_string_new(NULL);
+    for (int i = 0; i < ROSTER_CONTACTS; i++) {
+        g_string_append_printf(roster,
+            "<item jid='contact%d@localhost' subscription='both' name='Contact %d'>"
+                "<group>Group %d</group>"
+            "</item>", i, i, i % 20);
+    }
+
+    load_begin("roster_presence_storm", ROSTER_CONTACTS * 2);
+
+    prof_connect_with_roster(roster->str);
+    g_string_free(roster, TRUE);
+
+    for (int i = 0; i < ROSTER_CONTACTS; i++) {
+        gchar *presence = g_strdup_printf(
+            "<presence to='stabber@localhost' from='contact%d@localhost/laptop'>"
+                "<show>%s</show>"
+                "<status>status of contact %d</status>"
+                "<priority>%d</priority>"
+            "</presence>", i, i % 3 ? "away" : "dnd", i, i % 10);
+        load_send(presence);
+        g_free(presence);
+    }
+
+    load_probe(
+        "<message type='chat' to='stabber@localhost/profanity' from='contact4999@localhost/laptop'>"
+            "<body>probe</body>"
+        "</message>",
+        "<< chat message: Contact 4999");
+
+    load_end();
+}
@@ -0,0 +1 @@
+void roster_push_with_presence_storm(void **state);
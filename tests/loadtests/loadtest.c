@@ -0,0 +1,170 @@
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <glib.h>
+
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <cmocka.h>
+#include <stdio.h>
+
+#include <stabber.h>
+#include <expect.h>
+
+#include "proftest.h"
+#include "loadtest.h"
+
+typedef struct load_result_t {
+    char *scenario;
+    int stanzas;
+    gint64 start;
+    gint64 wall_us;
+    GArray *latencies_us;
+    struct rusage usage;
+    gboolean finished;
+} LoadResult;
+
+static GList *results = NULL;
+static LoadResult *current = NULL;
+
+int
+init_load_test(void **state)
+{
+    current = NULL;
+
+    // debug logging on either side would dominate the numbers
+    int res = init_prof_test_script("./tests/loadtests/start_profanity.sh", STBBR_LOGERROR);
+
+    // the floods scroll a lot of output past expect before the probe shows up
+    prof_timeout(120);
+
+    return res;
+}
+
+int
+close_load_test(void **state)
+{
+    prof_timeout_reset();
+
+    struct rusage usage;
+    int res = close_prof_test_rusage(&usage);
+
+    if (current) {
+        current->usage = usage;
+        current->finished = TRUE;
+        current = NULL;
+    }
+
+    return res;
+}
+
+void
+load_begin(const char *scenario, int stanzas)
+{
+    current = g_new0(LoadResult, 1);
+    current->scenario = g_strdup(scenario);
+    current->stanzas = stanzas;
+    current->latencies_us = g_array_new(FALSE, FALSE, sizeof(gint64));
+    current->start = g_get_monotonic_time();
+    results = g_list_append(results, current);
+}
+
+void
+load_send(const char *stanza)
+{
+    stbbr_send(stanza);
+}
+
+void
+load_probe(const char *stanza, const char *expected)
+{
+    gint64 sent = g_get_monotonic_time();
+    load_send(stanza);
+    assert_true(prof_output_exact(expected));
+    gint64 latency = g_get_monotonic_time() - sent;
+    g_array_append_val(current->latencies_us, latency);
+}
+
+void
+load_end(void)
+{
+    current->wall_us = g_get_monotonic_time() - current->start;
+}
+
+static gint
+_cmp_gint64(gconstpointer a, gconstpointer b)
+{
+    gint64 first = *(const gint64 *)a;
+    gint64 second = *(const gint64 *)b;
+
+    return (first > second) - (first < second);
+}
+
+static double
+_percentile_ms(GArray *sorted, double percentile)
+{
+    if (sorted->len == 0) {
+        return 0.0;
+    }
+
+    guint index = (guint)(percentile * (sorted->len - 1) + 0.5);
+
+    return g_array_index(sorted, gint64, index) / 1000.0;
+}
+
+static double
+_timeval_s(struct timeval *tv)
+{
+    return tv->tv_sec + tv->tv_usec / 1000000.0;
+}
+
+void
+load_report(const char *filename)
+{
+    GString *table = g_string_new(NULL);
+    g_string_append_printf(table, "%-28s %9s %9s %11s %10s %10s %10s %9s %9s %10s\n",
+        "scenario", "stanzas", "wall s", "stanzas/s", "p50 ms", "p95 ms", "max ms", "user s", "sys s", "rss MiB");
+
+    GString *tsv = g_string_new("scenario\tstanzas\twall_s\tstanzas_per_s\tlatency_p50_ms\tlatency_p95_ms\tlatency_max_ms\tcpu_user_s\tcpu_sys_s\tpeak_rss_kib\n");
+
+    GList *curr = results;
+    while (curr) {
+        LoadResult *result = curr->data;
+        curr = g_list_next(curr);
+
+        if (!result->finished || result->wall_us == 0) {
+            g_string_append_printf(table, "%-28s failed\n", result->scenario);
+            continue;
+        }
+
+        g_array_sort(result->latencies_us, _cmp_gint64);
+
+        double wall_s = result->wall_us / 1000000.0;
+        double p50 = _percentile_ms(result->latencies_us, 0.5);
+        double p95 = _percentile_ms(result->latencies_us, 0.95);
+        double max = _percentile_ms(result->latencies_us, 1.0);
+        double user_s = _timeval_s(&result->usage.ru_utime);
+        double sys_s = _timeval_s(&result->usage.ru_stime);
+        // ru_maxrss is in KiB on Linux
+        long rss_kib = result->usage.ru_maxrss;
+
+        g_string_append_printf(table, "%-28s %9d %9.2f %11.0f %10.1f %10.1f %10.1f %9.2f %9.2f %10.1f\n",
+            result->scenario, result->stanzas, wall_s, result->stanzas / wall_s, p50, p95, max, user_s, sys_s, rss_kib / 1024.0);
+        g_string_append_printf(tsv, "%s\t%d\t%.3f\t%.0f\t%.1f\t%.1f\t%.1f\t%.2f\t%.2f\t%ld\n",
+            result->scenario, result->stanzas, wall_s, result->stanzas / wall_s, p50, p95, max, user_s, sys_s, rss_kib);
+    }
+
+    printf("\n%s", table->str);
+
+    if (filename) {
+        GError *error = NULL;
+        if (!g_file_set_contents(filename, tsv->str, tsv->len, &error)) {
+            fprintf(stderr, "Could not write %s: %s\n", filename, error->message);
+            g_error_free(error);
+        }
+    }
+
+    g_string_free(table, TRUE);
+    g_string_free(tsv, TRUE);
+}
@@ -0,0 +1,14 @@
+#ifndef __H_LOADTEST
+#define __H_LOADTEST
+
+int init_load_test(void **state);
+int close_load_test(void **state);
+
+void load_begin(const char *scenario, int stanzas);
+void load_send(const char *stanza);
+void load_probe(const char *stanza, const char *expected);
+void load_end(void);
+
+void load_report(const char *filename);
+
+#endif
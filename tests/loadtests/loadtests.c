@@ -0,0 +1,36 @@
+#include <stdarg.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <sys/stat.h>
+
+#include "config.h"
+
+#include "proftest.h"
+#include "loadtest.h"
+#include "load_roster.h"
+#include "load_muc.h"
+#include "load_history.h"
+
+#define PROF_LOAD_TEST(test) cmocka_unit_test_setup_teardown(test, init_load_test, close_load_test)
+
+int main(int argc, char* argv[]) {
+
+    const struct CMUnitTest all_tests[] = {
+        PROF_LOAD_TEST(roster_push_with_presence_storm),
+        PROF_LOAD_TEST(muc_join_large_room),
+        PROF_LOAD_TEST(mam_catch_up),
+        PROF_LOAD_TEST(muc_sustained_traffic),
+        PROF_LOAD_TEST(receipt_flood),
+    };
+
+    int result = cmocka_run_group_tests(all_tests, NULL, NULL);
+
+    // optional path for a tab separated copy of the table
+    load_report(argc > 1 ? argv[1] : NULL);
+
+    return result;
+}
@@ -0,0 +1,2 @@
+export COLUMNS=300
+./profanity -l ERROR
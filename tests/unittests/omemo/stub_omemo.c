@@ -104,11 +104,6 @@ omemo_start_sessions(void)
 {
 }
 
-char*
-omemo_encrypt_file(FILE* in, FILE* out, off_t file_size, int* gcry_res)
-{
-    return NULL;
-};
 void omemo_free(void* a){};
 
 uint32_t
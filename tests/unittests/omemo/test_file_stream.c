@@ -0,0 +1,208 @@
+#include <glib.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "omemo/crypto.h"
+#include "omemo/file_stream.h"
+
+// not a multiple of the chunk or block size
+#define PLAINTEXT_SIZE 40007
+
+static GByteArray*
+_plaintext(size_t size)
+{
+    GByteArray* plaintext = g_byte_array_sized_new(size);
+    for (size_t i = 0; i < size; i++) {
+        guint8 byte = (guint8)(i * 31 + 7);
+        g_byte_array_append(plaintext, &byte, 1);
+    }
+    return plaintext;
+}
+
+// encrypt with the upload stream, reading in uneven pieces
+static GByteArray*
+_encrypt(GByteArray* plaintext, char** fragment)
+{
+    FILE* in = tmpfile();
+    assert_non_null(in);
+    assert_int_equal(fwrite(plaintext->data, 1, plaintext->len, in), plaintext->len);
+    rewind(in);
+
+    gcry_error_t res;
+    OmemoFileStream* stream = omemo_encrypt_stream_new(in, plaintext->len, fragment, &res);
+    assert_int_equal(res, GPG_ERR_NO_ERROR);
+    assert_non_null(stream);
+    assert_non_null(*fragment);
+
+    const size_t reads[] = { 7, 1000, 13, 16384, 1 };
+    GByteArray* ciphertext = g_byte_array_new();
+    char buffer[16384];
+    ssize_t got;
+    int i = 0;
+    while ((got = omemo_encrypt_stream_read(stream, buffer, reads[i++ % G_N_ELEMENTS(reads)])) > 0) {
+        g_byte_array_append(ciphertext, (guint8*)buffer, got);
+    }
+    assert_int_equal(got, 0);
+    assert_int_equal(ciphertext->len, omemo_encrypt_stream_size(stream));
+    assert_int_equal(ciphertext->len, plaintext->len + AES256_GCM_TAG_LENGTH);
+
+    omemo_file_stream_free(stream);
+    fclose(in);
+
+    return ciphertext;
+}
+
+// decrypt with the download stream, splitting the ciphertext at the given offsets
+static gcry_error_t
+_decrypt(const char* fragment, GByteArray* ciphertext, const size_t* splits, size_t nsplits, GByteArray** plaintext)
+{
+    FILE* out = tmpfile();
+    assert_non_null(out);
+
+    gcry_error_t res;
+    OmemoFileStream* stream = omemo_decrypt_stream_new(fragment, &res);
+    assert_int_equal(res, GPG_ERR_NO_ERROR);
+    assert_non_null(stream);
+
+    size_t pos = 0;
+    for (size_t i = 0; i <= nsplits; i++) {
+        size_t end = i < nsplits ? splits[i] : ciphertext->len;
+        res = omemo_decrypt_stream_write(stream, (char*)ciphertext->data + pos, end - pos, out);
+        assert_int_equal(res, GPG_ERR_NO_ERROR);
+        pos = end;
+    }
+    res = omemo_decrypt_stream_finish(stream, out);
+    omemo_file_stream_free(stream);
+
+    long size = ftell(out);
+    *plaintext = g_byte_array_sized_new(size);
+    g_byte_array_set_size(*plaintext, size);
+    rewind(out);
+    assert_int_equal(fread((*plaintext)->data, 1, size, out), size);
+    fclose(out);
+
+    return res;
+}
+
+static void
+_assert_bytes_equal(GByteArray* expected, GByteArray* actual)
+{
+    assert_int_equal(actual->len, expected->len);
+    assert_memory_equal(actual->data, expected->data, expected->len);
+}
+
+int
+file_stream_setup(void** state)
+{
+    static gboolean initialised = FALSE;
+
+    if (!initialised) {
+        assert_int_equal(omemo_crypto_init(), 0);
+        initialised = TRUE;
+    }
+    return 0;
+}
+
+void
+file_stream_round_trip(void** state)
+{
+    GByteArray* plaintext = _plaintext(PLAINTEXT_SIZE);
+    char* fragment;
+    GByteArray* ciphertext = _encrypt(plaintext, &fragment);
+
+    const size_t splits[] = { 4096, 8192, 20000, 30001 };
+    GByteArray* decrypted;
+    assert_int_equal(_decrypt(fragment, ciphertext, splits, G_N_ELEMENTS(splits), &decrypted), GPG_ERR_NO_ERROR);
+    _assert_bytes_equal(plaintext, decrypted);
+
+    g_byte_array_free(decrypted, TRUE);
+    g_byte_array_free(ciphertext, TRUE);
+    g_byte_array_free(plaintext, TRUE);
+    gcry_free(fragment);
+}
+
+void
+file_stream_round_trip_empty_file(void** state)
+{
+    GByteArray* plaintext = _plaintext(0);
+    char* fragment;
+    GByteArray* ciphertext = _encrypt(plaintext, &fragment);
+
+    GByteArray* decrypted;
+    assert_int_equal(_decrypt(fragment, ciphertext, NULL, 0, &decrypted), GPG_ERR_NO_ERROR);
+    assert_int_equal(decrypted->len, 0);
+
+    g_byte_array_free(decrypted, TRUE);
+    g_byte_array_free(ciphertext, TRUE);
+    g_byte_array_free(plaintext, TRUE);
+    gcry_free(fragment);
+}
+
+void
+file_stream_decrypt_split_inside_tag(void** state)
+{
+    GByteArray* plaintext = _plaintext(PLAINTEXT_SIZE);
+    char* fragment;
+    GByteArray* ciphertext = _encrypt(plaintext, &fragment);
+
+    for (size_t k = 1; k < AES256_GCM_TAG_LENGTH; k++) {
+        // the last write holds only the final k bytes of the tag
+        const size_t splits[] = { ciphertext->len - AES256_GCM_TAG_LENGTH - 3, ciphertext->len - k };
+        GByteArray* decrypted;
+        assert_int_equal(_decrypt(fragment, ciphertext, splits, G_N_ELEMENTS(splits), &decrypted), GPG_ERR_NO_ERROR);
+        _assert_bytes_equal(plaintext, decrypted);
+        g_byte_array_free(decrypted, TRUE);
+    }
+
+    g_byte_array_free(ciphertext, TRUE);
+    g_byte_array_free(plaintext, TRUE);
+    gcry_free(fragment);
+}
+
+void
+file_stream_decrypt_single_byte_chunks(void** state)
+{
+    GByteArray* plaintext = _plaintext(1000);
+    char* fragment;
+    GByteArray* ciphertext = _encrypt(plaintext, &fragment);
+
+    size_t nsplits = ciphertext->len - 1;
+    size_t* splits = g_new(size_t, nsplits);
+    for (size_t i = 0; i < nsplits; i++) {
+        splits[i] = i + 1;
+    }
+
+    GByteArray* decrypted;
+    assert_int_equal(_decrypt(fragment, ciphertext, splits, nsplits, &decrypted), GPG_ERR_NO_ERROR);
+    _assert_bytes_equal(plaintext, decrypted);
+
+    g_free(splits);
+    g_byte_array_free(decrypted, TRUE);
+    g_byte_array_free(ciphertext, TRUE);
+    g_byte_array_free(plaintext, TRUE);
+    gcry_free(fragment);
+}
+
+void
+file_stream_decrypt_rejects_tampered_tag(void** state)
+{
+    GByteArray* plaintext = _plaintext(PLAINTEXT_SIZE);
+    char* fragment;
+    GByteArray* ciphertext = _encrypt(plaintext, &fragment);
+
+    ciphertext->data[ciphertext->len - 1] ^= 0x01;
+
+    const size_t splits[] = { 16384 };
+    GByteArray* decrypted;
+    assert_int_not_equal(_decrypt(fragment, ciphertext, splits, G_N_ELEMENTS(splits), &decrypted), GPG_ERR_NO_ERROR);
+
+    g_byte_array_free(decrypted, TRUE);
+    g_byte_array_free(ciphertext, TRUE);
+    g_byte_array_free(plaintext, TRUE);
+    gcry_free(fragment);
+}
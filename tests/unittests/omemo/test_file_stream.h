@@ -0,0 +1,6 @@
+int file_stream_setup(void** state);
+void file_stream_round_trip(void** state);
+void file_stream_round_trip_empty_file(void** state);
+void file_stream_decrypt_split_inside_tag(void** state);
+void file_stream_decrypt_single_byte_chunks(void** state);
+void file_stream_decrypt_rejects_tampered_tag(void** state);
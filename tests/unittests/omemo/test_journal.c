@@ -0,0 +1,198 @@
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "omemo/journal.h"
+
+static gchar* journal_dir;
+static gchar* journal_path;
+
+int
+journal_setup(void** state)
+{
+    journal_dir = g_dir_make_tmp("prof_journal_XXXXXX", NULL);
+    journal_path = g_build_filename(journal_dir, "store.journal", NULL);
+    return 0;
+}
+
+int
+journal_teardown(void** state)
+{
+    g_unlink(journal_path);
+    g_rmdir(journal_dir);
+    g_free(journal_path);
+    g_free(journal_dir);
+    return 0;
+}
+
+static void
+_append_raw(const char* const data)
+{
+    FILE* file = fopen(journal_path, "a");
+    assert_non_null(file);
+    fputs(data, file);
+    fclose(file);
+}
+
+// reopen the journal as omemo_on_login() does and replay it
+static guint
+_replay(GKeyFile* sessions, GKeyFile* identity)
+{
+    OmemoJournal* journal = omemo_journal_open(journal_path);
+    assert_non_null(journal);
+    guint applied = omemo_journal_replay(journal, sessions, identity);
+    assert_int_equal(applied, omemo_journal_records(journal));
+    omemo_journal_close(journal);
+
+    return applied;
+}
+
+void
+journal_replays_appended_records(void** state)
+{
+    OmemoJournal* journal = omemo_journal_open(journal_path);
+    assert_true(omemo_journal_set(journal, FALSE, "alice@example.org", "1", "session"));
+    assert_true(omemo_journal_set(journal, TRUE, "prekeys", "7", "prekey"));
+    assert_true(omemo_journal_remove(journal, FALSE, "alice@example.org", "2"));
+    assert_int_equal(3, omemo_journal_records(journal));
+    omemo_journal_close(journal);
+
+    GKeyFile* sessions = g_key_file_new();
+    GKeyFile* identity = g_key_file_new();
+    g_key_file_set_string(sessions, "alice@example.org", "2", "stale");
+
+    assert_int_equal(3, _replay(sessions, identity));
+
+    gchar* session = g_key_file_get_string(sessions, "alice@example.org", "1", NULL);
+    gchar* prekey = g_key_file_get_string(identity, "prekeys", "7", NULL);
+    assert_string_equal("session", session);
+    assert_string_equal("prekey", prekey);
+    assert_false(g_key_file_has_key(sessions, "alice@example.org", "2", NULL));
+    assert_false(g_key_file_has_group(identity, "alice@example.org"));
+
+    g_free(session);
+    g_free(prekey);
+    g_key_file_free(sessions);
+    g_key_file_free(identity);
+}
+
+void
+journal_replay_applies_records_in_order(void** state)
+{
+    OmemoJournal* journal = omemo_journal_open(journal_path);
+    omemo_journal_set(journal, FALSE, "bob@example.org", "1", "first");
+    omemo_journal_remove(journal, FALSE, "bob@example.org", "1");
+    omemo_journal_set(journal, FALSE, "bob@example.org", "1", "last");
+    omemo_journal_close(journal);
+
+    GKeyFile* sessions = g_key_file_new();
+    GKeyFile* identity = g_key_file_new();
+
+    assert_int_equal(3, _replay(sessions, identity));
+
+    gchar* session = g_key_file_get_string(sessions, "bob@example.org", "1", NULL);
+    assert_string_equal("last", session);
+
+    g_free(session);
+    g_key_file_free(sessions);
+    g_key_file_free(identity);
+}
+
+void
+journal_replay_skips_torn_and_malformed_records(void** state)
+{
+    OmemoJournal* journal = omemo_journal_open(journal_path);
+    omemo_journal_set(journal, FALSE, "carol@example.org", "1", "kept");
+    omemo_journal_close(journal);
+    _append_raw("X\tsessions\tcarol@example.org\t2\n");
+    _append_raw("S\tunknown\tcarol@example.org\t3\tvalue\n");
+    // a crash in the middle of a write leaves the last record without newline
+    _append_raw("S\tsessions\tcarol@example.org\t4\tto");
+
+    GKeyFile* sessions = g_key_file_new();
+    GKeyFile* identity = g_key_file_new();
+
+    assert_int_equal(1, _replay(sessions, identity));
+
+    gchar** keys = g_key_file_get_keys(sessions, "carol@example.org", NULL, NULL);
+    assert_int_equal(1, g_strv_length(keys));
+    assert_string_equal("1", keys[0]);
+
+    g_strfreev(keys);
+    g_key_file_free(sessions);
+    g_key_file_free(identity);
+}
+
+void
+journal_append_after_torn_record_is_kept(void** state)
+{
+    _append_raw("S\tsessions\tfrank@example.org\t1\tto");
+
+    GKeyFile* sessions = g_key_file_new();
+    GKeyFile* identity = g_key_file_new();
+    OmemoJournal* journal = omemo_journal_open(journal_path);
+    assert_int_equal(0, omemo_journal_replay(journal, sessions, identity));
+    omemo_journal_set(journal, FALSE, "frank@example.org", "2", "after");
+    omemo_journal_close(journal);
+
+    assert_int_equal(1, _replay(sessions, identity));
+    gchar* session = g_key_file_get_string(sessions, "frank@example.org", "2", NULL);
+    assert_string_equal("after", session);
+    assert_false(g_key_file_has_key(sessions, "frank@example.org", "1", NULL));
+
+    g_free(session);
+    g_key_file_free(sessions);
+    g_key_file_free(identity);
+}
+
+void
+journal_truncate_drops_records(void** state)
+{
+    OmemoJournal* journal = omemo_journal_open(journal_path);
+    omemo_journal_set(journal, FALSE, "dave@example.org", "1", "compacted");
+    omemo_journal_set(journal, TRUE, "prekeys", "1", "compacted");
+
+    omemo_journal_truncate(journal);
+    assert_int_equal(0, omemo_journal_records(journal));
+
+    // appends after truncation start a new journal
+    omemo_journal_set(journal, FALSE, "dave@example.org", "2", "new");
+    assert_int_equal(1, omemo_journal_records(journal));
+    omemo_journal_close(journal);
+
+    GKeyFile* sessions = g_key_file_new();
+    GKeyFile* identity = g_key_file_new();
+
+    assert_int_equal(1, _replay(sessions, identity));
+    assert_false(g_key_file_has_key(sessions, "dave@example.org", "1", NULL));
+    assert_true(g_key_file_has_key(sessions, "dave@example.org", "2", NULL));
+    assert_false(g_key_file_has_group(identity, "prekeys"));
+
+    g_key_file_free(sessions);
+    g_key_file_free(identity);
+}
+
+void
+journal_needs_compaction_until_truncated(void** state)
+{
+    OmemoJournal* journal = omemo_journal_open(journal_path);
+    assert_false(omemo_journal_needs_compaction(journal));
+
+    guint appended = 0;
+    while (!omemo_journal_needs_compaction(journal) && appended < 100000) {
+        omemo_journal_set(journal, FALSE, "erin@example.org", "1", "session");
+        appended++;
+    }
+    assert_true(omemo_journal_needs_compaction(journal));
+    assert_int_equal(appended, omemo_journal_records(journal));
+
+    omemo_journal_truncate(journal);
+    assert_false(omemo_journal_needs_compaction(journal));
+
+    omemo_journal_close(journal);
+}
@@ -0,0 +1,8 @@
+int journal_setup(void** state);
+int journal_teardown(void** state);
+void journal_replays_appended_records(void** state);
+void journal_replay_applies_records_in_order(void** state);
+void journal_replay_skips_torn_and_malformed_records(void** state);
+void journal_append_after_torn_record_is_kept(void** state);
+void journal_truncate_drops_records(void** state);
+void journal_needs_compaction_until_truncated(void** state);
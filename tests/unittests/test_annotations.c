@@ -0,0 +1,95 @@
+#include <glib.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdlib.h>
+
+#include "config/preferences.h"
+#include "tools/annotations.h"
+#include "tools/trigger_matcher.h"
+
+void
+annotate_finds_urls(void** state)
+{
+    MessageAnnotations* annotations = message_annotate("see https://example.org/a?b=1, and (http://ü.example/x) aesgcm://host/f#k", NULL);
+
+    assert_int_equal(3, annotations->urls->len);
+    assert_string_equal("https://example.org/a?b=1,", g_ptr_array_index(annotations->urls, 0));
+    assert_string_equal("http://ü.example/x)", g_ptr_array_index(annotations->urls, 1));
+    assert_string_equal("aesgcm://host/f#k", g_ptr_array_index(annotations->urls, 2));
+
+    message_annotations_free(annotations);
+}
+
+void
+annotate_url_needs_more_than_scheme(void** state)
+{
+    MessageAnnotations* annotations = message_annotate("http:// and ftp://host and xhttps://a", NULL);
+
+    assert_int_equal(1, annotations->urls->len);
+    assert_string_equal("https://a", g_ptr_array_index(annotations->urls, 0));
+
+    message_annotations_free(annotations);
+}
+
+void
+annotate_detects_me_and_ascii(void** state)
+{
+    MessageAnnotations* annotations = message_annotate("/me waves", NULL);
+    assert_true(annotations->is_me);
+    assert_true(annotations->ascii);
+    message_annotations_free(annotations);
+
+    annotations = message_annotate("/mehr grüße", NULL);
+    assert_false(annotations->is_me);
+    assert_false(annotations->ascii);
+    message_annotations_free(annotations);
+}
+
+void
+annotate_skips_room_matching_without_nick(void** state)
+{
+    MessageAnnotations* annotations = message_annotate("hello bob", NULL);
+
+    assert_null(annotations->mentions);
+    assert_null(annotations->triggers);
+    assert_null(annotations->trigger_spans);
+
+    message_annotations_free(annotations);
+}
+
+static void
+_assert_span(GArray* spans, guint i, gsize start, gsize end)
+{
+    TriggerMatch* span = &g_array_index(spans, TriggerMatch, i);
+    assert_int_equal(start, span->start);
+    assert_int_equal(end, span->end);
+}
+
+void
+annotate_mention_spans_are_bytes(void** state)
+{
+    prefs_set_boolean(PREF_NOTIFY_MENTION_WHOLE_WORD, TRUE);
+    MessageAnnotations* annotations = message_annotate("hé bob, bob", "bob");
+
+    assert_int_equal(2, annotations->mention_spans->len);
+    _assert_span(annotations->mention_spans, 0, 4, 7);
+    _assert_span(annotations->mention_spans, 1, 9, 12);
+
+    message_annotations_free(annotations);
+}
+
+void
+annotate_merges_overlapping_mentions(void** state)
+{
+    prefs_set_boolean(PREF_NOTIFY_MENTION_WHOLE_WORD, FALSE);
+    MessageAnnotations* annotations = message_annotate("aaa baab", "aa");
+
+    assert_int_equal(3, g_slist_length(annotations->mentions));
+    assert_int_equal(2, annotations->mention_spans->len);
+    _assert_span(annotations->mention_spans, 0, 0, 3);
+    _assert_span(annotations->mention_spans, 1, 5, 7);
+
+    message_annotations_free(annotations);
+}
@@ -0,0 +1,6 @@
+void annotate_finds_urls(void** state);
+void annotate_url_needs_more_than_scheme(void** state);
+void annotate_detects_me_and_ascii(void** state);
+void annotate_skips_room_matching_without_nick(void** state);
+void annotate_mention_spans_are_bytes(void** state);
+void annotate_merges_overlapping_mentions(void** state);
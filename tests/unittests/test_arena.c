@@ -0,0 +1,62 @@
+#include <glib.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "tools/arena.h"
+
+void
+arena_allocations_are_aligned_and_zeroed(void** state)
+{
+    Arena* arena = arena_new(64);
+
+    char* a = arena_alloc(arena, 3);
+    char* b = arena_alloc(arena, 5);
+
+    assert_int_equal(0, (uintptr_t)a % sizeof(void*));
+    assert_int_equal(0, (uintptr_t)b % sizeof(void*));
+    assert_true(b >= a + 3);
+    assert_int_equal(0, b[0]);
+
+    arena_unref(arena);
+}
+
+void
+arena_owns_only_its_allocations(void** state)
+{
+    Arena* arena = arena_new(64);
+    char* copy = arena_strdup(arena, "bob@server.org");
+    char* other = strdup("bob@server.org");
+
+    assert_string_equal("bob@server.org", copy);
+    assert_true(arena_owns(arena, copy));
+    assert_false(arena_owns(arena, other));
+    assert_false(arena_owns(NULL, copy));
+    assert_null(arena_strdup(arena, NULL));
+
+    free(other);
+    arena_unref(arena);
+}
+
+void
+arena_gives_large_allocations_own_block(void** state)
+{
+    Arena* arena = arena_ref(arena_new(64));
+
+    char* small = arena_alloc(arena, 8);
+    char* large = arena_alloc(arena, 1000);
+    char* next = arena_alloc(arena, 8);
+
+    assert_true(arena_owns(arena, large + 999));
+    // the small block keeps serving small allocations
+    assert_ptr_equal(small + 2 * sizeof(void*), next);
+    assert_true(arena_size(arena) >= 64 + 1000);
+
+    arena_unref(arena);
+    assert_true(arena_owns(arena, small));
+    arena_unref(arena);
+}
@@ -0,0 +1,3 @@
+void arena_allocations_are_aligned_and_zeroed(void** state);
+void arena_owns_only_its_allocations(void** state);
+void arena_gives_large_allocations_own_block(void** state);
@@ -58,3 +58,46 @@ returns_commands(void** state)
 
     g_list_free(names);
 }
+
+static PluginTimedFunction*
+_create_timed(int interval_seconds)
+{
+    PluginTimedFunction* timed_function = calloc(1, sizeof(PluginTimedFunction));
+    timed_function->interval_seconds = interval_seconds;
+    return timed_function;
+}
+
+void
+returns_no_timed_wakeup_when_none(void** state)
+{
+    plugins_init();
+    callbacks_add_timed("plugin1", _create_timed(0));
+
+    assert_int_equal(-1, plugins_timed_next_wakeup());
+}
+
+void
+returns_earliest_timed_wakeup(void** state)
+{
+    plugins_init();
+    callbacks_add_timed("plugin1", _create_timed(60));
+    callbacks_add_timed("plugin1", _create_timed(5));
+    callbacks_add_timed("plugin2", _create_timed(30));
+
+    gint wakeup = plugins_timed_next_wakeup();
+    assert_true(wakeup > 4000 && wakeup <= 5000);
+}
+
+void
+removes_timed_wakeup_with_plugin(void** state)
+{
+    plugins_init();
+    callbacks_add_timed("plugin1", _create_timed(5));
+    callbacks_add_timed("plugin2", _create_timed(60));
+    callbacks_add_timed("plugin1", _create_timed(10));
+
+    callbacks_remove("plugin1");
+
+    gint wakeup = plugins_timed_next_wakeup();
+    assert_true(wakeup > 55000 && wakeup <= 60000);
+}
@@ -1,2 +1,5 @@
 void returns_no_commands(void** state);
 void returns_commands(void** state);
+void returns_no_timed_wakeup_when_none(void** state);
+void returns_earliest_timed_wakeup(void** state);
+void removes_timed_wakeup_with_plugin(void** state);
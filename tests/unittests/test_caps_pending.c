@@ -0,0 +1,117 @@
+#include <glib.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdlib.h>
+
+#include "xmpp/caps_pending.h"
+
+#define VER     "QgayPKawpkPSDYmwT/WM94uAlu0="
+#define TIMEOUT ((gint64)CAPS_PENDING_TIMEOUT * G_USEC_PER_SEC)
+
+static const char* const waiting[] = { "alice@example.org/laptop", "bob@example.org/phone", "carol@example.org/desk" };
+
+// JIDs are mapped in hash table order, accept each waiting JID
+static int
+_is_waiting_jid(const LargestIntegralType value, const LargestIntegralType check_value_data)
+{
+    for (size_t i = 0; i < G_N_ELEMENTS(waiting); i++) {
+        if (g_strcmp0((const char*)value, waiting[i]) == 0) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+static void
+_expect_mapped(int count)
+{
+    for (int i = 0; i < count; i++) {
+        expect_check(caps_map_jid_to_ver, jid, _is_waiting_jid, NULL);
+        expect_string(caps_map_jid_to_ver, ver, VER);
+    }
+}
+
+void
+caps_pending_dedupes_concurrent_requests(void** state)
+{
+    caps_pending_init();
+
+    assert_false(caps_pending_add_at(VER, waiting[0], 0));
+    assert_true(caps_pending_add_at(VER, waiting[1], G_USEC_PER_SEC));
+    assert_true(caps_pending_add_at(VER, waiting[2], 2 * G_USEC_PER_SEC));
+    // another ver needs its own request
+    assert_false(caps_pending_add_at("other", waiting[0], 2 * G_USEC_PER_SEC));
+
+    caps_pending_close();
+}
+
+void
+caps_pending_resolve_maps_waiting_jids(void** state)
+{
+    caps_pending_init();
+    caps_pending_add_at(VER, waiting[0], 0);
+    caps_pending_add_at(VER, waiting[1], 0);
+    caps_pending_add_at(VER, waiting[1], 0);
+
+    will_return(caps_cache_contains, TRUE);
+    _expect_mapped(2);
+    caps_pending_resolve(VER);
+
+    // completed, the next presence sends a new request
+    assert_false(caps_pending_add_at(VER, waiting[2], 0));
+
+    caps_pending_close();
+}
+
+void
+caps_pending_resolve_without_result_maps_nothing(void** state)
+{
+    caps_pending_init();
+    caps_pending_add_at(VER, waiting[0], 0);
+    caps_pending_add_at(VER, waiting[1], 0);
+
+    will_return(caps_cache_contains, FALSE);
+    caps_pending_resolve(VER);
+
+    assert_false(caps_pending_add_at(VER, waiting[0], 0));
+
+    caps_pending_close();
+}
+
+void
+caps_pending_resends_after_timeout(void** state)
+{
+    caps_pending_init();
+
+    assert_false(caps_pending_add_at(VER, waiting[0], 0));
+    assert_true(caps_pending_add_at(VER, waiting[1], TIMEOUT - 1));
+    assert_false(caps_pending_add_at(VER, waiting[2], TIMEOUT));
+    // the timeout runs from the resent request
+    assert_true(caps_pending_add_at(VER, waiting[2], 2 * TIMEOUT - 1));
+
+    // JIDs waiting on the timed out request still get the result
+    will_return(caps_cache_contains, TRUE);
+    _expect_mapped(3);
+    caps_pending_resolve(VER);
+
+    caps_pending_close();
+}
+
+void
+caps_pending_clear_forgets_requests(void** state)
+{
+    caps_pending_init();
+    caps_pending_add_at(VER, waiting[0], 0);
+
+    caps_pending_clear();
+
+    assert_false(caps_pending_add_at(VER, waiting[1], 0));
+    guint count = 0;
+    assert_true(caps_pending_memory(&count) > 0);
+    assert_int_equal(1, count);
+
+    caps_pending_close();
+}
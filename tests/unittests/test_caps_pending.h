@@ -0,0 +1,5 @@
+void caps_pending_dedupes_concurrent_requests(void** state);
+void caps_pending_resolve_maps_waiting_jids(void** state);
+void caps_pending_resolve_without_result_maps_nothing(void** state);
+void caps_pending_resends_after_timeout(void** state);
+void caps_pending_clear_forgets_requests(void** state);
@@ -1,5 +1,6 @@
 #include "xmpp/resource.h"
 #include "common.h"
+#include <glib/gstdio.h>
 #include <stdarg.h>
 #include <stddef.h>
 #include <setjmp.h>
@@ -555,6 +556,25 @@ prof_occurrences_of_large_message_tests(void** state)
     g_slist_free(expected);
 }
 
+void
+prof_occurrences_from_offset_appends_tests(void** state)
+{
+    GSList* actual = NULL;
+    GSList* expected = NULL;
+
+    actual = g_slist_append(actual, GINT_TO_POINTER(42));
+    expected = g_slist_append(expected, GINT_TO_POINTER(42));
+    expected = g_slist_append(expected, GINT_TO_POINTER(9));
+    expected = g_slist_append(expected, GINT_TO_POINTER(15));
+    assert_true(_lists_equal(prof_occurrences("bob", "bob, ünd bob ü bob", 2, TRUE, &actual), expected));
+    g_slist_free(actual);
+    actual = NULL;
+    g_slist_free(expected);
+    expected = NULL;
+
+    assert_true(_lists_equal(prof_occurrences("", "some string", 0, FALSE, &actual), expected));
+}
+
 void
 prof_partial_occurrences_tests(void** state)
 {
@@ -849,3 +869,128 @@ prof_whole_occurrences_tests(void** state)
     g_slist_free(expected);
     expected = NULL;
 }
+
+#define KEYFILE_T0        ((gint64)G_USEC_PER_SEC)
+#define KEYFILE_DEBOUNCE  ((gint64)KEYFILE_SAVE_DEBOUNCE_MS * 1000)
+#define KEYFILE_MAX_DELAY ((gint64)KEYFILE_SAVE_MAX_DELAY_MS * 1000)
+
+static void
+_keyfile_new(prof_keyfile_t* keyfile, const char* const dir, const char* const value)
+{
+    keyfile->filename = g_build_filename(dir, "test.keyfile", NULL);
+    keyfile->keyfile = g_key_file_new();
+    keyfile->dirty_since = 0;
+    keyfile->changed_at = 0;
+    g_key_file_set_string(keyfile->keyfile, "group", "key", value);
+}
+
+// the value on disk once queued writes are done, NULL if not written
+static gchar*
+_keyfile_on_disk(prof_keyfile_t* keyfile)
+{
+    // a still dirty keyfile would be written by the forced flush
+    if (keyfile->dirty_since != 0) {
+        return NULL;
+    }
+    flush_keyfiles(TRUE);
+
+    GKeyFile* loaded = g_key_file_new();
+    gchar* value = NULL;
+    if (g_key_file_load_from_file(loaded, keyfile->filename, G_KEY_FILE_NONE, NULL)) {
+        value = g_key_file_get_string(loaded, "group", "key", NULL);
+    }
+    g_key_file_free(loaded);
+
+    return value;
+}
+
+static void
+_keyfile_free(prof_keyfile_t* keyfile, gchar* dir)
+{
+    g_unlink(keyfile->filename);
+    free_keyfile(keyfile);
+    g_rmdir(dir);
+    g_free(dir);
+}
+
+void
+deferred_keyfile_waits_for_debounce(void** state)
+{
+    gchar* dir = g_dir_make_tmp("prof_keyfile_XXXXXX", NULL);
+    prof_keyfile_t keyfile;
+    _keyfile_new(&keyfile, dir, "value");
+
+    save_keyfile_deferred_at(&keyfile, KEYFILE_T0);
+    flush_keyfiles_at(FALSE, KEYFILE_T0 + KEYFILE_DEBOUNCE - 1);
+    assert_null(_keyfile_on_disk(&keyfile));
+
+    flush_keyfiles_at(FALSE, KEYFILE_T0 + KEYFILE_DEBOUNCE);
+    auto_gchar gchar* value = _keyfile_on_disk(&keyfile);
+    assert_string_equal("value", value);
+
+    _keyfile_free(&keyfile, dir);
+}
+
+void
+deferred_keyfile_redirty_postpones_write(void** state)
+{
+    gchar* dir = g_dir_make_tmp("prof_keyfile_XXXXXX", NULL);
+    prof_keyfile_t keyfile;
+    _keyfile_new(&keyfile, dir, "first");
+
+    save_keyfile_deferred_at(&keyfile, KEYFILE_T0);
+    g_key_file_set_string(keyfile.keyfile, "group", "key", "second");
+    save_keyfile_deferred_at(&keyfile, KEYFILE_T0 + KEYFILE_DEBOUNCE / 2);
+
+    flush_keyfiles_at(FALSE, KEYFILE_T0 + KEYFILE_DEBOUNCE);
+    assert_null(_keyfile_on_disk(&keyfile));
+
+    // one write with the last change
+    flush_keyfiles_at(FALSE, KEYFILE_T0 + KEYFILE_DEBOUNCE / 2 + KEYFILE_DEBOUNCE);
+    auto_gchar gchar* value = _keyfile_on_disk(&keyfile);
+    assert_string_equal("second", value);
+
+    _keyfile_free(&keyfile, dir);
+}
+
+void
+deferred_keyfile_busy_written_after_max_delay(void** state)
+{
+    gchar* dir = g_dir_make_tmp("prof_keyfile_XXXXXX", NULL);
+    prof_keyfile_t keyfile;
+    _keyfile_new(&keyfile, dir, "value");
+
+    // never left alone for the debounce window
+    gint64 now = KEYFILE_T0;
+    while (now < KEYFILE_T0 + KEYFILE_MAX_DELAY) {
+        save_keyfile_deferred_at(&keyfile, now);
+        flush_keyfiles_at(FALSE, now);
+        assert_null(_keyfile_on_disk(&keyfile));
+        now += KEYFILE_DEBOUNCE / 2;
+    }
+
+    save_keyfile_deferred_at(&keyfile, KEYFILE_T0 + KEYFILE_MAX_DELAY);
+    flush_keyfiles_at(FALSE, KEYFILE_T0 + KEYFILE_MAX_DELAY);
+    auto_gchar gchar* value = _keyfile_on_disk(&keyfile);
+    assert_string_equal("value", value);
+
+    _keyfile_free(&keyfile, dir);
+}
+
+void
+forced_flush_writes_dirty_keyfile(void** state)
+{
+    gchar* dir = g_dir_make_tmp("prof_keyfile_XXXXXX", NULL);
+    prof_keyfile_t keyfile;
+    _keyfile_new(&keyfile, dir, "value");
+
+    save_keyfile_deferred_at(&keyfile, KEYFILE_T0);
+    flush_keyfiles_at(TRUE, KEYFILE_T0);
+
+    assert_int_equal(0, keyfile.dirty_since);
+    assert_true(g_file_test(keyfile.filename, G_FILE_TEST_EXISTS));
+    auto_gchar gchar* value = _keyfile_on_disk(&keyfile);
+    assert_string_equal("value", value);
+
+    _keyfile_free(&keyfile, dir);
+}
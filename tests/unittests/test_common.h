@@ -32,5 +32,10 @@ void strip_quotes_strips_both(void** state);
 void prof_partial_occurrences_tests(void** state);
 void prof_whole_occurrences_tests(void** state);
 void prof_occurrences_of_large_message_tests(void** state);
+void prof_occurrences_from_offset_appends_tests(void** state);
 void unique_filename_from_url_td(void** state);
 void format_call_external_argv_td(void** state);
+void deferred_keyfile_waits_for_debounce(void** state);
+void deferred_keyfile_redirty_postpones_write(void** state);
+void deferred_keyfile_busy_written_after_max_delay(void** state);
+void forced_flush_writes_dirty_keyfile(void** state);
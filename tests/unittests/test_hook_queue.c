@@ -0,0 +1,297 @@
+#include <glib.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "profanity.h"
+#include "plugins/hook_queue.h"
+
+#define CALLS 50
+
+typedef struct hook_log_t
+{
+    GMutex mutex;
+    GCond cond;
+    // a call to _block_call waits while this is set
+    gboolean blocked;
+    // set once a call to _block_call started
+    gboolean started;
+    GArray* ran;
+    int freed;
+} HookLog;
+
+static HookLog hook_log;
+
+static void
+_log_init(void)
+{
+    g_mutex_init(&hook_log.mutex);
+    g_cond_init(&hook_log.cond);
+    hook_log.blocked = FALSE;
+    hook_log.started = FALSE;
+    hook_log.ran = g_array_new(FALSE, FALSE, sizeof(int));
+    hook_log.freed = 0;
+}
+
+static void
+_log_clear(void)
+{
+    g_array_free(hook_log.ran, TRUE);
+    g_cond_clear(&hook_log.cond);
+    g_mutex_clear(&hook_log.mutex);
+}
+
+static void
+_record_call(ProfPlugin* plugin, void* data)
+{
+    g_mutex_lock(&hook_log.mutex);
+    int num = GPOINTER_TO_INT(data);
+    g_array_append_val(hook_log.ran, num);
+    g_mutex_unlock(&hook_log.mutex);
+}
+
+static void
+_block_call(ProfPlugin* plugin, void* data)
+{
+    g_mutex_lock(&hook_log.mutex);
+    hook_log.started = TRUE;
+    g_cond_broadcast(&hook_log.cond);
+    while (hook_log.blocked) {
+        g_cond_wait(&hook_log.cond, &hook_log.mutex);
+    }
+    g_mutex_unlock(&hook_log.mutex);
+    _record_call(plugin, data);
+}
+
+static void
+_unblock(void)
+{
+    g_mutex_lock(&hook_log.mutex);
+    hook_log.blocked = FALSE;
+    g_cond_broadcast(&hook_log.cond);
+    g_mutex_unlock(&hook_log.mutex);
+}
+
+static void
+_count_free(void* data)
+{
+    g_mutex_lock(&hook_log.mutex);
+    hook_log.freed++;
+    g_cond_broadcast(&hook_log.cond);
+    g_mutex_unlock(&hook_log.mutex);
+}
+
+// unblock once every call but the running one has been dropped
+static gpointer
+_unblock_after_drop(gpointer data)
+{
+    g_mutex_lock(&hook_log.mutex);
+    while (hook_log.freed < CALLS - 1) {
+        g_cond_wait(&hook_log.cond, &hook_log.mutex);
+    }
+    g_mutex_unlock(&hook_log.mutex);
+    _unblock();
+
+    return NULL;
+}
+
+// pushes another call for its own plugin once unblocked
+static void
+_push_again_call(ProfPlugin* plugin, void* data)
+{
+    _block_call(plugin, data);
+    hook_queue_push(plugin, _record_call, GINT_TO_POINTER(1), _count_free);
+}
+
+static void
+_wait_started(void)
+{
+    g_mutex_lock(&hook_log.mutex);
+    while (!hook_log.started) {
+        g_cond_wait(&hook_log.cond, &hook_log.mutex);
+    }
+    g_mutex_unlock(&hook_log.mutex);
+}
+
+// the main loop lock is only released once the removal waits for the plugin
+static gpointer
+_unblock_while_removing(gpointer data)
+{
+    pthread_mutex_lock(&lock);
+    _unblock();
+    pthread_mutex_unlock(&lock);
+
+    return NULL;
+}
+
+static guint
+_ran_count(void)
+{
+    g_mutex_lock(&hook_log.mutex);
+    guint count = hook_log.ran->len;
+    g_mutex_unlock(&hook_log.mutex);
+    return count;
+}
+
+static ProfPlugin*
+_plugin_new(const char* const name)
+{
+    ProfPlugin* plugin = calloc(1, sizeof(ProfPlugin));
+    plugin->name = strdup(name);
+    return plugin;
+}
+
+static void
+_plugin_free(ProfPlugin* plugin)
+{
+    free(plugin->name);
+    free(plugin);
+}
+
+// the queue releases the main loop lock while waiting, so hold it like the main thread does
+static void
+_queue_init(void)
+{
+    _log_init();
+    pthread_mutex_lock(&lock);
+    hook_queue_init();
+}
+
+static void
+_queue_close(void)
+{
+    hook_queue_close();
+    pthread_mutex_unlock(&lock);
+    _log_clear();
+}
+
+void
+hook_queue_runs_calls_in_push_order(void** state)
+{
+    ProfPlugin* plugin = _plugin_new("ordered");
+    _queue_init();
+
+    for (int i = 0; i < CALLS; i++) {
+        assert_true(hook_queue_push(plugin, _record_call, GINT_TO_POINTER(i), _count_free));
+    }
+    assert_true(hook_queue_drain(HOOK_QUEUE_DRAIN_TIMEOUT_MS));
+
+    assert_int_equal(CALLS, hook_log.ran->len);
+    for (int i = 0; i < CALLS; i++) {
+        assert_int_equal(i, g_array_index(hook_log.ran, int, i));
+    }
+    assert_int_equal(CALLS, hook_log.freed);
+
+    _queue_close();
+    _plugin_free(plugin);
+}
+
+void
+hook_queue_close_runs_queued_calls(void** state)
+{
+    ProfPlugin* first = _plugin_new("first");
+    ProfPlugin* second = _plugin_new("second");
+    _queue_init();
+
+    for (int i = 0; i < CALLS; i++) {
+        hook_queue_push(i % 2 ? first : second, _record_call, GINT_TO_POINTER(i), _count_free);
+    }
+    hook_queue_close();
+
+    assert_int_equal(CALLS, hook_log.ran->len);
+    assert_int_equal(CALLS, hook_log.freed);
+
+    pthread_mutex_unlock(&lock);
+    _log_clear();
+    _plugin_free(first);
+    _plugin_free(second);
+}
+
+void
+hook_queue_drain_times_out_on_busy_plugin(void** state)
+{
+    ProfPlugin* plugin = _plugin_new("stuck");
+    _queue_init();
+
+    hook_log.blocked = TRUE;
+    hook_queue_push(plugin, _block_call, GINT_TO_POINTER(0), _count_free);
+    hook_queue_push(plugin, _record_call, GINT_TO_POINTER(1), _count_free);
+
+    assert_false(hook_queue_drain(10));
+    assert_int_equal(0, _ran_count());
+
+    _unblock();
+    assert_true(hook_queue_drain(HOOK_QUEUE_DRAIN_TIMEOUT_MS));
+    assert_int_equal(2, hook_log.ran->len);
+    assert_int_equal(2, hook_log.freed);
+
+    _queue_close();
+    _plugin_free(plugin);
+}
+
+void
+hook_queue_remove_plugin_drops_queued_calls(void** state)
+{
+    ProfPlugin* plugin = _plugin_new("unloaded");
+    _queue_init();
+
+    hook_log.blocked = TRUE;
+    hook_queue_push(plugin, _block_call, GINT_TO_POINTER(0), _count_free);
+    for (int i = 1; i < CALLS; i++) {
+        hook_queue_push(plugin, _record_call, GINT_TO_POINTER(i), _count_free);
+    }
+
+    GThread* unblocker = g_thread_new("unblock", _unblock_after_drop, NULL);
+    hook_queue_remove_plugin(plugin);
+    g_thread_join(unblocker);
+
+    // at most the call that was already running
+    assert_true(hook_log.ran->len <= 1);
+    assert_int_equal(CALLS, hook_log.freed);
+
+    _queue_close();
+    _plugin_free(plugin);
+}
+
+void
+hook_queue_remove_plugin_drops_calls_pushed_while_waiting(void** state)
+{
+    ProfPlugin* plugin = _plugin_new("pushing");
+    _queue_init();
+
+    hook_log.blocked = TRUE;
+    hook_queue_push(plugin, _push_again_call, GINT_TO_POINTER(0), _count_free);
+    _wait_started();
+
+    GThread* unblocker = g_thread_new("unblock", _unblock_while_removing, NULL);
+    hook_queue_remove_plugin(plugin);
+    g_thread_join(unblocker);
+
+    // the call pushed by the running one is dropped, not scheduled
+    assert_int_equal(1, hook_log.ran->len);
+    assert_int_equal(0, g_array_index(hook_log.ran, int, 0));
+    assert_int_equal(2, hook_log.freed);
+
+    _queue_close();
+    _plugin_free(plugin);
+}
+
+void
+hook_queue_push_after_close_is_refused(void** state)
+{
+    ProfPlugin* plugin = _plugin_new("closed");
+    _queue_init();
+    hook_queue_close();
+
+    assert_false(hook_queue_push(plugin, _record_call, GINT_TO_POINTER(0), _count_free));
+    assert_int_equal(0, hook_log.ran->len);
+    assert_int_equal(0, hook_log.freed);
+
+    pthread_mutex_unlock(&lock);
+    _log_clear();
+    _plugin_free(plugin);
+}
@@ -0,0 +1,6 @@
+void hook_queue_runs_calls_in_push_order(void** state);
+void hook_queue_close_runs_queued_calls(void** state);
+void hook_queue_drain_times_out_on_busy_plugin(void** state);
+void hook_queue_remove_plugin_drops_queued_calls(void** state);
+void hook_queue_remove_plugin_drops_calls_pushed_while_waiting(void** state);
+void hook_queue_push_after_close_is_refused(void** state);
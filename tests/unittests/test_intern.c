@@ -0,0 +1,42 @@
+#include <glib.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdlib.h>
+
+#include "tools/intern.h"
+
+void
+intern_returns_shared_copy(void** state)
+{
+    char first[] = "bob@server.org";
+    char second[] = "bob@server.org";
+
+    const char* a = intern_ref(first);
+    const char* b = intern_ref(second);
+
+    assert_ptr_equal(a, b);
+    assert_ptr_not_equal(a, first);
+    assert_string_equal("bob@server.org", a);
+    assert_null(intern_ref(NULL));
+
+    intern_unref(a);
+    intern_unref(b);
+}
+
+void
+intern_frees_with_last_reference(void** state)
+{
+    guint before = intern_count();
+
+    const char* a = intern_ref("alice@server.org");
+    const char* b = intern_ref("alice@server.org");
+    assert_int_equal(before + 1, intern_count());
+
+    intern_unref(a);
+    assert_int_equal(before + 1, intern_count());
+
+    intern_unref(b);
+    assert_int_equal(before, intern_count());
+}
@@ -0,0 +1,2 @@
+void intern_returns_shared_copy(void** state);
+void intern_frees_with_last_reference(void** state);
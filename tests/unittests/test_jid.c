@@ -237,3 +237,36 @@ returns_barejid_when_fulljid_not_exists(void** state)
 
     jid_destroy(jid);
 }
+
+void
+create_jid_returns_cached_jid(void** state)
+{
+    Jid* first = jid_create("cached@domain.org/res");
+    Jid* second = jid_create("cached@domain.org/res");
+
+    assert_ptr_equal(first, second);
+
+    jid_destroy(first);
+    jid_destroy(second);
+
+    Jid* third = jid_create("cached@domain.org/res");
+    assert_ptr_equal(first, third);
+    assert_string_equal("cached@domain.org", third->barejid);
+
+    jid_destroy(third);
+}
+
+void
+cached_jid_outlives_cache_clear(void** state)
+{
+    Jid* jid = jid_create("kept@domain.org/res");
+
+    jid_cache_clear();
+
+    assert_string_equal("kept@domain.org/res", jid->fulljid);
+    jid_destroy(jid);
+
+    Jid* fresh = jid_create("kept@domain.org/res");
+    assert_string_equal("res", fresh->resourcepart);
+    jid_destroy(fresh);
+}
@@ -0,0 +1,103 @@
+#include <glib.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdlib.h>
+
+#include "tools/autocomplete.h"
+#include "tools/memstats.h"
+
+static void
+_small_reporter(MemStats* stats)
+{
+    memstats_add(stats, "test.small", 10, 1);
+}
+
+static void
+_large_reporter(MemStats* stats)
+{
+    memstats_add(stats, "test.large", 1000, 5);
+    memstats_add(stats, "test.medium", 100, 2);
+}
+
+// other modules may have registered reporters too, so only test entries count
+static int
+_index_of(MemStats* stats, const char* const name)
+{
+    for (guint i = 0; i < stats->entries->len; i++) {
+        MemStatsEntry* entry = g_ptr_array_index(stats->entries, i);
+        if (g_strcmp0(entry->name, name) == 0) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+void
+memstats_collects_registered_reporters_largest_first(void** state)
+{
+    memstats_register("test.small", _small_reporter);
+    memstats_register("test.large", _large_reporter);
+
+    MemStats* stats = memstats_collect();
+
+    int large = _index_of(stats, "test.large");
+    int medium = _index_of(stats, "test.medium");
+    int small = _index_of(stats, "test.small");
+    assert_true(large >= 0);
+    assert_true(large < medium);
+    assert_true(medium < small);
+    assert_true(stats->total >= 1110);
+
+    MemStatsEntry* entry = g_ptr_array_index(stats->entries, large);
+    assert_int_equal(1000, entry->bytes);
+    assert_int_equal(5, entry->items);
+
+    memstats_free(stats);
+    memstats_unregister("test.small");
+    memstats_unregister("test.large");
+}
+
+void
+memstats_unregistered_reporter_not_collected(void** state)
+{
+    memstats_register("test.small", _small_reporter);
+    // registering again replaces rather than adds
+    memstats_register("test.small", _small_reporter);
+    memstats_register("test.large", _large_reporter);
+    memstats_unregister("test.large");
+
+    MemStats* stats = memstats_collect();
+
+    int small = _index_of(stats, "test.small");
+    assert_true(small >= 0);
+    assert_int_equal(-1, _index_of(stats, "test.large"));
+    for (guint i = small + 1; i < stats->entries->len; i++) {
+        MemStatsEntry* entry = g_ptr_array_index(stats->entries, i);
+        assert_string_not_equal("test.small", entry->name);
+    }
+
+    memstats_free(stats);
+    memstats_unregister("test.small");
+}
+
+void
+memstats_autocomplete_grows_with_items(void** state)
+{
+    Autocomplete ac = autocomplete_new();
+    gsize empty = autocomplete_memory(ac);
+
+    autocomplete_add(ac, "alice@example.org");
+    gsize one = autocomplete_memory(ac);
+    autocomplete_add(ac, "bob@example.org");
+    gsize two = autocomplete_memory(ac);
+
+    assert_true(empty > 0);
+    assert_true(one >= empty + sizeof(GList) + sizeof("alice@example.org"));
+    assert_true(two >= one + sizeof(GList) + sizeof("bob@example.org"));
+    assert_int_equal(0, autocomplete_memory(NULL));
+
+    autocomplete_free(ac);
+}
@@ -0,0 +1,3 @@
+void memstats_collects_registered_reporters_largest_first(void** state);
+void memstats_unregistered_reporter_not_collected(void** state);
+void memstats_autocomplete_grows_with_items(void** state);
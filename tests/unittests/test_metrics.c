@@ -0,0 +1,68 @@
+#include <glib.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdlib.h>
+
+#include "tools/metrics.h"
+
+void
+histogram_buckets_bound_values(void** state)
+{
+    for (guint64 value = 0; value < 1000000; value += 7) {
+        guint64 bucket = metrics_histogram_bucket(value);
+        guint64 upper = metrics_histogram_upper(bucket);
+        assert_true(upper > value);
+        // a bucket is never wider than a quarter of its values, plus one
+        assert_true(upper - value <= value / 4 + 1);
+    }
+}
+
+void
+histogram_buckets_are_ordered(void** state)
+{
+    guint64 previous = 0;
+    for (guint64 value = 0; value < 100000; value++) {
+        guint64 bucket = metrics_histogram_bucket(value);
+        assert_true(bucket >= previous);
+        assert_true(bucket <= previous + 1);
+        previous = bucket;
+    }
+}
+
+void
+metrics_empty_after_reset(void** state)
+{
+    metrics_init();
+    metrics_record(METRIC_DB_ADD, g_get_monotonic_time() - 1000);
+    metrics_reset();
+
+    MetricSnapshot snapshot;
+    metrics_get(METRIC_DB_ADD, &snapshot);
+
+    assert_int_equal(0, snapshot.count);
+    assert_int_equal(0, snapshot.max_us);
+    assert_int_equal(0, snapshot.p99_us);
+}
+
+void
+metrics_percentiles_follow_recorded_values(void** state)
+{
+    metrics_init();
+    for (int i = 0; i < 90; i++) {
+        metrics_record(METRIC_UI_UPDATE, g_get_monotonic_time() - 100);
+    }
+    for (int i = 0; i < 10; i++) {
+        metrics_record(METRIC_UI_UPDATE, g_get_monotonic_time() - 50000);
+    }
+
+    MetricSnapshot snapshot;
+    metrics_get(METRIC_UI_UPDATE, &snapshot);
+
+    assert_int_equal(100, snapshot.count);
+    assert_true(snapshot.p50_us >= 100 && snapshot.p50_us < 1000);
+    assert_true(snapshot.p99_us >= 50000);
+    assert_true(snapshot.max_us >= 50000);
+    assert_true(snapshot.p99_us <= snapshot.max_us);
+}
@@ -0,0 +1,4 @@
+void histogram_buckets_bound_values(void** state);
+void histogram_buckets_are_ordered(void** state);
+void metrics_empty_after_reset(void** state);
+void metrics_percentiles_follow_recorded_values(void** state);
@@ -0,0 +1,108 @@
+#include <glib.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdlib.h>
+
+#include "tools/trigger_matcher.h"
+
+static void
+_assert_match(GArray* matches, guint index, gsize start, gsize end, guint pattern)
+{
+    assert_true(index < matches->len);
+    TriggerMatch* match = &g_array_index(matches, TriggerMatch, index);
+    assert_int_equal(start, match->start);
+    assert_int_equal(end, match->end);
+    assert_int_equal(pattern, match->pattern);
+}
+
+// walk the text the way message_annotate() does
+static GArray*
+_find(TriggerMatcher* matcher, const char* const text)
+{
+    GArray* matches = g_array_new(FALSE, FALSE, sizeof(TriggerMatch));
+    TriggerScan scan;
+    trigger_scan_init(&scan, matcher);
+    for (const gchar* curr = text; *curr != '\0'; curr = g_utf8_next_char(curr)) {
+        trigger_scan_feed(&scan, g_utf8_get_char(curr), curr - text, g_utf8_next_char(curr) - text, matches);
+    }
+    trigger_scan_clear(&scan);
+
+    return matches;
+}
+
+void
+trigger_matcher_finds_nothing_without_patterns(void** state)
+{
+    gchar* patterns[] = { "", NULL };
+    TriggerMatcher* matcher = trigger_matcher_new(patterns, 1);
+
+    GArray* matches = _find(matcher, "some message");
+    assert_int_equal(0, matches->len);
+
+    g_array_free(matches, TRUE);
+    trigger_matcher_free(matcher);
+}
+
+void
+trigger_matcher_finds_overlapping_occurrences(void** state)
+{
+    gchar* patterns[] = { "he", "she", "hers", NULL };
+    TriggerMatcher* matcher = trigger_matcher_new(patterns, 3);
+
+    GArray* matches = _find(matcher, "ushers");
+    assert_int_equal(3, matches->len);
+    _assert_match(matches, 0, 1, 4, 1);
+    _assert_match(matches, 1, 2, 4, 0);
+    _assert_match(matches, 2, 2, 6, 2);
+
+    g_array_free(matches, TRUE);
+    trigger_matcher_free(matcher);
+}
+
+void
+trigger_matcher_ignores_case(void** state)
+{
+    gchar* patterns[] = { "Beer", NULL };
+    TriggerMatcher* matcher = trigger_matcher_new(patterns, 1);
+
+    GArray* matches = _find(matcher, "BEER and beer");
+    assert_int_equal(2, matches->len);
+    _assert_match(matches, 0, 0, 4, 0);
+    _assert_match(matches, 1, 9, 13, 0);
+
+    g_array_free(matches, TRUE);
+    trigger_matcher_free(matcher);
+}
+
+void
+trigger_matcher_spans_prefer_leftmost_longest(void** state)
+{
+    gchar* patterns[] = { "ax", "xbc", "bc", "a", NULL };
+    TriggerMatcher* matcher = trigger_matcher_new(patterns, 4);
+
+    GArray* spans = _find(matcher, "axbc");
+    trigger_matches_to_spans(spans);
+    assert_int_equal(2, spans->len);
+    _assert_match(spans, 0, 0, 2, 0);
+    _assert_match(spans, 1, 2, 4, 2);
+
+    g_array_free(spans, TRUE);
+    trigger_matcher_free(matcher);
+}
+
+void
+trigger_matcher_spans_use_byte_offsets(void** state)
+{
+    gchar* patterns[] = { "grüße", NULL };
+    TriggerMatcher* matcher = trigger_matcher_new(patterns, 1);
+
+    GArray* spans = _find(matcher, "Schöne GRÜSSE, schöne Grüße");
+    trigger_matches_to_spans(spans);
+    assert_int_equal(1, spans->len);
+    _assert_match(spans, 0, 25, 32, 0);
+
+    g_array_free(spans, TRUE);
+    trigger_matcher_free(matcher);
+}
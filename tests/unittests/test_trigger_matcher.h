@@ -0,0 +1,5 @@
+void trigger_matcher_finds_nothing_without_patterns(void** state);
+void trigger_matcher_finds_overlapping_occurrences(void** state);
+void trigger_matcher_ignores_case(void** state);
+void trigger_matcher_spans_prefer_leftmost_longest(void** state);
+void trigger_matcher_spans_use_byte_offsets(void** state);
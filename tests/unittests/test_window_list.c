@@ -0,0 +1,130 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+
+#include "xmpp/xmpp.h"
+#include "xmpp/roster_list.h"
+#include "ui/ui.h"
+#include "ui/window_list.h"
+
+static ProfWin*
+_new_chat(const char* const barejid)
+{
+    ProfChatWin* chatwin = calloc(1, sizeof(ProfChatWin));
+    chatwin->window.type = WIN_CHAT;
+    chatwin->barejid = strdup(barejid);
+    will_return(win_create_chat, &chatwin->window);
+
+    return wins_new_chat(barejid);
+}
+
+static void
+_init_wins(void)
+{
+    ProfConsoleWin* console = calloc(1, sizeof(ProfConsoleWin));
+    console->window.type = WIN_CONSOLE;
+    will_return(win_create_console, &console->window);
+    wins_init();
+    roster_create();
+}
+
+void
+wins_get_chat_finds_new_window(void** state)
+{
+    _init_wins();
+    ProfWin* bob = _new_chat("bob@server.org");
+    ProfWin* alice = _new_chat("alice@server.org");
+
+    assert_ptr_equal(bob, wins_get_chat("bob@server.org"));
+    assert_ptr_equal(alice, wins_get_chat("alice@server.org"));
+    assert_null(wins_get_chat("carol@server.org"));
+    assert_null(wins_get_muc("bob@server.org"));
+
+    roster_destroy();
+    wins_destroy();
+}
+
+void
+wins_get_chat_follows_swapped_window(void** state)
+{
+    _init_wins();
+    ProfWin* bob = _new_chat("bob@server.org");
+    ProfWin* alice = _new_chat("alice@server.org");
+
+    wins_swap(2, 3);
+
+    assert_ptr_equal(bob, wins_get_chat("bob@server.org"));
+    assert_int_equal(3, wins_get_num(bob));
+    assert_ptr_equal(alice, wins_get_chat("alice@server.org"));
+    assert_int_equal(2, wins_get_num(alice));
+
+    roster_destroy();
+    wins_destroy();
+}
+
+void
+wins_get_chat_forgets_closed_window(void** state)
+{
+    _init_wins();
+    _new_chat("bob@server.org");
+    ProfWin* alice = _new_chat("alice@server.org");
+
+    will_return(connection_get_status, JABBER_DISCONNECTED);
+    wins_close_by_num(2);
+
+    assert_null(wins_get_chat("bob@server.org"));
+    assert_ptr_equal(alice, wins_get_chat("alice@server.org"));
+
+    roster_destroy();
+    wins_destroy();
+}
+
+void
+wins_total_unread_follows_added_and_cleared(void** state)
+{
+    _init_wins();
+    ProfWin* bob = _new_chat("bob@server.org");
+    ProfWin* alice = _new_chat("alice@server.org");
+
+    wins_add_unread(bob);
+    wins_add_unread(bob);
+    wins_add_unread(alice);
+    assert_int_equal(3, wins_get_total_unread());
+    assert_int_equal(2, ((ProfChatWin*)bob)->unread);
+
+    wins_clear_unread(bob);
+    assert_int_equal(1, wins_get_total_unread());
+    assert_int_equal(0, ((ProfChatWin*)bob)->unread);
+
+    will_return(connection_get_status, JABBER_DISCONNECTED);
+    wins_close_by_num(3);
+    assert_int_equal(0, wins_get_total_unread());
+
+    roster_destroy();
+    wins_destroy();
+}
+
+void
+wins_get_next_unread_returns_lowest_window(void** state)
+{
+    _init_wins();
+    _new_chat("bob@server.org");
+    ProfWin* alice = _new_chat("alice@server.org");
+    ProfWin* carol = _new_chat("carol@server.org");
+
+    assert_null(wins_get_next_unread());
+
+    wins_add_unread(carol);
+    wins_add_unread(alice);
+    assert_ptr_equal(alice, wins_get_next_unread());
+
+    wins_clear_unread(alice);
+    assert_ptr_equal(carol, wins_get_next_unread());
+
+    roster_destroy();
+    wins_destroy();
+}
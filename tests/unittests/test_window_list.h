@@ -0,0 +1,5 @@
+void wins_get_chat_finds_new_window(void** state);
+void wins_get_chat_follows_swapped_window(void** state);
+void wins_get_chat_forgets_closed_window(void** state);
+void wins_total_unread_follows_added_and_cleared(void** state);
+void wins_get_next_unread_returns_lowest_window(void** state);
@@ -12,17 +12,13 @@ typedef struct aesgcm_download_t
     char* url;
     char* filename;
     ProfWin* window;
-    pthread_t worker;
-    HTTPDownload* http_dl;
 } AESGCMDownload;
 
-void*
-aesgcm_file_get(void* userdata)
+void
+aesgcm_file_get(AESGCMDownload* download)
 {
-    return NULL;
 };
 
 void aesgcm_download_cancel_processes(ProfWin* window){};
-void aesgcm_download_add_download(AESGCMDownload* download){};
 
 #endif
@@ -16,15 +16,13 @@ typedef struct http_download_t
     FILE* filehandle;
     curl_off_t bytes_received;
     ProfWin* window;
-    pthread_t worker;
     int cancel;
     gboolean silent;
 } HTTPDownload;
 
-void*
-http_file_get(void* userdata)
+void
+http_file_get(HTTPDownload* download)
 {
-    return NULL;
 }
 
 void http_download_cancel_processes(){};
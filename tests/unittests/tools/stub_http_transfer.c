@@ -0,0 +1,24 @@
+#include <glib.h>
+#include <curl/curl.h>
+
+#include "tools/http_transfer.h"
+
+void
+http_transfer_init(guint max_active)
+{
+}
+
+void
+http_transfer_set_max_active(guint max_active)
+{
+}
+
+void
+http_transfer_submit(CURL* curl, int* cancel, http_transfer_progress_cb on_progress, http_transfer_done_cb on_done, void* userdata)
+{
+}
+
+void
+http_transfer_process_events(void)
+{
+}
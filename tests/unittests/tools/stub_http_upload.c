@@ -16,14 +16,12 @@ typedef struct http_upload_t
     char* get_url;
     char* put_url;
     ProfWin* window;
-    pthread_t worker;
     int cancel;
 } HTTPUpload;
 
-void*
-http_file_put(void* userdata)
+void
+http_file_put(HTTPUpload* upload)
 {
-    return NULL;
 }
 
 char*
@@ -5,10 +5,9 @@
 typedef struct prof_win_t ProfWin;
 typedef struct http_download_t HTTPDownload;
 
-void*
-plugin_download_install(void* userdata)
+void
+plugin_download_install(HTTPDownload* download)
 {
-    return NULL;
 }
 
 void
@@ -363,7 +363,7 @@ mucwin_history(ProfMucWin* mucwin, const ProfMessage* const message)
 {
 }
 void
-mucwin_incoming_msg(ProfMucWin* mucwin, const ProfMessage* const message, GSList* mentions, GList* triggers, gboolean filter_reflection)
+mucwin_incoming_msg(ProfMucWin* mucwin, const ProfMessage* const message, const MessageAnnotations* const annotations, gboolean filter_reflection)
 {
 }
 void
@@ -1279,6 +1279,12 @@ void
 win_free(ProfWin* window)
 {
 }
+gsize
+win_memory(ProfWin* window, guint* entries)
+{
+    *entries = 0;
+    return 0;
+}
 gboolean
 win_notify_remind(ProfWin* window)
 {
@@ -14,6 +14,13 @@
 #include "xmpp/chat_session.h"
 #include "helpers.h"
 #include "test_autocomplete.h"
+#include "test_metrics.h"
+#include "test_trigger_matcher.h"
+#include "test_annotations.h"
+#include "test_intern.h"
+#include "test_arena.h"
+#include "test_memstats.h"
+#include "test_window_list.h"
 #include "test_chat_session.h"
 #include "test_common.h"
 #include "test_contact.h"
@@ -25,6 +32,7 @@
 #include "test_cmd_otr.h"
 #include "test_cmd_pgp.h"
 #include "test_jid.h"
+#include "test_caps_pending.h"
 #include "test_parser.h"
 #include "test_roster_list.h"
 #include "test_preferences.h"
@@ -38,6 +46,11 @@
 #include "test_form.h"
 #include "test_callbacks.h"
 #include "test_plugins_disco.h"
+#include "test_hook_queue.h"
+#ifdef HAVE_OMEMO
+#include "omemo/test_journal.h"
+#include "omemo/test_file_stream.h"
+#endif
 
 #define muc_unit_test(f) cmocka_unit_test_setup_teardown(f, muc_before_test, muc_after_test)
 
@@ -97,6 +110,43 @@ main(int argc, char* argv[])
         cmocka_unit_test(strip_quotes_strips_both),
         cmocka_unit_test(format_call_external_argv_td),
         cmocka_unit_test(unique_filename_from_url_td),
+        cmocka_unit_test(deferred_keyfile_waits_for_debounce),
+        cmocka_unit_test(deferred_keyfile_redirty_postpones_write),
+        cmocka_unit_test(deferred_keyfile_busy_written_after_max_delay),
+        cmocka_unit_test(forced_flush_writes_dirty_keyfile),
+
+        cmocka_unit_test(histogram_buckets_bound_values),
+        cmocka_unit_test(histogram_buckets_are_ordered),
+        cmocka_unit_test(metrics_empty_after_reset),
+        cmocka_unit_test(metrics_percentiles_follow_recorded_values),
+
+        cmocka_unit_test(trigger_matcher_finds_nothing_without_patterns),
+        cmocka_unit_test(trigger_matcher_finds_overlapping_occurrences),
+        cmocka_unit_test(trigger_matcher_ignores_case),
+        cmocka_unit_test(trigger_matcher_spans_prefer_leftmost_longest),
+        cmocka_unit_test(trigger_matcher_spans_use_byte_offsets),
+
+        cmocka_unit_test(annotate_finds_urls),
+        cmocka_unit_test(annotate_url_needs_more_than_scheme),
+        cmocka_unit_test(annotate_detects_me_and_ascii),
+        cmocka_unit_test(annotate_skips_room_matching_without_nick),
+        cmocka_unit_test_setup_teardown(annotate_mention_spans_are_bytes,
+                                        load_preferences,
+                                        close_preferences),
+        cmocka_unit_test_setup_teardown(annotate_merges_overlapping_mentions,
+                                        load_preferences,
+                                        close_preferences),
+
+        cmocka_unit_test(intern_returns_shared_copy),
+        cmocka_unit_test(intern_frees_with_last_reference),
+
+        cmocka_unit_test(arena_allocations_are_aligned_and_zeroed),
+        cmocka_unit_test(arena_owns_only_its_allocations),
+        cmocka_unit_test(arena_gives_large_allocations_own_block),
+
+        cmocka_unit_test(memstats_collects_registered_reporters_largest_first),
+        cmocka_unit_test(memstats_unregistered_reporter_not_collected),
+        cmocka_unit_test(memstats_autocomplete_grows_with_items),
 
         cmocka_unit_test(clear_empty),
         cmocka_unit_test(reset_after_create),
@@ -140,6 +190,14 @@ main(int argc, char* argv[])
         cmocka_unit_test(create_full_with_trailing_slash),
         cmocka_unit_test(returns_fulljid_when_exists),
         cmocka_unit_test(returns_barejid_when_fulljid_not_exists),
+        cmocka_unit_test(create_jid_returns_cached_jid),
+        cmocka_unit_test(cached_jid_outlives_cache_clear),
+
+        cmocka_unit_test(caps_pending_dedupes_concurrent_requests),
+        cmocka_unit_test(caps_pending_resolve_maps_waiting_jids),
+        cmocka_unit_test(caps_pending_resolve_without_result_maps_nothing),
+        cmocka_unit_test(caps_pending_resends_after_timeout),
+        cmocka_unit_test(caps_pending_clear_forgets_requests),
 
         cmocka_unit_test(parse_null_returns_null),
         cmocka_unit_test(parse_empty_returns_null),
@@ -469,6 +527,12 @@ main(int argc, char* argv[])
                                         load_preferences,
                                         close_preferences),
 
+        cmocka_unit_test(wins_get_chat_finds_new_window),
+        cmocka_unit_test(wins_get_chat_follows_swapped_window),
+        cmocka_unit_test(wins_get_chat_forgets_closed_window),
+        cmocka_unit_test(wins_total_unread_follows_added_and_cleared),
+        cmocka_unit_test(wins_get_next_unread_returns_lowest_window),
+
         cmocka_unit_test(cmd_alias_add_shows_usage_when_no_args),
         cmocka_unit_test(cmd_alias_add_shows_usage_when_no_value),
         cmocka_unit_test(cmd_alias_remove_shows_usage_when_no_args),
@@ -629,6 +693,7 @@ main(int argc, char* argv[])
         cmocka_unit_test(prof_partial_occurrences_tests),
         cmocka_unit_test(prof_whole_occurrences_tests),
         cmocka_unit_test(prof_occurrences_of_large_message_tests),
+        cmocka_unit_test(prof_occurrences_from_offset_appends_tests),
 
         cmocka_unit_test_setup_teardown(returns_no_commands,
                                         load_preferences,
@@ -636,6 +701,15 @@ main(int argc, char* argv[])
         cmocka_unit_test_setup_teardown(returns_commands,
                                         load_preferences,
                                         close_preferences),
+        cmocka_unit_test_setup_teardown(returns_no_timed_wakeup_when_none,
+                                        load_preferences,
+                                        close_preferences),
+        cmocka_unit_test_setup_teardown(returns_earliest_timed_wakeup,
+                                        load_preferences,
+                                        close_preferences),
+        cmocka_unit_test_setup_teardown(removes_timed_wakeup_with_plugin,
+                                        load_preferences,
+                                        close_preferences),
 
         cmocka_unit_test(returns_empty_list_when_none),
         cmocka_unit_test(returns_added_feature),
@@ -644,6 +718,27 @@ main(int argc, char* argv[])
         cmocka_unit_test(does_not_add_duplicate_feature),
         cmocka_unit_test(removes_plugin_features),
         cmocka_unit_test(does_not_remove_feature_when_more_than_one_reference),
+
+        cmocka_unit_test(hook_queue_runs_calls_in_push_order),
+        cmocka_unit_test(hook_queue_close_runs_queued_calls),
+        cmocka_unit_test(hook_queue_drain_times_out_on_busy_plugin),
+        cmocka_unit_test(hook_queue_remove_plugin_drops_queued_calls),
+        cmocka_unit_test(hook_queue_remove_plugin_drops_calls_pushed_while_waiting),
+        cmocka_unit_test(hook_queue_push_after_close_is_refused),
+
+#ifdef HAVE_OMEMO
+        cmocka_unit_test_setup_teardown(journal_replays_appended_records, journal_setup, journal_teardown),
+        cmocka_unit_test_setup_teardown(journal_replay_applies_records_in_order, journal_setup, journal_teardown),
+        cmocka_unit_test_setup_teardown(journal_replay_skips_torn_and_malformed_records, journal_setup, journal_teardown),
+        cmocka_unit_test_setup_teardown(journal_append_after_torn_record_is_kept, journal_setup, journal_teardown),
+        cmocka_unit_test_setup_teardown(journal_truncate_drops_records, journal_setup, journal_teardown),
+        cmocka_unit_test_setup_teardown(journal_needs_compaction_until_truncated, journal_setup, journal_teardown),
+        cmocka_unit_test_setup(file_stream_round_trip, file_stream_setup),
+        cmocka_unit_test_setup(file_stream_round_trip_empty_file, file_stream_setup),
+        cmocka_unit_test_setup(file_stream_decrypt_split_inside_tag, file_stream_setup),
+        cmocka_unit_test_setup(file_stream_decrypt_single_byte_chunks, file_stream_setup),
+        cmocka_unit_test_setup(file_stream_decrypt_rejects_tampered_tag, file_stream_setup),
+#endif
     };
     return cmocka_run_group_tests(all_tests, NULL, NULL);
 }
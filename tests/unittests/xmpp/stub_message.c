@@ -1,3 +1,6 @@
+#include <stdlib.h>
+#include <string.h>
+
 #include "xmpp/message.h"
 
 ProfMessage*
@@ -10,3 +13,22 @@ void
 message_free(ProfMessage* message)
 {
 }
+
+ProfMessage*
+message_init_in(Arena* arena)
+{
+    return NULL;
+}
+
+char*
+message_strdup(ProfMessage* message, const char* const str)
+{
+    return str ? strdup(str) : NULL;
+}
+
+void
+message_set_plain(ProfMessage* message, char* plain)
+{
+    free(message->plain);
+    message->plain = plain;
+}
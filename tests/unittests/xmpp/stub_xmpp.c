@@ -489,6 +489,19 @@ caps_jid_has_feature(const char* const jid, const char* const feature)
     return FALSE;
 }
 
+gboolean
+caps_cache_contains(const char* const ver)
+{
+    return mock_type(gboolean);
+}
+
+void
+caps_map_jid_to_ver(const char* const jid, const char* const ver)
+{
+    check_expected(jid);
+    check_expected(ver);
+}
+
 gboolean
 bookmark_add(const char* jid, const char* nick, const char* password, const char* autojoin_str, const char* name)
 {